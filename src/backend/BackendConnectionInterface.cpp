@@ -267,6 +267,32 @@ BackendConnectionInterface::remove(const Namespace& nspace,
                    may_not_exist);
 }
 
+void
+BackendConnectionInterface::remove_objects(const Namespace& nspace,
+                                           const std::vector<std::string>& names,
+                                           const ObjectMayNotExist may_not_exist)
+{
+    Logger l(__FUNCTION__, nspace);
+    LOG_INFO(nspace << ": removing " << names.size() << " objects");
+    return remove_objects_(nspace,
+                           names,
+                           may_not_exist);
+}
+
+void
+BackendConnectionInterface::copy_object(const Namespace& src_nspace,
+                                        const std::string& name,
+                                        const Namespace& dst_nspace,
+                                        const OverwriteObject overwrite)
+{
+    Logger l(__FUNCTION__, src_nspace, name);
+    LOG_INFO(src_nspace << "/" << name << " -> " << dst_nspace);
+    return copy_object_(src_nspace,
+                        name,
+                        dst_nspace,
+                        overwrite);
+}
+
 uint64_t
 BackendConnectionInterface::getSize(const Namespace& nspace,
                                     const std::string& name)
@@ -382,6 +408,62 @@ BackendConnectionInterface::invalidate_cache_(const boost::optional<Namespace>&
              ": not invalidating local cache because there presumably isn't one");
 }
 
+void
+BackendConnectionInterface::remove_objects_(const Namespace& nspace,
+                                            const std::vector<std::string>& names,
+                                            const ObjectMayNotExist may_not_exist)
+{
+    bool missing = false;
+
+    for (const auto& name : names)
+    {
+        try
+        {
+            remove_(nspace,
+                    name,
+                    may_not_exist);
+        }
+        catch (BackendObjectDoesNotExistException&)
+        {
+            LOG_ERROR(nspace << "/" << name << ": object does not exist");
+            missing = true;
+        }
+    }
+
+    if (missing)
+    {
+        throw BackendObjectDoesNotExistException();
+    }
+}
+
+void
+BackendConnectionInterface::copy_object_(const Namespace& src_nspace,
+                                         const std::string& name,
+                                         const Namespace& dst_nspace,
+                                         const OverwriteObject overwrite)
+{
+    boost::filesystem::path temp_file;
+    try
+    {
+        temp_file = youtils::FileUtils::create_temp_file_in_temp_dir(name);
+    }
+    catch (...)
+    {
+        throw BackendOutputException();
+    }
+
+    ALWAYS_CLEANUP_FILE(temp_file);
+
+    read_(src_nspace,
+          temp_file,
+          name,
+          InsistOnLatestVersion::T);
+    write_(dst_nspace,
+           temp_file,
+           name,
+           overwrite);
+}
+
 void
 BackendConnectionInterface::clearNamespace_(const Namespace& nspace)
 {
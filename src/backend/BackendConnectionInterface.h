@@ -178,6 +178,33 @@ protected:
            const std::string& name,
            const ObjectMayNotExist may_not_exist = ObjectMayNotExist::F);
 
+    // Bulk version of remove: backends that support it remove the objects in
+    // batches / in parallel, the others remove them one by one.
+    // With ObjectMayNotExist::F, BackendObjectDoesNotExistException is thrown
+    // *after* all existing objects were removed.
+    void
+    remove_objects(const Namespace& nspace,
+                   const std::vector<std::string>& names,
+                   const ObjectMayNotExist may_not_exist = ObjectMayNotExist::F);
+
+    // Whether remove_objects is more than a loop over remove, i.e. whether it's
+    // worth handing large batches to a single call.
+    bool
+    has_native_remove_objects() const
+    {
+        return has_native_remove_objects_();
+    }
+
+    // Copies an object to another namespace of the same backend. Backends that
+    // support it do so without moving the data through this host (the local
+    // backend hardlinks), the others fall back to read + write through a
+    // temporary file.
+    void
+    copy_object(const Namespace& src_nspace,
+                const std::string& name,
+                const Namespace& dst_nspace,
+                const OverwriteObject overwrite = OverwriteObject::F);
+
     uint64_t
     getSize(const Namespace& nspace,
             const std::string& name);
@@ -305,6 +332,23 @@ private:
             const std::string& name,
             const ObjectMayNotExist) = 0;
 
+    virtual void
+    remove_objects_(const Namespace&,
+                    const std::vector<std::string>& names,
+                    const ObjectMayNotExist);
+
+    virtual bool
+    has_native_remove_objects_() const
+    {
+        return false;
+    }
+
+    virtual void
+    copy_object_(const Namespace& src_nspace,
+                 const std::string& name,
+                 const Namespace& dst_nspace,
+                 const OverwriteObject);
+
     virtual uint64_t
     getSize_(const Namespace&,
              const std::string& name) = 0;
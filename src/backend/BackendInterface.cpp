@@ -330,6 +330,35 @@ BackendInterface::remove(const std::string& name,
                              may_not_exist);
 }
 
+void
+BackendInterface::remove_objects(const std::vector<std::string>& names,
+                                 const ObjectMayNotExist may_not_exist,
+                                 const BackendRequestParameters& params)
+{
+    wrap_<void,
+          decltype(names),
+          ObjectMayNotExist>(params,
+                             &BackendConnectionInterface::remove_objects,
+                             names,
+                             may_not_exist);
+}
+
+void
+BackendInterface::copy_object_to(const std::string& name,
+                                 const Namespace& dst_nspace,
+                                 const OverwriteObject overwrite,
+                                 const BackendRequestParameters& params)
+{
+    wrap_<void,
+          decltype(name),
+          decltype(dst_nspace),
+          OverwriteObject>(params,
+                           &BackendConnectionInterface::copy_object,
+                           name,
+                           dst_nspace,
+                           overwrite);
+}
+
 void
 BackendInterface::partial_read(const BackendConnectionInterface::PartialReads& partial_reads,
                                BackendConnectionInterface::PartialReadFallbackFun& fallback_fun,
@@ -420,6 +449,12 @@ BackendInterface::getNS() const
     return nspace_;
 }
 
+bool
+BackendInterface::has_native_remove_objects()
+{
+    return conn_manager_->getConnection()->has_native_remove_objects();
+}
+
 bool
 BackendInterface::hasExtendedApi()
 {
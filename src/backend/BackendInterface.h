@@ -101,6 +101,22 @@ public:
            const ObjectMayNotExist = ObjectMayNotExist::F,
            const BackendRequestParameters& = default_request_parameters());
 
+    void
+    remove_objects(const std::vector<std::string>& names,
+                   const ObjectMayNotExist = ObjectMayNotExist::F,
+                   const BackendRequestParameters& = default_request_parameters());
+
+    bool
+    has_native_remove_objects();
+
+    // Copies the object to `dst_nspace' on the same backend, server side where
+    // the backend supports it.
+    void
+    copy_object_to(const std::string& name,
+                   const Namespace& dst_nspace,
+                   const OverwriteObject = OverwriteObject::F,
+                   const BackendRequestParameters& = default_request_parameters());
+
     BackendInterfacePtr
     clone() const;
 
@@ -287,6 +287,34 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(s3_connection_strict_consistency,
                                       ShowDocumentation::F,
                                       false);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedged_reads,
+                                      backend_connection_manager_name,
+                                      "multi_connection_hedged_reads",
+                                      "When backend_type is MULTI: issue a read to a second backend if the first one does not answer within the hedge delay",
+                                      ShowDocumentation::T,
+                                      false);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedge_percentile,
+                                      backend_connection_manager_name,
+                                      "multi_connection_hedge_percentile",
+                                      "When backend_type is MULTI: latency percentile of the preferred backend after which a hedged read is issued",
+                                      ShowDocumentation::T,
+                                      95);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedge_min_delay_usecs,
+                                      backend_connection_manager_name,
+                                      "multi_connection_hedge_min_delay_usecs",
+                                      "When backend_type is MULTI: lower bound of the delay (in microseconds) before a hedged read is issued",
+                                      ShowDocumentation::T,
+                                      1000);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_prefer_fastest_for_writes,
+                                      backend_connection_manager_name,
+                                      "multi_connection_prefer_fastest_for_writes",
+                                      "When backend_type is MULTI: direct writes to the backend with the lowest observed latency instead of the current one",
+                                      ShowDocumentation::T,
+                                      false);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_host,
                                       backend_connection_manager_name,
                                       "alba_connection_host",
@@ -86,6 +86,11 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(s3_connection_ssl_cert_file, std::string)
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(s3_connection_flavour, backend::S3Flavour);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(s3_connection_strict_consistency, bool);
 
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedged_reads, bool);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedge_percentile, uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_hedge_min_delay_usecs, uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(multi_connection_prefer_fastest_for_writes, bool);
+
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_host, std::string);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_port, uint16_t);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_timeout, uint16_t);
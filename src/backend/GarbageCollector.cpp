@@ -82,39 +82,41 @@ struct BarrierTask
     std::string nspace;
 };
 
-struct DeleteObjectTask
+// Removes a batch of objects of a namespace with a single remove_objects call
+// which lets backends that support it delete them in bulk.
+struct DeleteObjectsTask
     : public GarbageCollector::ThreadPool::Task
 {
-    DeleteObjectTask(BackendConnectionManagerPtr c,
-                     const std::string& n,
-                     std::string o)
+    DeleteObjectsTask(BackendConnectionManagerPtr c,
+                      const std::string& n,
+                      std::vector<std::string> o)
         : GarbageCollector::ThreadPool::Task(yt::BarrierTask::F)
         , cm(c)
         , nspace(n)
-        , object_name(std::move(o))
+        , object_names(std::move(o))
     {}
 
-    virtual ~DeleteObjectTask() = default;
+    virtual ~DeleteObjectsTask() = default;
 
     void
     run(int /* thread id */) override final
     {
         try
         {
-            cm->newBackendInterface(Namespace(nspace))->remove(object_name,
-                                                               ObjectMayNotExist::T);
+            cm->newBackendInterface(Namespace(nspace))->remove_objects(object_names,
+                                                                       ObjectMayNotExist::T);
         }
         catch (BackendNamespaceDoesNotExistException&)
         {
-            LOG_ERROR(nspace << "/" << object_name <<
-                      ": namespace does not exist (anymore?) - ignoring it");
+            LOG_ERROR(nspace << ": namespace does not exist (anymore?) - ignoring " <<
+                      object_names.size() << " objects");
         }
     }
 
     const std::string&
     getName() const override final
     {
-        static const std::string s("GarbageCollectorDeleteObjectTask");
+        static const std::string s("GarbageCollectorDeleteObjectsTask");
         return s;
     }
 
@@ -126,21 +128,76 @@ struct DeleteObjectTask
 
     BackendConnectionManagerPtr cm;
     const std::string nspace;
-    const std::string object_name;
+    const std::vector<std::string> object_names;
 };
 
 }
 
+bool
+GarbageCollector::native_remove_objects_()
+{
+    try
+    {
+        return cm_->getConnection()->has_native_remove_objects();
+    }
+    CATCH_STD_ALL_LOG_IGNORE("Failed to determine whether the backend supports bulk removal");
+
+    return false;
+}
+
+size_t
+GarbageCollector::batch_size_(size_t nobjects,
+                              bool native_remove_objects,
+                              size_t nthreads)
+{
+    if (native_remove_objects)
+    {
+        return max_batch_size;
+    }
+    else
+    {
+        nthreads = std::max<size_t>(nthreads,
+                                    1);
+        return std::max<size_t>(std::min<size_t>((nobjects + nthreads - 1) / nthreads,
+                                                 max_batch_size),
+                                1);
+    }
+}
+
 void
 GarbageCollector::queue(Garbage garbage)
 {
-    for (auto&& g : garbage.object_names)
+    queue_(std::move(garbage),
+           native_remove_objects_());
+}
+
+size_t
+GarbageCollector::queue_(Garbage garbage,
+                         bool native_remove_objects)
+{
+    const size_t batch_size = batch_size_(garbage.object_names.size(),
+                                          native_remove_objects,
+                                          thread_pool_.getNumThreads());
+    size_t nbatches = 0;
+    auto it = garbage.object_names.begin();
+
+    while (it != garbage.object_names.end())
     {
-        std::unique_ptr<ThreadPool::Task> t(new DeleteObjectTask(cm_,
-                                                                 garbage.nspace.str(),
-                                                                 std::move(g)));
+        const size_t n = std::min<size_t>(batch_size,
+                                          garbage.object_names.end() - it);
+
+        std::vector<std::string> batch(std::make_move_iterator(it),
+                                       std::make_move_iterator(it + n));
+        it += n;
+
+        std::unique_ptr<ThreadPool::Task> t(new DeleteObjectsTask(cm_,
+                                                                  garbage.nspace.str(),
+                                                                  std::move(batch)));
         thread_pool_.addTask(std::move(t));
+        ++nbatches;
     }
+
+    return nbatches;
 }
 
 std::future<bool>
@@ -112,11 +112,30 @@ public:
     using ThreadPool = youtils::ThreadPool<std::string,
                                            GarbageCollectorThreadPoolTraits>;
 
+    // Upper bound of the number of objects removed by a single task / call to
+    // BackendInterface::remove_objects (cf. S3's DeleteObjects limit). Backends
+    // without a native remove_objects get a share of the garbage per bgc thread
+    // instead, so they keep removing objects in parallel.
+    static const size_t max_batch_size = 1000;
+
 private:
     DECLARE_LOGGER("GarbageCollector");
 
     backend::BackendConnectionManagerPtr cm_;
     ThreadPool thread_pool_;
+
+    bool
+    native_remove_objects_();
+
+    static size_t
+    batch_size_(size_t nobjects,
+                bool native_remove_objects,
+                size_t nthreads);
+
+    // Returns the number of batches the garbage was split into.
+    size_t
+    queue_(Garbage,
+           bool native_remove_objects);
 };
 
 }
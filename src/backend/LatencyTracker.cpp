@@ -0,0 +1,92 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LatencyTracker.h"
+
+#include <algorithm>
+
+#include <youtils/Assert.h>
+
+namespace backend
+{
+
+LatencyTracker::LatencyTracker(size_t window,
+                               size_t min_samples)
+    : window_(window, 0)
+    , next_(0)
+    , count_(0)
+    , min_samples_(std::min(std::max(min_samples,
+                                     static_cast<size_t>(1)),
+                            window))
+{
+    VERIFY(window > 0);
+}
+
+void
+LatencyTracker::record(const Duration& d)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    window_[next_] = d.count();
+    next_ = (next_ + 1) % window_.size();
+    count_ = std::min(count_ + 1, window_.size());
+}
+
+boost::optional<LatencyTracker::Duration>
+LatencyTracker::percentile(double p) const
+{
+    std::vector<Duration::rep> v;
+
+    {
+        boost::lock_guard<decltype(lock_)> g(lock_);
+        if (count_ < min_samples_)
+        {
+            return boost::none;
+        }
+
+        v.assign(window_.begin(),
+                 window_.begin() + count_);
+    }
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    const size_t idx = std::min(static_cast<size_t>(p * v.size() / 100.0),
+                                v.size() - 1);
+
+    std::nth_element(v.begin(),
+                     v.begin() + idx,
+                     v.end());
+
+    return Duration(v[idx]);
+}
+
+size_t
+LatencyTracker::samples() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return count_;
+}
+
+void
+LatencyTracker::clear()
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    next_ = 0;
+    count_ = 0;
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,78 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_LATENCY_TRACKER_H_
+#define BACKEND_LATENCY_TRACKER_H_
+
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace backend
+{
+
+// Keeps a window of the most recent request latencies of a backend (connection)
+// and derives percentiles from it. Used by the MULTI backend to pick the fastest
+// sub-backend and to decide when to hedge a request.
+class LatencyTracker
+{
+public:
+    using Clock = boost::chrono::steady_clock;
+    using Duration = boost::chrono::microseconds;
+
+    explicit LatencyTracker(size_t window = 256,
+                            size_t min_samples = 16);
+
+    ~LatencyTracker() = default;
+
+    LatencyTracker(const LatencyTracker&) = delete;
+
+    LatencyTracker&
+    operator=(const LatencyTracker&) = delete;
+
+    void
+    record(const Duration&);
+
+    // boost::none if there are fewer than min_samples samples
+    boost::optional<Duration>
+    percentile(double p) const;
+
+    size_t
+    samples() const;
+
+    void
+    clear();
+
+private:
+    DECLARE_LOGGER("LatencyTracker");
+
+    mutable boost::mutex lock_;
+    std::vector<Duration::rep> window_;
+    size_t next_;
+    size_t count_;
+    const size_t min_samples_;
+};
+
+}
+
+#endif // !BACKEND_LATENCY_TRACKER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
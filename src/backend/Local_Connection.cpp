@@ -14,6 +14,12 @@
 
 #include "Local_Connection.h"
 
+#include <cerrno>
+#include <cstring>
+#include <future>
+
+#include <unistd.h>
+
 #include <boost/filesystem/fstream.hpp>
 
 #include <youtils/Assert.h>
@@ -202,6 +208,90 @@ Connection::write_(const Namespace& nspace,
     }
 }
 
+void
+Connection::copy_object_(const Namespace& src_nspace,
+                         const std::string& name,
+                         const Namespace& dst_nspace,
+                         const OverwriteObject overwrite)
+{
+    nanosleep(&timespec_, 0);
+
+    const fs::path src(objectPath_(src_nspace, name));
+    const fs::path dst(objectPath_(dst_nspace, name));
+
+    if (not fs::exists(src))
+    {
+        if (not namespaceExists_(src_nspace))
+        {
+            throw BackendNamespaceDoesNotExistException();
+        }
+        throw BackendObjectDoesNotExistException();
+    }
+
+    if (not namespaceExists_(dst_nspace))
+    {
+        throw BackendNamespaceDoesNotExistException();
+    }
+
+    const bool pre_exists = fs::exists(dst);
+
+    if (pre_exists and F(overwrite))
+    {
+        LOG_ERROR("Target already in backend " << dst);
+        throw BackendOverwriteNotAllowedException();
+    }
+
+    // Objects are never modified in place (cf. write_), so source and
+    // destination can share the inode. Link to a temp name first and rename it
+    // into place to keep the replacement atomic, like safe_copy does.
+    fs::path tmp;
+    try
+    {
+        tmp = yt::FileUtils::create_temp_file(dst);
+        fs::remove(tmp);
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERROR("Failed to create temp file for " << dst << ": " << e.what());
+        throw BackendStoreException();
+    }
+
+    if (::link(src.string().c_str(),
+               tmp.string().c_str()) != 0)
+    {
+        const int err = errno;
+        LOG_WARN("Failed to hardlink " << src << " -> " << tmp << ": " <<
+                 strerror(err) << " - falling back to copying");
+        return write_(dst_nspace,
+                      src,
+                      name,
+                      overwrite);
+    }
+
+    try
+    {
+        if (T(sync_object_after_write_))
+        {
+            yt::FileDescriptor f(tmp, yt::FDMode::Read);
+            f.sync();
+        }
+
+        fs::rename(tmp, dst);
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERROR("Failed to sync / rename " << tmp << " -> " << dst << ": " << e.what());
+        fs::remove(tmp);
+        throw BackendStoreException();
+    }
+
+    if (pre_exists)
+    {
+        lruCache().erase_no_evict(dst);
+    }
+
+    LOG_DEBUG("linked " << src << " -> " << dst);
+}
 
 bool
 Connection::objectExists_(const Namespace& nspace,
@@ -251,6 +341,112 @@ Connection::remove_(const Namespace& nspace,
     }
 }
 
+void
+Connection::remove_objects_(const Namespace& nspace,
+                            const std::vector<std::string>& names,
+                            const ObjectMayNotExist may_not_exist)
+{
+    if (not namespaceExists_(nspace))
+    {
+        throw BackendNamespaceDoesNotExistException();
+    }
+
+    // returns the number of objects that did not exist
+    auto fun([&](size_t begin,
+                 size_t end) -> size_t
+             {
+                 size_t missing = 0;
+
+                 for (size_t i = begin; i < end; ++i)
+                 {
+                     const fs::path p(objectPath_(nspace,
+                                                  names[i]));
+                     LOG_TRACE("removing " << p);
+
+                     if (::unlink(p.string().c_str()) == 0)
+                     {
+                         lruCache().erase_no_evict(p);
+                     }
+                     else
+                     {
+                         const int err = errno;
+                         if (err == ENOENT)
+                         {
+                             LOG_TRACE("*not* removing " << p <<
+                                       " as it doesn't appear to exist");
+                             ++missing;
+                         }
+                         else
+                         {
+                             LOG_ERROR("Failed to remove " << p << ": " <<
+                                       strerror(err));
+                             throw BackendException(strerror(err));
+                         }
+                     }
+                 }
+
+                 return missing;
+             });
+
+    const size_t nthreads =
+        std::max<size_t>(1,
+                         std::min(max_remove_threads,
+                                  names.size() / remove_objects_per_thread));
+    const size_t chunk = (names.size() + nthreads - 1) / nthreads;
+
+    std::vector<std::future<size_t>> futures;
+    futures.reserve(nthreads - 1);
+
+    for (size_t i = 1; i < nthreads; ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async,
+                                        fun,
+                                        std::min(i * chunk, names.size()),
+                                        std::min((i + 1) * chunk, names.size())));
+    }
+
+    size_t missing = 0;
+    std::exception_ptr eptr;
+
+    try
+    {
+        missing += fun(0,
+                       std::min(chunk, names.size()));
+    }
+    catch (...)
+    {
+        eptr = std::current_exception();
+    }
+
+    // wait for all of them before bailing out as they refer to our stack
+    for (auto& f : futures)
+    {
+        try
+        {
+            missing += f.get();
+        }
+        catch (...)
+        {
+            if (not eptr)
+            {
+                eptr = std::current_exception();
+            }
+        }
+    }
+
+    if (eptr)
+    {
+        std::rethrow_exception(eptr);
+    }
+
+    if (missing != 0 and F(may_not_exist))
+    {
+        LOG_ERROR(nspace << ": " << missing << " of " << names.size() <<
+                  " objects to remove did not exist");
+        throw BackendObjectDoesNotExistException();
+    }
+}
+
 void
 Connection::deleteNamespace_(const Namespace& nspace)
 {
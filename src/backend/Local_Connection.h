@@ -116,6 +116,23 @@ public:
             const std::string& name,
             const ObjectMayNotExist) override final;
 
+    virtual void
+    remove_objects_(const Namespace& nspace,
+                    const std::vector<std::string>& names,
+                    const ObjectMayNotExist) override final;
+
+    virtual bool
+    has_native_remove_objects_() const override final
+    {
+        return true;
+    }
+
+    virtual void
+    copy_object_(const Namespace& src_nspace,
+                 const std::string& name,
+                 const Namespace& dst_nspace,
+                 const OverwriteObject) override final;
+
     virtual uint64_t
     getSize_(const Namespace& nspace,
              const std::string& name) override final;
@@ -202,6 +219,11 @@ public:
 
     const static size_t lru_cache_size = 32;
 
+    // remove_objects_ unlinks in parallel, using a thread per this many objects
+    // (up to max_remove_threads).
+    const static size_t remove_objects_per_thread = 256;
+    const static size_t max_remove_threads = 8;
+
 private:
     // CryptoPP::Weak::MD5 md5_;
 
@@ -31,8 +31,16 @@ class MultiConfig
     DECLARE_LOGGER("MultiConfig");
 
 public:
-    MultiConfig(const std::vector<std::unique_ptr<BackendConfig>>& configs)
+    MultiConfig(const std::vector<std::unique_ptr<BackendConfig>>& configs,
+                const bool hedged_reads = false,
+                const uint32_t hedge_percentile = 95,
+                const uint32_t hedge_min_delay_usecs = 1000,
+                const bool prefer_fastest_for_writes = false)
         : BackendConfig(BackendType::MULTI)
+        , multi_connection_hedged_reads(hedged_reads)
+        , multi_connection_hedge_percentile(hedge_percentile)
+        , multi_connection_hedge_min_delay_usecs(hedge_min_delay_usecs)
+        , multi_connection_prefer_fastest_for_writes(prefer_fastest_for_writes)
     {
         // SOME VALUE TO STOP THE COMPILER FROM COMPLAINING
         BackendType backend_type = BackendType::MULTI;
@@ -60,6 +68,10 @@ public:
 
     MultiConfig(const boost::property_tree::ptree& pt)
         : BackendConfig(BackendType::MULTI)
+        , multi_connection_hedged_reads(pt)
+        , multi_connection_hedge_percentile(pt)
+        , multi_connection_hedge_min_delay_usecs(pt)
+        , multi_connection_prefer_fastest_for_writes(pt)
     {
         const boost::property_tree::ptree& backend_connection_manager = pt.get_child("backend_connection_manager");
         int index = 0;
@@ -136,7 +148,11 @@ public:
     clone() const override final
     {
         std::unique_ptr<BackendConfig>
-            bc(new MultiConfig(configs_));
+            bc(new MultiConfig(configs_,
+                               multi_connection_hedged_reads.value(),
+                               multi_connection_hedge_percentile.value(),
+                               multi_connection_hedge_min_delay_usecs.value(),
+                               multi_connection_prefer_fastest_for_writes.value()));
 
         return bc;
     }
@@ -147,6 +163,15 @@ public:
     {
         putBackendType(pt,
                        reportDefault);
+        multi_connection_hedged_reads.persist(pt,
+                                              reportDefault);
+        multi_connection_hedge_percentile.persist(pt,
+                                                  reportDefault);
+        multi_connection_hedge_min_delay_usecs.persist(pt,
+                                                       reportDefault);
+        multi_connection_prefer_fastest_for_writes.persist(pt,
+                                                           reportDefault);
+
         boost::property_tree::ptree& backend_tree =
             pt.get_child(std::string(initialized_params::backend_connection_manager_name));
 
@@ -171,8 +196,18 @@ public:
     virtual bool
     operator==(const BackendConfig& other) const override final
     {
-        return other.backend_type.value() == BackendType::MULTI and
-            all_configs_equal(static_cast<const MultiConfig&>(other));
+        if (other.backend_type.value() != BackendType::MULTI)
+        {
+            return false;
+        }
+
+        const MultiConfig& o = static_cast<const MultiConfig&>(other);
+        return
+            o.multi_connection_hedged_reads.value() == multi_connection_hedged_reads.value() and
+            o.multi_connection_hedge_percentile.value() == multi_connection_hedge_percentile.value() and
+            o.multi_connection_hedge_min_delay_usecs.value() == multi_connection_hedge_min_delay_usecs.value() and
+            o.multi_connection_prefer_fastest_for_writes.value() == multi_connection_prefer_fastest_for_writes.value() and
+            all_configs_equal(o);
     }
 
     virtual bool
@@ -184,6 +219,11 @@ public:
 
     std::vector<std::unique_ptr<BackendConfig> > configs_;
 
+    DECLARE_PARAMETER(multi_connection_hedged_reads);
+    DECLARE_PARAMETER(multi_connection_hedge_percentile);
+    DECLARE_PARAMETER(multi_connection_hedge_min_delay_usecs);
+    DECLARE_PARAMETER(multi_connection_prefer_fastest_for_writes);
+
 private:
     bool
     all_configs_equal(const MultiConfig& other) const
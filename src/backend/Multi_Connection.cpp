@@ -15,40 +15,573 @@
 #include "Multi_Connection.h"
 #include "Local_Connection.h"
 
+#include <deque>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <youtils/Catchers.h>
+#include <youtils/System.h>
+
 namespace backend
 {
 namespace multi
 {
+
+namespace bc = boost::chrono;
+namespace yt = youtils;
+
+// Not const as XTest messes with it
+size_t
+Connection::hedge_threads =
+    yt::System::get_env_with_default<size_t>("MULTI_BACKEND_HEDGE_THREADS",
+                                             32);
+
+struct HedgedRequest
+{
+    virtual ~HedgedRequest() = default;
+
+    virtual bool
+    run(BackendConnectionInterface&) = 0;
+
+    virtual void
+    commit() = 0;
+};
+
+struct HedgeState
+{
+    explicit HedgeState(size_t nbackends)
+        : busy(nbackends, false)
+    {}
+
+    boost::mutex lock;
+    boost::condition_variable cond;
+    size_t running = 0;
+    // indexed like Connection::backends_: attempts still using the connection
+    std::vector<bool> busy;
+    bool done = false;
+    bool result = false;
+    std::shared_ptr<HedgedRequest> winner;
+    // a logical error (e.g. the object does not exist) ends the request
+    std::exception_ptr error;
+};
+
+namespace
+{
+
+DECLARE_LOGGER("MultiConnectionHedging");
+
+// Runs the hedged attempts of all connections on a fixed number of threads.
+// Attempts are never queued: if no thread is idle the caller has to do without
+// hedging, so a slow backend does not pile up threads.
+class HedgePool
+{
+public:
+    explicit HedgePool(size_t nthreads)
+    {
+        threads_.reserve(nthreads);
+        for (size_t i = 0; i < nthreads; ++i)
+        {
+            threads_.emplace_back([this]
+                                  {
+                                      work_();
+                                  });
+        }
+    }
+
+    ~HedgePool()
+    {
+        {
+            boost::lock_guard<decltype(lock_)> g(lock_);
+            stop_ = true;
+        }
+
+        cond_.notify_all();
+
+        for (auto& t : threads_)
+        {
+            t.join();
+        }
+    }
+
+    HedgePool(const HedgePool&) = delete;
+
+    HedgePool&
+    operator=(const HedgePool&) = delete;
+
+    static HedgePool&
+    get()
+    {
+        static HedgePool pool(std::max<size_t>(Connection::hedge_threads,
+                                               1));
+        return pool;
+    }
+
+    // fun must not throw.
+    bool
+    try_run(std::function<void()> fun)
+    {
+        boost::lock_guard<decltype(lock_)> g(lock_);
+        if (tasks_.size() >= idle_)
+        {
+            return false;
+        }
+
+        tasks_.emplace_back(std::move(fun));
+        cond_.notify_one();
+        return true;
+    }
+
+private:
+    boost::mutex lock_;
+    boost::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_;
+    size_t idle_ = 0;
+    bool stop_ = false;
+    std::vector<boost::thread> threads_;
+
+    void
+    work_()
+    {
+        while (true)
+        {
+            std::function<void()> fun;
+
+            {
+                boost::unique_lock<decltype(lock_)> u(lock_);
+                ++idle_;
+                cond_.wait(u,
+                           [&]
+                           {
+                               return stop_ or not tasks_.empty();
+                           });
+                --idle_;
+
+                if (tasks_.empty())
+                {
+                    return;
+                }
+
+                fun = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            fun();
+        }
+    }
+};
+
+// Every attempt reads into its own temp file next to the destination, the
+// winner's is renamed to the destination.
+struct HedgedRead
+    : public HedgedRequest
+{
+    HedgedRead(const Namespace& ns,
+               const fs::path& d,
+               const std::string& n,
+               const InsistOnLatestVersion i)
+        : nspace(ns)
+        , dst(d)
+        , tmp(fs::unique_path(d.string() + ".hedged-%%%%-%%%%-%%%%"))
+        , name(n)
+        , insist_on_latest(i)
+    {}
+
+    ~HedgedRead()
+    {
+        try
+        {
+            fs::remove(tmp);
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to remove " << tmp);
+    }
+
+    bool
+    run(BackendConnectionInterface& conn) override final
+    {
+        conn.read(nspace,
+                  tmp,
+                  name,
+                  insist_on_latest);
+        return true;
+    }
+
+    void
+    commit() override final
+    {
+        fs::rename(tmp,
+                   dst);
+    }
+
+    const Namespace nspace;
+    const fs::path dst;
+    const fs::path tmp;
+    const std::string name;
+    const InsistOnLatestVersion insist_on_latest;
+};
+
+// Every attempt reads into its own buffer, the winner's contents are copied to
+// the caller's slices.
+struct HedgedPartialRead
+    : public HedgedRequest
+{
+    using PartialReads = BackendConnectionInterface::PartialReads;
+    using ObjectSlice = BackendConnectionInterface::ObjectSlice;
+    using ObjectSlices = BackendConnectionInterface::ObjectSlices;
+
+    HedgedPartialRead(const Namespace& ns,
+                      const PartialReads& preads,
+                      const InsistOnLatestVersion i)
+        : nspace(ns)
+        , caller_reads(preads)
+        , insist_on_latest(i)
+        , ok(false)
+    {
+        size_t size = 0;
+        for (const auto& p : caller_reads)
+        {
+            for (const auto& slice : p.second)
+            {
+                size += slice.size;
+            }
+        }
+
+        buf.resize(size);
+        byte* b = buf.data();
+
+        for (const auto& p : caller_reads)
+        {
+            ObjectSlices slices;
+            for (const auto& slice : p.second)
+            {
+                slices.emplace(slice.size,
+                               slice.offset,
+                               b);
+                b += slice.size;
+            }
+
+            reads.emplace(p.first,
+                          std::move(slices));
+        }
+    }
+
+    ~HedgedPartialRead() = default;
+
+    bool
+    run(BackendConnectionInterface& conn) override final
+    {
+        ok = conn.partial_read_(nspace,
+                                reads,
+                                insist_on_latest);
+        return ok;
+    }
+
+    void
+    commit() override final
+    {
+        if (ok)
+        {
+            auto it = reads.begin();
+            for (const auto& p : caller_reads)
+            {
+                VERIFY(it != reads.end());
+                VERIFY(it->first == p.first);
+                VERIFY(it->second.size() == p.second.size());
+
+                auto sit = it->second.begin();
+                for (const auto& slice : p.second)
+                {
+                    memcpy(slice.buf,
+                           sit->buf,
+                           slice.size);
+                    ++sit;
+                }
+
+                ++it;
+            }
+        }
+    }
+
+    const Namespace nspace;
+    // The buffers of the caller_reads must only be accessed in commit().
+    const PartialReads caller_reads;
+    PartialReads reads;
+    const InsistOnLatestVersion insist_on_latest;
+    std::vector<byte> buf;
+    bool ok;
+};
+
+}
+
 Connection::Connection(const config_type& cfg)
+    : hedged_reads_(cfg.multi_connection_hedged_reads.value())
+    , hedge_percentile_(cfg.multi_connection_hedge_percentile.value())
+    , hedge_min_delay_(cfg.multi_connection_hedge_min_delay_usecs.value())
+    , prefer_fastest_for_writes_(cfg.multi_connection_prefer_fastest_for_writes.value())
 {
     const std::vector<std::unique_ptr<BackendConfig> >& configs = cfg.configs_;
 
     for(size_t i = 0; i < configs.size(); ++i)
     {
-        const BackendConfig* config = configs[i].get();
-        switch (config->backend_type.value())
+        backends_.push_back(make_backend_(*configs[i]));
+        configs_.push_back(configs[i]->clone());
+        latencies_.push_back(std::make_shared<LatencyTracker>());
+    }
+    current_iterator_ = backends_.begin();
+
+}
+
+Connection::~Connection() = default;
+
+Connection::BackendPtr
+Connection::make_backend_(const BackendConfig& config)
+{
+    switch (config.backend_type.value())
+    {
+    case BackendType::LOCAL:
+        {
+            const LocalConfig* config_tmp(dynamic_cast<const LocalConfig*>(&config));
+            return std::make_shared<local::Connection>(*config_tmp);
+        }
+    default:
+        throw "backend type not supported in MULTI backend";
+    }
+}
+
+void
+Connection::record_latency_(size_t idx,
+                            const LatencyTracker::Clock::time_point& start)
+{
+    latencies_[idx]->record(bc::duration_cast<LatencyTracker::Duration>(LatencyTracker::Clock::now() -
+                                                                        start));
+}
+
+boost::optional<size_t>
+Connection::fastest_(const boost::optional<size_t>& exclude) const
+{
+    boost::optional<size_t> res;
+    boost::optional<LatencyTracker::Duration> best;
+
+    for (size_t i = 0; i < latencies_.size(); ++i)
+    {
+        if (exclude and *exclude == i)
+        {
+            continue;
+        }
+
+        const boost::optional<LatencyTracker::Duration> l(latencies_[i]->percentile(50));
+        if (l and (not best or *l < *best))
+        {
+            best = l;
+            res = i;
+        }
+    }
+
+    return res;
+}
+
+bool
+Connection::launch_hedged_(const std::shared_ptr<HedgeState>& state,
+                           size_t idx,
+                           std::unique_ptr<HedgedRequest> request)
+{
+    // Called with state->lock held, which the attempt needs to report back.
+    auto fun([state,
+              idx,
+              conn = backends_[idx],
+              tracker = latencies_[idx],
+              req = std::shared_ptr<HedgedRequest>(std::move(request))]() mutable
+             {
+                 const LatencyTracker::Clock::time_point start(LatencyTracker::Clock::now());
+                 bool ok = false;
+                 bool res = false;
+                 std::exception_ptr error;
+
+                 try
+                 {
+                     res = req->run(*conn);
+                     ok = true;
+                     tracker->record(bc::duration_cast<LatencyTracker::Duration>(LatencyTracker::Clock::now() -
+                                                                                 start));
+                 }
+                 // The backend did answer, so these are no reason to hedge or
+                 // to distrust its latency.
+                 catch (BackendObjectDoesNotExistException&)
+                 {
+                     error = std::current_exception();
+                 }
+                 catch (BackendNamespaceDoesNotExistException&)
+                 {
+                     error = std::current_exception();
+                 }
+                 catch (BackendNotImplementedException&)
+                 {
+                     error = std::current_exception();
+                 }
+                 CATCH_STD_ALL_EWHAT({
+                         LOG_WARN("Hedged request on backend " << idx <<
+                                  " failed: " << EWHAT);
+                         // forget about its latency until it proves to be working again
+                         tracker->clear();
+                     });
+
+                 boost::lock_guard<decltype(state->lock)> g(state->lock);
+                 --state->running;
+                 state->busy[idx] = false;
+                 if (not state->done)
+                 {
+                     if (ok)
+                     {
+                         state->done = true;
+                         state->result = res;
+                         state->winner = std::move(req);
+                     }
+                     else if (error)
+                     {
+                         state->done = true;
+                         state->error = error;
+                     }
+                 }
+
+                 state->cond.notify_all();
+             });
+
+    if (HedgePool::get().try_run(std::move(fun)))
+    {
+        ++state->running;
+        state->busy[idx] = true;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+void
+Connection::replace_busy_backends_(const std::vector<bool>& busy)
+{
+    // Sub-connections are not meant to be used concurrently, so the ones that
+    // are still in use by straggling hedged requests are replaced.
+    for (size_t i = 0; i < backends_.size(); ++i)
+    {
+        if (busy[i])
         {
-        case BackendType::LOCAL:
+            try
+            {
+                backends_[i] = make_backend_(*configs_[i]);
+            }
+            CATCH_STD_ALL_LOG_IGNORE("Failed to replace busy backend connection " << i);
+        }
+    }
+}
+
+boost::optional<bool>
+Connection::hedged_(const std::function<std::unique_ptr<HedgedRequest>()>& make_request)
+{
+    if (not hedged_reads_ or
+        backends_.size() < 2 or
+        not maybe_switch_back_to_default())
+    {
+        return boost::none;
+    }
+
+    const size_t primary = fastest_().value_or(current_index_());
+    const boost::optional<LatencyTracker::Duration>
+        p(latencies_[primary]->percentile(hedge_percentile_));
+
+    if (not p)
+    {
+        // not enough samples yet - the regular path will provide them
+        return boost::none;
+    }
+
+    const size_t secondary =
+        fastest_(primary).value_or((primary + 1) % backends_.size());
+    const LatencyTracker::Clock::time_point
+        deadline(LatencyTracker::Clock::now() + std::max(*p,
+                                                         hedge_min_delay_));
+
+    auto state(std::make_shared<HedgeState>(backends_.size()));
+    std::shared_ptr<HedgedRequest> winner;
+    bool result = false;
+    std::exception_ptr error;
+    std::vector<bool> busy;
+
+    {
+        boost::unique_lock<decltype(state->lock)> u(state->lock);
+
+        if (not launch_hedged_(state,
+                               primary,
+                               make_request()))
+        {
+            LOG_DEBUG("All hedging threads are busy, not hedging");
+            return boost::none;
+        }
+
+        while (not state->done and state->running > 0)
+        {
+            if (state->cond.wait_until(u, deadline) == boost::cv_status::timeout)
             {
-                const LocalConfig* config_tmp(dynamic_cast<const LocalConfig*>(config));
-                backends_.push_back(new local::Connection(*config_tmp));
                 break;
+            }
+        }
 
+        if (not state->done)
+        {
+            if (launch_hedged_(state,
+                               secondary,
+                               make_request()))
+            {
+                LOG_INFO("Backend " << primary <<
+                         " did not respond in time, hedged with backend " << secondary);
+                ++hedged_requests_;
+            }
+            else
+            {
+                LOG_INFO("Backend " << primary <<
+                         " did not respond in time but all hedging threads are busy");
+            }
+
+            while (not state->done and state->running > 0)
+            {
+                state->cond.wait(u);
             }
-        default:
-            throw "backend type not supported in MULTI backend";
         }
+
+        winner = std::move(state->winner);
+        result = state->result;
+        error = state->error;
+        busy = state->busy;
     }
-    current_iterator_ = backends_.begin();
 
+    replace_busy_backends_(busy);
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    if (winner)
+    {
+        winner->commit();
+        return result;
+    }
+    else
+    {
+        LOG_WARN("All hedged requests failed, falling back to regular failover");
+        return boost::none;
+    }
 }
 
-Connection::~Connection()
+bool
+Connection::has_native_remove_objects_() const
 {
-    for(unsigned i = 0; i < backends_.size(); ++i)
+    if(current_iterator_ != backends_.end())
     {
-        delete backends_[i];
+        return (*current_iterator_)->has_native_remove_objects();
     }
+    throw BackendNoMultiBackendAvailableException();
 }
 
 bool
@@ -149,15 +682,31 @@ Connection::read_(const Namespace& nspace,
                   const std::string& name,
                   InsistOnLatestVersion insist_on_latest_version)
 {
+    const boost::optional<bool> hedged(hedged_([&]() -> std::unique_ptr<HedgedRequest>
+                                               {
+                                                   return std::make_unique<HedgedRead>(nspace,
+                                                                                       dst,
+                                                                                       name,
+                                                                                       insist_on_latest_version);
+                                               }));
+    if (hedged)
+    {
+        return;
+    }
+
     iterator_t start_iterator = current_iterator_;
     while(maybe_switch_back_to_default())
     {
         try
         {
-            return (*current_iterator_)->read(nspace,
-                                              dst,
-                                              name,
-                                              insist_on_latest_version);
+            const LatencyTracker::Clock::time_point start(LatencyTracker::Clock::now());
+            (*current_iterator_)->read(nspace,
+                                       dst,
+                                       name,
+                                       insist_on_latest_version);
+            record_latency_(current_index_(),
+                            start);
+            return;
         }
         catch(BackendNotImplementedException)
         {
@@ -187,14 +736,29 @@ Connection::partial_read_(const Namespace& nspace,
                           const PartialReads& partial_reads,
                           InsistOnLatestVersion insist)
 {
+    const boost::optional<bool> hedged(hedged_([&]() -> std::unique_ptr<HedgedRequest>
+                                               {
+                                                   return std::make_unique<HedgedPartialRead>(nspace,
+                                                                                              partial_reads,
+                                                                                              insist);
+                                               }));
+    if (hedged)
+    {
+        return *hedged;
+    }
+
     iterator_t start_iterator = current_iterator_;
     while(maybe_switch_back_to_default())
     {
         try
         {
-            return (*current_iterator_)->partial_read_(nspace,
-                                                       partial_reads,
-                                                       insist);
+            const LatencyTracker::Clock::time_point start(LatencyTracker::Clock::now());
+            const bool res = (*current_iterator_)->partial_read_(nspace,
+                                                                 partial_reads,
+                                                                 insist);
+            record_latency_(current_index_(),
+                            start);
+            return res;
         }
         catch(BackendObjectDoesNotExistException)
         {
@@ -218,16 +782,58 @@ Connection::write_(const Namespace& nspace,
                    OverwriteObject overwrite,
                    const youtils::CheckSum* chksum)
 {
+    if (prefer_fastest_for_writes_ and maybe_switch_back_to_default())
+    {
+        const boost::optional<size_t> fastest(fastest_());
+        if (fastest and *fastest != current_index_())
+        {
+            try
+            {
+                const LatencyTracker::Clock::time_point start(LatencyTracker::Clock::now());
+                backends_[*fastest]->write(nspace,
+                                           src,
+                                           name,
+                                           overwrite,
+                                           chksum);
+                record_latency_(*fastest,
+                                start);
+                return;
+            }
+            catch(BackendNotImplementedException)
+            {
+                throw;
+            }
+            catch(BackendNamespaceAlreadyExistsException&)
+            {
+                throw;
+            }
+            catch(BackendObjectDoesNotExistException)
+            {
+                throw;
+            }
+            catch(std::exception& e)
+            {
+                LOG_WARN("Write to fastest backend " << *fastest << " failed: " <<
+                         e.what() << " - falling back to the current one");
+                latencies_[*fastest]->clear();
+            }
+        }
+    }
+
     iterator_t start_iterator = current_iterator_;
     while(maybe_switch_back_to_default())
     {
         try
         {
-            return (*current_iterator_)->write(nspace,
-                                               src,
-                                               name,
-                                               overwrite,
-                                               chksum);
+            const LatencyTracker::Clock::time_point start(LatencyTracker::Clock::now());
+            (*current_iterator_)->write(nspace,
+                                        src,
+                                        name,
+                                        overwrite,
+                                        chksum);
+            record_latency_(current_index_(),
+                            start);
+            return;
         }
         catch(BackendNotImplementedException)
         {
@@ -324,6 +930,82 @@ Connection::remove_(const Namespace& nspace,
     throw BackendNoMultiBackendAvailableException();
 }
 
+void
+Connection::copy_object_(const Namespace& src_nspace,
+                         const std::string& name,
+                         const Namespace& dst_nspace,
+                         const OverwriteObject overwrite)
+{
+    iterator_t start_iterator = current_iterator_;
+    while(maybe_switch_back_to_default())
+    {
+        try
+        {
+            return (*current_iterator_)->copy_object(src_nspace,
+                                                     name,
+                                                     dst_nspace,
+                                                     overwrite);
+        }
+        catch(BackendNotImplementedException)
+        {
+            throw;
+        }
+        catch(BackendOverwriteNotAllowedException)
+        {
+            throw;
+        }
+        catch(BackendObjectDoesNotExistException)
+        {
+            throw;
+        }
+        catch(std::exception&)
+        {
+            if(update_current_index(start_iterator))
+            {
+                throw;
+            }
+        }
+    }
+    throw BackendNoMultiBackendAvailableException();
+}
+
+void
+Connection::remove_objects_(const Namespace& nspace,
+                            const std::vector<std::string>& names,
+                            const ObjectMayNotExist may_not_exist)
+{
+    iterator_t start_iterator = current_iterator_;
+    while(maybe_switch_back_to_default())
+    {
+        try
+        {
+            return (*current_iterator_)->remove_objects(nspace,
+                                                        names,
+                                                        may_not_exist);
+        }
+        catch(BackendNotImplementedException)
+        {
+            throw;
+        }
+        catch(BackendNamespaceAlreadyExistsException&)
+        {
+            throw;
+        }
+        catch(BackendObjectDoesNotExistException)
+        {
+            throw;
+        }
+        catch(std::exception&)
+        {
+            if(update_current_index(start_iterator))
+            {
+                throw;
+            }
+        }
+    }
+    throw BackendNoMultiBackendAvailableException();
+}
+
 void
 Connection::deleteNamespace_(const Namespace& nspace)
 {
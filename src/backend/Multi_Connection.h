@@ -17,9 +17,14 @@
 
 #include "BackendException.h"
 #include "BackendConnectionInterface.h"
+#include "LatencyTracker.h"
 #include "MultiConfig.h"
 
+#include <functional>
+#include <memory>
+
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 
 #include <youtils/IOException.h>
 #include <youtils/Logging.h>
@@ -31,6 +36,15 @@ namespace multi
 {
 namespace fs = boost::filesystem;
 
+// A (read) request that can be issued to several sub-backends concurrently.
+// Only the result of the first one to succeed is commit()ed; the others are left
+// to complete in the background and clean up after themselves, hence they must
+// not refer to caller owned state.
+// The attempts run on a small process wide pool of threads; requests are not
+// hedged (but issued the regular way) while all of them are busy.
+struct HedgedRequest;
+struct HedgeState;
+
 class Connection
     : public BackendConnectionInterface
 {
@@ -46,6 +60,17 @@ public:
     Connection&
     operator=(const Connection&) = delete;
 
+    // Number of requests that were hedged to a second sub-backend.
+    uint64_t
+    hedged_requests() const
+    {
+        return hedged_requests_;
+    }
+
+    // Size of the pool running the hedged attempts of all connections.
+    // Not const as XTest messes with it (before the first hedged request).
+    static size_t hedge_threads;
+
     virtual void
     listNamespaces_(std::list<std::string>& objects) override final;
 
@@ -105,6 +130,20 @@ public:
             const std::string& name,
             const ObjectMayNotExist) override final;
 
+    virtual void
+    remove_objects_(const Namespace& nspace,
+                    const std::vector<std::string>& names,
+                    const ObjectMayNotExist) override final;
+
+    virtual bool
+    has_native_remove_objects_() const override final;
+
+    virtual void
+    copy_object_(const Namespace& src_nspace,
+                 const std::string& name,
+                 const Namespace& dst_nspace,
+                 const OverwriteObject) override final;
+
     virtual uint64_t
     getSize_(const Namespace& nspace,
              const std::string& name) override final;
@@ -172,12 +211,29 @@ public:
              const youtils::CheckSum* chksum) override final;
 
 private:
-    typedef std::vector<BackendConnectionInterface*>::iterator iterator_t;
-    std::vector<BackendConnectionInterface*> backends_;
-    std::vector<BackendConnectionInterface*>::iterator current_iterator_;
+    using BackendPtr = std::shared_ptr<BackendConnectionInterface>;
+    typedef std::vector<BackendPtr>::iterator iterator_t;
+    std::vector<BackendPtr> backends_;
+    std::vector<BackendPtr>::iterator current_iterator_;
     youtils::wall_timer2 switch_back_timer_;
     const unsigned switch_back_seconds = 10 * 60;
 
+    // Per sub-backend (same index as backends_) - the configs are kept around to
+    // be able to replace a connection that is still busy with a straggling hedged
+    // request, the latency trackers are shared with those requests.
+    std::vector<std::unique_ptr<BackendConfig>> configs_;
+    std::vector<std::shared_ptr<LatencyTracker>> latencies_;
+
+    const bool hedged_reads_;
+    const double hedge_percentile_;
+    const LatencyTracker::Duration hedge_min_delay_;
+    const bool prefer_fastest_for_writes_;
+
+    uint64_t hedged_requests_ = 0;
+
+    static BackendPtr
+    make_backend_(const BackendConfig&);
+
     bool
     update_current_index(const iterator_t& start_iterator)
     {
@@ -205,6 +261,33 @@ private:
         return current_iterator_ != backends_.end();
     }
 
+    size_t
+    current_index_() const
+    {
+        return current_iterator_ - backends_.begin();
+    }
+
+    void
+    record_latency_(size_t idx,
+                    const LatencyTracker::Clock::time_point& start);
+
+    // The sub-backend with the lowest median latency, if enough samples are known.
+    boost::optional<size_t>
+    fastest_(const boost::optional<size_t>& exclude = boost::none) const;
+
+    // boost::none: hedging is disabled / not possible (yet) or all attempts failed
+    // - the caller is expected to fall back to the regular failover path.
+    boost::optional<bool>
+    hedged_(const std::function<std::unique_ptr<HedgedRequest>()>& make_request);
+
+    // Returns false if there's no idle thread to run the request on.
+    bool
+    launch_hedged_(const std::shared_ptr<HedgeState>& state,
+                   size_t idx,
+                   std::unique_ptr<HedgedRequest> request);
+
+    void
+    replace_busy_backends_(const std::vector<bool>& busy);
 };
 }
 }
@@ -0,0 +1,208 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ObjectCopier.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+
+#include <boost/thread/thread.hpp>
+
+#include <youtils/Assert.h>
+#include <youtils/FileUtils.h>
+#include <youtils/System.h>
+
+namespace backend
+{
+
+namespace fs = boost::filesystem;
+namespace yt = youtils;
+
+// Not const as XTest messes with it
+size_t
+ObjectCopier::default_streams =
+    yt::System::get_env_with_default<size_t>("BACKEND_COPY_STREAMS",
+                                             8);
+
+ObjectCopier::ObjectCopier(BackendInterfacePtr source,
+                           BackendInterfacePtr target,
+                           const ServerSideCopy server_side,
+                           size_t streams)
+    : source_(std::move(source))
+    , target_(std::move(target))
+    , server_side_(server_side)
+    , streams_(std::max<size_t>(streams, 1))
+{
+    VERIFY(source_);
+    VERIFY(target_);
+
+    LOG_INFO(source_->getNS() << " -> " << target_->getNS() <<
+             ": server side copy: " << server_side_ <<
+             ", streams: " << streams_);
+}
+
+void
+ObjectCopier::operator()(const std::vector<std::string>& objects,
+                         const OverwriteObject overwrite)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    const bool in_memory =
+        F(server_side_) and
+        source_->hasExtendedApi() and
+        target_->hasExtendedApi();
+
+    const size_t nstreams = std::min(streams_, objects.size());
+
+    LOG_INFO(source_->getNS() << " -> " << target_->getNS() << ": copying " <<
+             objects.size() << " objects using " << nstreams <<
+             " streams, in memory: " << in_memory);
+
+    // The streams cannot be interrupted themselves (they're not boost::threads),
+    // so the calling thread checks for interruption and tells them to stop.
+    std::atomic<bool> cancelled(false);
+
+    auto fun([&](BackendInterfacePtr src,
+                 BackendInterfacePtr dst,
+                 size_t idx)
+             {
+                 for (size_t i = idx; i < objects.size(); i += nstreams)
+                 {
+                     if (cancelled)
+                     {
+                         return;
+                     }
+
+                     copy_(*src,
+                           *dst,
+                           objects[i],
+                           in_memory,
+                           overwrite);
+                 }
+             });
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(nstreams);
+
+    // Wait for all of them before leaving as they reference `objects' and
+    // `cancelled'.
+    auto join([&]() -> std::exception_ptr
+              {
+                  std::exception_ptr eptr;
+
+                  for (auto& f : futures)
+                  {
+                      try
+                      {
+                          f.get();
+                      }
+                      catch (...)
+                      {
+                          if (not eptr)
+                          {
+                              eptr = std::current_exception();
+                          }
+                      }
+                  }
+
+                  return eptr;
+              });
+
+    try
+    {
+        for (size_t i = 0; i < nstreams; ++i)
+        {
+            futures.emplace_back(std::async(std::launch::async,
+                                            fun,
+                                            source_->clone(),
+                                            target_->clone(),
+                                            i));
+        }
+
+        for (auto& f : futures)
+        {
+            while (f.wait_for(std::chrono::milliseconds(100)) !=
+                   std::future_status::ready)
+            {
+                boost::this_thread::interruption_point();
+            }
+        }
+    }
+    catch (...)
+    {
+        LOG_WARN(source_->getNS() << " -> " << target_->getNS() <<
+                 ": interrupted or failed to start streams, stopping them");
+        cancelled = true;
+        join();
+        throw;
+    }
+
+    const std::exception_ptr eptr(join());
+
+    if (eptr)
+    {
+        LOG_ERROR(source_->getNS() << " -> " << target_->getNS() <<
+                  ": failed to copy objects");
+        std::rethrow_exception(eptr);
+    }
+}
+
+void
+ObjectCopier::copy_(BackendInterface& source,
+                    BackendInterface& target,
+                    const std::string& object,
+                    const bool in_memory,
+                    const OverwriteObject overwrite)
+{
+    LOG_TRACE(source.getNS() << "/" << object << " -> " << target.getNS());
+
+    if (T(server_side_))
+    {
+        source.copy_object_to(object,
+                              target.getNS(),
+                              overwrite);
+    }
+    else if (in_memory)
+    {
+        std::string buf;
+        source.x_read(buf,
+                      object,
+                      InsistOnLatestVersion::T);
+        target.x_write(buf,
+                       object,
+                       overwrite);
+    }
+    else
+    {
+        const fs::path p(yt::FileUtils::create_temp_file_in_temp_dir(object));
+        ALWAYS_CLEANUP_FILE(p);
+
+        source.read(p,
+                    object,
+                    InsistOnLatestVersion::T);
+        target.write(p,
+                     object,
+                     overwrite);
+    }
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
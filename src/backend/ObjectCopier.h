@@ -0,0 +1,90 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_OBJECT_COPIER_H_
+#define BACKEND_OBJECT_COPIER_H_
+
+#include "BackendInterface.h"
+
+#include <string>
+#include <vector>
+
+#include <youtils/BooleanEnum.h>
+#include <youtils/Logging.h>
+
+namespace backend
+{
+
+BOOLEAN_ENUM(ServerSideCopy);
+
+// Copies objects from one namespace to another using a number of concurrent
+// streams, each of which works on a disjoint share of the objects:
+// * ServerSideCopy::T: source and target live on the same backend, the
+//   objects are copied by the backend itself (BackendInterface::copy_object_to)
+// * otherwise the data is moved through this host - in memory if both
+//   backends support the extended API, through a temp file if not.
+// The first error encountered is rethrown once all streams have finished.
+// Interrupting the calling thread (boost::thread_interrupted) stops the
+// streams after the objects they're currently working on.
+class ObjectCopier
+{
+public:
+    ObjectCopier(BackendInterfacePtr source,
+                 BackendInterfacePtr target,
+                 const ServerSideCopy,
+                 size_t streams = default_streams);
+
+    ~ObjectCopier() = default;
+
+    ObjectCopier(const ObjectCopier&) = delete;
+
+    ObjectCopier&
+    operator=(const ObjectCopier&) = delete;
+
+    void
+    operator()(const std::vector<std::string>& objects,
+               const OverwriteObject = OverwriteObject::F);
+
+    size_t
+    streams() const
+    {
+        return streams_;
+    }
+
+    // Not const as XTest messes with it
+    static size_t default_streams;
+
+private:
+    DECLARE_LOGGER("ObjectCopier");
+
+    BackendInterfacePtr source_;
+    BackendInterfacePtr target_;
+    const ServerSideCopy server_side_;
+    const size_t streams_;
+
+    void
+    copy_(BackendInterface& source,
+          BackendInterface& target,
+          const std::string& object,
+          const bool in_memory,
+          const OverwriteObject);
+};
+
+}
+
+#endif // !BACKEND_OBJECT_COPIER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -288,6 +288,33 @@ TEST_F(BackendObjectTest, listBig)
                          list_entries_per_chunk);
 }
 
+TEST_F(BackendObjectTest, remove_objects)
+{
+    const size_t num_objs = 1000;
+    const size_t objsize = 4 << 10;
+
+    createAndListObjects(objsize,
+                         "Shoplifters of the world unite",
+                         num_objs);
+
+    std::list<std::string> objs;
+    bi_(nspace_->ns())->listObjects(objs);
+
+    std::vector<std::string> names(objs.begin(),
+                                   objs.end());
+    names.emplace_back("does-not-exist");
+
+    bi_(nspace_->ns())->remove_objects(names,
+                                       ObjectMayNotExist::T);
+
+    objs.clear();
+    bi_(nspace_->ns())->listObjects(objs);
+    EXPECT_TRUE(objs.empty());
+
+    bi_(nspace_->ns())->remove_objects({},
+                                       ObjectMayNotExist::F);
+}
+
 TEST_F(BackendObjectTest, getalot)
 {
     const size_t ocount(yt::System::get_env_with_default("NUM_OBJECTS",
@@ -58,6 +58,115 @@ protected:
         return gc.thread_pool_;
     }
 
+    size_t
+    queue(GarbageCollector& gc,
+          Garbage garbage,
+          bool native_remove_objects)
+    {
+        return gc.queue_(std::move(garbage),
+                         native_remove_objects);
+    }
+
+    static size_t
+    batch_size(size_t nobjects,
+               bool native_remove_objects,
+               size_t nthreads)
+    {
+        return GarbageCollector::batch_size_(nobjects,
+                                             native_remove_objects,
+                                             nthreads);
+    }
+
+    size_t
+    expected_batches(size_t nobjects,
+                     bool native_remove_objects)
+    {
+        const size_t bs = batch_size(nobjects,
+                                     native_remove_objects,
+                                     thread_pool(*gc_).getNumThreads());
+        return (nobjects + bs - 1) / bs;
+    }
+
+    std::vector<std::string>
+    put_objects(const Namespace& nspace,
+                size_t count)
+    {
+        std::vector<std::string> objects;
+        objects.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto s(boost::lexical_cast<std::string>(i));
+            const fs::path p(path_ / s);
+
+            createAndPut(p,
+                         4096,
+                         s,
+                         cm_,
+                         s,
+                         nspace,
+                         OverwriteObject::F);
+
+            objects.emplace_back(s);
+        }
+
+        return objects;
+    }
+
+    size_t
+    object_count(const Namespace& nspace)
+    {
+        std::list<std::string> l;
+        cm_->getConnection()->listObjects(nspace,
+                                          l);
+        return l.size();
+    }
+
+    // The garbage of each namespace is batched separately; backends with a
+    // native remove_objects get batches of up to max_batch_size, the others a
+    // share per bgc thread.
+    void
+    test_batches(bool native_remove_objects)
+    {
+        auto wrns1(make_random_namespace());
+        auto wrns2(make_random_namespace());
+
+        const size_t count1 = 13;
+        const size_t count2 = 7;
+
+        std::vector<std::string> objects1(put_objects(wrns1->ns(),
+                                                      count1));
+        const std::vector<std::string> objects2(put_objects(wrns2->ns(),
+                                                            count2));
+
+        // these don't exist but are removed nevertheless
+        const size_t nonexistent = 2 * GarbageCollector::max_batch_size + 1;
+        for (size_t i = 0; i < nonexistent; ++i)
+        {
+            objects1.emplace_back("nonexistent-" + boost::lexical_cast<std::string>(i));
+        }
+
+        EXPECT_EQ(expected_batches(count1 + nonexistent,
+                                   native_remove_objects),
+                  queue(*gc_,
+                        Garbage(wrns1->ns(),
+                                objects1),
+                        native_remove_objects));
+
+        EXPECT_EQ(expected_batches(count2,
+                                   native_remove_objects),
+                  queue(*gc_,
+                        Garbage(wrns2->ns(),
+                                objects2),
+                        native_remove_objects));
+
+        EXPECT_TRUE(gc_->barrier(wrns1->ns()).get());
+        EXPECT_TRUE(gc_->barrier(wrns2->ns()).get());
+
+        EXPECT_EQ(0U, object_count(wrns1->ns()));
+        EXPECT_EQ(0U, object_count(wrns2->ns()));
+    }
+
     std::unique_ptr<GarbageCollector> gc_;
 };
 
@@ -149,6 +258,41 @@ TEST_F(GarbageCollectorTest, real_garbage)
     check_object_count(0);
 }
 
+TEST_F(GarbageCollectorTest, batch_size)
+{
+    const size_t max = GarbageCollector::max_batch_size;
+
+    EXPECT_EQ(max, batch_size(1, true, 4));
+    EXPECT_EQ(max, batch_size(10 * max, true, 4));
+
+    EXPECT_EQ(1U, batch_size(0, false, 4));
+    EXPECT_EQ(1U, batch_size(1, false, 4));
+    EXPECT_EQ(4U, batch_size(13, false, 4));
+    EXPECT_EQ(13U, batch_size(13, false, 1));
+    EXPECT_EQ(13U, batch_size(13, false, 0));
+    EXPECT_EQ(max, batch_size(10 * max, false, 4));
+}
+
+TEST_F(GarbageCollectorTest, batches_with_native_remove_objects)
+{
+    EXPECT_EQ(3U, expected_batches(2 * GarbageCollector::max_batch_size + 1,
+                                   true));
+    test_batches(true);
+}
+
+TEST_F(GarbageCollectorTest, batches_without_native_remove_objects)
+{
+    const size_t nthreads = thread_pool(*gc_).getNumThreads();
+    if (nthreads > 1)
+    {
+        // spread over the threads instead of a single batch
+        EXPECT_LT(1U,
+                  expected_batches(13, false));
+    }
+
+    test_batches(false);
+}
+
 namespace
 {
 
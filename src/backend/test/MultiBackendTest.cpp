@@ -14,14 +14,18 @@
 
 #include "BackendTestBase.h"
 
+#include <atomic>
+
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <backend/LatencyTracker.h>
 #include <backend/Multi_Connection.h>
 #include <youtils/Chooser.h>
 #include <youtils/UUID.h>
 #include <boost/chrono.hpp>
 #include <boost/thread/thread.hpp>
+
 namespace backendtest
 {
 using namespace backend;
@@ -758,6 +762,233 @@ TEST_F(MultiBackendTest, DISABLED_stress)
     t.join();
 
 }
+
+TEST_F(MultiBackendTest, latency_tracker)
+{
+    LatencyTracker tracker(100,
+                           10);
+
+    EXPECT_EQ(boost::none,
+              tracker.percentile(50));
+
+    for (size_t i = 1; i <= 100; ++i)
+    {
+        tracker.record(LatencyTracker::Duration(i));
+    }
+
+    EXPECT_EQ(100U, tracker.samples());
+    EXPECT_EQ(LatencyTracker::Duration(51), *tracker.percentile(50));
+    EXPECT_EQ(LatencyTracker::Duration(100), *tracker.percentile(99));
+    EXPECT_EQ(LatencyTracker::Duration(100), *tracker.percentile(100));
+    EXPECT_EQ(LatencyTracker::Duration(1), *tracker.percentile(0));
+
+    // the window only keeps the most recent samples
+    for (size_t i = 0; i < 100; ++i)
+    {
+        tracker.record(LatencyTracker::Duration(1000));
+    }
+
+    EXPECT_EQ(LatencyTracker::Duration(1000), *tracker.percentile(0));
+
+    tracker.clear();
+    EXPECT_EQ(0U, tracker.samples());
+    EXPECT_EQ(boost::none,
+              tracker.percentile(50));
+}
+
+TEST_F(MultiBackendTest, hedged_reads)
+{
+    boost::property_tree::ptree pt = make_local_config();
+    pt.put("backend_connection_manager.multi_connection_hedged_reads", true);
+    pt.put("backend_connection_manager.multi_connection_hedge_percentile", 0);
+    pt.put("backend_connection_manager.multi_connection_hedge_min_delay_usecs", 0);
+
+    setup_multi_dirs();
+
+    BackendConnectionManagerPtr bcm = BackendConnectionManager::create(pt);
+    BackendConnectionInterfacePtr connection = bcm->getConnection();
+
+    const Namespace ns(youtils::UUID().str());
+    connection->createNamespace(ns);
+
+    const std::string pattern("hedgehog");
+    const size_t size = 4096;
+    const std::string obj("object");
+
+    const fs::path src(path_ / "source");
+    const youtils::CheckSum chksum(createTestFile(src,
+                                                  size,
+                                                  pattern));
+    connection->write(ns,
+                      src,
+                      obj);
+
+    const fs::path dst(path_ / "destination");
+
+    // the first reads go the regular way and provide latency samples, the
+    // later ones are hedged (with a zero delay) to another backend
+    for (size_t i = 0; i < 64; ++i)
+    {
+        fs::remove(dst);
+        connection->read(ns,
+                         dst,
+                         obj,
+                         InsistOnLatestVersion::T);
+        EXPECT_TRUE(verifyTestFile(dst,
+                                   size,
+                                   pattern,
+                                   &chksum));
+    }
+
+    EXPECT_THROW(connection->read(ns,
+                                  dst,
+                                  "no-such-object",
+                                  InsistOnLatestVersion::T),
+                 BackendObjectDoesNotExistException);
+
+    connection->deleteNamespace(ns);
+}
+
+TEST_F(MultiBackendTest, hedged_reads_with_slow_backend)
+{
+    boost::property_tree::ptree pt = make_local_config();
+    pt.put("backend_connection_manager.multi_connection_hedged_reads", true);
+    pt.put("backend_connection_manager.multi_connection_hedge_percentile", 0);
+    pt.put("backend_connection_manager.multi_connection_hedge_min_delay_usecs", 0);
+    // every request to the default backend takes at least 20ms
+    pt.put("backend_connection_manager.0.local_connection_tv_nsec", 20000000);
+
+    setup_multi_dirs();
+
+    BackendConnectionManagerPtr bcm = BackendConnectionManager::create(pt);
+    BackendConnectionInterfacePtr connection = bcm->getConnection();
+
+    auto multi = dynamic_cast<multi::Connection*>(connection.get());
+    ASSERT_TRUE(multi != nullptr);
+
+    const Namespace ns(youtils::UUID().str());
+    connection->createNamespace(ns);
+
+    const std::string pattern("slow hedgehog");
+    const size_t size = 4096;
+    const std::string obj("object");
+
+    const fs::path src(path_ / "source");
+    const youtils::CheckSum chksum(createTestFile(src,
+                                                  size,
+                                                  pattern));
+    connection->write(ns,
+                      src,
+                      obj);
+
+    const fs::path dst(path_ / "destination");
+
+    // The regular reads go to the slow default backend and provide its latency
+    // samples. Once there are enough, reads taking longer than the fastest of
+    // them are hedged to a fast backend.
+    for (size_t i = 0; i < 64; ++i)
+    {
+        fs::remove(dst);
+        connection->read(ns,
+                         dst,
+                         obj,
+                         InsistOnLatestVersion::T);
+        EXPECT_TRUE(verifyTestFile(dst,
+                                   size,
+                                   pattern,
+                                   &chksum));
+    }
+
+    EXPECT_LT(0U,
+              multi->hedged_requests());
+
+    EXPECT_THROW(connection->read(ns,
+                                  dst,
+                                  "no-such-object",
+                                  InsistOnLatestVersion::T),
+                 BackendObjectDoesNotExistException);
+
+    connection->deleteNamespace(ns);
+}
+
+// More concurrent readers than there are hedging threads: the excess ones are
+// not hedged but must still be served.
+TEST_F(MultiBackendTest, hedged_reads_exceeding_hedge_threads)
+{
+    boost::property_tree::ptree pt = make_local_config();
+    pt.put("backend_connection_manager.multi_connection_hedged_reads", true);
+    pt.put("backend_connection_manager.multi_connection_hedge_percentile", 0);
+    pt.put("backend_connection_manager.multi_connection_hedge_min_delay_usecs", 0);
+    pt.put("backend_connection_manager.0.local_connection_tv_nsec", 20000000);
+
+    setup_multi_dirs();
+
+    BackendConnectionManagerPtr bcm = BackendConnectionManager::create(pt);
+
+    const Namespace ns(youtils::UUID().str());
+    bcm->getConnection()->createNamespace(ns);
+
+    const std::string pattern("crowded hedgehog");
+    const size_t size = 4096;
+    const std::string obj("object");
+
+    const fs::path src(path_ / "source");
+    const youtils::CheckSum chksum(createTestFile(src,
+                                                  size,
+                                                  pattern));
+    bcm->getConnection()->write(ns,
+                                src,
+                                obj);
+
+    const size_t nreaders = 2 * multi::Connection::hedge_threads;
+    std::vector<boost::thread> readers;
+    readers.reserve(nreaders);
+
+    std::atomic<size_t> failures(0);
+
+    for (size_t i = 0; i < nreaders; ++i)
+    {
+        readers.emplace_back([&, i]
+                             {
+                                 BackendConnectionInterfacePtr conn(bcm->getConnection());
+                                 const fs::path dst(path_ / ("destination-" +
+                                                             boost::lexical_cast<std::string>(i)));
+
+                                 for (size_t j = 0; j < 32; ++j)
+                                 {
+                                     try
+                                     {
+                                         fs::remove(dst);
+                                         conn->read(ns,
+                                                    dst,
+                                                    obj,
+                                                    InsistOnLatestVersion::T);
+                                         if (not verifyTestFile(dst,
+                                                                size,
+                                                                pattern,
+                                                                &chksum))
+                                         {
+                                             ++failures;
+                                         }
+                                     }
+                                     catch (std::exception&)
+                                     {
+                                         ++failures;
+                                     }
+                                 }
+                             });
+    }
+
+    for (auto& t : readers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(0U, failures.load());
+
+    bcm->getConnection()->deleteNamespace(ns);
+}
+
 }
 
 // Local Variables: **
@@ -0,0 +1,132 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <boost/lexical_cast.hpp>
+
+#include "BackendTestBase.h"
+
+#include <backend/BackendException.h>
+#include <backend/ObjectCopier.h>
+
+namespace backendtest
+{
+
+namespace be = backend;
+namespace yt = youtils;
+
+class ObjectCopierTest
+    : public be::BackendTestBase
+{
+public:
+    ObjectCopierTest()
+        : be::BackendTestBase("ObjectCopierTest")
+    {}
+
+    void
+    test_copy(const be::ServerSideCopy server_side,
+              size_t streams)
+    {
+        std::unique_ptr<be::BackendTestSetup::WithRandomNamespace>
+            src_nspace(make_random_namespace());
+        std::unique_ptr<be::BackendTestSetup::WithRandomNamespace>
+            dst_nspace(make_random_namespace());
+
+        const size_t nobjs = 37;
+        const size_t size = 4 << 10;
+
+        std::vector<std::string> names;
+        std::vector<yt::CheckSum> checksums;
+
+        for (size_t i = 0; i < nobjs; ++i)
+        {
+            const std::string name("object-" + boost::lexical_cast<std::string>(i));
+            checksums.emplace_back(createAndPut(path_ / name,
+                                                size,
+                                                name,
+                                                cm_,
+                                                name,
+                                                src_nspace->ns(),
+                                                OverwriteObject::F));
+            names.emplace_back(name);
+        }
+
+        be::ObjectCopier copier(bi_(src_nspace->ns()),
+                                bi_(dst_nspace->ns()),
+                                server_side,
+                                streams);
+
+        copier(names);
+
+        for (size_t i = 0; i < nobjs; ++i)
+        {
+            EXPECT_TRUE(retrieveAndVerify(path_ / (names[i] + "-copy"),
+                                          size,
+                                          names[i],
+                                          &checksums[i],
+                                          cm_,
+                                          names[i],
+                                          dst_nspace->ns()));
+        }
+
+        EXPECT_THROW(copier(names),
+                     be::BackendOverwriteNotAllowedException);
+
+        copier(names,
+               OverwriteObject::T);
+
+        // the source is left alone
+        for (size_t i = 0; i < nobjs; ++i)
+        {
+            EXPECT_EQ(checksums[i],
+                      bi_(src_nspace->ns())->getCheckSum(names[i]));
+        }
+    }
+};
+
+TEST_F(ObjectCopierTest, server_side)
+{
+    test_copy(be::ServerSideCopy::T,
+              4);
+}
+
+TEST_F(ObjectCopierTest, client_side)
+{
+    test_copy(be::ServerSideCopy::F,
+              4);
+}
+
+TEST_F(ObjectCopierTest, more_streams_than_objects)
+{
+    test_copy(be::ServerSideCopy::T,
+              1024);
+}
+
+TEST_F(ObjectCopierTest, nonexistent_object)
+{
+    std::unique_ptr<be::BackendTestSetup::WithRandomNamespace>
+        src_nspace(make_random_namespace());
+    std::unique_ptr<be::BackendTestSetup::WithRandomNamespace>
+        dst_nspace(make_random_namespace());
+
+    be::ObjectCopier copier(bi_(src_nspace->ns()),
+                            bi_(dst_nspace->ns()),
+                            be::ServerSideCopy::T);
+
+    EXPECT_THROW(copier({ "does-not-exist" }),
+                 be::BackendObjectDoesNotExistException);
+
+    copier({});
+}
+
+}
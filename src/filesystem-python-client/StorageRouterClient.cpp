@@ -566,6 +566,21 @@ BOOST_PYTHON_MODULE(storagerouterclient)
              "@raises \n"
              "      ObjectNotFoundException\n"
              "      InvalidOperationException (on clone)\n")
+        .def("get_changed_extents",
+             &vfs::PythonClient::get_changed_extents,
+             (bpy::args("volume_id"),
+              bpy::args("end_snapshot"),
+              bpy::arg("start_snapshot") = bpy::object()),
+             "Get the extents written to after start_snapshot (or since the creation\n"
+             "of the volume if not specified) up to and including end_snapshot.\n"
+             "Data inherited from a clone's parent is not included.\n"
+             "@param volume_id: string, volume identifier\n"
+             "@param end_snapshot: string, snapshot name\n"
+             "@param start_snapshot: optional string, snapshot name\n"
+             "@returns: list of (offset, length) tuples, in bytes\n"
+             "@raises \n"
+             "      ObjectNotFoundException\n"
+             "      SnapshotNotFoundException\n")
         // .def("get_scrubbing_workunits",
         //      &vfs::PythonClient::get_scrubbing_work,
         //      (bpy::args("volume_id")),
@@ -16,6 +16,7 @@
 #include "FileSystemEvents.h"
 #include "Handle.h"
 #include "Registry.h"
+#include "RestartScheduler.h"
 #include "TracePoints_tp.h"
 #include "VirtualDiskFormat.h"
 #include "VirtualDiskFormatVmdk.h"
@@ -39,6 +40,7 @@
 
 #include <volumedriver/MDSNodeConfig.h>
 #include <volumedriver/MetaDataBackendConfig.h>
+#include <volumedriver/VolManager.h>
 
 namespace volumedriverfs
 {
@@ -79,6 +81,33 @@ setlimit(int resource, uint32_t value)
     }
 }
 
+// The bulk of a local restart's time goes to checking and replaying the TLogs
+// that did not make it to the backend yet, so their size is a good enough
+// estimate of how long a restart is going to take.
+uint64_t
+local_tlog_data_size(const ObjectId& id)
+{
+    uint64_t size = 0;
+
+    try
+    {
+        const fs::path p(vd::VolManager::get()->getTLogPath() / id.str());
+        if (fs::exists(p))
+        {
+            for (fs::directory_iterator it(p); it != fs::directory_iterator(); ++it)
+            {
+                if (fs::is_regular_file(it->status()))
+                {
+                    size += fs::file_size(it->path());
+                }
+            }
+        }
+    }
+    CATCH_STD_ALL_LOG_IGNORE(id << ": failed to determine size of local TLogs");
+
+    return size;
+}
+
 std::unique_ptr<VirtualDiskFormat>
 get_virtual_disk_format(const bpt::ptree& pt)
 {
@@ -180,7 +209,11 @@ FileSystem::FileSystem(const bpt::ptree& pt,
     DECLARE_PARAMETER(fs_max_open_files)(pt);
     setlimit(RLIMIT_NOFILE, fs_max_open_files.value());
 
-    restart_();
+    DECLARE_PARAMETER(fs_restart_parallelism)(pt);
+    DECLARE_PARAMETER(fs_restart_largest_first)(pt);
+
+    restart_(fs_restart_parallelism.value(),
+             fs_restart_largest_first.value());
 
     InstantiateXMLRPCS<xmlrpcs>::doit(xmlrpc_svc_, *this);
     xmlrpc_svc_.start();
@@ -361,26 +394,33 @@ FileSystem::is_volume_path_(const FrontendPath& p) const
 }
 
 void
-FileSystem::restart_()
+FileSystem::restart_(uint32_t parallelism,
+                     bool largest_first)
 {
-    auto fun([this](const FrontendPath& p, const DirectoryEntryPtr dentry)
+    RestartScheduler sched(parallelism);
+
+    auto fun([&](const FrontendPath& p, const DirectoryEntryPtr dentry)
              {
                  const ObjectId& id = dentry->object_id();
                  if (not is_directory(dentry))
                  {
-                     LOG_TRACE(p << ": trying to restart " << id);
-                     try
-                     {
-                         router_.maybe_restart(id,
-                                               ForceRestart::F);
-                     }
-                     CATCH_STD_ALL_LOG_IGNORE(p << ": failed to restart volume " <<
-                                              id);
+                     LOG_TRACE(p << ": scheduling restart of " << id);
+                     sched.add(id,
+                               (largest_first and
+                                dentry->type() == DirectoryEntry::Type::Volume) ?
+                               local_tlog_data_size(id) :
+                               0);
                  }
              });
 
     mdstore_.walk(FrontendPath("/"),
                   std::move(fun));
+
+    sched.run([&](const ObjectId& id)
+              {
+                  router_.maybe_restart(id,
+                                        ForceRestart::F);
+              });
 }
 
 void
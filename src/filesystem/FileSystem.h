@@ -591,7 +591,8 @@ private:
                                const FrontendPath& to);
 
     void
-    restart_();
+    restart_(uint32_t parallelism,
+             bool largest_first);
 
     void
     create_volume_(const FrontendPath& path,
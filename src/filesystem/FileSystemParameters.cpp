@@ -217,6 +217,20 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_max_open_files,
                                       ShowDocumentation::T,
                                       65536);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_restart_parallelism,
+                                      filesystem_component_name,
+                                      "fs_restart_parallelism",
+                                      "Number of volumes that are restarted concurrently on startup",
+                                      ShowDocumentation::T,
+                                      4);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_restart_largest_first,
+                                      filesystem_component_name,
+                                      "fs_restart_largest_first",
+                                      "Whether to restart volumes with the most local TLog data (i.e. the longest restart) first on startup",
+                                      ShowDocumentation::T,
+                                      true);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_internal_suffix,
                                       filesystem_component_name,
                                       "fs_internal_suffix",
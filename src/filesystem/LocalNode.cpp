@@ -1598,6 +1598,43 @@ LocalNode::get_scrub_work(const ObjectId& id,
     return res;
 }
 
+std::vector<std::pair<uint64_t, uint64_t>>
+LocalNode::get_changed_extents(const ObjectId& id,
+                               const boost::optional<vd::SnapshotName>& start_snap,
+                               const vd::SnapshotName& end_snap)
+{
+    LOG_INFO(id << ": getting changed extents, start snapshot " << start_snap <<
+             ", end snapshot " << end_snap);
+
+    RWLockPtr l(get_lock_(id));
+    fungi::ScopedReadLock rg(*l);
+
+    vd::WeakVolumePtr vol;
+
+    with_api_exception_conversion([&]
+    {
+        vol = api::getVolumePointer(static_cast<vd::VolumeId>(id));
+    });
+
+    // Not holding the management mutex while computing the changes as the
+    // TLogs might have to be fetched from the backend.
+    const vd::ChangedClusters changed(api::getChangedClusters(vol,
+                                                              start_snap,
+                                                              end_snap));
+    const uint64_t csize = api::GetClusterSize(vol);
+
+    std::vector<std::pair<uint64_t, uint64_t>> extents;
+    extents.reserve(changed.extents().size());
+
+    for (const auto& e : changed.extents())
+    {
+        extents.emplace_back(e.ca * csize,
+                             e.count * csize);
+    }
+
+    return extents;
+}
+
 void
 LocalNode::queue_scrub_reply(const ObjectId& oid,
                              const scrubbing::ScrubReply& reply)
@@ -1491,6 +1491,18 @@ ObjectRouter::get_scrub_work(const ObjectId& oid,
                                          end_snap);
 }
 
+std::vector<std::pair<uint64_t, uint64_t>>
+ObjectRouter::get_changed_extents(const ObjectId& oid,
+                                  const boost::optional<vd::SnapshotName>& start_snap,
+                                  const vd::SnapshotName& end_snap)
+{
+    LOG_INFO(oid << ": getting changed extents, start snapshot " << start_snap <<
+             ", end snapshot " << end_snap);
+    return local_node_()->get_changed_extents(oid,
+                                              start_snap,
+                                              end_snap);
+}
+
 void
 ObjectRouter::queue_scrub_reply(const ObjectId& oid,
                                 const scrubbing::ScrubReply& scrub_reply)
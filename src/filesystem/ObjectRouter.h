@@ -262,6 +262,13 @@ public:
                    const boost::optional<volumedriver::SnapshotName>& start_snap,
                    const boost::optional<volumedriver::SnapshotName>& end_snap);
 
+    // (offset, length) in bytes of the extents written to after start_snap (or
+    // the creation of the volume) up to and including end_snap.
+    std::vector<std::pair<uint64_t, uint64_t>>
+    get_changed_extents(const ObjectId& oid,
+                        const boost::optional<volumedriver::SnapshotName>& start_snap,
+                        const volumedriver::SnapshotName& end_snap);
+
     void
     queue_scrub_reply(const ObjectId& oid,
                       const scrubbing::ScrubReply&);
@@ -440,6 +440,35 @@ PythonClient::get_scrubbing_work(const std::string& volume_id)
     return l;
 }
 
+bpy::list
+PythonClient::get_changed_extents(const std::string& volume_id,
+                                  const std::string& end_snapshot,
+                                  const boost::optional<std::string>& start_snapshot)
+{
+    XmlRpc::XmlRpcValue req;
+    req[XMLRPCKeys::volume_id] = volume_id;
+    req[XMLRPCKeys::end_snapshot] = end_snapshot;
+    if (start_snapshot)
+    {
+        req[XMLRPCKeys::start_snapshot] = *start_snapshot;
+    }
+
+    auto rsp(call(GetChangedExtents::method_name(), req));
+
+    bpy::list l;
+    for (auto i = 0; i < rsp.size(); ++i)
+    {
+        const uint64_t off =
+            boost::lexical_cast<uint64_t>(static_cast<std::string>(rsp[i][0]));
+        const uint64_t len =
+            boost::lexical_cast<uint64_t>(static_cast<std::string>(rsp[i][1]));
+        l.append(bpy::make_tuple(off,
+                                 len));
+    }
+
+    return l;
+}
+
 void
 PythonClient::apply_scrubbing_result(const bpy::tuple& tup)
 {
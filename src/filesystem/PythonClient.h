@@ -173,6 +173,11 @@ public:
     boost::python::list
     get_scrubbing_work(const std::string& volume_id);
 
+    boost::python::list
+    get_changed_extents(const std::string& volume_id,
+                        const std::string& end_snapshot,
+                        const boost::optional<std::string>& start_snapshot = boost::none);
+
     void
     apply_scrubbing_result(const boost::python::tuple& tuple);
 
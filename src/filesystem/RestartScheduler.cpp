@@ -0,0 +1,135 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RestartScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
+#include <youtils/wall_timer.h>
+
+namespace volumedriverfs
+{
+
+namespace yt = youtils;
+
+RestartScheduler::RestartScheduler(uint32_t parallelism)
+    : parallelism_(std::max<uint32_t>(parallelism,
+                                      1))
+{}
+
+void
+RestartScheduler::add(const ObjectId& id,
+                      uint64_t priority)
+{
+    jobs_.emplace_back(Job{ id,
+                            priority });
+}
+
+RestartScheduler::Results
+RestartScheduler::run(const RestartFun& fun)
+{
+    std::stable_sort(jobs_.begin(),
+                     jobs_.end(),
+                     [](const Job& a,
+                        const Job& b)
+                     {
+                         return a.priority > b.priority;
+                     });
+
+    Results results;
+    results.reserve(jobs_.size());
+
+    for (const auto& j : jobs_)
+    {
+        results.emplace_back(j.id);
+    }
+
+    const size_t nthreads = std::min<size_t>(parallelism_,
+                                             jobs_.size());
+
+    LOG_INFO("restarting " << jobs_.size() << " objects, " << nthreads <<
+             " at a time");
+
+    yt::wall_timer timer;
+    std::atomic<size_t> next(0);
+
+    auto work([&]
+              {
+                  while (true)
+                  {
+                      const size_t idx = next++;
+                      if (idx >= jobs_.size())
+                      {
+                          break;
+                      }
+
+                      Result& res = results[idx];
+                      yt::wall_timer t;
+
+                      try
+                      {
+                          fun(res.id);
+                          res.ok = true;
+                      }
+                      CATCH_STD_ALL_LOG_IGNORE(res.id << ": failed to restart");
+
+                      res.duration_secs = t.elapsed();
+
+                      LOG_INFO(res.id << ": restart " <<
+                               (res.ok ? "succeeded" : "failed") << " after " <<
+                               res.duration_secs << " seconds");
+                  }
+              });
+
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+
+    {
+        auto on_exit(yt::make_scope_exit([&]
+                                         {
+                                             for (auto& t : threads)
+                                             {
+                                                 t.join();
+                                             }
+                                         }));
+
+        // the calling thread is one of the workers
+        for (size_t i = 1; i < nthreads; ++i)
+        {
+            threads.emplace_back(work);
+        }
+
+        work();
+    }
+
+    const size_t failed = std::count_if(results.begin(),
+                                        results.end(),
+                                        [](const Result& r)
+                                        {
+                                            return not r.ok;
+                                        });
+
+    LOG_INFO("restarted " << (results.size() - failed) << " of " <<
+             results.size() << " objects in " << timer.elapsed() <<
+             " seconds, " << failed << " failed");
+
+    return results;
+}
+
+}
@@ -0,0 +1,97 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VFS_RESTART_SCHEDULER_H_
+#define VFS_RESTART_SCHEDULER_H_
+
+#include "Object.h"
+
+#include <functional>
+#include <vector>
+
+#include <youtils/Logging.h>
+
+namespace volumedriverfs
+{
+
+// Restarts a set of objects (after a node restart) with bounded parallelism, in
+// order of descending priority - objects of the same priority are restarted in
+// the order they were added in.
+// A failed restart is logged and does not affect the others.
+class RestartScheduler
+{
+public:
+    using RestartFun = std::function<void(const ObjectId&)>;
+
+    struct Result
+    {
+        explicit Result(const ObjectId& i)
+            : id(i)
+            , ok(false)
+            , duration_secs(0)
+        {}
+
+        ObjectId id;
+        bool ok;
+        double duration_secs;
+    };
+
+    using Results = std::vector<Result>;
+
+    explicit RestartScheduler(uint32_t parallelism);
+
+    ~RestartScheduler() = default;
+
+    RestartScheduler(const RestartScheduler&) = delete;
+
+    RestartScheduler&
+    operator=(const RestartScheduler&) = delete;
+
+    void
+    add(const ObjectId&,
+        uint64_t priority = 0);
+
+    size_t
+    size() const
+    {
+        return jobs_.size();
+    }
+
+    uint32_t
+    parallelism() const
+    {
+        return parallelism_;
+    }
+
+    // Blocks until all restarts are done. The results are in the order the
+    // restarts were started in.
+    Results
+    run(const RestartFun&);
+
+private:
+    DECLARE_LOGGER("RestartScheduler");
+
+    struct Job
+    {
+        ObjectId id;
+        uint64_t priority;
+    };
+
+    const uint32_t parallelism_;
+    std::vector<Job> jobs_;
+};
+
+}
+
+#endif // !VFS_RESTART_SCHEDULER_H_
@@ -613,6 +613,36 @@ ShmClient::list_volumes()
     return volumes;
 }
 
+std::vector<std::pair<uint64_t, uint64_t>>
+ShmClient::snapshot_diff(const std::string& volume_name,
+                         const std::string& start_snapshot_name,
+                         const std::string& end_snapshot_name)
+{
+    CORBA::Object_var obj = orb_helper().getObjectReference(vd_context_name,
+                                                            vd_context_kind,
+                                                            vd_object_name,
+                                                            vd_object_kind);
+    assert(not CORBA::is_nil(obj));
+    ShmIdlInterface::VolumeFactory_var volumefactory_ref =
+        ShmIdlInterface::VolumeFactory::_narrow(obj);
+    assert(not CORBA::is_nil(volumefactory_ref));
+
+    ShmIdlInterface::ULongLongSequence_var results;
+    volumefactory_ref->snapshot_diff(volume_name.c_str(),
+                                     start_snapshot_name.c_str(),
+                                     end_snapshot_name.c_str(),
+                                     results.out());
+
+    std::vector<std::pair<uint64_t, uint64_t>> extents;
+    extents.reserve(results->length() / 2);
+    for (unsigned int i = 0; i + 1 < results->length(); i += 2)
+    {
+        extents.emplace_back(results[i],
+                             results[i + 1]);
+    }
+    return extents;
+}
+
 int
 ShmClient::stat(struct stat *st)
 {
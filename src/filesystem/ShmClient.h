@@ -149,6 +149,11 @@ public:
     static std::vector<std::string>
     list_volumes();
 
+    static std::vector<std::pair<uint64_t, uint64_t>>
+    snapshot_diff(const std::string& volume_name,
+                  const std::string& start_snapshot_name,
+                  const std::string& end_snapshot_name);
+
     void*
     get_address_from_handle(ipc::managed_shared_memory::handle_t handle);
 
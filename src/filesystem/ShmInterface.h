@@ -221,6 +221,33 @@ public:
         return int(h->is_snapshot_synced(volume_name, snapshot_name));
     }
 
+    void
+    snapshot_diff(const char* volume_name,
+                  const char* start_snapshot_name,
+                  const char* end_snapshot_name,
+                  ShmIdlInterface::ULongLongSequence_out extents)
+    {
+        std::unique_ptr<Handler> h(new Handler(handler_args_));
+        boost::optional<std::string> start;
+        if (*start_snapshot_name)
+        {
+            start = std::string(start_snapshot_name);
+        }
+
+        const std::vector<std::pair<uint64_t, uint64_t>>
+            res(h->snapshot_diff(volume_name,
+                                 start,
+                                 end_snapshot_name));
+
+        extents = new ShmIdlInterface::ULongLongSequence(2 * res.size());
+        extents->length(2 * res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+        {
+            extents[2 * i] = res[i].first;
+            extents[2 * i + 1] = res[i].second;
+        }
+    }
+
     void
     list_volumes(ShmIdlInterface::StringSequence_out results)
     {
@@ -377,6 +377,42 @@ public:
         }
     }
 
+    std::vector<std::pair<uint64_t, uint64_t>>
+    snapshot_diff(const std::string& volume_name,
+                  const boost::optional<std::string>& start_snap_name,
+                  const std::string& end_snap_name)
+    {
+        LOG_INFO(volume_name << ": getting changed extents, start snapshot " <<
+                 start_snap_name << ", end snapshot " << end_snap_name);
+
+        const FrontendPath volume_path(make_volume_path(volume_name));
+        boost::optional<ObjectId> volume_id(get_objectid(volume_path));
+
+        boost::optional<volumedriver::SnapshotName> start_snap;
+        if (start_snap_name)
+        {
+            start_snap = volumedriver::SnapshotName(*start_snap_name);
+        }
+
+        try
+        {
+            return fs_.object_router().get_changed_extents(*volume_id,
+                                                           start_snap,
+                                                           volumedriver::SnapshotName(end_snap_name));
+        }
+        catch (volumedriver::SnapshotNotFoundException& e)
+        {
+            LOG_INFO("Snapshot not found: " << e.what());
+            throw ShmIdlInterface::SnapshotNotFound(volume_name.c_str());
+        }
+        catch (std::exception& e)
+        {
+            LOG_INFO("Problem getting changed extents of volume " << volume_name <<
+                     ",err: " << e.what());
+            throw;
+        }
+    }
+
     std::vector<std::string>
     list_volumes()
     {
@@ -818,6 +818,40 @@ GetScrubbingWork::execute_internal(::XmlRpc::XmlRpcValue& params,
     }
 }
 
+void
+GetChangedExtents::execute_internal(::XmlRpc::XmlRpcValue& params,
+                                    ::XmlRpc::XmlRpcValue& result)
+{
+    const ObjectId volid(getID(params[0]));
+
+    boost::optional<vd::SnapshotName> ssnap;
+    if (params[0].hasMember(XMLRPCKeys::start_snapshot))
+    {
+        ssnap = vd::SnapshotName(params[0][XMLRPCKeys::start_snapshot]);
+    }
+
+    XMLRPCUtils::ensure_arg(params[0], XMLRPCKeys::end_snapshot);
+    const vd::SnapshotName esnap(params[0][XMLRPCKeys::end_snapshot]);
+
+    const std::vector<std::pair<uint64_t, uint64_t>>
+        extents(fs_.object_router().get_changed_extents(volid,
+                                                        ssnap,
+                                                        esnap));
+
+    // [offset, length] pairs, as strings since XMLRPC ints are 32 bits only
+    result.clear();
+    result.setSize(0);
+    int k = 0;
+    for (const auto& e : extents)
+    {
+        ::XmlRpc::XmlRpcValue ext;
+        ext.setSize(2);
+        ext[0] = XMLVAL(e.first);
+        ext[1] = XMLVAL(e.second);
+        result[k++] = ext;
+    }
+}
+
 void
 ApplyScrubbingResult::execute_internal(::XmlRpc::XmlRpcValue&  params,
                                        ::XmlRpc::XmlRpcValue& /*result*/)
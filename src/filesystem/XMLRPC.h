@@ -328,6 +328,11 @@ REGISTER_XMLRPC(XMLRPCCallTimingRedirect,
                 "getScrubbingWork",
                 "Get scrubbing work");
 
+REGISTER_XMLRPC(XMLRPCCallTimingRedirect,
+                GetChangedExtents,
+                "getChangedExtents",
+                "Get the extents written between two snapshots");
+
 REGISTER_XMLRPC(XMLRPCCallTiming,
                 ApplyScrubbingResult,
                 "applyScrubbingResult",
@@ -686,7 +691,7 @@ REGISTER_XMLRPC(XMLRPCCallTimingRedirectLock,
                 "getMetaDataCacheCapacity",
                 "get capacity of the metadata cache (in pages)");
 
-typedef LOKI_TYPELIST_84(
+typedef LOKI_TYPELIST_85(
 // ================== EXPOSED IN XMLRPC CLIENT ===================
                          VolumeCreate,
                          VolumesList,
@@ -705,6 +710,7 @@ typedef LOKI_TYPELIST_84(
                          VolumeDriverPerformanceCounters,
                          SetVolumeAsTemplate,
                          GetScrubbingWork,
+                         GetChangedExtents,
                          ApplyScrubbingResult,
                          Revision,
                          MarkNodeOffline,
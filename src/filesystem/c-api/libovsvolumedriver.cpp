@@ -861,6 +861,88 @@ ovs_snapshot_is_synced(const char* volume_name,
     return r;
 }
 
+int
+ovs_snapshot_diff(const char *volume_name,
+                  const char *start_snap_name,
+                  const char *end_snap_name,
+                  ovs_extent_t *extents,
+                  size_t *max_extents)
+{
+    int r = 0;
+
+    tracepoint(openvstorage_libovsvolumedriver,
+               ovs_snapshot_diff_enter,
+               volume_name,
+               start_snap_name ? start_snap_name : "",
+               end_snap_name ? end_snap_name : "",
+               extents);
+
+    auto on_exit(youtils::make_scope_exit([&]
+                {
+                    safe_errno_tracepoint(openvstorage_libovsvolumedriver,
+                                          ovs_snapshot_diff_exit,
+                                          volume_name,
+                                          extents,
+                                          r,
+                                          max_extents ? *max_extents : 0,
+                                          errno);
+                }));
+
+    if (not max_extents or
+        not end_snap_name or
+        not _is_volume_name_valid(volume_name))
+    {
+        errno = EINVAL;
+        return (r = -1);
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> res;
+    try
+    {
+        res = volumedriverfs::ShmClient::snapshot_diff(volume_name,
+                                                       start_snap_name ?
+                                                       start_snap_name : "",
+                                                       end_snap_name);
+    }
+    catch (const ShmIdlInterface::VolumeDoesNotExist&)
+    {
+        errno = ENOENT;
+        return (r = -1);
+    }
+    catch (const ShmIdlInterface::SnapshotNotFound&)
+    {
+        errno = ENOENT;
+        return (r = -1);
+    }
+    catch (...)
+    {
+        errno = EIO;
+        return (r = -1);
+    }
+
+    if (*max_extents < res.size())
+    {
+        *max_extents = res.size();
+        errno = ERANGE;
+        return (r = -1);
+    }
+
+    if (not extents and not res.empty())
+    {
+        errno = EINVAL;
+        return (r = -1);
+    }
+
+    for (size_t i = 0; i < res.size(); ++i)
+    {
+        extents[i].offset = res[i].first;
+        extents[i].length = res[i].second;
+    }
+
+    r = static_cast<int>(res.size());
+    return r;
+}
+
 int
 ovs_list_volumes(char *names, size_t *size)
 {
@@ -50,6 +50,7 @@ extern "C"
 typedef struct ovs_buffer ovs_buffer_t;
 typedef struct ovs_context_t ovs_ctx_t;
 typedef struct ovs_snapshot_info ovs_snapshot_info_t;
+typedef struct ovs_extent ovs_extent_t;
 typedef struct ovs_aio_request ovs_aio_request;
 typedef struct ovs_completion ovs_completion_t;
 typedef void (*ovs_callback_t)(ovs_completion_t *cb, void *arg);
@@ -68,6 +69,12 @@ struct ovs_snapshot_info
     uint64_t size;
 };
 
+struct ovs_extent
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
 /*
  * Initialize Open vStorage context
  * param volume_name: Volume name
@@ -167,6 +174,25 @@ int
 ovs_snapshot_is_synced(const char *volume_name,
                        const char *snap_name);
 
+/*
+ * List the extents written to after a snapshot up to and including another one
+ * param volume_name: Volume name
+ * param start_snap_name: Start snapshot name, or NULL to start at the
+ *                        creation of the volume
+ * param end_snap_name: End snapshot name
+ * param extents: Extents array (offset and length in bytes)
+ * param max_extents: The size of the extents array
+ * On error the number of extents is returned in max_extents
+ * and errno is set to ERANGE.
+ * return: The number of extents on success, -1 on fail
+ */
+int
+ovs_snapshot_diff(const char *volume_name,
+                  const char *start_snap_name,
+                  const char *end_snap_name,
+                  ovs_extent_t *extents,
+                  size_t *max_extents);
+
 /*
  * List volumes
  * param names: Volumes string
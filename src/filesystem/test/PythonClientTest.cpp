@@ -1926,6 +1926,64 @@ TEST_F(PythonClientTest, backend_sync_snapshot)
                                                         snap));
 }
 
+TEST_F(PythonClientTest, changed_extents)
+{
+    const vfs::FrontendPath vpath(make_volume_name("/some-volume"));
+    const vfs::ObjectId vol_id(create_file(vpath, 10 << 20));
+    const uint64_t csize = get_cluster_size(vol_id);
+
+    using Extents = std::vector<std::pair<uint64_t, uint64_t>>;
+
+    auto check([&](const boost::optional<std::string>& start_snap,
+                   const std::string& end_snap,
+                   const Extents& exp)
+               {
+                   const bpy::list l(client_.get_changed_extents(vol_id,
+                                                                 end_snap,
+                                                                 start_snap));
+                   ASSERT_EQ(exp.size(),
+                             bpy::len(l));
+
+                   for (size_t i = 0; i < exp.size(); ++i)
+                   {
+                       const uint64_t off = bpy::extract<uint64_t>(l[i][0]);
+                       const uint64_t len = bpy::extract<uint64_t>(l[i][1]);
+                       EXPECT_EQ(exp[i],
+                                 std::make_pair(off, len));
+                   }
+               });
+
+    write_to_file(vpath, "first", 2 * csize, 4 * csize);
+    const std::string snap1(client_.create_snapshot(vol_id));
+    wait_for_snapshot(vol_id, snap1);
+
+    write_to_file(vpath, "second", csize, 16 * csize);
+    const std::string snap2(client_.create_snapshot(vol_id));
+    wait_for_snapshot(vol_id, snap2);
+
+    check(boost::none,
+          snap1,
+          Extents{ { 4 * csize, 2 * csize } });
+
+    check(snap1,
+          snap2,
+          Extents{ { 16 * csize, csize } });
+
+    check(boost::none,
+          snap2,
+          Extents{ { 4 * csize, 2 * csize },
+                   { 16 * csize, csize } });
+
+    check(snap2,
+          snap2,
+          Extents());
+
+    EXPECT_THROW(client_.get_changed_extents(vol_id,
+                                             "no-such-snapshot",
+                                             boost::none),
+                 std::exception);
+}
+
 TEST_F(PythonClientTest, metadata_cache_capacity)
 {
     const vfs::FrontendPath vpath(make_volume_name("/some-volume"));
@@ -0,0 +1,172 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../RestartScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <boost/lexical_cast.hpp>
+
+#include <youtils/TestBase.h>
+
+namespace volumedriverfstest
+{
+
+using namespace volumedriverfs;
+
+class RestartSchedulerTest
+    : public youtilstest::TestBase
+{
+protected:
+    static ObjectId
+    make_id(size_t i)
+    {
+        return ObjectId(boost::lexical_cast<std::string>(i));
+    }
+};
+
+TEST_F(RestartSchedulerTest, nothing_to_do)
+{
+    RestartScheduler sched(4);
+
+    const RestartScheduler::Results
+        res(sched.run([](const ObjectId&)
+                      {
+                          FAIL() << "there's nothing to restart";
+                      }));
+
+    EXPECT_TRUE(res.empty());
+}
+
+TEST_F(RestartSchedulerTest, priorities)
+{
+    RestartScheduler sched(1);
+
+    const std::vector<uint64_t> prios{ 1, 7, 0, 7, 3 };
+
+    for (size_t i = 0; i < prios.size(); ++i)
+    {
+        sched.add(make_id(i),
+                  prios[i]);
+    }
+
+    std::vector<ObjectId> order;
+
+    const RestartScheduler::Results
+        res(sched.run([&](const ObjectId& id)
+                      {
+                          order.push_back(id);
+                      }));
+
+    // same priority: order of addition
+    const std::vector<ObjectId> exp{ make_id(1),
+                                     make_id(3),
+                                     make_id(4),
+                                     make_id(0),
+                                     make_id(2) };
+
+    EXPECT_EQ(exp, order);
+
+    ASSERT_EQ(exp.size(), res.size());
+
+    for (size_t i = 0; i < exp.size(); ++i)
+    {
+        EXPECT_EQ(exp[i], res[i].id);
+        EXPECT_TRUE(res[i].ok);
+    }
+}
+
+TEST_F(RestartSchedulerTest, bounded_parallelism)
+{
+    const uint32_t parallelism = 3;
+    const size_t count = 12;
+
+    RestartScheduler sched(parallelism);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        sched.add(make_id(i));
+    }
+
+    std::atomic<uint32_t> running(0);
+    std::atomic<uint32_t> max_running(0);
+
+    std::mutex lock;
+    std::set<ObjectId> seen;
+
+    const RestartScheduler::Results
+        res(sched.run([&](const ObjectId& id)
+                      {
+                          {
+                              std::lock_guard<std::mutex> g(lock);
+                              EXPECT_TRUE(seen.insert(id).second);
+                          }
+
+                          const uint32_t r = ++running;
+
+                          uint32_t m = max_running;
+                          while (m < r and
+                                 not max_running.compare_exchange_weak(m, r))
+                          {
+                          }
+
+                          std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                          --running;
+                      }));
+
+    EXPECT_EQ(count, seen.size());
+    EXPECT_EQ(count, res.size());
+    EXPECT_LE(max_running, parallelism);
+    // not strictly guaranteed, but with the above sleep it'd take a really
+    // sluggish scheduler for this to fail
+    EXPECT_LT(1U, max_running);
+}
+
+TEST_F(RestartSchedulerTest, failures)
+{
+    RestartScheduler sched(2);
+    const size_t count = 10;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        sched.add(make_id(i));
+    }
+
+    std::atomic<size_t> calls(0);
+
+    const RestartScheduler::Results
+        res(sched.run([&](const ObjectId& id)
+                      {
+                          ++calls;
+                          if (boost::lexical_cast<size_t>(id.str()) % 2)
+                          {
+                              throw std::runtime_error("failed to restart");
+                          }
+                      }));
+
+    EXPECT_EQ(count, calls);
+    ASSERT_EQ(count, res.size());
+
+    for (const auto& r : res)
+    {
+        EXPECT_EQ(boost::lexical_cast<size_t>(r.id.str()) % 2 == 0,
+                  r.ok);
+    }
+}
+
+}
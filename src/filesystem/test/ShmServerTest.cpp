@@ -526,6 +526,114 @@ TEST_F(ShmServerTest, ovs_create_rollback_list_remove_snapshot)
                                   "snap1"));
 }
 
+TEST_F(ShmServerTest, ovs_snapshot_diff)
+{
+    uint64_t volume_size = 1 << 30;
+    int64_t timeout = 10;
+    EXPECT_EQ(0,
+              ovs_create_volume("volume",
+                                volume_size));
+    ovs_ctx_t *ctx = ovs_ctx_init("volume",
+                                  O_RDWR);
+    ASSERT_TRUE(ctx != nullptr);
+
+    const size_t len = 4096;
+    const off_t off2 = 1 << 20;
+    ovs_buffer_t *wbuf = ovs_allocate(ctx,
+                                      len);
+    ASSERT_TRUE(wbuf != nullptr);
+    memset(ovs_buffer_data(wbuf),
+           'x',
+           len);
+
+    EXPECT_EQ(len,
+              ovs_write(ctx,
+                        ovs_buffer_data(wbuf),
+                        len,
+                        0));
+    EXPECT_EQ(0,
+              ovs_snapshot_create("volume",
+                                  "snap1",
+                                  timeout));
+
+    EXPECT_EQ(len,
+              ovs_write(ctx,
+                        ovs_buffer_data(wbuf),
+                        len,
+                        off2));
+    EXPECT_EQ(0,
+              ovs_snapshot_create("volume",
+                                  "snap2",
+                                  timeout));
+
+    EXPECT_EQ(0,
+              ovs_deallocate(ctx,
+                             wbuf));
+    EXPECT_EQ(0,
+              ovs_ctx_destroy(ctx));
+
+    ovs_extent_t extents[2];
+    size_t max_extents = 2;
+
+    EXPECT_EQ(1,
+              ovs_snapshot_diff("volume",
+                                NULL,
+                                "snap1",
+                                extents,
+                                &max_extents));
+    EXPECT_EQ(0U,
+              extents[0].offset);
+    EXPECT_LE(len,
+              extents[0].length);
+
+    EXPECT_EQ(1,
+              ovs_snapshot_diff("volume",
+                                "snap1",
+                                "snap2",
+                                extents,
+                                &max_extents));
+    EXPECT_GE(static_cast<uint64_t>(off2),
+              extents[0].offset);
+    EXPECT_LT(static_cast<uint64_t>(off2),
+              extents[0].offset + extents[0].length);
+
+    EXPECT_EQ(2,
+              ovs_snapshot_diff("volume",
+                                NULL,
+                                "snap2",
+                                extents,
+                                &max_extents));
+
+    // same snapshot: nothing changed
+    EXPECT_EQ(0,
+              ovs_snapshot_diff("volume",
+                                "snap2",
+                                "snap2",
+                                extents,
+                                &max_extents));
+
+    max_extents = 1;
+    EXPECT_EQ(-1,
+              ovs_snapshot_diff("volume",
+                                NULL,
+                                "snap2",
+                                extents,
+                                &max_extents));
+    EXPECT_EQ(ERANGE,
+              errno);
+    EXPECT_EQ(2U,
+              max_extents);
+
+    EXPECT_EQ(-1,
+              ovs_snapshot_diff("volume",
+                                NULL,
+                                "fsnap",
+                                extents,
+                                &max_extents));
+    EXPECT_EQ(ENOENT,
+              errno);
+}
+
 TEST_F(ShmServerTest, ovs_completion_two_ctxs)
 {
     struct completion_function
@@ -927,6 +927,15 @@ api::getScrubbingWork(const vd::VolumeId& volName,
                                                                      end_snap);
 }
 
+vd::ChangedClusters
+api::getChangedClusters(vd::WeakVolumePtr vol,
+                        const boost::optional<vd::SnapshotName>& start_snap,
+                        const vd::SnapshotName& end_snap)
+{
+    return SharedVolumePtr(vol)->getChangedClusters(start_snap,
+                                                    end_snap);
+}
+
 boost::optional<be::Garbage>
 api::applyScrubbingWork(const vd::VolumeId& volName,
                         const scrubbing::ScrubReply& scrub_reply,
@@ -18,6 +18,7 @@
 // currently the api leaks too many implementation details - this needs to be
 // revised
 
+#include "ChangedClusters.h"
 #include "ClusterCache.h"
 #include "ClusterCount.h"
 #include "Events.h"
@@ -469,6 +470,13 @@ public:
                      const boost::optional<volumedriver::SnapshotName>& start_snap,
                      const boost::optional<volumedriver::SnapshotName>& end_snap);
 
+    // Does not require the management mutex to be held as this might have to
+    // fetch TLogs from the backend.
+    static volumedriver::ChangedClusters
+    getChangedClusters(volumedriver::WeakVolumePtr,
+                       const boost::optional<volumedriver::SnapshotName>& start_snap,
+                       const volumedriver::SnapshotName& end_snap);
+
     static boost::optional<backend::Garbage>
     applyScrubbingWork(const volumedriver::VolumeId&,
                        const scrubbing::ScrubReply&,
@@ -14,6 +14,7 @@
 
 #include "ArakoonMetaDataBackend.h"
 #include "CachedMetaDataPage.h"
+#include "CachePageCodec.h"
 #include "CachedMetaDataStore.h"
 #include "MetaDataBackendConfig.h"
 #include "VolumeConfig.h"
@@ -67,22 +68,6 @@ private:
 namespace arakoon
 {
 
-template<>
-struct DataBufferTraits<volumedriver::CachePage>
-{
-    static size_t
-    size(const volumedriver::CachePage&)
-    {
-        return volumedriver::CachePage::size();
-    }
-
-    static const void*
-    data(const volumedriver::CachePage& page)
-    {
-        return (const void*)page.data();
-    }
-};
-
 template<>
 struct DataBufferTraits<volumedriver::ArakoonMetaDataPageKey>
 {
@@ -167,6 +152,7 @@ ArakoonMetaDataBackend::ArakoonMetaDataBackend(const ArakoonMetaDataBackendConfi
     , write_sequence_data_(VolManager::get()->arakoon_metadata_sequence_size.value() *
                            CachePage::capacity())
     , config_(cfg)
+    , encode_pages_(VolManager::get()->metadata_page_encoding.value())
 {
     write_sequence_.reserve(VolManager::get()->arakoon_metadata_sequence_size.value());
 
@@ -351,9 +337,9 @@ ArakoonMetaDataBackend::getPage(CachePage& p,
     try
     {
         ara::buffer b = (try_parent ? *parent_cluster_ : cluster_).get(key);
-        std::pair<size_t, void*> buf = b.release();
-        VERIFY(buf.first == CachePage::size());
-        memcpy(p.data(), buf.second, buf.first);
+        CachePageCodec::decode(b.data(),
+                               b.size(),
+                               p);
         return true;
     }
     catch (ara::error_not_found&)
@@ -399,9 +385,12 @@ ArakoonMetaDataBackend::getPage(CachePage& p)
         ArakoonMetaDataPageKey key(page_dir_,
                                    p.page_address());
 
+        std::string val;
+        CachePageCodec::serialize(p, val, encode_pages_);
+
         try
         {
-            cluster_.set(key, p);
+            cluster_.set(key, val);
         }
         CATCH_STD_ALL_LOG_RETHROW(ns_ << ": set failed")
 
@@ -516,6 +505,76 @@ ArakoonMetaDataBackend::discardPage(const CachePage& p,
     CATCH_STD_ALL_LOG_RETHROW(ns_ << ": failed to discard page")
 }
 
+void
+ArakoonMetaDataBackend::putPages(const PageUpdates& pages)
+{
+    LOG_TRACE(ns_ << ": " << pages.size() << " pages");
+
+    int64_t used = used_clusters_;
+
+    try
+    {
+        for (const auto& u : pages)
+        {
+            write_sequence_.emplace_back(u.page,
+                                         &write_sequence_data_[write_sequence_.size()]);
+            used += u.used_clusters_delta;
+            maybe_flush_write_sequence_();
+        }
+
+        ASSERT(used >= 0);
+        used_clusters_ = used;
+    }
+    CATCH_STD_ALL_LOG_RETHROW(ns_ << ": failed to put pages")
+}
+
+void
+ArakoonMetaDataBackend::discardPages(const PageUpdates& pages)
+{
+    LOG_TRACE(ns_ << ": " << pages.size() << " pages");
+
+    if (pages.empty())
+    {
+        return;
+    }
+
+    // cf. discardPage
+    flush_write_sequence_(false);
+
+    ASSERT(write_sequence_.empty());
+
+    int64_t used = used_clusters_;
+    ara::sequence s;
+
+    for (const auto& u : pages)
+    {
+        ArakoonMetaDataPageKey key(page_dir_,
+                                   u.page.page_address());
+        s.add_delete(key);
+        used += u.used_clusters_delta;
+    }
+
+    ASSERT(used >= 0);
+    s.add_set(used_clusters_key_, used);
+
+    try
+    {
+        cluster_.sequence(s);
+        used_clusters_ = used;
+    }
+    catch (ara::error_not_found&)
+    {
+        // (at least) one of the pages does not exist in the backend and the whole
+        // sequence was aborted - retry one by one.
+        for (const auto& u : pages)
+        {
+            discardPage(u.page,
+                        u.used_clusters_delta);
+        }
+    }
+    CATCH_STD_ALL_LOG_RETHROW(ns_ << ": failed to discard pages")
+}
+
 void
 ArakoonMetaDataBackend::clear_all_keys()
 {
@@ -636,12 +695,20 @@ ArakoonMetaDataBackend::build_write_sequence_()
     LOG_TRACE(ns_);
 
     ara::sequence seq;
+
+    write_sequence_values_.clear();
+    write_sequence_values_.reserve(write_sequence_.size());
+
     for (const auto& e : write_sequence_)
     {
         LOG_TRACE(ns_ << ": adding page " << e.page_address() << " to sequence");
         const ArakoonMetaDataPageKey key(page_dir_,
                                          e.page_address());
-        seq.add_set(key, e);
+        write_sequence_values_.emplace_back();
+        CachePageCodec::serialize(e,
+                                  write_sequence_values_.back(),
+                                  encode_pages_);
+        seq.add_set(key, write_sequence_values_.back());
     }
 
     write_sequence_.clear();
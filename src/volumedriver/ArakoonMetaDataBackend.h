@@ -59,6 +59,12 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    virtual void
+    putPages(const PageUpdates& pages) override final;
+
+    virtual void
+    discardPages(const PageUpdates& pages) override final;
+
     bool
     pageExistsInParent(const PageAddress pa) const override final;
 
@@ -162,8 +168,11 @@ private:
     // This is a bandaid as the arakoon::sequence cannot be inspected.
     std::vector<ClusterLocationAndHash> write_sequence_data_;
     std::vector<CachePage> write_sequence_;
+    // serialized pages referenced by the sequence built from write_sequence_
+    std::vector<std::string> write_sequence_values_;
 
     const ArakoonMetaDataBackendConfig config_;
+    const bool encode_pages_;
     // virtual void
     // debugPrint();
 
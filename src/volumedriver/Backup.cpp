@@ -14,6 +14,9 @@
 
 #include "Backup.h"
 
+#include <deque>
+#include <future>
+
 #include <boost/dynamic_bitset.hpp>
 #include <boost/property_tree/info_parser.hpp>
 #include <boost/scope_exit.hpp>
@@ -21,6 +24,7 @@
 #include "failovercache/fungilib/Mutex.h"
 
 #include <backend/BackendConnectionManager.h>
+#include <backend/ObjectCopier.h>
 
 #include <volumedriver/Api.h>
 #include <volumedriver/BackwardTLogReader.h>
@@ -61,6 +65,9 @@ Backup::Backup(const boost::property_tree::ptree& config_ptree)
      , grace_period_(youtils::GracePeriod(boost::posix_time::seconds(configuration_ptree_.get<uint64_t>("grace_period_in_seconds",
                                                                                                         30))))
      , total_size_(0)
+     , copy_streams_(std::max<size_t>(configuration_ptree_.get<size_t>("copy_streams",
+                                                                       backend::ObjectCopier::default_streams),
+                                      1))
 {
     LOG_INFO("Report threshold is " << report_threshold);
     LOG_INFO("grace_period_in_seconds is " << static_cast<boost::posix_time::time_duration>(grace_period_));
@@ -678,12 +685,31 @@ Backup::replay_tlogs_on_target()
     const uint64_t cluster_size = source_volume_config->lba_size_ * source_volume_config->cluster_mult_;
 
     FileUtils::checkDirectoryEmptyOrNonExistant(tlogDir);
-    const fs::path the_sco = file_pool->newFile("the_sco");
     // Y42
     const unsigned MAX_SCO_SIZE = 3 * source_volume_config->sco_mult_
         * source_volume_config->cluster_mult_ * source_volume_config->lba_size_;
-    std::vector<byte> buf(MAX_SCO_SIZE);
 
+    // Fetches a SCO into memory. Up to copy_streams_ of these run concurrently
+    // ahead of the replay, which itself has to stay strictly ordered.
+    auto fetch_sco([&](backend::BackendInterfacePtr bi,
+                       const SCO sco) -> std::vector<byte>
+                   {
+                       const fs::path p(file_pool->tempFile(sco.str()));
+                       ALWAYS_CLEANUP_FILE(p);
+
+                       bi->read(p,
+                                sco.str(),
+                                InsistOnLatestVersion::F);
+
+                       const uint64_t size = fs::file_size(p);
+                       VERIFY(size <= MAX_SCO_SIZE);
+
+                       std::vector<byte> buf(size);
+                       youtils::FileDescriptor sio(p, youtils::FDMode::Read);
+                       const ssize_t res = sio.read(buf.data(), size);
+                       VERIFY(res == static_cast<ssize_t>(size));
+                       return buf;
+                   });
 
     //    VERIFY(source_snapshot_persistor);
     // const uint64_t total_size(source_snapshot_persistor->getBackendSize(end_snapshot_name,
@@ -694,7 +720,8 @@ Backup::replay_tlogs_on_target()
     status_.start(target_volume_.get(),
                   total_size_);
 
-    LOG_INFO("Replaying the source tlogs on the target volume");
+    LOG_INFO("Replaying the source tlogs on the target volume, fetching up to " <<
+             copy_streams_ << " SCOs concurrently");
 
     // This has to change... there is no guarantee that the clonetlogs are filled up correctly
     // other than most of our code does is... should be a map
@@ -715,74 +742,112 @@ Backup::replay_tlogs_on_target()
             LOG_INFO("Working on TLog " << *tlog_it);
             status_.current_tlog(*tlog_it);
 
-            std::unique_ptr<TLogReaderInterface>
-                tlog_reader(new volumedriver::BackwardTLogReader(tlogDir,
-                                                                 boost::lexical_cast<std::string>(*tlog_it),
-                                                                 nsid.get(i->first)->clone()));
+            // First pass: find the clusters to replay and the SCOs they live
+            // in (in the order they're needed) so the latter can be fetched
+            // ahead of time.
+            std::vector<std::pair<ClusterAddress, ClusterLocation>> clusters;
+            std::vector<SCO> scos;
 
-            SCO current_sco;
-            uint64_t current_sco_size = 0;
-
-            const Entry* entry = 0;
-            while((entry = tlog_reader->nextLocation()))
             {
+                std::unique_ptr<TLogReaderInterface>
+                    tlog_reader(new volumedriver::BackwardTLogReader(tlogDir,
+                                                                     boost::lexical_cast<std::string>(*tlog_it),
+                                                                     nsid.get(i->first)->clone()));
 
-                boost::this_thread::interruption_point();
-                // Y42 do we do CRC checking here?
-                if(entry->isLocation())
+                const Entry* entry = 0;
+                while((entry = tlog_reader->nextLocation()))
                 {
-                    status_.add_seen();
-
-                    const ClusterAddress cluster_address = entry->clusterAddress();
-                    VERIFY(cluster_address < bitset_size);
-                    if(not cluster_bitset.test(cluster_address))
+                    boost::this_thread::interruption_point();
+                    // Y42 do we do CRC checking here?
+                    if(entry->isLocation())
                     {
-                        status_.add_kept();
-
-                        const ClusterLocation cluster_location(entry->clusterLocation());
-                        const SCO looking_at_sco(cluster_location.sco());
+                        status_.add_seen();
 
-                        if(looking_at_sco != current_sco)
+                        const ClusterAddress cluster_address = entry->clusterAddress();
+                        VERIFY(cluster_address < bitset_size);
+                        if(not cluster_bitset.test(cluster_address))
                         {
-                            nsid.get(i->first)->read(the_sco,
-                                                     looking_at_sco.str(),
-                                                     InsistOnLatestVersion::F);
-                            ALWAYS_CLEANUP_FILE(the_sco);
-
-                            current_sco_size = fs::file_size(the_sco);
-                            VERIFY(current_sco_size <= buf.size());
-                            youtils::FileDescriptor sio(the_sco, youtils::FDMode::Read);
-                            const ssize_t res = sio.read(&buf[0], current_sco_size);
-                            VERIFY(res == static_cast<ssize_t>(current_sco_size));
-                            current_sco = looking_at_sco;
-                        }
+                            status_.add_kept();
+                            cluster_bitset[cluster_address] = 1;
 
-                        VERIFY((cluster_location.offset() + 1) * cluster_size <= current_sco_size);
-                        boost::this_thread::interruption_point();
-                        bool finished = false;
-                        while(not finished)
-                        {
-                            try
-                            {
-                                api::Write(target_volume_.get(),
-                                           cluster_address << 3,
-                                           &buf[0] + (cluster_location.offset() * cluster_size),
-                                           cluster_size);
-                                finished = true;
-                            }
-                            catch(TransientException& e)
+                            const ClusterLocation cluster_location(entry->clusterLocation());
+                            if(scos.empty() or scos.back() != cluster_location.sco())
                             {
-                                LOG_INFO("Caught a transient exception while writing, sleeping for "
-                                         << usleep_micro_sec << " microseconds");
-                                usleep(usleep_micro_sec);
-                                if(usleep_micro_sec < ten_seconds)
-                                {
-                                    usleep_micro_sec = std::min(usleep_micro_sec * 2, ten_seconds);
-                                }
+                                scos.push_back(cluster_location.sco());
                             }
+
+                            clusters.emplace_back(cluster_address,
+                                                  cluster_location);
                         }
+                    }
+                }
+            }
 
-                        cluster_bitset[cluster_address] = 1;
+            // Declared after `scos' as the pending fetches reference it.
+            std::deque<std::future<std::vector<byte>>> prefetched;
+            size_t next_fetch = 0;
+
+            auto prefetch([&]
+                          {
+                              while(next_fetch < scos.size() and
+                                    prefetched.size() < copy_streams_)
+                              {
+                                  prefetched.emplace_back(std::async(std::launch::async,
+                                                                     fetch_sco,
+                                                                     nsid.get(i->first)->clone(),
+                                                                     scos[next_fetch++]));
+                              }
+                          });
+
+            prefetch();
+
+            // Second pass: replay them on the target, in order.
+            SCO current_sco;
+            std::vector<byte> buf;
+            size_t next_sco = 0;
+
+            for(const auto& c : clusters)
+            {
+                const ClusterAddress cluster_address = c.first;
+                const ClusterLocation& cluster_location = c.second;
+                const SCO looking_at_sco(cluster_location.sco());
+
+                if(looking_at_sco != current_sco)
+                {
+                    VERIFY(next_sco < scos.size());
+                    VERIFY(scos[next_sco] == looking_at_sco);
+                    VERIFY(not prefetched.empty());
+
+                    buf = prefetched.front().get();
+                    prefetched.pop_front();
+                    ++next_sco;
+                    current_sco = looking_at_sco;
+
+                    prefetch();
+                }
+
+                VERIFY((cluster_location.offset() + 1) * cluster_size <= buf.size());
+                boost::this_thread::interruption_point();
+                bool finished = false;
+                while(not finished)
+                {
+                    try
+                    {
+                        api::Write(target_volume_.get(),
+                                   cluster_address << 3,
+                                   &buf[0] + (cluster_location.offset() * cluster_size),
+                                   cluster_size);
+                        finished = true;
+                    }
+                    catch(TransientException& e)
+                    {
+                        LOG_INFO("Caught a transient exception while writing, sleeping for "
+                                 << usleep_micro_sec << " microseconds");
+                        usleep(usleep_micro_sec);
+                        if(usleep_micro_sec < ten_seconds)
+                        {
+                            usleep_micro_sec = std::min(usleep_micro_sec * 2, ten_seconds);
+                        }
                     }
                 }
             }
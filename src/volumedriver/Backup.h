@@ -154,6 +154,8 @@ private:
 public:
     const youtils::GracePeriod grace_period_;
     uint64_t total_size_;
+    // Number of SCOs fetched concurrently while replaying the TLogs.
+    const size_t copy_streams_;
 
 };
 
@@ -0,0 +1,352 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CachedMetaDataPage.h"
+#include "CachePageCodec.h"
+#include "ClusterLocationAndHash.h"
+
+#include <string.h>
+
+#include <snappy.h>
+
+namespace volumedriver
+{
+
+namespace
+{
+
+// first byte of an encoded page
+const uint8_t format_tagged = 1;
+
+// second byte
+const uint8_t flag_snappy = 1;
+
+// header: format, flags
+const size_t header_size = 2;
+
+// snappy is not worth it for less
+const size_t snappy_min_size = 64;
+
+enum class Tag
+    : uint8_t
+{
+    // all zeroes, i.e. never written
+    Zero = 0,
+    // ClusterLocationAndHash::discarded_location_and_hash()
+    Discarded = 1,
+    // next offset in the SCO of the previous location, followed by the hash
+    Next = 2,
+    // first offset of the SCO following the one of the previous location,
+    // followed by the hash
+    NextSCO = 3,
+    // followed by the full entry
+    Full = 4,
+};
+
+const size_t loc_size = sizeof(ClusterLocation);
+const size_t hash_size = sizeof(ClusterLocationAndHash) - loc_size;
+
+bool
+same(const ClusterLocationAndHash& a,
+     const ClusterLocationAndHash& b)
+{
+    return memcmp(&a, &b, sizeof(ClusterLocationAndHash)) == 0;
+}
+
+bool
+same(const ClusterLocation& a,
+     const ClusterLocation& b)
+{
+    return memcmp(&a, &b, loc_size) == 0;
+}
+
+const ClusterLocationAndHash&
+zero_entry()
+{
+    static const ClusterLocationAndHash z = []
+        {
+            ClusterLocationAndHash clh;
+            memset(&clh, 0x0, sizeof(clh));
+            return clh;
+        }();
+
+    return z;
+}
+
+ClusterLocation
+next(const ClusterLocation& prev)
+{
+    ClusterLocation loc(prev);
+    loc.offset(prev.offset() + 1);
+    return loc;
+}
+
+ClusterLocation
+next_sco(const ClusterLocation& prev)
+{
+    return ClusterLocation(prev.number() + 1,
+                           0,
+                           prev.cloneID(),
+                           prev.version());
+}
+
+void
+append(std::string& out,
+       const void* p,
+       size_t size)
+{
+    out.append(static_cast<const char*>(p),
+               size);
+}
+
+void
+append_hash(std::string& out,
+            const ClusterLocationAndHash& clh)
+{
+    append(out,
+           reinterpret_cast<const uint8_t*>(&clh) + loc_size,
+           hash_size);
+}
+
+void
+decode_tagged(const uint8_t* src,
+              size_t size,
+              CachePage& page)
+{
+    const uint8_t* const end = src + size;
+
+    auto check([&](size_t n)
+               {
+                   if (src + n > end)
+                   {
+                       throw CachePageCodecException("truncated page");
+                   }
+               });
+
+    ClusterLocation prev;
+
+    for (size_t i = 0; i < CachePage::capacity(); ++i)
+    {
+        ClusterLocationAndHash& clh = page[i];
+
+        check(1);
+        const Tag tag = static_cast<Tag>(*src++);
+
+        switch (tag)
+        {
+        case Tag::Zero:
+            clh = zero_entry();
+            break;
+        case Tag::Discarded:
+            clh = ClusterLocationAndHash::discarded_location_and_hash();
+            break;
+        case Tag::Next:
+        case Tag::NextSCO:
+            {
+                check(hash_size);
+
+                const ClusterLocation loc(tag == Tag::Next ?
+                                          next(prev) :
+                                          next_sco(prev));
+                memcpy(&clh, &loc, loc_size);
+                memcpy(reinterpret_cast<uint8_t*>(&clh) + loc_size,
+                       src,
+                       hash_size);
+                src += hash_size;
+                prev = loc;
+                break;
+            }
+        case Tag::Full:
+            check(sizeof(clh));
+            memcpy(&clh, src, sizeof(clh));
+            src += sizeof(clh);
+            prev = clh.clusterLocation;
+            break;
+        default:
+            throw CachePageCodecException("invalid entry tag");
+        }
+    }
+
+    if (src != end)
+    {
+        throw CachePageCodecException("trailing data after page");
+    }
+}
+
+}
+
+void
+CachePageCodec::encode(const CachePage& page,
+                       std::string& out)
+{
+    std::string tagged;
+    tagged.reserve(CachePage::size());
+
+    ClusterLocation prev;
+
+    for (size_t i = 0; i < CachePage::capacity(); ++i)
+    {
+        const ClusterLocationAndHash& clh = page[i];
+
+        if (same(clh, zero_entry()))
+        {
+            tagged.push_back(static_cast<char>(Tag::Zero));
+        }
+        else if (same(clh, ClusterLocationAndHash::discarded_location_and_hash()))
+        {
+            tagged.push_back(static_cast<char>(Tag::Discarded));
+        }
+        else
+        {
+            if (same(clh.clusterLocation, next(prev)))
+            {
+                tagged.push_back(static_cast<char>(Tag::Next));
+                append_hash(tagged, clh);
+            }
+            else if (same(clh.clusterLocation, next_sco(prev)))
+            {
+                tagged.push_back(static_cast<char>(Tag::NextSCO));
+                append_hash(tagged, clh);
+            }
+            else
+            {
+                tagged.push_back(static_cast<char>(Tag::Full));
+                append(tagged, &clh, sizeof(clh));
+            }
+
+            prev = clh.clusterLocation;
+        }
+
+        if (tagged.size() + header_size >= CachePage::size())
+        {
+            break;
+        }
+    }
+
+    out.clear();
+
+    if (tagged.size() + header_size >= CachePage::size())
+    {
+        append(out,
+               page.data(),
+               CachePage::size());
+        return;
+    }
+
+    if (tagged.size() >= snappy_min_size)
+    {
+        out.resize(header_size + snappy::MaxCompressedLength(tagged.size()));
+
+        size_t res = 0;
+        snappy::RawCompress(tagged.data(),
+                            tagged.size(),
+                            &out[header_size],
+                            &res);
+        if (res < tagged.size())
+        {
+            out[0] = format_tagged;
+            out[1] = flag_snappy;
+            out.resize(header_size + res);
+            return;
+        }
+    }
+
+    out.clear();
+    out.reserve(header_size + tagged.size());
+    out.push_back(format_tagged);
+    out.push_back(0);
+    out.append(tagged);
+}
+
+void
+CachePageCodec::serialize(const CachePage& page,
+                          std::string& out,
+                          bool enc)
+{
+    if (enc)
+    {
+        encode(page,
+               out);
+    }
+    else
+    {
+        out.assign(reinterpret_cast<const char*>(page.data()),
+                   CachePage::size());
+    }
+}
+
+void
+CachePageCodec::decode(const void* buf,
+                       size_t size,
+                       CachePage& page)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(buf);
+
+    if (size == CachePage::size())
+    {
+        memcpy(page.data(), src, size);
+        return;
+    }
+
+    if (size < header_size or
+        size > CachePage::size() or
+        src[0] != format_tagged)
+    {
+        throw CachePageCodecException("not a metadata page");
+    }
+
+    if (src[1] & flag_snappy)
+    {
+        const char* csrc = reinterpret_cast<const char*>(src + header_size);
+        const size_t csize = size - header_size;
+
+        size_t n = 0;
+        if (not snappy::GetUncompressedLength(csrc,
+                                              csize,
+                                              &n))
+        {
+            throw CachePageCodecException("invalid compressed page");
+        }
+
+        // the tagged representation can't be larger than the raw one
+        if (n > CachePage::capacity() * (1 + sizeof(ClusterLocationAndHash)))
+        {
+            throw CachePageCodecException("invalid size of compressed page");
+        }
+
+        std::vector<uint8_t> tagged(n);
+        if (not snappy::RawUncompress(csrc,
+                                      csize,
+                                      reinterpret_cast<char*>(tagged.data())))
+        {
+            throw CachePageCodecException("failed to decompress page");
+        }
+
+        decode_tagged(tagged.data(),
+                      tagged.size(),
+                      page);
+    }
+    else
+    {
+        decode_tagged(src + header_size,
+                      size - header_size,
+                      page);
+    }
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
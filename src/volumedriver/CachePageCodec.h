@@ -0,0 +1,65 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VD_CACHE_PAGE_CODEC_H_
+#define VD_CACHE_PAGE_CODEC_H_
+
+#include <string>
+
+#include <youtils/IOException.h>
+
+namespace volumedriver
+{
+
+class CachePage;
+
+MAKE_EXCEPTION(CachePageCodecException, fungi::IOException);
+
+// Format of the metadata pages as stored by the RocksDB, Arakoon and MDS
+// backends (and hence also as sent to the MDS):
+// * the raw page (CachePage::size() bytes) - this is what older versions
+//   wrote and is still used unless the encoding is enabled (cf. the
+//   metadata_page_encoding parameter) and pays off
+// * otherwise an encoded page which is always smaller than that: each entry is
+//   described by a tag - all zeroes (never written), discarded, the cluster
+//   following the previous one in the same SCO / at the start of the next SCO,
+//   or the full entry. Hashes are only stored for the entries that need one.
+//   The result is snappy compressed if that helps any further.
+// The size is what tells the two formats apart.
+struct CachePageCodec
+{
+    static void
+    encode(const CachePage&,
+           std::string&);
+
+    // Encodes the page if requested, copies it raw otherwise.
+    static void
+    serialize(const CachePage&,
+              std::string&,
+              bool encode);
+
+    // Throws CachePageCodecException if the buffer is neither.
+    static void
+    decode(const void* buf,
+           size_t size,
+           CachePage&);
+};
+
+}
+
+#endif // !VD_CACHE_PAGE_CODEC_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -22,11 +22,20 @@
 #include "VolManager.h"
 #include "VolumeConfig.h"
 
+#include <algorithm>
+#include <exception>
+#include <list>
+#include <unordered_map>
+
 #include <boost/foreach.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/thread.hpp>
+
+#include <procon/ProCon.h>
 
 #include <youtils/Assert.h>
 #include <youtils/ScopeExit.h>
+#include <youtils/System.h>
 
 namespace volumedriver
 {
@@ -66,11 +75,22 @@ namespace yt = youtils;
 
 uint64_t CachedMetaDataStore::replayClustersCached = 8000000;
 
+uint32_t CachedMetaDataStore::replayThreads =
+    yt::System::get_env_with_default<uint32_t>("METADATASTORE_REPLAY_THREADS",
+                                               4);
+
+uint64_t CachedMetaDataStore::relocationBatchSize =
+    yt::System::get_env_with_default<uint64_t>("METADATASTORE_RELOCATION_BATCH_SIZE",
+                                               65536);
+
 CachedMetaDataStore::CachedMetaDataStore(const MetaDataBackendInterfacePtr& backend,
                                          const std::string& id,
-                                         uint64_t capacity)
+                                         uint64_t capacity,
+                                         const std::shared_ptr<MetaDataCacheBudget>& budget)
     : backend_(backend)
-    , page_data_(capacity * CachePage::capacity())
+    , num_frames_(0)
+    , capacity_(capacity)
+    , budget_(budget)
     , num_pages_(0)
     , cache_hits_(0)
     , cache_misses_(0)
@@ -86,29 +106,79 @@ CachedMetaDataStore::CachedMetaDataStore(const MetaDataBackendInterfacePtr& back
         scrub_id_ = backend_->scrub_id();
     }
 
-    init_pages_(capacity);
+    LOG_INFO(id_ <<
+             ": page capacity (entries): " << CachePage::capacity() <<
+             ", max cached pages: " << capacity_ <<
+             (budget_ ? ", using the shared page budget" : ""));
+
+    if (budget_)
+    {
+        budget_->register_client(*this);
+    }
 }
 
 CachedMetaDataStore::~CachedMetaDataStore()
 {
+    if (budget_)
+    {
+        budget_->unregister_client(*this);
+    }
+
     write_dirty_pages_to_backend_and_clear_page_list(true,
                                                      true);
+
+    for (CachePage* p : free_pages_)
+    {
+        free_page_(p);
+    }
+}
+
+CachePage*
+CachedMetaDataStore::allocate_page_()
+{
+    std::unique_ptr<ClusterLocationAndHash[]>
+        data(new ClusterLocationAndHash[CachePage::capacity()]);
+
+    CachePage* p = new CachePage(PageAddress(0),
+                                 data.get());
+    data.release();
+    ++num_frames_;
+
+    return p;
 }
 
 void
-CachedMetaDataStore::init_pages_(size_t capacity)
+CachedMetaDataStore::free_page_(CachePage* p)
 {
-    pages_.reserve(capacity);
+    ASSERT(not p->is_in_list());
+    ASSERT(not p->is_in_set());
+
+    std::unique_ptr<ClusterLocationAndHash[]> data(p->data());
+    delete p;
+}
 
-    for (uint64_t i = 0; i < capacity; ++i)
+void
+CachedMetaDataStore::release_free_pages_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+
+    const uint64_t n = free_pages_.size();
+
+    for (CachePage* p : free_pages_)
     {
-        VERIFY((i + 1) * CachePage::capacity() <= page_data_.size());
-        pages_.emplace_back(i, &page_data_[i * CachePage::capacity()]);
+        free_page_(p);
     }
 
-    LOG_INFO(id_ <<
-             ": page capacity (entries): " << CachePage::capacity() <<
-             ", max cached pages: " << pages_.size());
+    free_pages_.clear();
+
+    ASSERT(num_frames_ >= n);
+    num_frames_ -= n;
+
+    if (budget_)
+    {
+        budget_->shrink(*this,
+                        n);
+    }
 }
 
 void
@@ -222,7 +292,7 @@ CachedMetaDataStore::getStats(MetaDataStoreStats& stats)
     stats.cache_hits = cache_hits_;
     stats.cache_misses = cache_misses_;
     stats.cached_pages = num_pages_;
-    stats.max_pages = pages_.size();
+    stats.max_pages = budget_ ? num_frames_ : capacity_;
     stats.corked_clusters.clear();
 
     getCorkedClusters(stats.corked_clusters);
@@ -348,16 +418,18 @@ CachedMetaDataStore::unCork(const boost::optional<yt::UUID>& cork)
     }
 
     {
-        uint32_t dirty_count = 0;
-
         LOCK_CACHE_READ;
+
+        std::vector<CachePage*> pages;
+        pages.reserve(num_pages_);
+
         for (CachePage& p : page_list_)
         {
-            if (maybeWritePage_locked_context(p, false))
-            {
-                dirty_count++;
-            }
+            pages.push_back(&p);
         }
+
+        const size_t dirty_count = write_pages_locked_context_(pages,
+                                                               false);
         LOG_INFO(id_ << ": written out " << dirty_count << " dirty pages");
     }
 
@@ -387,35 +459,49 @@ CachedMetaDataStore::processCloneTLogs(const CloneTLogs& ctl,
            (corks_.size() == 1 and
             corks_.front().second->empty()));
 
-    SCOCloneID prev_cloneid;
+    for (CloneTLogs::size_type i = 1; i < ctl.size(); ++i)
+    {
+        VERIFY(ctl[i - 1].first > ctl[i].first);
+    }
 
-    for (CloneTLogs::size_type i = 0; i < ctl.size(); ++i)
+    // The parallel replay bypasses the cache and writes straight to the backend,
+    // which is only what we're after if the caller asks for the result to be
+    // synced out anyway.
+    if (sync and replayThreads > 1)
     {
-        const SCOCloneID cloneid = ctl[i].first;
-        if (i != 0)
+        replay_parallel_(ctl,
+                         nsidmap,
+                         tlog_path);
+    }
+    else
+    {
+        for (const auto& clone_tlogs : ctl)
         {
-            VERIFY(prev_cloneid > cloneid);
+            const SCOCloneID cloneid = clone_tlogs.first;
+            std::shared_ptr<TLogReaderInterface>
+                r(CombinedTLogReader::create<VerifyingMappedTLogReader>(tlog_path,
+                                                                        clone_tlogs.second,
+                                                                        nsidmap.get(cloneid)->clone(),
+                                                                        CombinedTLogReader::FetchStrategy::Parallel));
+            processTLogReaderInterface(r, cloneid);
         }
-        prev_cloneid = cloneid;
-
-        const OrderedTLogIds& tlogs = ctl[i].second;
-
-        std::shared_ptr<TLogReaderInterface>
-            r(CombinedTLogReader::create(tlog_path,
-                                         tlogs,
-                                         nsidmap.get(cloneid)->clone()));
-        processTLogReaderInterface(r, cloneid);
     }
 
     if(sync)
     {
         LOCK_CACHE_WRITE;
 
+        std::vector<CachePage*> pages;
+        pages.reserve(num_pages_);
+
         for (CachePage& p : page_list_)
         {
-            maybeWritePage_locked_context(p, false);
+            pages.push_back(&p);
         }
 
+        write_pages_locked_context_(pages,
+                                    false);
+
         if (cork != boost::none)
         {
             LOCK_BACKEND;
@@ -458,18 +544,379 @@ CachedMetaDataStore::processPages(std::unique_ptr<yt::Generator<PageDataPtr>> r,
     return pages;
 }
 
+std::unique_ptr<yt::Generator<PageDataPtr>>
+CachedMetaDataStore::make_replay_generator_(std::shared_ptr<TLogReaderInterface> r)
+{
+    std::unique_ptr<PageSortingGenerator_>
+        psg(new PageSortingGenerator_(replayClustersCached, r));
+
+    return std::unique_ptr<yt::Generator<PageDataPtr>>(
+        new yt::ThreadedGenerator<PageDataPtr>(std::move(psg),
+                                               replayPagesQueued));
+}
+
 uint64_t
 CachedMetaDataStore::processTLogReaderInterface(std::shared_ptr<TLogReaderInterface> r,
                                                 SCOCloneID cloneid)
 {
-    std::unique_ptr<PageSortingGenerator_>
-        psg(new PageSortingGenerator_(replayClustersCached, r));
+    return processPages(make_replay_generator_(r),
+                        cloneid);
+}
+
+namespace
+{
+
+// Applies the TLog entries of one partition of the address space to a private
+// working set of pages during a parallel replay. The partitions are disjoint,
+// so the workers never touch the same page; only the backend access is shared.
+class ReplayWorker
+{
+public:
+    ReplayWorker(MetaDataBackendInterface& backend,
+                 boost::mutex& backend_lock,
+                 uint64_t max_pages)
+        : backend_(backend)
+        , backend_lock_(backend_lock)
+        , concurrent_reads_(backend.concurrent_reads())
+        , max_pages_(std::max<uint64_t>(max_pages,
+                                        write_back_pages_))
+    {}
+
+    ReplayWorker(const ReplayWorker&) = delete;
+
+    ReplayWorker&
+    operator=(const ReplayWorker&) = delete;
+
+    void
+    apply(const PageData& entries,
+          SCOCloneID cloneid)
+    {
+        VERIFY(not entries.empty());
+
+        CachePage& page = get_page_(CachePage::pageAddress(entries.front().clusterAddress()));
+
+        for (const Entry& e : entries)
+        {
+            ASSERT(CachePage::pageAddress(e.clusterAddress()) == page.page_address());
+
+            ClusterLocationAndHash loc(e.clusterLocationAndHash());
+            loc.clusterLocation.cloneID(cloneid);
+
+            ClusterLocationAndHash& clh = page[CachePage::offset(e.clusterAddress())];
+            if (clh.clusterLocation.isNull() and
+                not loc.clusterLocation.isNull())
+            {
+                ++page.written_clusters_since_last_backend_write;
+            }
+            else if (not clh.clusterLocation.isNull() and
+                     loc.clusterLocation.isNull())
+            {
+                ++page.discarded_clusters_since_last_backend_write;
+            }
+
+            clh = loc;
+        }
+
+        page.dirty = true;
+    }
+
+    void
+    flush()
+    {
+        while (not lru_.empty())
+        {
+            evict_();
+        }
+    }
+
+private:
+    DECLARE_LOGGER("CachedMetaDataStoreReplayWorker");
+
+    struct Frame
+    {
+        explicit Frame(PageAddress pa)
+            : data(CachePage::capacity())
+            , page(pa,
+                   data.data())
+        {}
+
+        std::vector<ClusterLocationAndHash> data;
+        CachePage page;
+        std::list<PageAddress>::iterator lru_pos;
+    };
+
+    // max number of pages written back in one go on eviction
+    static const uint32_t write_back_pages_ = 32;
+
+    MetaDataBackendInterface& backend_;
+    boost::mutex& backend_lock_;
+    const bool concurrent_reads_;
+    const uint64_t max_pages_;
+
+    std::unordered_map<PageAddress, std::unique_ptr<Frame>> frames_;
+    std::list<PageAddress> lru_;
+
+    CachePage&
+    get_page_(PageAddress pa)
+    {
+        auto it = frames_.find(pa);
+        if (it != frames_.end())
+        {
+            Frame& f = *it->second;
+            lru_.splice(lru_.end(),
+                        lru_,
+                        f.lru_pos);
+            return f.page;
+        }
+
+        if (frames_.size() >= max_pages_)
+        {
+            evict_();
+        }
+
+        std::unique_ptr<Frame> f(new Frame(pa));
+
+        bool found;
+        if (concurrent_reads_)
+        {
+            found = backend_.getPage(f->page);
+        }
+        else
+        {
+            boost::lock_guard<boost::mutex> g(backend_lock_);
+            found = backend_.getPage(f->page);
+        }
+
+        if (not found)
+        {
+            f->page.reset();
+        }
+
+        f->lru_pos = lru_.insert(lru_.end(),
+                                 pa);
+
+        CachePage& page = f->page;
+        frames_.emplace(pa,
+                        std::move(f));
+        return page;
+    }
+
+    // writes back and drops the least recently used pages
+    void
+    evict_()
+    {
+        std::vector<PageAddress> victims;
+        victims.reserve(write_back_pages_);
+
+        for (auto it = lru_.begin();
+             it != lru_.end() and victims.size() < write_back_pages_;
+             ++it)
+        {
+            victims.push_back(*it);
+        }
+
+        PageUpdates puts;
+        PageUpdates discards;
+
+        {
+            boost::lock_guard<boost::mutex> g(backend_lock_);
 
-    std::unique_ptr<yt::Generator<PageDataPtr>>
-        g(new yt::ThreadedGenerator<PageDataPtr>(std::move(psg),
-                                                 replayPagesQueued));
+            for (const auto& pa : victims)
+            {
+                const CachePage& p = frames_[pa]->page;
+                if (p.dirty)
+                {
+                    const int32_t delta = p.written_clusters_since_last_backend_write -
+                        p.discarded_clusters_since_last_backend_write;
+
+                    if (p.empty() and
+                        not backend_.pageExistsInParent(pa))
+                    {
+                        discards.emplace_back(p,
+                                              delta);
+                    }
+                    else
+                    {
+                        puts.emplace_back(p,
+                                          delta);
+                    }
+                }
+            }
+
+            if (not discards.empty())
+            {
+                backend_.discardPages(discards);
+            }
+
+            if (not puts.empty())
+            {
+                backend_.putPages(puts);
+            }
+        }
+
+        for (const auto& pa : victims)
+        {
+            auto it = frames_.find(pa);
+            ASSERT(it != frames_.end());
+            lru_.erase(it->second->lru_pos);
+            frames_.erase(it);
+        }
+    }
+};
 
-    return processPages(std::move(g), cloneid);
+}
+
+void
+CachedMetaDataStore::replay_parallel_(const CloneTLogs& ctl,
+                                      const NSIDMap& nsidmap,
+                                      const fs::path& tlog_path)
+{
+    ASSERT_CORKS_WRITE_LOCKED;
+
+    const uint32_t nthreads = replayThreads;
+    VERIFY(nthreads > 1);
+
+    LOG_INFO(id_ << ": replaying TLogs of " << ctl.size() <<
+             " clone levels with " << nthreads << " threads");
+
+    // Keep readers from (re)populating the cache with pages that are about
+    // to become stale.
+    LOCK_CACHE_WRITE;
+
+    // The workers go to the backend directly and hence the cache must not hold
+    // on to anything.
+    do_write_dirty_pages_to_backend_and_clear_page_list(true,
+                                                        false);
+
+    // Each worker is fed the pages of its regions in TLog (and clone level)
+    // order, which is all that's needed for the result to match the sequential
+    // replay.
+    using ReplayItem = std::pair<SCOCloneID, PageDataPtr>;
+    using ReplayChannel = yin::Channel<ReplayItem>;
+
+    std::vector<std::unique_ptr<ReplayChannel>> channels;
+    channels.reserve(nthreads);
+
+    for (uint32_t i = 0; i < nthreads; ++i)
+    {
+        channels.emplace_back(new ReplayChannel(replayPagesQueued));
+    }
+
+    std::vector<std::exception_ptr> errors(nthreads);
+    std::vector<boost::thread> threads;
+    threads.reserve(nthreads);
+
+    auto stop_workers([&]
+                      {
+                          for (auto& c : channels)
+                          {
+                              c->mayStop();
+                          }
+
+                          for (auto& t : threads)
+                          {
+                              if (t.joinable())
+                              {
+                                  t.join();
+                              }
+                          }
+                      });
+
+    auto on_exit(yt::make_scope_exit([&]
+                                     {
+                                         stop_workers();
+                                     }));
+
+    const uint64_t max_pages = capacity_ / nthreads;
+
+    for (uint32_t i = 0; i < nthreads; ++i)
+    {
+        ReplayChannel& chan = *channels[i];
+        std::exception_ptr& err = errors[i];
+
+        threads.emplace_back([this, &chan, &err, max_pages]
+        {
+            try
+            {
+                ReplayWorker w(*backend_,
+                               backend_lock_,
+                               max_pages);
+
+                while (true)
+                {
+                    ReplayItem item;
+
+                    try
+                    {
+                        item = chan.poll();
+                    }
+                    catch (yin::pc_exception&)
+                    {
+                        break;
+                    }
+
+                    w.apply(*item.second,
+                            item.first);
+                }
+
+                w.flush();
+            }
+            CATCH_STD_ALL_EWHAT({
+                    LOG_ERROR(id_ << ": TLog replay worker failed: " << EWHAT);
+                    err = std::current_exception();
+                    // makes the producer bail out if it's blocked on us
+                    chan.mayStop();
+                });
+        });
+    }
+
+    uint64_t pages = 0;
+
+    try
+    {
+        for (const auto& clone_tlogs : ctl)
+        {
+            const SCOCloneID cloneid = clone_tlogs.first;
+            std::shared_ptr<TLogReaderInterface>
+                r(CombinedTLogReader::create<VerifyingMappedTLogReader>(tlog_path,
+                                                                        clone_tlogs.second,
+                                                                        nsidmap.get(cloneid)->clone(),
+                                                                        CombinedTLogReader::FetchStrategy::Parallel));
+
+            std::unique_ptr<yt::Generator<PageDataPtr>> g(make_replay_generator_(r));
+
+            while (not g->finished())
+            {
+                PageDataPtr m(g->current());
+                if (not m->empty())
+                {
+                    const PageAddress pa =
+                        CachePage::pageAddress(m->front().clusterAddress());
+                    channels[(pa / replay_region_pages_) % nthreads]->offer(ReplayItem(cloneid,
+                                                                                       m));
+                    ++pages;
+                }
+
+                g->next();
+            }
+        }
+    }
+    catch (yin::pc_exception&)
+    {
+        // a worker gave up - its error is rethrown below
+    }
+
+    stop_workers();
+
+    for (const auto& e : errors)
+    {
+        if (e)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+
+    LOG_INFO(id_ << ": finished replaying " << pages << " pages");
 }
 
 void
@@ -485,6 +932,20 @@ void
 CachedMetaDataStore::do_write_dirty_pages_to_backend_and_clear_page_list(bool sync,
                                                                          bool ignore_errors)
 {
+    if (sync)
+    {
+        std::vector<CachePage*> pages;
+        pages.reserve(num_pages_);
+
+        for (auto& p : page_list_)
+        {
+            pages.push_back(&p);
+        }
+
+        write_pages_locked_context_(pages,
+                                    ignore_errors);
+    }
+
     while (not page_list_.empty())
     {
         CachePage& p(page_list_.front());
@@ -493,19 +954,12 @@ CachedMetaDataStore::do_write_dirty_pages_to_backend_and_clear_page_list(bool sy
         p.unlink_from_set();
         --num_pages_;
 
-        if (sync)
-        {
-            maybeWritePage_locked_context(p, ignore_errors);
-        }
+        p.reset();
+        free_pages_.push_back(&p);
     }
 
     ASSERT(page_map_.empty());
     ASSERT(num_pages_ == 0);
-
-    for (auto& p : pages_)
-    {
-        p.reset();
-    }
 }
 
 void
@@ -513,16 +967,19 @@ CachedMetaDataStore::write_dirty_pages_to_backend_keeping_page_list()
 {
     LOCK_CACHE_WRITE;
 
+    std::vector<CachePage*> pages;
+
     for (auto& page : page_list_)
     {
         if(page.dirty and not page.empty())
         {
-            maybeWritePage_locked_context(page, false);
-            LOCK_BACKEND;
-            dispose_page(&MetaDataBackendInterface::putPage, page);
-            page.dirty = false;
+            pages.push_back(&page);
         }
     }
+
+    LOCK_BACKEND;
+    dispose_pages_(&MetaDataBackendInterface::putPages,
+                   pages);
 }
 
 namespace
@@ -547,6 +1004,21 @@ struct PageCmp
 
 }
 
+struct CachedMetaDataStore::Relocation
+{
+    ClusterAddress ca;
+    ClusterLocation old_loc;
+    ClusterLocationAndHash new_loc;
+
+    Relocation(const ClusterAddress a,
+               const ClusterLocation& o,
+               const ClusterLocationAndHash& n)
+        : ca(a)
+        , old_loc(o)
+        , new_loc(n)
+    {}
+};
+
 uint64_t
 CachedMetaDataStore::applyRelocs(RelocationReaderFactory& factory,
                                  SCOCloneID scid,
@@ -561,10 +1033,13 @@ CachedMetaDataStore::applyRelocs(RelocationReaderFactory& factory,
 
     std::unique_ptr<TLogReaderInterface> treader(factory.get_one());
 
+    const uint64_t batch_size = std::max<uint64_t>(relocationBatchSize, 1);
+
+    std::vector<Relocation> batch;
+    batch.reserve(std::min<uint64_t>(batch_size, 4096));
+
     while ((e_old = treader->nextLocation()))
     {
-        //  No problem to keep the lock in the loop
-
         const Entry* e_new = treader->nextLocation();
         if(not e_new)
         {
@@ -582,29 +1057,25 @@ CachedMetaDataStore::applyRelocs(RelocationReaderFactory& factory,
         }
 
         ClusterLocation l_old = e_old->clusterLocation();
-
         l_old.cloneID(scid);
 
-        ClusterLocationAndHash l_current;
+        ClusterLocationAndHash l_new = e_new->clusterLocationAndHash();
+        l_new.clusterLocation.cloneID(scid);
 
-        LOCK_CACHE_WRITE;
-
-        get_page_unlocked_(a_old,
-                           l_current,
-                           false);
+        batch.emplace_back(a_old,
+                           l_old,
+                           l_new);
 
-        if (l_current.clusterLocation == l_old)
+        if (batch.size() >= batch_size)
         {
-            ClusterLocationAndHash l_new = e_new->clusterLocationAndHash();
-            l_new.clusterLocation.cloneID(scid);
-            get_page_unlocked_(a_old,
-                               const_cast<ClusterLocationAndHash&>(l_new),
-                               true);
+            apply_relocation_batch_(batch);
         }
+
         relocNum++;
     }
 
-    write_dirty_pages_to_backend_keeping_page_list();
+    apply_relocation_batch_(batch);
+
     set_scrub_id(scrub_id);
 
     sync();
@@ -612,6 +1083,58 @@ CachedMetaDataStore::applyRelocs(RelocationReaderFactory& factory,
     return relocNum;
 }
 
+// Relocations come in the order of the scrubbed SCOs, i.e. scattered all over
+// the address space. Sorting them by page (stable, as relocations of the same
+// cluster address need to be applied in order) lets us apply all updates to a
+// page under a single acquisition of the cache lock and lookup of the page, and
+// to write out the dirty pages as one batch (multisets in the MDS case) instead
+// of evicting them one by one. The cache lock is dropped between pages to not
+// stall foreground I/O for the whole batch.
+void
+CachedMetaDataStore::apply_relocation_batch_(std::vector<Relocation>& batch)
+{
+    if (batch.empty())
+    {
+        return;
+    }
+
+    std::stable_sort(batch.begin(),
+                     batch.end(),
+                     [](const Relocation& a,
+                        const Relocation& b)
+                     {
+                         return CachePage::pageAddress(a.ca) <
+                             CachePage::pageAddress(b.ca);
+                     });
+
+    auto it = batch.begin();
+
+    while (it != batch.end())
+    {
+        const PageAddress pa = CachePage::pageAddress(it->ca);
+
+        LOCK_CACHE_WRITE;
+
+        bool hit = false;
+        CachePage& page = lookup_page_unlocked_(pa,
+                                                hit);
+
+        for (; it != batch.end() and CachePage::pageAddress(it->ca) == pa; ++it)
+        {
+            if (page[CachePage::offset(it->ca)].clusterLocation == it->old_loc)
+            {
+                update_entry_unlocked_(page,
+                                       it->ca,
+                                       it->new_loc);
+            }
+        }
+    }
+
+    batch.clear();
+
+    write_dirty_pages_to_backend_keeping_page_list();
+}
+
 bool
 CachedMetaDataStore::get_page_(const ClusterAddress ca,
                                ClusterLocationAndHash& loc,
@@ -628,32 +1151,156 @@ void
 CachedMetaDataStore::set_cache_capacity(const size_t new_capacity)
 {
     LOG_INFO(id_ << ": request to change cache capacity from " <<
-             pages_.size() << " to " << new_capacity);
+             capacity_ << " to " << new_capacity);
 
     VERIFY(new_capacity > 0);
 
     LOCK_CORKS_WRITE;
     LOCK_CACHE_WRITE;
 
-    if (new_capacity != pages_.size())
+    if (new_capacity != capacity_)
     {
         do_write_dirty_pages_to_backend_and_clear_page_list(true,
                                                             true);
+        release_free_pages_();
+        capacity_ = new_capacity;
+    }
+}
+
+CachePage*
+CachedMetaDataStore::find_clean_victim_()
+{
+    uint32_t n = 0;
+
+    for (auto& p : page_list_)
+    {
+        if (n++ == clean_victim_scan_pages_)
+        {
+            break;
+        }
+
+        if (not p.dirty)
+        {
+            return &p;
+        }
+    }
+
+    return nullptr;
+}
+
+CachePage*
+CachedMetaDataStore::evict_page_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+    ASSERT(not page_list_.empty());
+
+    CachePage* page = find_clean_victim_();
+    if (page == nullptr)
+    {
+        page = &page_list_.front();
+        write_back_ahead_();
+    }
+
+    page->unlink_from_list();
+    page->unlink_from_set();
+    --num_pages_;
+    maybeWritePage_locked_context(*page, false);
+
+    return page;
+}
 
-        page_data_.resize(new_capacity * CachePage::capacity());
-        pages_.clear();
+CachePage*
+CachedMetaDataStore::get_free_page_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
 
-        init_pages_(new_capacity);
+    if (not free_pages_.empty())
+    {
+        CachePage* page = free_pages_.back();
+        free_pages_.pop_back();
+        return page;
+    }
+    else if (num_frames_ < capacity_ and
+             (budget_ == nullptr or budget_->grow(*this)))
+    {
+        return allocate_page_();
+    }
+    else
+    {
+        return evict_page_();
     }
 }
 
+bool
+CachedMetaDataStore::release_page()
+{
+    // Invoked by the budget with its lock held, hence neither blocking nor I/O
+    // allowed here.
+    boost::unique_lock<decltype(cache_lock_)> u(cache_lock_,
+                                                boost::try_to_lock);
+    if (not u.owns_lock())
+    {
+        return false;
+    }
+
+    CachePage* page = nullptr;
+
+    if (not free_pages_.empty())
+    {
+        page = free_pages_.back();
+        free_pages_.pop_back();
+    }
+    else
+    {
+        page = find_clean_victim_();
+        if (page == nullptr)
+        {
+            return false;
+        }
+
+        page->unlink_from_list();
+        page->unlink_from_set();
+        --num_pages_;
+    }
+
+    free_page_(page);
+
+    ASSERT(num_frames_ > 0);
+    --num_frames_;
+
+    return true;
+}
+
 bool
 CachedMetaDataStore::get_page_unlocked_(const ClusterAddress ca,
                                         ClusterLocationAndHash& loc,
                                         bool for_write)
 {
     bool hit = false;
-    PageAddress pa = CachePage::pageAddress(ca);
+    CachePage& page = lookup_page_unlocked_(CachePage::pageAddress(ca),
+                                            hit);
+
+    if (for_write)
+    {
+        update_entry_unlocked_(page,
+                               ca,
+                               loc);
+    }
+    else
+    {
+        loc = page[CachePage::offset(ca)];
+    }
+
+    return hit;
+}
+
+CachePage&
+CachedMetaDataStore::lookup_page_unlocked_(const PageAddress pa,
+                                           bool& hit)
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+
+    hit = false;
     CachePage* page = nullptr;
 
     typename map_type::iterator it = page_map_.find(pa,
@@ -662,23 +1309,12 @@ CachedMetaDataStore::get_page_unlocked_(const ClusterAddress ca,
     {
         ++cache_misses_;
 
-        if (num_pages_ < pages_.size())
-        {
-            page = &pages_[num_pages_];
-        }
-        else
-        {
-            page = &page_list_.front();
-            page->unlink_from_list();
-            page->unlink_from_set();
-            --num_pages_;
-            maybeWritePage_locked_context(*page, false);
-        }
+        page = get_free_page_();
 
         ASSERT(not page->dirty);
         ASSERT(not page->is_in_set());
         ASSERT(not page->is_in_list());
-        ASSERT(num_pages_ < pages_.size());
+        ASSERT(num_pages_ < num_frames_);
 
         page = new(page) CachePage(pa, page->data());
 
@@ -704,31 +1340,30 @@ CachedMetaDataStore::get_page_unlocked_(const ClusterAddress ca,
 
     page_list_.push_back(*page);
 
-    if (for_write)
-    {
-        ClusterLocationAndHash& clh = (*page)[CachePage::offset(ca)];
-        if (clh.clusterLocation.isNull() and
-            not loc.clusterLocation.isNull())
-        {
-            page->written_clusters_since_last_backend_write++;
-            written_clusters_++;
-        }
-        else if (not clh.clusterLocation.isNull() and
-                 loc.clusterLocation.isNull())
-        {
-            page->discarded_clusters_since_last_backend_write++;
-            discarded_clusters_++;
-        }
+    return *page;
+}
 
-        clh = loc;
-        page->dirty = true;
+void
+CachedMetaDataStore::update_entry_unlocked_(CachePage& page,
+                                            const ClusterAddress ca,
+                                            const ClusterLocationAndHash& loc)
+{
+    ClusterLocationAndHash& clh = page[CachePage::offset(ca)];
+    if (clh.clusterLocation.isNull() and
+        not loc.clusterLocation.isNull())
+    {
+        page.written_clusters_since_last_backend_write++;
+        written_clusters_++;
     }
-    else
+    else if (not clh.clusterLocation.isNull() and
+             loc.clusterLocation.isNull())
     {
-        loc = (*page)[CachePage::offset(ca)];
+        page.discarded_clusters_since_last_backend_write++;
+        discarded_clusters_++;
     }
 
-    return hit;
+    clh = loc;
+    page.dirty = true;
 }
 
 void
@@ -748,6 +1383,114 @@ CachedMetaDataStore::dispose_page(backend_mem_fun dispose, CachePage& p)
     p.dirty = false;
 }
 
+void
+CachedMetaDataStore::dispose_pages_(backend_batch_mem_fun dispose,
+                                    const std::vector<CachePage*>& pages)
+{
+    ASSERT_BACKEND_LOCKED;
+
+    if (pages.empty())
+    {
+        return;
+    }
+
+    PageUpdates updates;
+    updates.reserve(pages.size());
+
+    for (const CachePage* p : pages)
+    {
+        updates.emplace_back(*p,
+                             p->written_clusters_since_last_backend_write -
+                             p->discarded_clusters_since_last_backend_write);
+    }
+
+    ((*backend_).*dispose)(updates);
+
+    for (CachePage* p : pages)
+    {
+        written_clusters_ -= p->written_clusters_since_last_backend_write;
+        discarded_clusters_ -= p->discarded_clusters_since_last_backend_write;
+        p->written_clusters_since_last_backend_write = 0;
+        p->discarded_clusters_since_last_backend_write = 0;
+        p->dirty = false;
+    }
+}
+
+size_t
+CachedMetaDataStore::write_pages_locked_context_(const std::vector<CachePage*>& pages,
+                                                 bool ignore_errors)
+{
+    ASSERT_CACHE_READ_LOCKED;
+
+    std::vector<CachePage*> puts;
+    std::vector<CachePage*> discards;
+
+    try
+    {
+        LOCK_BACKEND;
+
+        for (CachePage* p : pages)
+        {
+            if (p->dirty)
+            {
+                if (p->empty() and
+                    not backend_->pageExistsInParent(p->page_address()))
+                {
+                    discards.push_back(p);
+                }
+                else
+                {
+                    puts.push_back(p);
+                }
+            }
+        }
+
+        dispose_pages_(&MetaDataBackendInterface::discardPages,
+                       discards);
+        dispose_pages_(&MetaDataBackendInterface::putPages,
+                       puts);
+
+        return puts.size();
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_ERROR(id_ << ": failed to write out " << puts.size() <<
+                      " and discard " << discards.size() << " pages: " << EWHAT);
+            if (not ignore_errors)
+            {
+                throw;
+            }
+            else
+            {
+                return 0;
+            }
+        });
+}
+
+void
+CachedMetaDataStore::write_back_ahead_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+
+    std::vector<CachePage*> pages;
+    pages.reserve(write_back_ahead_pages_);
+
+    for (auto& p : page_list_)
+    {
+        if (pages.size() == write_back_ahead_pages_)
+        {
+            break;
+        }
+
+        if (p.dirty)
+        {
+            pages.push_back(&p);
+        }
+    }
+
+    write_pages_locked_context_(pages,
+                                false);
+}
+
 // TODO: rather expensive - can we be more clever?
 bool
 CachedMetaDataStore::possibly_discard_page_(CachePage& p)
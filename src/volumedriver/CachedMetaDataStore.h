@@ -17,11 +17,13 @@
 
 #include "CachedMetaDataPage.h"
 #include "MetaDataBackendInterface.h"
+#include "MetaDataCacheBudget.h"
 #include "MetaDataStoreInterface.h"
 #include "PageSortingGenerator.h"
 #include "ScrubId.h"
 #include "Types.h"
 
+#include <atomic>
 #include <memory>
 
 #include <boost/thread/locks.hpp>
@@ -41,8 +43,12 @@ namespace volumedriver
 class ClusterLocationAndHash;
 class VolManagerTestSetup;
 
+// If a MetaDataCacheBudget is passed in, cache pages are drawn from that (shared)
+// budget on demand and `capacity' is merely an upper bound for this instance.
+// Otherwise up to `capacity' pages are used.
 class CachedMetaDataStore
     : public MetaDataStoreInterface
+    , private MetaDataCacheBudget::Client
 {
     friend class VolManagerTestSetup;
     friend class volumedrivertest::MetaDataStoreTest;
@@ -50,7 +56,8 @@ class CachedMetaDataStore
 public:
     CachedMetaDataStore(const MetaDataBackendInterfacePtr& backend,
                         const std::string& id,
-                        uint64_t capacity = default_capacity_);
+                        uint64_t capacity = default_capacity_,
+                        const std::shared_ptr<MetaDataCacheBudget>& budget = nullptr);
 
     virtual ~CachedMetaDataStore();
 
@@ -181,7 +188,7 @@ public:
     uint32_t
     capacity() const
     {
-        return pages_.size();
+        return capacity_;
     }
 
     void
@@ -199,13 +206,27 @@ public:
     static uint64_t replayClustersCached;
     static const uint32_t replayPagesQueued = 5;
 
+    // Number of threads processCloneTLogs uses to replay TLogs if sync is
+    // requested - 1 means sequential replay through the page cache.
+    static uint32_t replayThreads;
+
+    // Max number of relocations applyRelocs reads, sorts by page and applies
+    // before writing out the dirty pages in one go.
+    // Not const as ScrubberTest messes with it.
+    static uint64_t relocationBatchSize;
+
 private:
     DECLARE_LOGGER("CachedMetaDataStore");
 
     MetaDataBackendInterfacePtr backend_;
 
-    std::vector<CachePage> pages_;
-    std::vector<ClusterLocationAndHash> page_data_;
+    // Pages are allocated on demand (and accounted for with the budget_ if there
+    // is one) - num_frames_ is the total number of allocated pages, i.e. the
+    // ones in use (num_pages_) plus the ones on free_pages_.
+    std::vector<CachePage*> free_pages_;
+    uint64_t num_frames_;
+    uint64_t capacity_;
+    std::shared_ptr<MetaDataCacheBudget> budget_;
 
     // For now "num_pages_" tracks the size of the map as its ->size() is not O(1).
     // However, we only make use of auto-unlinking (which necessitates our use of
@@ -223,8 +244,8 @@ private:
     map_type page_map_;
     list_type page_list_;
     uint64_t num_pages_;
-    uint64_t cache_hits_;
-    uint64_t cache_misses_;
+    std::atomic<uint64_t> cache_hits_;
+    std::atomic<uint64_t> cache_misses_;
     uint64_t written_clusters_;
     uint64_t discarded_clusters_;
 
@@ -232,6 +253,16 @@ private:
 
     static const uint64_t default_capacity_ = 1024;
 
+    // max number of dirty pages written back ahead of eviction
+    static const uint32_t write_back_ahead_pages_ = 32;
+
+    // number of pages at the LRU end of the list that are looked at for a clean
+    // eviction candidate
+    static const uint32_t clean_victim_scan_pages_ = 8;
+
+    // parallel replay: consecutive pages handed to the same worker
+    static const uint32_t replay_region_pages_ = 16;
+
 #ifndef NDEBUG
     mutable boost::mutex uncork_dbg_mutex_;
 #endif
@@ -256,8 +287,53 @@ private:
     processPages(std::unique_ptr<youtils::Generator<PageDataPtr>> r,
                  SCOCloneID cloneid);
 
+    static std::unique_ptr<youtils::Generator<PageDataPtr>>
+    make_replay_generator_(std::shared_ptr<TLogReaderInterface> r);
+
+    void
+    replay_parallel_(const CloneTLogs& ctl,
+                     const NSIDMap& nsidmap,
+                     const boost::filesystem::path& tlog_path);
+
+    CachePage*
+    allocate_page_();
+
+    static void
+    free_page_(CachePage*);
+
     void
-    init_pages_(size_t capacity);
+    release_free_pages_();
+
+    CachePage*
+    find_clean_victim_();
+
+    CachePage*
+    evict_page_();
+
+    CachePage*
+    get_free_page_();
+
+    // MetaDataCacheBudget::Client
+    virtual const std::string&
+    cache_id() const override final
+    {
+        return id_;
+    }
+
+    virtual uint64_t
+    cache_hits() const override final
+    {
+        return cache_hits_;
+    }
+
+    virtual uint64_t
+    cache_misses() const override final
+    {
+        return cache_misses_;
+    }
+
+    virtual bool
+    release_page() override final;
 
     // bit of a misnomer - if sync is false nothing is written out!
     void
@@ -276,6 +352,20 @@ private:
                        ClusterLocationAndHash& loc,
                        bool for_write);
 
+    CachePage&
+    lookup_page_unlocked_(const PageAddress pa,
+                          bool& hit);
+
+    void
+    update_entry_unlocked_(CachePage& page,
+                           const ClusterAddress ca,
+                           const ClusterLocationAndHash& loc);
+
+    struct Relocation;
+
+    void
+    apply_relocation_batch_(std::vector<Relocation>& batch);
+
     bool
     get_page_(const ClusterAddress ca,
               ClusterLocationAndHash& loc,
@@ -295,6 +385,24 @@ private:
     maybeWritePage_locked_context(CachePage& p,
                                   bool ignore_errors);
 
+    typedef void (MetaDataBackendInterface::*backend_batch_mem_fun)(const PageUpdates&);
+
+    void
+    dispose_pages_(backend_batch_mem_fun dispose,
+                   const std::vector<CachePage*>& pages);
+
+    // Batched maybeWritePage_locked_context: returns the number of pages written
+    // out (as opposed to discarded or left alone as they're clean).
+    size_t
+    write_pages_locked_context_(const std::vector<CachePage*>& pages,
+                                bool ignore_errors);
+
+    // Called when the page to be evicted is dirty: writes it back along with the
+    // next dirty pages in LRU order, so these can be evicted later on without
+    // another trip to the backend.
+    void
+    write_back_ahead_();
+
     uint64_t
     processTLogReaderInterface(std::shared_ptr<TLogReaderInterface> r,
                                SCOCloneID cloneid);
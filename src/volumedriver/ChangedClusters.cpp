@@ -0,0 +1,290 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ChangedClusters.h"
+#include "Entry.h"
+#include "MappedTLogReader.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <youtils/System.h>
+
+#include <backend/BackendInterface.h>
+
+namespace volumedriver
+{
+
+namespace fs = boost::filesystem;
+namespace yt = youtils;
+
+uint64_t ChangedClustersCache::default_capacity =
+    yt::System::get_env_with_default<uint64_t>("CHANGED_CLUSTERS_CACHE_BYTES",
+                                               32ULL << 20);
+
+ChangedClusters::ChangedClusters(std::vector<ClusterAddress> cas)
+{
+    std::sort(cas.begin(),
+              cas.end());
+
+    for (const auto& ca : cas)
+    {
+        if (not extents_.empty())
+        {
+            Extent& e = extents_.back();
+            if (ca < e.ca + e.count)
+            {
+                continue;
+            }
+            else if (ca == e.ca + e.count)
+            {
+                ++e.count;
+                continue;
+            }
+        }
+
+        extents_.emplace_back(ca, 1);
+    }
+
+    // these end up in ChangedClustersCache, so don't waste memory
+    extents_.shrink_to_fit();
+}
+
+ChangedClusters
+ChangedClusters::from_tlog(TLogReaderInterface& reader)
+{
+    std::vector<ClusterAddress> cas;
+    const Entry* e;
+
+    while ((e = reader.nextLocation()))
+    {
+        cas.push_back(e->clusterAddress());
+    }
+
+    return ChangedClusters(std::move(cas));
+}
+
+ChangedClusters&
+ChangedClusters::merge(const ChangedClusters& other)
+{
+    if (other.empty())
+    {
+        return *this;
+    }
+
+    Extents res;
+    res.reserve(extents_.size() + other.extents_.size());
+
+    auto add([&res](const Extent& e)
+             {
+                 if (not res.empty() and
+                     e.ca <= res.back().ca + res.back().count)
+                 {
+                     Extent& last = res.back();
+                     last.count = std::max(last.ca + last.count,
+                                           e.ca + e.count) - last.ca;
+                 }
+                 else
+                 {
+                     res.push_back(e);
+                 }
+             });
+
+    auto it = extents_.begin();
+    auto oit = other.extents_.begin();
+
+    while (it != extents_.end() or oit != other.extents_.end())
+    {
+        if (oit == other.extents_.end() or
+            (it != extents_.end() and it->ca <= oit->ca))
+        {
+            add(*it++);
+        }
+        else
+        {
+            add(*oit++);
+        }
+    }
+
+    extents_ = std::move(res);
+    return *this;
+}
+
+bool
+ChangedClusters::contains(ClusterAddress ca) const
+{
+    auto it = std::upper_bound(extents_.begin(),
+                               extents_.end(),
+                               ca,
+                               [](ClusterAddress a, const Extent& e)
+                               {
+                                   return a < e.ca;
+                               });
+
+    if (it == extents_.begin())
+    {
+        return false;
+    }
+    else
+    {
+        --it;
+        return ca < it->ca + it->count;
+    }
+}
+
+uint64_t
+ChangedClusters::size() const
+{
+    uint64_t n = 0;
+    for (const auto& e : extents_)
+    {
+        n += e.count;
+    }
+
+    return n;
+}
+
+std::ostream&
+operator<<(std::ostream& os,
+           const ChangedClusters::Extent& e)
+{
+    return os << "[" << e.ca << ", " << e.count << "]";
+}
+
+std::ostream&
+operator<<(std::ostream& os,
+           const ChangedClusters& c)
+{
+    os << "ChangedClusters{";
+    bool first = true;
+    for (const auto& e : c.extents())
+    {
+        if (not first)
+        {
+            os << ", ";
+        }
+        first = false;
+        os << e;
+    }
+
+    return os << "}";
+}
+
+ChangedClustersCache::ChangedClustersCache(size_t capacity)
+    : capacity_(capacity)
+{}
+
+ChangedClustersCache::Ptr
+ChangedClustersCache::find_(const Key& key)
+{
+    auto it = map_.find(key);
+    if (it == map_.end())
+    {
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(),
+                lru_,
+                it->second);
+    return it->second->second;
+}
+
+void
+ChangedClustersCache::insert_(const Key& key,
+                              Ptr cc)
+{
+    if (map_.find(key) != map_.end())
+    {
+        return;
+    }
+
+    bytes_ += cc->footprint();
+    lru_.emplace_front(key,
+                       std::move(cc));
+    map_.emplace(key,
+                 lru_.begin());
+
+    // the most recently used entry is kept even if it exceeds the capacity on
+    // its own
+    while (bytes_ > capacity_ and lru_.size() > 1)
+    {
+        const auto& victim = lru_.back();
+        bytes_ -= victim.second->footprint();
+        map_.erase(victim.first);
+        lru_.pop_back();
+    }
+}
+
+ChangedClusters
+ChangedClustersCache::get(const fs::path& tlog_path,
+                          const OrderedTLogIds& tlog_ids,
+                          const BackendInterface& bi)
+{
+    ChangedClusters res;
+
+    for (const auto& tlog_id : tlog_ids)
+    {
+        const Key key(bi.getNS(),
+                      tlog_id);
+        Ptr cc;
+
+        {
+            boost::lock_guard<decltype(lock_)> g(lock_);
+            cc = find_(key);
+        }
+
+        if (not cc)
+        {
+            // Not holding the lock while reading the TLog - at worst it's
+            // read twice by concurrent callers.
+            LOG_TRACE(bi.getNS() << ": " << tlog_id << ": not cached, reading it");
+
+            MappedTLogReader reader(tlog_path,
+                                    boost::lexical_cast<std::string>(tlog_id),
+                                    bi.clone());
+
+            cc = std::make_shared<const ChangedClusters>(ChangedClusters::from_tlog(reader));
+
+            boost::lock_guard<decltype(lock_)> g(lock_);
+            insert_(key,
+                    cc);
+        }
+
+        res.merge(*cc);
+    }
+
+    return res;
+}
+
+size_t
+ChangedClustersCache::size() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return map_.size();
+}
+
+size_t
+ChangedClustersCache::bytes() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return bytes_;
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,211 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VD_CHANGED_CLUSTERS_H_
+#define VD_CHANGED_CLUSTERS_H_
+
+#include "TLogId.h"
+#include "Types.h"
+
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+#include <backend/Namespace.h>
+
+namespace volumedriver
+{
+
+class TLogReaderInterface;
+
+// The set of cluster addresses written to by a TLog (or a range of snapshots),
+// kept as sorted, disjoint and non-adjacent extents. Writes are typically
+// clustered, so this is a lot more compact than a bitmap over all clusters
+// of the volume (cf. Backup::replay_tlogs_on_target).
+class ChangedClusters
+{
+public:
+    struct Extent
+    {
+        Extent(ClusterAddress a,
+               uint64_t n)
+            : ca(a)
+            , count(n)
+        {}
+
+        ClusterAddress ca;
+        uint64_t count;
+
+        bool
+        operator==(const Extent& other) const
+        {
+            return ca == other.ca and count == other.count;
+        }
+
+        bool
+        operator!=(const Extent& other) const
+        {
+            return not operator==(other);
+        }
+    };
+
+    using Extents = std::vector<Extent>;
+
+    ChangedClusters() = default;
+
+    // The addresses can be passed in any order and may contain duplicates.
+    explicit ChangedClusters(std::vector<ClusterAddress>);
+
+    ~ChangedClusters() = default;
+
+    ChangedClusters(const ChangedClusters&) = default;
+
+    ChangedClusters(ChangedClusters&&) = default;
+
+    ChangedClusters&
+    operator=(const ChangedClusters&) = default;
+
+    ChangedClusters&
+    operator=(ChangedClusters&&) = default;
+
+    static ChangedClusters
+    from_tlog(TLogReaderInterface&);
+
+    ChangedClusters&
+    merge(const ChangedClusters&);
+
+    bool
+    contains(ClusterAddress) const;
+
+    // number of changed clusters (not extents)
+    uint64_t
+    size() const;
+
+    // approximate memory footprint in bytes
+    size_t
+    footprint() const
+    {
+        return sizeof(*this) + extents_.capacity() * sizeof(Extent);
+    }
+
+    bool
+    empty() const
+    {
+        return extents_.empty();
+    }
+
+    const Extents&
+    extents() const
+    {
+        return extents_;
+    }
+
+    bool
+    operator==(const ChangedClusters& other) const
+    {
+        return extents_ == other.extents_;
+    }
+
+    bool
+    operator!=(const ChangedClusters& other) const
+    {
+        return not operator==(other);
+    }
+
+private:
+    Extents extents_;
+};
+
+std::ostream&
+operator<<(std::ostream&,
+           const ChangedClusters::Extent&);
+
+std::ostream&
+operator<<(std::ostream&,
+           const ChangedClusters&);
+
+// Caches the ChangedClusters per (namespace, TLog). TLogs are immutable once
+// closed (scrubbing replaces them by new ones, with new TLogIds), so entries
+// never need to be invalidated - they're only evicted in LRU order once the
+// footprint of the cached entries exceeds the capacity (in bytes).
+// There's a single instance owned by the VolManager which is shared by all
+// volumes, i.e. the capacity is a per-process budget.
+class ChangedClustersCache
+{
+public:
+    explicit ChangedClustersCache(size_t capacity = default_capacity);
+
+    ~ChangedClustersCache() = default;
+
+    ChangedClustersCache(const ChangedClustersCache&) = delete;
+
+    ChangedClustersCache&
+    operator=(const ChangedClustersCache&) = delete;
+
+    // Union of the changed clusters of the given (closed!) TLogs of the
+    // backend's namespace. TLogs not found in tlog_path are fetched from the
+    // backend.
+    ChangedClusters
+    get(const boost::filesystem::path& tlog_path,
+        const OrderedTLogIds&,
+        const BackendInterface&);
+
+    // number of cached TLogs
+    size_t
+    size() const;
+
+    // footprint of the cached entries
+    size_t
+    bytes() const;
+
+    // Not const as XTest messes with it.
+    static uint64_t default_capacity;
+
+private:
+    DECLARE_LOGGER("ChangedClustersCache");
+
+    using Ptr = std::shared_ptr<const ChangedClusters>;
+    using Key = std::pair<backend::Namespace, TLogId>;
+    // most recently used first
+    using LRUList = std::list<std::pair<Key, Ptr>>;
+
+    mutable boost::mutex lock_;
+    const size_t capacity_;
+    size_t bytes_ = 0;
+    LRUList lru_;
+    std::map<Key, LRUList::iterator> map_;
+
+    Ptr
+    find_(const Key&);
+
+    void
+    insert_(const Key&,
+            Ptr);
+};
+
+}
+
+#endif // !VD_CHANGED_CLUSTERS_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -16,9 +16,12 @@
 #define COMBINEDTLOGBACKENDREADER_H_
 
 #include "BackwardTLogReader.h"
+#include "MappedTLogReader.h"
 #include "TLogReader.h"
 #include "TLogReaderInterface.h"
 
+#include <deque>
+#include <future>
 #include <vector>
 #include <string>
 
@@ -27,6 +30,7 @@
 
 #include <youtils/Generator.h>
 #include <youtils/Logging.h>
+#include <youtils/System.h>
 
 #include <backend/BackendInterface.h>
 
@@ -36,6 +40,26 @@ namespace volumedriver
 typedef boost::shared_ptr<TLogReaderInterface> TLogGenItem;
 typedef youtils::Generator<TLogGenItem> TLogGen;
 
+// Without a backend the TLog is expected to be found in tlog_path, otherwise it
+// is fetched from the backend unless there's a local copy.
+template<typename ReaderType>
+TLogGenItem
+make_tlog_reader(const boost::filesystem::path& tlog_path,
+                 const std::string& name,
+                 BackendInterfacePtr bi)
+{
+    if (bi)
+    {
+        return TLogGenItem(new ReaderType(tlog_path,
+                                          name,
+                                          std::move(bi)));
+    }
+    else
+    {
+        return TLogGenItem(new ReaderType(tlog_path / name));
+    }
+}
+
 template<typename ReaderType,
          typename Items>
 class TLogReaderGen
@@ -79,16 +103,9 @@ private:
         if (next_index_ < items_.size())
         {
             const auto name(boost::lexical_cast<std::string>(items_[next_index_++]));
-            if(bi_)
-            {
-                current_.reset(new ReaderType(tlog_path_,
-                                              name,
-                                              bi_->clone()));
-            }
-            else
-            {
-                current_.reset(new ReaderType(tlog_path_ / name));
-            }
+            current_ = make_tlog_reader<ReaderType>(tlog_path_,
+                                                    name,
+                                                    bi_ ? bi_->clone() : nullptr);
         }
         else
         {
@@ -103,6 +120,102 @@ private:
     const std::vector<typename Items::value_type> items_;
 };
 
+// Sets up the readers of up to `window' TLogs concurrently (i.e. TLogs are
+// fetched from the backend in parallel) but hands them out in order, so the
+// backend round trips overlap with each other and with the processing of the
+// current TLog. Every fetched TLog occupies a temporary file in tlog_path until
+// its reader is released, so the window also bounds the disk space used.
+template<typename ReaderType,
+         typename Items>
+class ParallelTLogReaderGen
+    : public TLogGen
+{
+public:
+    ParallelTLogReaderGen(const boost::filesystem::path& tlog_path,
+                          const Items& items,
+                          BackendInterfacePtr bi,
+                          size_t window)
+        : tlog_path_(tlog_path)
+        , next_index_(0)
+        , bi_(std::move(bi))
+        , items_(items.begin(),
+                 items.end())
+        , window_(std::max<size_t>(window,
+                                   1))
+    {
+        update();
+    }
+
+    // the futures' destructors wait for the outstanding fetches
+    ~ParallelTLogReaderGen() = default;
+
+    void
+    next() override final
+    {
+        update();
+    }
+
+    TLogGenItem&
+    current() override final
+    {
+        return current_;
+    }
+
+    bool
+    finished() override final
+    {
+        return not current_.get();
+    }
+
+private:
+    void
+    fill_()
+    {
+        while (pending_.size() < window_ and
+               next_index_ < items_.size())
+        {
+            const auto name(boost::lexical_cast<std::string>(items_[next_index_++]));
+
+            // cloned here as BackendInterface::clone isn't necessarily thread safe
+            BackendInterfacePtr bi(bi_ ? bi_->clone() : nullptr);
+
+            pending_.emplace_back(std::async(std::launch::async,
+                                             [tlog_path = tlog_path_,
+                                              name,
+                                              bi = std::move(bi)]() mutable -> TLogGenItem
+                                             {
+                                                 return make_tlog_reader<ReaderType>(tlog_path,
+                                                                                     name,
+                                                                                     std::move(bi));
+                                             }));
+        }
+    }
+
+    void
+    update()
+    {
+        // drop the previous one first to free up its slot in the budget
+        current_.reset();
+
+        fill_();
+
+        if (not pending_.empty())
+        {
+            std::future<TLogGenItem> f(std::move(pending_.front()));
+            pending_.pop_front();
+            current_ = f.get();
+        }
+    }
+
+    TLogGenItem current_;
+    const boost::filesystem::path tlog_path_;
+    uint64_t next_index_;
+    BackendInterfacePtr bi_;
+    const std::vector<typename Items::value_type> items_;
+    const size_t window_;
+    std::deque<std::future<TLogGenItem>> pending_;
+};
+
 class CombinedTLogReader
     : public TLogReaderInterface
 {
@@ -143,11 +256,25 @@ public:
         Prefetch,
         OnDemand,
         Concurrent,
+        // fetch up to parallel_fetch_window() TLogs at once
+        Parallel,
     };
 
+    static size_t
+    parallel_fetch_window()
+    {
+        static const size_t window =
+            youtils::System::get_env_with_default<size_t>("TLOG_FETCH_WINDOW",
+                                                          8);
+        return window;
+    }
+
     // Why templates you ask: The OrderedTLogIds are sufficient for everything except scrubbing
     // where we treat the relocation as TLog. You can't type that as OrderedTLogIds.
-    template <typename T>
+    // ReaderType can be set to MappedTLogReader if none of the TLogs can change while
+    // being read, i.e. none of them is the current TLog of a running volume.
+    template <typename ReaderType = TLogReader,
+              typename T>
     static std::unique_ptr<TLogReaderInterface>
     create(const fs::path& tlog_path,
            const T& items,
@@ -156,22 +283,30 @@ public:
     {
         std::unique_ptr<TLogGen> generator;
 
-        std::unique_ptr<TLogGen>
-            base_generator(new TLogReaderGen<TLogReader, T>(tlog_path,
-                                                           items,
-                                                           std::move(bi)));
+        auto base_generator([&]() -> std::unique_ptr<TLogGen>
+                            {
+                                return std::unique_ptr<TLogGen>(new TLogReaderGen<ReaderType, T>(tlog_path,
+                                                                                                 items,
+                                                                                                 std::move(bi)));
+                            });
 
         switch (strategy)
         {
         case FetchStrategy::Prefetch:
-            generator.reset(new youtils::PrefetchGenerator<TLogGenItem>(std::move(base_generator)));
+            generator.reset(new youtils::PrefetchGenerator<TLogGenItem>(base_generator()));
             break;
         case FetchStrategy::Concurrent:
-            generator.reset(new youtils::ThreadedGenerator<TLogGenItem>(std::move(base_generator),
+            generator.reset(new youtils::ThreadedGenerator<TLogGenItem>(base_generator(),
                                                                         uint32_t(10)));
             break;
         case FetchStrategy::OnDemand:
-            generator = std::move(base_generator);
+            generator = base_generator();
+            break;
+        case FetchStrategy::Parallel:
+            generator.reset(new ParallelTLogReaderGen<ReaderType, T>(tlog_path,
+                                                                     items,
+                                                                     std::move(bi),
+                                                                     parallel_fetch_window()));
             break;
         }
 
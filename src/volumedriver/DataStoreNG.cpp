@@ -830,13 +830,14 @@ DataStoreNG::pushAndUpdateCurrentSCO_(bool ignore_transient_errors)
 }
 
 void
-DataStoreNG::writeClusterToLocation(const uint8_t* buf,
-                                    const ClusterLocation& loc,
-                                    uint32_t& throttle)
+DataStoreNG::writeClustersToLocation(const uint8_t* buf,
+                                     const ClusterLocation& loc,
+                                     size_t num_locs,
+                                     uint32_t& throttle)
 {
     WLOCK_DATASTORE();
-    LOG_DEBUG(nspace_ << ": forced write to " << loc << ", current loc: " <<
-              currentClusterLoc_);
+    LOG_DEBUG(nspace_ << ": forced write of " << num_locs << " clusters to " <<
+              loc << ", current loc: " << currentClusterLoc_);
 
     VERIFY(loc.cloneID() == 0);
     VERIFY(loc.version() == 0);
@@ -849,9 +850,9 @@ DataStoreNG::writeClusterToLocation(const uint8_t* buf,
                                  nspace_.c_str());
     }
 
-    std::vector<ClusterLocation> dummy(1);
-    writeClusters_(buf, dummy, 1, throttle);
-    VERIFY(dummy[0] == loc);
+    std::vector<ClusterLocation> locs(num_locs);
+    writeClusters_(buf, locs, num_locs, throttle);
+    VERIFY(num_locs == 0 or locs[0] == loc);
 }
 
 void
@@ -144,10 +144,13 @@ public:
     void
     readClusters(const std::vector<ClusterReadDescriptor>& descs);
 
+    // Writes num_locs clusters at consecutive locations starting at loc,
+    // which has to be the current cluster location.
     void
-    writeClusterToLocation(const uint8_t* buf,
-                           const ClusterLocation& loc,
-                           uint32_t& throttle);
+    writeClustersToLocation(const uint8_t* buf,
+                            const ClusterLocation& loc,
+                            size_t num_locs,
+                            uint32_t& throttle);
 
     void
     writeClusters(const uint8_t* buf,
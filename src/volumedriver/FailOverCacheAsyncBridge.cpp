@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <limits>
 
 namespace volumedriver
 {
@@ -24,8 +25,8 @@ namespace volumedriver
 #define LOCK()                                                          \
     boost::lock_guard<decltype(mutex_)> lg__(mutex_)
 
-#define LOCK_NEW_ONES()                                                 \
-    boost::lock_guard<decltype(new_ones_mutex_)> nolg__(new_ones_mutex_)
+#define LOCK_BATCHES()                                                  \
+    boost::lock_guard<decltype(batch_mutex_)> blg__(batch_mutex_)
 
 const boost::chrono::seconds
 FailOverCacheAsyncBridge::timeout_(1);
@@ -38,23 +39,34 @@ TODO("AR: get rid of LBASize and ClusterMultiplier");
 FailOverCacheAsyncBridge::FailOverCacheAsyncBridge(const LBASize lba_size,
                                                    const ClusterMultiplier cluster_multiplier,
                                                    const size_t max_entries,
-                                                   const std::atomic<unsigned>& write_trigger)
+                                                   const std::atomic<unsigned>& write_trigger,
+                                                   const size_t batches_in_flight)
     : FailOverCacheClientInterface(max_entries)
     , lba_size_(lba_size)
     , cluster_multiplier_(cluster_multiplier)
-    , newData(cluster_size_() * max_entries)
-    , oldData(cluster_size_() * max_entries)
+    , sealed_(0)
+    , sent_(0)
+    , acked_(0)
     , write_trigger_(write_trigger)
     , thread_(nullptr)
     , stop_(true)
     , throttling(false)
 {
+    VERIFY(batches_in_flight > 0);
+
+    // one more than can be in flight: the one being filled
+    batches_.reserve(batches_in_flight + 1);
+    for (size_t i = 0; i < batches_in_flight + 1; ++i)
+    {
+        batches_.emplace_back(cluster_size_() * max_entries);
+        batches_.back().entries.reserve(max_entries);
+    }
 }
 
 void
 FailOverCacheAsyncBridge::init_cache_()
 {
-    //PRECONDITION: thread_ = 0, oldOnes = 0, newones = 0
+    //PRECONDITION: thread_ = 0, no batches queued
     // Y42 why not assert for these preconditions??
     // Y42 also a throw might put a monkey wrench into these so called preconditions
     if(cache_)
@@ -89,6 +101,23 @@ FailOverCacheAsyncBridge::backup()
     return cache_ != nullptr;
 }
 
+void
+FailOverCacheAsyncBridge::reset_batches_()
+{
+    LOCK_BATCHES();
+
+    for (auto& b : batches_)
+    {
+        b.entries.clear();
+    }
+
+    sealed_ = 0;
+    sent_ = 0;
+    acked_ = 0;
+
+    condvar_.notify_all();
+}
+
 void
 FailOverCacheAsyncBridge::newCache(std::unique_ptr<FailOverCacheProxy> cache)
 {
@@ -102,8 +131,9 @@ FailOverCacheAsyncBridge::newCache(std::unique_ptr<FailOverCacheProxy> cache)
 
     {
         LOCK();
+        LOCK_BATCHES();
         stop_ = true;
-        condvar_.notify_one();
+        condvar_.notify_all();
     }
     if(cache_)
     {
@@ -115,9 +145,7 @@ FailOverCacheAsyncBridge::newCache(std::unique_ptr<FailOverCacheProxy> cache)
 
         {
             LOCK();
-            LOCK_NEW_ONES();
-            newOnes.clear();
-            oldOnes.clear();
+            reset_batches_();
         }
     }
 
@@ -133,8 +161,9 @@ FailOverCacheAsyncBridge::destroy(SyncFailOverToBackend sync)
 
     {
         LOCK();
+        LOCK_BATCHES();
         stop_ = true;
-        condvar_.notify_one();
+        condvar_.notify_all();
     }
     if (cache_)
     {
@@ -143,118 +172,223 @@ FailOverCacheAsyncBridge::destroy(SyncFailOverToBackend sync)
         thread_->destroy();
         thread_ = 0;
         // VOLUME SHOULD HAVE BEEN SYNCED AND DETACHED
-        //  VERIFY(oldOnes.empty() and
-        // newOnes.empty());
+        // i.e. no batches should be queued anymore
+
+        LOCK();
+
+        if(T(sync))
         {
-            LOCK_NEW_ONES();
-            if (not oldOnes.empty())
+            try
             {
-                if(T(sync))
-                {
-                    try
-                    {
-                        cache_->addEntries(oldOnes);
-                    }
-                    // Z42: std::exception?
-                    catch(fungi::IOException& e)
-                    {
-                        LOG_ERROR("problem adding entries " << e.what() << ", ignoring");
-                    }
-
-                }
-                oldOnes.clear();
+                send_batches_();
+            }
+            catch(std::exception& e)
+            {
+                LOG_ERROR("problem adding entries " << e.what() << ", ignoring");
             }
         }
 
-        {
-            LOCK_NEW_ONES();
+        reset_batches_();
+        cache_ = nullptr;
+    }
+}
 
-            if(not newOnes.empty())
-            {
-                if(T(sync))
-                {
-                    try
-                    {
-                        cache_->addEntries(newOnes);
-                    }
-                    // Z42: std::exception?
-                    catch(fungi::IOException& e)
-                    {
-                        LOG_ERROR("problem adding entries " << e.what() << ", ignoring");
-                    }
+void
+FailOverCacheAsyncBridge::setRequestTimeout(const boost::chrono::seconds seconds)
+{
+    LOCK();
 
-                }
-                newOnes.clear();
+    if(cache_)
+    {
+        cache_->setRequestTimeout(seconds);
+    }
+}
 
-            }
+// Sends the next batch with a sequence number <= target or, if all of these were
+// sent already, collects the next pending acknowledgement. Returns false if
+// there was nothing to do. Requires mutex_ to be held.
+bool
+FailOverCacheAsyncBridge::pump_once_(uint64_t target)
+{
+    Batch* batch = nullptr;
+    bool ack = false;
+
+    {
+        LOCK_BATCHES();
+
+        if (sent_ < sealed_ and sent_ < target)
+        {
+            batch = &batches_[sent_ % batches_.size()];
         }
+        else if (acked_ < sent_ and acked_ < target)
         {
-            LOCK();
-            cache_ = nullptr;
+            ack = true;
+        }
+    }
+
+    if (batch != nullptr)
+    {
+        // sealed batches are not touched by addEntries, so no need to hold
+        // batch_mutex_ while sending
+        LOG_DEBUG("Sending " << batch->entries.size() <<
+                  " entries to the failover cache");
+        cache_->sendEntries(batch->entries);
+
+        LOCK_BATCHES();
+        ++sent_;
+        return true;
+    }
+    else if (ack)
+    {
+        // other requests on the proxy might have collected it already
+        if (cache_->entriesInFlight() > 0)
+        {
+            cache_->ackEntries();
         }
 
+        LOCK_BATCHES();
+        batches_[acked_ % batches_.size()].entries.clear();
+        ++acked_;
+        condvar_.notify_all();
+        return true;
+    }
+    else
+    {
+        return false;
     }
 }
 
 void
-FailOverCacheAsyncBridge::setRequestTimeout(const boost::chrono::seconds seconds)
+FailOverCacheAsyncBridge::pump_(uint64_t target)
 {
-    LOCK();
+    while (pump_once_(target))
+    {
+    }
+}
 
-    if(cache_)
+// Sends all entries queued so far and waits for their acknowledgement, but not
+// for batches queued in the meantime. Requires mutex_ to be held.
+void
+FailOverCacheAsyncBridge::send_batches_()
+{
+    uint64_t target = 0;
+
+    while (true)
     {
-        cache_->setRequestTimeout(seconds);
+        {
+            LOCK_BATCHES();
+            if (maybe_seal_())
+            {
+                target = sealed_;
+                break;
+            }
+        }
+
+        // no room in the ring - make some
+        const bool progress = pump_once_(std::numeric_limits<uint64_t>::max());
+        VERIFY(progress);
     }
+
+    pump_(target);
 }
 
+// Collects all pending acknowledgements - needs to happen before any other
+// request is sent on the proxy. Requires mutex_ to be held.
 void
-FailOverCacheAsyncBridge::run()
+FailOverCacheAsyncBridge::drain_()
 {
-    boost::unique_lock<decltype(mutex_)> unique_lock(mutex_);
+    uint64_t target = 0;
 
+    {
+        LOCK_BATCHES();
+        target = sent_;
+    }
+
+    pump_(target);
+}
+
+void
+FailOverCacheAsyncBridge::run()
+{
     while (not stop_)
     {
         try
         {
-            if (not oldOnes.empty())
+            bool busy = false;
+
             {
-                LOG_DEBUG("Writing " << oldOnes.size() << " entries to the failover cache");
-                cache_->addEntries(oldOnes);
-                oldOnes.clear();
-                LOG_DEBUG("Written");
+                LOCK();
+                if (stop_)
+                {
+                    break;
+                }
+
+                busy = pump_once_(std::numeric_limits<uint64_t>::max());
             }
-            else
+
+            if (busy)
             {
-                // Y42 The machine that goes ping
-                cache_->flush();
+                continue;
             }
 
-            condvar_.wait_for(unique_lock,
-                              timeout_);
+            bool ping = false;
 
-            if (oldOnes.empty())
             {
-                //we get here by a timeout -> time to swap
-                //no risk for deadlock as addEntry only does a tryLock on mutex_
-                LOCK_NEW_ONES();
+                boost::unique_lock<decltype(batch_mutex_)> u(batch_mutex_);
+
+                const bool work =
+                    condvar_.wait_for(u,
+                                      timeout_,
+                                      [&]() -> bool
+                                      {
+                                          return
+                                              stop_ or
+                                              sent_ < sealed_ or
+                                              acked_ < sent_;
+                                      });
+
+                if (not work)
+                {
+                    // timeout: ship whatever was gathered so far, or see
+                    // whether the DTL is still there
+                    if (filling_().entries.empty())
+                    {
+                        ping = true;
+                    }
+                    else
+                    {
+                        maybe_seal_();
+                    }
+                }
+            }
 
-                std::swap(newOnes, oldOnes);
-                std::swap(newData, oldData);
+            if (ping)
+            {
+                LOCK();
+                if (not stop_)
+                {
+                    // Y42 The machine that goes ping
+                    cache_->flush();
+                }
             }
         }
         catch (std::exception& e)
         {
             LOG_ERROR("Exception in failover thread: " << e.what());
+
+            LOCK();
+
             if(degraded_fun_)
             {
                 degraded_fun_();
             }
 
-            LOCK_NEW_ONES();
+            {
+                LOCK_BATCHES();
+                stop_ = true;
+            }
 
-            stop_ = true;
-            newOnes.clear();
-            oldOnes.clear();
+            reset_batches_();
 
             // This thread cleans up itself when it is detached
             thread_->detach();
@@ -286,9 +420,32 @@ FailOverCacheAsyncBridge::addEntry(ClusterLocation loc,
                                    const uint8_t* buf,
                                    size_t /* bufsize */)
 {
-    uint8_t* ptr = newData.data() + (newOnes.size() * cluster_size_());
+    Batch& batch = filling_();
+    uint8_t* ptr = batch.data.data() + (batch.entries.size() * cluster_size_());
     memcpy(ptr, buf, cluster_size_());
-    newOnes.emplace_back(loc, lba, ptr, cluster_size_());
+    batch.entries.emplace_back(loc, lba, ptr, cluster_size_());
+}
+
+// Hands the batch being filled over to the worker thread and moves on to the
+// next one, unless the ring is full. Requires batch_mutex_ to be held.
+bool
+FailOverCacheAsyncBridge::maybe_seal_()
+{
+    if (filling_().entries.empty())
+    {
+        return true;
+    }
+
+    if (sealed_ + 1 - acked_ >= batches_.size())
+    {
+        return false;
+    }
+
+    ++sealed_;
+    VERIFY(filling_().entries.empty());
+
+    condvar_.notify_all();
+    return true;
 }
 
 bool
@@ -299,7 +456,7 @@ FailOverCacheAsyncBridge::addEntries(const std::vector<ClusterLocation>& locs,
 {
     VERIFY(num_locs <= max_entries());
 
-    LOCK_NEW_ONES();
+    LOCK_BATCHES();
 
     // Needs improvement!!!
     if (stop_)
@@ -307,20 +464,25 @@ FailOverCacheAsyncBridge::addEntries(const std::vector<ClusterLocation>& locs,
         return true;
     }
 
-    TODO("AR: revisit the batching of entries");
-    // TODO: Batches must not cross SCO boundaries.
-    // We could be way smarter by allowing multiple outstanding batches.
+    // Batches must not cross SCO boundaries.
+    const Batch& batch = filling_();
     const bool new_sco =
-        (not newOnes.empty()) and
+        (not batch.entries.empty()) and
         (not locs.empty()) and
-        (newOnes.back().cli_.sco() != locs.front().sco());
+        (batch.entries.back().cli_.sco() != locs.front().sco());
 
-    setThrottling((newOnes.size() + num_locs > max_entries()) or
-                  new_sco);
+    bool room = true;
+    if (new_sco or
+        (batch.entries.size() + num_locs > max_entries()))
+    {
+        room = maybe_seal_();
+    }
+
+    // Only throttle if all batches are in flight.
+    setThrottling(not room);
 
     if (not throttling)
     {
-        // Otherwise work the batch
         for (size_t i = 0; i < num_locs; ++i)
         {
             addEntry(locs[i],
@@ -328,32 +490,14 @@ FailOverCacheAsyncBridge::addEntries(const std::vector<ClusterLocation>& locs,
                      data + i * cluster_size_(),
                      cluster_size_());
         }
-    }
 
-    maybe_swap_(new_sco);
-
-    return not throttling;
-}
-
-void
-FailOverCacheAsyncBridge::maybe_swap_(bool new_sco)
-{
-    if (new_sco or
-        (newOnes.size() >= write_trigger_))
-    {
-        //must be trylock otherwise risk for deadlock
-        boost::unique_lock<decltype(mutex_)> u(mutex_,
-                                               boost::try_to_lock);
-        if (u)
+        if (filling_().entries.size() >= write_trigger_)
         {
-            if (oldOnes.empty())
-            {
-                std::swap(newOnes, oldOnes);
-                std::swap(newData, oldData);
-                condvar_.notify_one();
-            }
+            maybe_seal_();
         }
     }
+
+    return not throttling;
 }
 
 void FailOverCacheAsyncBridge::Flush()
@@ -367,22 +511,9 @@ FailOverCacheAsyncBridge::flush_()
 {
     if(cache_)
     {
-        LOCK_NEW_ONES();
-
-        LOG_DEBUG("oldOnes: " << oldOnes.size() << " ,newOnes: " << newOnes.size());
-
-        oldOnes.reserve(oldOnes.size() + newOnes.size());
-        for (auto&& v : newOnes)
-        {
-            oldOnes.emplace_back(std::move(v));
-        }
-
-        newOnes.clear();
-
         try
         {
-            cache_->addEntries(std::move(oldOnes));
-            oldOnes.clear();
+            send_batches_();
             cache_->flush();
         }
         CATCH_STD_ALL_EWHAT({
@@ -402,6 +533,7 @@ FailOverCacheAsyncBridge::removeUpTo(const SCO& sconame)
 
     if(cache_)
     {
+        drain_();
         cache_->removeUpTo(sconame);
     }
 }
@@ -413,6 +545,7 @@ FailOverCacheAsyncBridge::Clear()
 
     if(cache_)
     {
+        drain_();
         cache_->clear();
     }
 }
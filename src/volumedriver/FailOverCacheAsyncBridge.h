@@ -45,7 +45,8 @@ public:
     FailOverCacheAsyncBridge(const LBASize,
                              const ClusterMultiplier,
                              const size_t max_entries,
-                             const std::atomic<unsigned>& write_trigger);
+                             const std::atomic<unsigned>& write_trigger,
+                             const size_t batches_in_flight = 4);
 
     FailOverCacheAsyncBridge(const FailOverCacheAsyncBridge&) = delete;
 
@@ -109,8 +110,39 @@ private:
     void
     setThrottling(bool v);
 
+    struct Batch
+    {
+        explicit Batch(size_t bytes)
+            : data(bytes)
+        {}
+
+        std::vector<FailOverCacheEntry> entries;
+        std::vector<uint8_t> data;
+    };
+
+    Batch&
+    filling_()
+    {
+        return batches_[sealed_ % batches_.size()];
+    }
+
+    bool
+    maybe_seal_();
+
+    bool
+    pump_once_(uint64_t target);
+
     void
-    maybe_swap_(bool new_sco);
+    pump_(uint64_t target);
+
+    void
+    send_batches_();
+
+    void
+    drain_();
+
+    void
+    reset_batches_();
 
     void
     init_cache_();
@@ -126,26 +158,37 @@ private:
 
     std::unique_ptr<FailOverCacheProxy> cache_;
 
-    // mutex_: protects stop_ and cache_
-    // new_ones_mutex_: protects newOnes / oldOnes + buffers
-    // lock order: mutex_ before new_ones_mutex_
+    // mutex_: protects cache_ and serializes its use (the worker thread and
+    //         Flush & co. take turns in sending batches / collecting acks)
+    // batch_mutex_: protects the batch ring and its counters
+    // lock order: mutex_ before batch_mutex_
     boost::mutex mutex_;
-    boost::mutex new_ones_mutex_;
+    boost::mutex batch_mutex_;
+    // signalled (with batch_mutex_) when there's work for the worker thread
+    // or room in the ring
     boost::condition_variable condvar_;
 
-    std::vector<FailOverCacheEntry> newOnes;
-    std::vector<FailOverCacheEntry> oldOnes;
     const LBASize lba_size_;
     const ClusterMultiplier cluster_multiplier_;
-    std::vector<uint8_t> newData;
-    std::vector<uint8_t> oldData;
+
+    // Ring of preallocated batches, indexed by sequence number modulo the
+    // ring size:
+    // [acked_, sent_): sent to the DTL, acknowledgement pending
+    // [sent_, sealed_): complete, waiting to be sent
+    // sealed_: being filled by addEntries
+    // Up to batches_.size() - 1 batches can hence be in flight.
+    std::vector<Batch> batches_;
+    uint64_t sealed_;
+    uint64_t sent_;
+    uint64_t acked_;
+
     const std::atomic<unsigned>& write_trigger_;
 
     // make configurable?
     static const boost::chrono::seconds timeout_;
     // number of entries before scheduling a write
     fungi::Thread* thread_;
-    bool stop_;
+    std::atomic<bool> stop_;
     bool throttling;
 
     DegradedFun degraded_fun_;
@@ -26,7 +26,8 @@ FailOverCacheClientInterface::create(const FailOverCacheMode mode,
                                      const LBASize lba_size,
                                      const ClusterMultiplier cluster_multiplier,
                                      const size_t max_entries,
-                                     const std::atomic<unsigned>& write_trigger)
+                                     const std::atomic<unsigned>& write_trigger,
+                                     const size_t batches_in_flight)
 {
     switch (mode)
     {
@@ -34,7 +35,8 @@ FailOverCacheClientInterface::create(const FailOverCacheMode mode,
         return Ptr(new FailOverCacheAsyncBridge(lba_size,
                                                 cluster_multiplier,
                                                 max_entries,
-                                                write_trigger));
+                                                write_trigger,
+                                                batches_in_flight));
     case FailOverCacheMode::Synchronous:
         return Ptr(new FailOverCacheSyncBridge(max_entries));
     }
@@ -32,7 +32,8 @@ public:
            const LBASize lba_size,
            const ClusterMultiplier cluster_multiplier,
            const size_t max_entries,
-           const std::atomic<unsigned>& write_trigger);
+           const std::atomic<unsigned>& write_trigger,
+           const size_t batches_in_flight);
 
     virtual ~FailOverCacheClientInterface() = default;
 
@@ -16,6 +16,17 @@
 #include "FailOverCacheProxy.h"
 #include "Volume.h"
 
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <snappy.h>
+
+#include <youtils/Catchers.h>
 #include <youtils/IOException.h>
 
 namespace volumedriver
@@ -23,11 +34,61 @@ namespace volumedriver
 
 using namespace fungi;
 
+namespace yt = youtils;
+
+namespace
+{
+
+// Compressing a batch has to save at least 1/8th, ...
+const uint64_t min_compression_gain_shift = 3;
+// ... otherwise up to this many batches are sent uncompressed before trying
+// again.
+const uint32_t max_compression_backoff = 64;
+
+// Whether the peer address is one of ours, i.e. the local end of the
+// connection uses the same address.
+bool
+peer_is_local(int fd)
+{
+    struct sockaddr_storage local;
+    struct sockaddr_storage peer;
+    socklen_t local_len = sizeof(local);
+    socklen_t peer_len = sizeof(peer);
+
+    if (::getsockname(fd,
+                      reinterpret_cast<struct sockaddr*>(&local),
+                      &local_len) != 0 or
+        ::getpeername(fd,
+                      reinterpret_cast<struct sockaddr*>(&peer),
+                      &peer_len) != 0 or
+        local.ss_family != peer.ss_family)
+    {
+        return false;
+    }
+
+    switch (local.ss_family)
+    {
+    case AF_INET:
+        return reinterpret_cast<const struct sockaddr_in&>(local).sin_addr.s_addr ==
+            reinterpret_cast<const struct sockaddr_in&>(peer).sin_addr.s_addr;
+    case AF_INET6:
+        return memcmp(&reinterpret_cast<const struct sockaddr_in6&>(local).sin6_addr,
+                      &reinterpret_cast<const struct sockaddr_in6&>(peer).sin6_addr,
+                      sizeof(struct in6_addr)) == 0;
+    default:
+        return false;
+    }
+}
+
+}
+
 FailOverCacheProxy::FailOverCacheProxy(const FailOverCacheConfig& cfg,
                                        const Namespace& ns,
                                        const LBASize lba_size,
                                        const ClusterMultiplier cluster_mult,
-                                       const boost::chrono::seconds timeout)
+                                       const boost::chrono::seconds timeout,
+                                       const uint64_t shmem_size,
+                                       const bool compression)
     : socket_(fungi::Socket::createClientSocket(cfg.host,
                                                 cfg.port))
     , stream_(*socket_)
@@ -35,11 +96,27 @@ FailOverCacheProxy::FailOverCacheProxy(const FailOverCacheConfig& cfg,
     , lba_size_(lba_size)
     , cluster_mult_(cluster_mult)
     , delete_failover_dir_(false)
+    , sent_(0)
+    , acked_(0)
+    , compress_(false)
+    , compress_skip_(0)
+    , compress_backoff_(0)
 {
     //        stream_ << fungi::IOBaseStream::cork; --AT-- removed because this command is never sent over the wire
     stream_ << fungi::IOBaseStream::RequestTimeout(timeout.count());
     //        stream_ << fungi::IOBaseStream::uncork;
     register_();
+
+    if (shmem_size > 0)
+    {
+        attach_shmem_(shmem_size);
+    }
+
+    // No point in compressing what doesn't go through the socket.
+    if (compression and not shmem_)
+    {
+        enable_compression_();
+    }
 }
 
 FailOverCacheProxy::~FailOverCacheProxy()
@@ -55,6 +132,8 @@ void
 FailOverCacheProxy::getSCORange(SCO& oldest,
                                 SCO& youngest)
 {
+    drainAcks_();
+
     stream_ << fungi::IOBaseStream::cork;
     OUT_ENUM(stream_, GetSCORange);
     stream_ << fungi::IOBaseStream::uncork;
@@ -72,6 +151,182 @@ FailOverCacheProxy::register_()
                                                     csize);
 }
 
+void
+FailOverCacheProxy::attach_shmem_(uint64_t size)
+{
+    if (socket_->isRdma() or not peer_is_local(socket_->fileno()))
+    {
+        LOG_INFO(ns_ << ": DTL is not on this host, not using shared memory");
+        return;
+    }
+
+    std::unique_ptr<yt::SharedMemoryRegion> region;
+
+    try
+    {
+        region = std::make_unique<yt::SharedMemoryRegion>(dtl_shmem_header_size +
+                                                          size);
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_WARN(ns_ << ": failed to create shared memory region: " <<
+                     EWHAT << " - not using shared memory");
+            return;
+        });
+
+    std::random_device rd;
+    const uint64_t cookie = (static_cast<uint64_t>(rd()) << 32) bitor rd();
+    memcpy(region->address(),
+           &cookie,
+           sizeof(cookie));
+
+    sendAttachSharedMemory(stream_,
+                           static_cast<uint64_t>(region->id()),
+                           cookie,
+                           region->size());
+
+    stream_ >> fungi::IOBaseStream::cork;
+    uint32_t res;
+    stream_ >> res;
+
+    if (res == volumedriver::Ok)
+    {
+        LOG_INFO(ns_ << ": using shared memory region " << region->id() <<
+                 ", size " << region->size());
+        shmem_ = std::move(region);
+    }
+    else
+    {
+        LOG_INFO(ns_ << ": DTL cannot attach to shared memory, using the socket");
+    }
+}
+
+// Finds room for size bytes in the data area of the shared memory region,
+// waiting for outstanding requests to be acknowledged if necessary.
+boost::optional<uint64_t>
+FailOverCacheProxy::alloc_shmem_(uint64_t size)
+{
+    VERIFY(shmem_ != nullptr);
+
+    const uint64_t area = shmem_->size() - dtl_shmem_header_size;
+    if (size == 0 or size > area)
+    {
+        return boost::none;
+    }
+
+    while (true)
+    {
+        if (shmem_extents_.empty())
+        {
+            return 0;
+        }
+
+        const uint64_t tail = shmem_extents_.front().first;
+        const uint64_t head = shmem_extents_.back().first +
+            shmem_extents_.back().second;
+
+        if (head >= tail)
+        {
+            if (head + size <= area)
+            {
+                return head;
+            }
+            else if (size < tail)
+            {
+                // wrap around; strictly less to tell a full ring from an empty one
+                return 0;
+            }
+        }
+        else if (head + size < tail)
+        {
+            return head;
+        }
+
+        VERIFY(acked_ < sent_);
+        ackEntries();
+    }
+}
+
+void
+FailOverCacheProxy::enable_compression_()
+{
+    sendEnableCompression(stream_,
+                          dtl_compression_snappy);
+    checkStreamOK(__FUNCTION__);
+
+    LOG_INFO(ns_ << ": compressing DTL traffic");
+    compress_ = true;
+}
+
+// Returns false if the entries were not sent since compression was not
+// deemed worthwhile.
+bool
+FailOverCacheProxy::send_compressed_(const std::vector<FailOverCacheEntry>& entries)
+{
+    VERIFY(compress_);
+
+    if (compress_skip_ > 0)
+    {
+        --compress_skip_;
+        return false;
+    }
+
+    uint64_t raw_size = 0;
+    bool contiguous = true;
+
+    for (const auto& e : entries)
+    {
+        if (e.buffer_ != entries.front().buffer_ + raw_size)
+        {
+            contiguous = false;
+        }
+        raw_size += e.size_;
+    }
+
+    if (raw_size == 0)
+    {
+        return false;
+    }
+
+    const uint8_t* src = entries.front().buffer_;
+    if (not contiguous)
+    {
+        compress_in_.resize(raw_size);
+        uint8_t* dst = compress_in_.data();
+        for (const auto& e : entries)
+        {
+            memcpy(dst, e.buffer_, e.size_);
+            dst += e.size_;
+        }
+        src = compress_in_.data();
+    }
+
+    compress_out_.resize(snappy::MaxCompressedLength(raw_size));
+
+    size_t size = 0;
+    snappy::RawCompress(reinterpret_cast<const char*>(src),
+                        raw_size,
+                        reinterpret_cast<char*>(compress_out_.data()),
+                        &size);
+
+    const uint64_t limit = raw_size - (raw_size >> min_compression_gain_shift);
+    if (size > limit)
+    {
+        compress_backoff_ = std::min(std::max(2 * compress_backoff_, 1U),
+                                     max_compression_backoff);
+        compress_skip_ = compress_backoff_;
+        return false;
+    }
+
+    compress_backoff_ = 0;
+
+    sendAddEntriesCompressed(stream_,
+                             entries,
+                             raw_size,
+                             compress_out_.data(),
+                             size);
+    return true;
+}
+
 void
 FailOverCacheProxy::checkStreamOK(const std::string& ex)
 {
@@ -91,6 +346,7 @@ FailOverCacheProxy::unregister_()
     if(delete_failover_dir_)
     {
         LOG_INFO("Deleting failover dir for " << ns_);
+        drainAcks_();
         stream_ << fungi::IOBaseStream::cork;
         OUT_ENUM(stream_, Unregister);
         stream_ << fungi::IOBaseStream::uncork;
@@ -107,6 +363,7 @@ FailOverCacheProxy::removeUpTo(const SCO sconame) throw ()
 {
     try
     {
+        drainAcks_();
         stream_ << fungi::IOBaseStream::cork;
         OUT_ENUM(stream_,RemoveUpTo);
         stream_ << sconame;
@@ -145,13 +402,98 @@ FailOverCacheProxy::addEntries(std::vector<FailOverCacheEntry> entries)
     }
 #endif
 
-    const CommandData<AddEntries> comd(std::move(entries));
-    stream_ << comd;
+    drainAcks_();
+
+    if (shmem_ or compress_)
+    {
+        sendEntries(entries);
+        drainAcks_();
+    }
+    else
+    {
+        const CommandData<AddEntries> comd(std::move(entries));
+        stream_ << comd;
+    }
+}
+
+uint64_t
+FailOverCacheProxy::sendEntries(const std::vector<FailOverCacheEntry>& entries)
+{
+    if (shmem_)
+    {
+        uint64_t size = 0;
+        for (const auto& e : entries)
+        {
+            size += e.size_;
+        }
+
+        const boost::optional<uint64_t> off(alloc_shmem_(size));
+        if (off)
+        {
+            uint8_t* dst = static_cast<uint8_t*>(shmem_->address()) +
+                dtl_shmem_header_size + *off;
+            for (const auto& e : entries)
+            {
+                memcpy(dst, e.buffer_, e.size_);
+                dst += e.size_;
+            }
+
+            sendAddEntriesShared(stream_,
+                                 entries,
+                                 *off);
+            shmem_extents_.emplace_back(*off, size);
+        }
+        else
+        {
+            // empty or too large - the zero sized extent keeps the
+            // bookkeeping in step with the acknowledgements
+            sendAddEntries(stream_,
+                           entries);
+            shmem_extents_.emplace_back(shmem_extents_.empty() ?
+                                        0 :
+                                        shmem_extents_.back().first +
+                                        shmem_extents_.back().second,
+                                        0);
+        }
+    }
+    else if (not compress_ or
+             not send_compressed_(entries))
+    {
+        sendAddEntries(stream_,
+                       entries);
+    }
+
+    return ++sent_;
+}
+
+uint64_t
+FailOverCacheProxy::ackEntries()
+{
+    VERIFY(acked_ < sent_);
+    checkStreamOK(__FUNCTION__);
+
+    if (shmem_)
+    {
+        VERIFY(not shmem_extents_.empty());
+        shmem_extents_.pop_front();
+    }
+
+    return ++acked_;
+}
+
+void
+FailOverCacheProxy::drainAcks_()
+{
+    while (acked_ < sent_)
+    {
+        ackEntries();
+    }
 }
 
 void
 FailOverCacheProxy::flush()
 {
+    drainAcks_();
     stream_ << CommandData<Flush>();
 }
 
@@ -160,6 +502,8 @@ FailOverCacheProxy::clear()
 {
     LOG_TRACE("Clearing failover cache");
 
+    drainAcks_();
+
     stream_ << fungi::IOBaseStream::cork;
     OUT_ENUM(stream_, Clear);
     stream_ << fungi::IOBaseStream::uncork;
@@ -170,6 +514,8 @@ void
 FailOverCacheProxy::getEntries(SCOProcessorFun processor)
 {
     // Y42 review later
+    drainAcks_();
+
     stream_ << fungi::IOBaseStream::cork;
     OUT_ENUM(stream_, GetEntries);
     stream_ << fungi::IOBaseStream::uncork;
@@ -181,6 +527,8 @@ uint64_t
 FailOverCacheProxy::getSCOFromFailOver(SCO a,
                                        SCOProcessorFun processor)
 {
+    drainAcks_();
+
     stream_ << fungi::IOBaseStream::cork;
     OUT_ENUM(stream_, GetSCO);
     stream_ << a;
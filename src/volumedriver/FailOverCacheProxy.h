@@ -23,9 +23,14 @@
 #include "failovercache/fungilib/IOBaseStream.h"
 #include "failovercache/fungilib/Buffer.h"
 
+#include <deque>
+
+#include <boost/optional.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/scoped_array.hpp>
 
+#include <youtils/SharedMemoryRegion.h>
+
 namespace volumedriver
 {
 
@@ -39,7 +44,9 @@ public:
                        const Namespace&,
                        const LBASize,
                        const ClusterMultiplier,
-                       const boost::chrono::seconds);
+                       const boost::chrono::seconds,
+                       const uint64_t shmem_size = 0,
+                       const bool compression = false);
 
     FailOverCacheProxy(const FailOverCacheProxy&) = delete;
 
@@ -51,6 +58,25 @@ public:
     void
     addEntries(std::vector<FailOverCacheEntry> entries);
 
+    // Pipelined variant of addEntries: the request is sent without waiting
+    // for the acknowledgement, which is to be collected with ackEntries.
+    // The DTL acknowledges requests in order. Returns the sequence number of
+    // the request. Other requests first wait for all outstanding
+    // acknowledgements.
+    uint64_t
+    sendEntries(const std::vector<FailOverCacheEntry>& entries);
+
+    // Waits for the acknowledgement of the oldest outstanding sendEntries
+    // request and returns its sequence number.
+    uint64_t
+    ackEntries();
+
+    uint64_t
+    entriesInFlight() const
+    {
+        return sent_ - acked_;
+    }
+
     // returns the SCO size - 0 indicates a problem.
     // Z42: throw instead!
     uint64_t
@@ -95,6 +121,21 @@ public:
         return cluster_mult_;
     }
 
+    // Whether cluster data is passed through shared memory (DTL on the same
+    // host) rather than the socket.
+    bool
+    uses_shared_memory() const
+    {
+        return shmem_ != nullptr;
+    }
+
+    // Whether cluster data is (potentially) sent compressed.
+    bool
+    uses_compression() const
+    {
+        return compress_;
+    }
+
 private:
     DECLARE_LOGGER("FailOverCacheProxy");
 
@@ -110,12 +151,43 @@ private:
     uint64_t
     getObject_(SCOProcessorFun processor);
 
+    void
+    drainAcks_();
+
+    void
+    attach_shmem_(uint64_t size);
+
+    boost::optional<uint64_t>
+    alloc_shmem_(uint64_t size);
+
+    void
+    enable_compression_();
+
+    bool
+    send_compressed_(const std::vector<FailOverCacheEntry>& entries);
+
     std::unique_ptr<fungi::Socket> socket_;
     fungi::IOBaseStream stream_;
     const Namespace ns_;
     const LBASize lba_size_;
     const ClusterMultiplier cluster_mult_;
     bool delete_failover_dir_;
+    uint64_t sent_;
+    uint64_t acked_;
+
+    // Data area of the shared memory region is used as a ring buffer; it
+    // holds one extent (offset, size) per request in flight, in order.
+    std::unique_ptr<youtils::SharedMemoryRegion> shmem_;
+    std::deque<std::pair<uint64_t, uint64_t>> shmem_extents_;
+
+    // Batches that do not compress well are sent as is, and compression is
+    // not attempted again for the next compress_skip_ batches; the backoff
+    // doubles for every consecutive failure.
+    bool compress_;
+    uint32_t compress_skip_;
+    uint32_t compress_backoff_;
+    std::vector<uint8_t> compress_in_;
+    std::vector<uint8_t> compress_out_;
 };
 
 }
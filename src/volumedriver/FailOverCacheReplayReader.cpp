@@ -0,0 +1,107 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "FailOverCacheProxy.h"
+#include "FailOverCacheReplayReader.h"
+
+#include <youtils/Assert.h>
+
+namespace volumedriver
+{
+
+constexpr size_t FailOverCacheReplayReader::default_max_run_clusters;
+
+FailOverCacheReplayReader::FailOverCacheReplayReader(FailOverCacheProxy& foc,
+                                                     const ClusterSize csize,
+                                                     const size_t max_run_clusters)
+    : foc_(foc)
+    , cluster_size_(csize)
+    , max_run_clusters_(max_run_clusters)
+{
+    VERIFY(max_run_clusters_ > 0);
+
+    run_.lbas.reserve(max_run_clusters_);
+    run_.data.reserve(max_run_clusters_ * cluster_size_);
+}
+
+void
+FailOverCacheReplayReader::read(const RunFun& fun)
+{
+    run_.lbas.clear();
+    run_.data.clear();
+
+    foc_.getEntries([&](ClusterLocation loc,
+                        uint64_t lba,
+                        const uint8_t* buf,
+                        size_t size)
+                    {
+                        add_(loc,
+                             lba,
+                             buf,
+                             size,
+                             fun);
+                    });
+
+    flush_(fun);
+}
+
+void
+FailOverCacheReplayReader::add_(ClusterLocation loc,
+                                uint64_t lba,
+                                const uint8_t* buf,
+                                size_t size,
+                                const RunFun& fun)
+{
+    VERIFY(size == cluster_size_);
+
+    if (not run_.lbas.empty())
+    {
+        const ClusterLocation& start = run_.start;
+        const size_t n = run_.lbas.size();
+
+        if (loc.sco() != start.sco() or
+            loc.offset() != start.offset() + n or
+            n == max_run_clusters_)
+        {
+            flush_(fun);
+        }
+    }
+
+    if (run_.lbas.empty())
+    {
+        run_.start = loc;
+    }
+
+    run_.lbas.push_back(lba);
+    run_.data.insert(run_.data.end(),
+                     buf,
+                     buf + size);
+}
+
+void
+FailOverCacheReplayReader::flush_(const RunFun& fun)
+{
+    if (not run_.lbas.empty())
+    {
+        fun(run_);
+        run_.lbas.clear();
+        run_.data.clear();
+    }
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,91 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VD_FAILOVER_CACHE_REPLAY_READER_H_
+#define VD_FAILOVER_CACHE_REPLAY_READER_H_
+
+#include "ClusterLocation.h"
+#include "Types.h"
+
+#include <functional>
+#include <vector>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+
+class FailOverCacheProxy;
+
+// Groups the entries streamed out of a FailOverCacheProxy into runs of clusters
+// at consecutive locations of the same SCO, i.e. into pieces that can be
+// written out in one go.
+// The runs are handed out from within the proxy's receive loop (the whole
+// GetEntries reply is received before the first entry is processed anyway).
+class FailOverCacheReplayReader
+{
+public:
+    struct Run
+    {
+        ClusterLocation start;
+        std::vector<uint64_t> lbas;
+        std::vector<uint8_t> data;
+    };
+
+    // The Run is only valid during the call.
+    using RunFun = std::function<void(const Run&)>;
+
+    FailOverCacheReplayReader(FailOverCacheProxy&,
+                              const ClusterSize,
+                              const size_t max_run_clusters = default_max_run_clusters);
+
+    ~FailOverCacheReplayReader() = default;
+
+    FailOverCacheReplayReader(const FailOverCacheReplayReader&) = delete;
+
+    FailOverCacheReplayReader&
+    operator=(const FailOverCacheReplayReader&) = delete;
+
+    void
+    read(const RunFun&);
+
+    static constexpr size_t default_max_run_clusters = 1024;
+
+private:
+    DECLARE_LOGGER("FailOverCacheReplayReader");
+
+    FailOverCacheProxy& foc_;
+    const ClusterSize cluster_size_;
+    const size_t max_run_clusters_;
+
+    Run run_;
+
+    void
+    add_(ClusterLocation loc,
+         uint64_t lba,
+         const uint8_t* buf,
+         size_t size,
+         const RunFun&);
+
+    void
+    flush_(const RunFun&);
+};
+
+}
+
+#endif // !VD_FAILOVER_CACHE_REPLAY_READER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
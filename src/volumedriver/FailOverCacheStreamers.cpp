@@ -18,11 +18,114 @@
 #include "failovercache/fungilib/WrapByteArray.h"
 #include "failovercache/fungilib/Socket.h"
 
+#include <cstring>
+#include <limits>
+
+#include <sys/uio.h>
+
 namespace
 {
 
 DECLARE_LOGGER("FailOverCacheStreamers");
 
+using namespace volumedriver;
+
+// Encodes the fixed size parts of a request into a preallocated buffer, in the
+// same (native) representation fungi::IOBaseStream uses.
+class HeaderWriter
+{
+public:
+    explicit HeaderWriter(std::vector<uint8_t>& buf)
+        : buf_(buf)
+        , pos_(0)
+    {}
+
+    template<typename T>
+    void
+    put(const T t)
+    {
+        VERIFY(pos_ + sizeof(T) <= buf_.size());
+        memcpy(buf_.data() + pos_, &t, sizeof(T));
+        pos_ += sizeof(T);
+    }
+
+    void
+    cluster_location(const ClusterLocation& loc)
+    {
+        put<uint16_t>(loc.offset());
+        put<uint8_t>(loc.sco().version());
+        put<uint32_t>(loc.sco().number());
+        put<uint8_t>(loc.sco().cloneID());
+    }
+
+    uint8_t*
+    pos()
+    {
+        return buf_.data() + pos_;
+    }
+
+private:
+    std::vector<uint8_t>& buf_;
+    size_t pos_;
+};
+
+// chunk length + command + number of entries
+const size_t request_header_size =
+    sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+// ClusterLocation + lba + size of the ByteArray
+const size_t entry_header_size =
+    sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint8_t) +
+    sizeof(uint64_t) + sizeof(int64_t);
+
+// The TCP variant of AddEntries: the request is framed like a corked chunk but
+// handed to the socket as a list of buffers that reference the cluster data
+// directly, instead of copying everything into the cork buffer first.
+void
+send_add_entries_gathered(fungi::IOBaseStream& stream,
+                          const std::vector<FailOverCacheEntry>& entries)
+{
+    std::vector<uint8_t> headers(request_header_size +
+                                 entries.size() * entry_header_size);
+    std::vector<struct iovec> iov;
+    iov.reserve(2 * entries.size() + 1);
+
+    size_t len = headers.size() - sizeof(uint32_t);
+    for (const auto& e : entries)
+    {
+        len += e.size_;
+    }
+
+    VERIFY(len <= static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+
+    HeaderWriter w(headers);
+    uint8_t* start = w.pos();
+
+    w.put<int32_t>(len);
+    w.put<uint32_t>(AddEntries);
+    w.put<uint64_t>(entries.size());
+
+    for (const auto& e : entries)
+    {
+        w.cluster_location(e.cli_);
+        w.put<uint64_t>(e.lba_);
+        w.put<int64_t>(e.size_);
+
+        iov.push_back({ start, static_cast<size_t>(w.pos() - start) });
+        iov.push_back({ const_cast<uint8_t*>(e.buffer_), e.size_ });
+
+        start = w.pos();
+    }
+
+    if (w.pos() != start)
+    {
+        iov.push_back({ start, static_cast<size_t>(w.pos() - start) });
+    }
+
+    stream.writev(iov.data(),
+                  iov.size());
+}
+
 }
 
 namespace volumedriver
@@ -65,15 +168,31 @@ operator>>(fungi::IOBaseStream& stream, CommandData<Register>& data)
 fungi::IOBaseStream&
 operator<<(fungi::IOBaseStream& stream, const CommandData<AddEntries>& data)
 {
-    if (not data.entries_.empty())
+    sendAddEntries(stream,
+                   data.entries_);
+    return checkStreamOK(stream, "AddEntries");
+}
+
+void
+sendAddEntries(fungi::IOBaseStream& stream,
+               const std::vector<FailOverCacheEntry>& entries)
+{
+    if (not entries.empty())
     {
-        VERIFY(data.entries_.front().cli_.sco() == data.entries_.back().cli_.sco());
+        VERIFY(entries.front().cli_.sco() == entries.back().cli_.sco());
     }
 
     bool isRDMA = stream.isRdma();
+    if (not isRDMA)
+    {
+        send_add_entries_gathered(stream,
+                                  entries);
+        return;
+    }
+
     stream << fungi::IOBaseStream::cork;
     OUT_ENUM(stream, AddEntries);
-    const size_t wsize = data.entries_.size();
+    const size_t wsize = entries.size();
     stream << wsize;
 
     if (isRDMA) // make small but finished packets with RDMA
@@ -81,8 +200,8 @@ operator<<(fungi::IOBaseStream& stream, const CommandData<AddEntries>& data)
         stream << fungi::IOBaseStream::uncork;
     }
 
-    for (std::vector<FailOverCacheEntry>::const_iterator it = data.entries_.begin();
-        it!= data.entries_.end();
+    for (std::vector<FailOverCacheEntry>::const_iterator it = entries.begin();
+        it!= entries.end();
         ++it)
     {
         if (isRDMA) // make small but finished packets with RDMA
@@ -99,7 +218,83 @@ operator<<(fungi::IOBaseStream& stream, const CommandData<AddEntries>& data)
         }
     }
     stream << fungi::IOBaseStream::uncork;
-    return checkStreamOK(stream, "AddEntries");
+}
+
+void
+sendAttachSharedMemory(fungi::IOBaseStream& stream,
+                       uint64_t region_id,
+                       uint64_t cookie,
+                       uint64_t size)
+{
+    stream << fungi::IOBaseStream::cork;
+    OUT_ENUM(stream, AttachSharedMemory);
+    stream << region_id;
+    stream << cookie;
+    stream << size;
+    stream << fungi::IOBaseStream::uncork;
+}
+
+void
+sendAddEntriesShared(fungi::IOBaseStream& stream,
+                     const std::vector<FailOverCacheEntry>& entries,
+                     uint64_t offset)
+{
+    if (not entries.empty())
+    {
+        VERIFY(entries.front().cli_.sco() == entries.back().cli_.sco());
+    }
+
+    stream << fungi::IOBaseStream::cork;
+    OUT_ENUM(stream, AddEntriesShared);
+    stream << static_cast<uint64_t>(entries.size());
+    stream << offset;
+
+    for (const auto& e : entries)
+    {
+        stream << e.cli_;
+        stream << e.lba_;
+        stream << static_cast<int64_t>(e.size_);
+    }
+
+    stream << fungi::IOBaseStream::uncork;
+}
+
+void
+sendEnableCompression(fungi::IOBaseStream& stream,
+                      uint32_t codec)
+{
+    stream << fungi::IOBaseStream::cork;
+    OUT_ENUM(stream, EnableCompression);
+    stream << codec;
+    stream << fungi::IOBaseStream::uncork;
+}
+
+void
+sendAddEntriesCompressed(fungi::IOBaseStream& stream,
+                         const std::vector<FailOverCacheEntry>& entries,
+                         uint64_t raw_size,
+                         const uint8_t* data,
+                         uint64_t size)
+{
+    if (not entries.empty())
+    {
+        VERIFY(entries.front().cli_.sco() == entries.back().cli_.sco());
+    }
+
+    stream << fungi::IOBaseStream::cork;
+    OUT_ENUM(stream, AddEntriesCompressed);
+    stream << static_cast<uint64_t>(entries.size());
+
+    for (const auto& e : entries)
+    {
+        stream << e.cli_;
+        stream << e.lba_;
+        stream << static_cast<int64_t>(e.size_);
+    }
+
+    stream << raw_size;
+    stream << fungi::WrapByteArray(const_cast<byte*>(data), size);
+    stream << fungi::IOBaseStream::uncork;
 }
 
 fungi::IOBaseStream&
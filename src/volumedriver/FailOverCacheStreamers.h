@@ -37,7 +37,11 @@ enum FailOverCacheCommand
     NotOk          =  0x8,
     Unregister     =  0x9,
     Clear          =  0xA,
-    GetSCORange    =  0xB
+    GetSCORange    =  0xB,
+    AttachSharedMemory = 0xC,
+    AddEntriesShared   = 0xD,
+    EnableCompression  = 0xE,
+    AddEntriesCompressed = 0xF,
     //    Bye            =  0xff
 };
 
@@ -118,6 +122,58 @@ operator<<(fungi::IOBaseStream& stream, const CommandData<AddEntries>& data);
 fungi::IOBaseStream&
 operator>>(fungi::IOBaseStream& stream, CommandData<AddEntries>& data);
 
+// Sends an AddEntries request without waiting for the reply, which needs to be
+// consumed with checkStreamOK later on.
+void
+sendAddEntries(fungi::IOBaseStream& stream,
+               const std::vector<FailOverCacheEntry>& entries);
+
+// Shared memory transport for a DTL on the same host: the client creates a
+// shared memory region and announces it with AttachSharedMemory (region id,
+// cookie, size). The server maps it and checks that the cookie stored at the
+// start of the region matches - otherwise it's not on the same host (or the
+// same IPC namespace) and it replies NotOk.
+// AddEntriesShared is AddEntries without the cluster data, which is instead
+// found in the region's data area (i.e. after the header) at the given offset.
+// The client copies the data into the region and the server hands it to the
+// backend from there, so the payload is copied once instead of through the
+// loopback socket. Requests and acknowledgements still go over the socket,
+// i.e. every batch still costs a round trip.
+const size_t dtl_shmem_header_size = 64;
+
+void
+sendAttachSharedMemory(fungi::IOBaseStream& stream,
+                       uint64_t region_id,
+                       uint64_t cookie,
+                       uint64_t size);
+
+// As sendAddEntries.
+void
+sendAddEntriesShared(fungi::IOBaseStream& stream,
+                     const std::vector<FailOverCacheEntry>& entries,
+                     uint64_t offset);
+
+// Optional compression of the cluster data of AddEntries requests: the client
+// asks for it with EnableCompression (codec) after Register, and the server
+// replies Ok if it supports the codec. Servers that predate this reply NotOk
+// and drop the connection, so it's to be switched on only once all DTL servers
+// understand it.
+// AddEntriesCompressed is AddEntries with the cluster data of all entries
+// concatenated and compressed (snappy raw format) into a single ByteArray,
+// preceded by its uncompressed size.
+const uint32_t dtl_compression_snappy = 1;
+
+void
+sendEnableCompression(fungi::IOBaseStream& stream,
+                      uint32_t codec);
+
+// As sendAddEntries. `data' is the compressed cluster data of all entries.
+void
+sendAddEntriesCompressed(fungi::IOBaseStream& stream,
+                         const std::vector<FailOverCacheEntry>& entries,
+                         uint64_t raw_size,
+                         const uint8_t* data,
+                         uint64_t size);
 
 template<>
 struct CommandData<Flush>
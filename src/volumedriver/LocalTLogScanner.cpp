@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "LocalTLogScanner.h"
+#include "MappedTLogReader.h"
 #include "MetaDataStoreInterface.h"
 #include "SnapshotPersistor.h"
 #include "TLogReaderInterface.h"
@@ -125,7 +126,7 @@ LocalTLogScanner::scanTLog(const TLogId& tlog_id)
 
     current_proc_.reset(new CheckTLogAndSCOCRCProcessor(tlog_id));
     auto proc = make_combined_processor(*this, *current_proc_);
-    TLogReader tlog_reader(tlog_path);
+    MappedTLogReader tlog_reader(tlog_path);
 
     bool current_tlog_scanned_to_the_end = true;
     try
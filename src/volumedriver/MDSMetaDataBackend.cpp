@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "CachedMetaDataPage.h"
+#include "CachePageCodec.h"
 #include "MDSMetaDataBackend.h"
 #include "MDSNodeConfig.h"
 #include "VolManager.h"
@@ -23,29 +24,6 @@
 #include <youtils/Assert.h>
 #include <youtils/Catchers.h>
 
-namespace metadata_server
-{
-
-template<>
-struct DataBufferTraits<volumedriver::CachePage>
-{
-    static size_t
-    size(const volumedriver::CachePage&)
-    {
-        return volumedriver::CachePage::size();
-    }
-
-    static const void*
-    data(const volumedriver::CachePage& page)
-    {
-        return (const void*)page.data();
-    }
-};
-
-}
-
-TODO("AR: TODO: introduce batching");
-
 namespace volumedriver
 {
 
@@ -58,10 +36,16 @@ namespace yt = youtils;
 namespace
 {
 
-const std::string cork_key("cork_id");
+const std::string cork_id_key("cork_id");
 const std::string used_clusters_key("used_clusters");
 const std::string scrub_id_key("scrub_id");
 
+const size_t shmem_size = 64ULL << 10;
+
+// Keep batched multisets within the shared memory region (leaving some headroom
+// for the encoding overhead) - they'd otherwise fall back to the socket.
+const size_t max_multiset_size = shmem_size / 2;
+
 DECLARE_LOGGER("MDSMetaDataBackendHelpers");
 
 mds::DataBaseInterfacePtr
@@ -96,6 +80,20 @@ make_db(const MDSNodeConfig& cfg,
     return db;
 }
 
+bool
+encode_pages()
+{
+    try
+    {
+        return VolManager::get()->metadata_page_encoding.value();
+    }
+    catch (std::logic_error&)
+    {
+        LOG_WARN("VolManager not running - this should only happen in a test!");
+        return false;
+    }
+}
+
 }
 
 TODO("AR: expose shmem size!?");
@@ -105,10 +103,11 @@ MDSMetaDataBackend::MDSMetaDataBackend(const MDSNodeConfig& config,
                                        const boost::optional<std::chrono::seconds>& timeout)
 try
     : db_(make_db(config,
-                  64ULL << 10,
+                  shmem_size,
                   timeout))
     , table_(db_->open(nspace.str()))
     , used_clusters_(0)
+    , encode_pages_(encode_pages())
 {
     LOG_INFO(nspace << ": using " << config);
 
@@ -122,6 +121,8 @@ try
     : db_(db)
     , table_(db_->open(nspace.str()))
     , used_clusters_(0)
+    // used by the MDS itself, which doesn't get to decide on the format
+    , encode_pages_(false)
 {
     LOG_INFO(nspace);
 
@@ -144,6 +145,12 @@ MDSMetaDataBackend::~MDSMetaDataBackend()
     }
 }
 
+const std::string&
+MDSMetaDataBackend::cork_key()
+{
+    return cork_id_key;
+}
+
 void
 MDSMetaDataBackend::init_()
 {
@@ -169,8 +176,9 @@ MDSMetaDataBackend::getPage(CachePage& p)
 
     if (ms[0] != boost::none)
     {
-        VERIFY(ms[0]->size() == CachePage::size());
-        memcpy(p.data(), ms[0]->data(), ms[0]->size());
+        CachePageCodec::decode(ms[0]->data(),
+                               ms[0]->size(),
+                               p);
         return true;
     }
     else
@@ -192,9 +200,12 @@ MDSMetaDataBackend::putPage(const CachePage& p,
     VERIFY(x >= 0);
     const uint64_t used_clusters = x;
 
+    std::string val;
+    CachePageCodec::serialize(p, val, encode_pages_);
+
     const mds::TableInterface::Records
         recs{ mds::Record(mds::Key(p.page_address()),
-                          mds::Value(p)),
+                          mds::Value(val)),
               mds::Record(mds::Key(used_clusters_key),
                           mds::Value(used_clusters)) };
 
@@ -229,6 +240,88 @@ MDSMetaDataBackend::discardPage(const CachePage& p,
     used_clusters_ = used_clusters;
 }
 
+void
+MDSMetaDataBackend::multiset_pages_(const PageUpdates& pages,
+                                    bool discard)
+{
+    LOG_TRACE(table_->nspace() << ": " << pages.size() << " pages, discard: " <<
+              discard);
+
+    if (pages.empty())
+    {
+        return;
+    }
+
+    int64_t x = used_clusters_;
+    for (const auto& u : pages)
+    {
+        x += u.used_clusters_delta;
+    }
+
+    VERIFY(x >= 0);
+    const uint64_t used_clusters = x;
+
+    mds::TableInterface::Records recs;
+    size_t size = 0;
+
+    // The records only reference the serialized pages, hence these must not move
+    // before the multiset.
+    std::vector<std::string> vals;
+    if (not discard)
+    {
+        vals.reserve(pages.size());
+    }
+
+    for (const auto& u : pages)
+    {
+        if (discard)
+        {
+            recs.emplace_back(mds::Key(u.page.page_address()),
+                              mds::None());
+        }
+        else
+        {
+            vals.emplace_back();
+            CachePageCodec::serialize(u.page, vals.back(), encode_pages_);
+            recs.emplace_back(mds::Key(u.page.page_address()),
+                              mds::Value(vals.back()));
+            size += vals.back().size();
+        }
+
+        size += sizeof(PageAddress);
+
+        if (size >= max_multiset_size)
+        {
+            table_->multiset(recs,
+                             Barrier::F);
+            recs.clear();
+            size = 0;
+        }
+    }
+
+    recs.emplace_back(mds::Key(used_clusters_key),
+                      mds::Value(used_clusters));
+
+    table_->multiset(recs,
+                     Barrier::F);
+
+    used_clusters_ = used_clusters;
+}
+
+void
+MDSMetaDataBackend::putPages(const PageUpdates& pages)
+{
+    multiset_pages_(pages,
+                    false);
+}
+
+void
+MDSMetaDataBackend::discardPages(const PageUpdates& pages)
+{
+    multiset_pages_(pages,
+                    true);
+}
+
 void
 MDSMetaDataBackend::sync()
 {
@@ -250,7 +343,7 @@ MDSMetaDataBackend::setCork(const yt::UUID& cork_id)
 
     const std::string s(cork_id.str());
 
-    const mds::TableInterface::Records recs{ mds::Record(mds::Key(cork_key),
+    const mds::TableInterface::Records recs{ mds::Record(mds::Key(cork_id_key),
                                                          mds::Value(s)) };
 
     table_->multiset(recs,
@@ -262,7 +355,7 @@ MDSMetaDataBackend::lastCorkUUID()
 {
     LOG_TRACE(table_->nspace());
 
-    const mds::TableInterface::Keys keys{ mds::Key(cork_key) };
+    const mds::TableInterface::Keys keys{ mds::Key(cork_id_key) };
     const mds::TableInterface::MaybeStrings ms(table_->multiget(keys));
 
     boost::optional<yt::UUID> cork;
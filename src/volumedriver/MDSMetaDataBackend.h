@@ -64,12 +64,24 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    virtual void
+    putPages(const PageUpdates& pages) override final;
+
+    virtual void
+    discardPages(const PageUpdates& pages) override final;
+
     bool
     pageExistsInParent(const PageAddress) const override final
     {
         return false;
     }
 
+    bool
+    concurrent_reads() const override final
+    {
+        return true;
+    }
+
     void
     sync() override final;
 
@@ -140,6 +152,16 @@ public:
         table_->set_role(metadata_server::Role::Master);
     }
 
+    void
+    set_replicas(const MDSNodeConfigs& replicas)
+    {
+        table_->set_replicas(replicas);
+    }
+
+    // the key the cork is stored under
+    static const std::string&
+    cork_key();
+
 private:
     DECLARE_LOGGER("MDSMetaDataBackend");
 
@@ -147,9 +169,14 @@ private:
     metadata_server::TableInterfacePtr table_;
     const boost::optional<MDSNodeConfig> config_;
     uint64_t used_clusters_;
+    const bool encode_pages_;
 
     void
     init_();
+
+    void
+    multiset_pages_(const PageUpdates&,
+                    bool discard);
 };
 
 }
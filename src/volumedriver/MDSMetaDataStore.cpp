@@ -22,6 +22,7 @@
 #include "VolumeInterface.h"
 
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
 
 #include <metadata-server/ClientNG.h>
 
@@ -45,7 +46,8 @@ namespace yt = youtils;
 MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
                                    be::BackendInterfacePtr bi,
                                    const fs::path& home,
-                                   uint64_t num_pages_cached)
+                                   uint64_t num_pages_cached,
+                                   const std::shared_ptr<MetaDataCacheBudget>& cache_budget)
     : VolumeBackPointer(getLogger__())
     , rwlock_("mdsmdstore-" + bi->getNS().str())
     , bi_(std::move(bi))
@@ -53,6 +55,7 @@ MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
     , apply_relocations_to_slaves_(cfg.apply_relocations_to_slaves())
     , timeout_(cfg.timeout())
     , num_pages_cached_(num_pages_cached)
+    , cache_budget_(cache_budget)
     , home_(home)
 {
     check_config_(cfg);
@@ -76,7 +79,7 @@ MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
 
     try
     {
-        mdstore_ = connect_(node_configs_[0]);
+        mdstore_ = connect_(node_configs_);
     }
     CATCH_STD_ALL_EWHAT({
             LOG_ERROR(bi_->getNS() << ": failed to connect to " <<
@@ -214,7 +217,7 @@ MDSMetaDataStore::do_failover_(bool startup)
 
         try
         {
-            MetaDataStorePtr md(build_new_one_(node_configs_[0],
+            MetaDataStorePtr md(build_new_one_(node_configs_,
                                                startup));
             std::stringstream ss;
             ss << node_configs_[0];
@@ -237,8 +240,11 @@ MDSMetaDataStore::do_failover_(bool startup)
 }
 
 MDSMetaDataStore::MetaDataStorePtr
-MDSMetaDataStore::connect_(const MDSNodeConfig& ncfg) const
+MDSMetaDataStore::connect_(const MDSNodeConfigs& ncfgs) const
 {
+    VERIFY(not ncfgs.empty());
+    const MDSNodeConfig& ncfg = ncfgs[0];
+
     LOG_INFO(bi_->getNS() << ": connecting to " << ncfg);
 
     auto mdb(std::make_shared<MDSMetaDataBackend>(ncfg,
@@ -247,22 +253,46 @@ MDSMetaDataStore::connect_(const MDSNodeConfig& ncfg) const
 
     auto md(std::make_shared<CachedMetaDataStore>(mdb,
                                                   bi_->getNS().str(),
-                                                  num_pages_cached_));
+                                                  num_pages_cached_,
+                                                  cache_budget_));
 
     mdb->set_master();
+    register_replicas_(*mdb,
+                       ncfgs);
 
     return md;
 }
 
+void
+MDSMetaDataStore::register_replicas_(MDSMetaDataBackend& mdb,
+                                     const MDSNodeConfigs& ncfgs) const
+{
+    VERIFY(not ncfgs.empty());
+
+    const MDSNodeConfigs replicas(ncfgs.begin() + 1,
+                                  ncfgs.end());
+
+    // Streaming to the replicas is an optimization - they fall back to catching
+    // up via the backend.
+    try
+    {
+        mdb.set_replicas(replicas);
+    }
+    CATCH_STD_ALL_LOG_IGNORE(bi_->getNS() << ": failed to register replicas with " <<
+                             ncfgs[0]);
+}
+
 MDSMetaDataStore::MetaDataStorePtr
-MDSMetaDataStore::build_new_one_(const MDSNodeConfig& ncfg,
+MDSMetaDataStore::build_new_one_(const MDSNodeConfigs& ncfgs,
                                  bool startup) const
 {
     ASSERT_WLOCKED();
 
-    LOG_INFO(bi_->getNS() << ": attempting failover to " << ncfg);
+    VERIFY(not ncfgs.empty());
+
+    LOG_INFO(bi_->getNS() << ": attempting failover to " << ncfgs[0]);
 
-    auto md(connect_(ncfg));
+    auto md(connect_(ncfgs));
 
     // mdstore_ can only be nullptr when we ended up here while in the constructor
     // Find a way to enforce this invariant.
@@ -564,13 +594,22 @@ MDSMetaDataStore::set_config(const MDSMetaDataBackendConfig& cfg)
         LOG_INFO(bi_->getNS() << ": " << node_configs_[0] <<
                  " is currently in use, failover to " << new_configs[0] <<
                  " requested");
-        mdstore_ = build_new_one_(new_configs[0],
+        mdstore_ = build_new_one_(new_configs,
                                   false);
     }
     else
     {
         LOG_INFO(bi_->getNS() << ": " << new_configs[0] <<
                  " is already in use, no need to failover");
+
+        if (new_configs != node_configs_)
+        {
+            MDSMetaDataBackend mdb(new_configs[0],
+                                   bi_->getNS(),
+                                   timeout_);
+            register_replicas_(mdb,
+                               new_configs);
+        }
     }
 
     node_configs_ = new_configs;
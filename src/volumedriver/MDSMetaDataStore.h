@@ -33,6 +33,7 @@ namespace volumedriver
 
 class CachedMetaDataStore;
 class MDSMetaDataBackend;
+class MetaDataCacheBudget;
 
 class ClusterLocationAndHash;
 
@@ -47,7 +48,8 @@ public:
     MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
                      backend::BackendInterfacePtr bi,
                      const boost::filesystem::path& home,
-                     uint64_t num_pages_cached);
+                     uint64_t num_pages_cached,
+                     const std::shared_ptr<MetaDataCacheBudget>& cache_budget = nullptr);
 
     ~MDSMetaDataStore() = default;
 
@@ -152,17 +154,24 @@ private:
     std::chrono::seconds timeout_;
 
     const uint64_t num_pages_cached_;
+    const std::shared_ptr<MetaDataCacheBudget> cache_budget_;
     const boost::filesystem::path home_;
 
     using MetaDataStorePtr = std::shared_ptr<CachedMetaDataStore>;
 
+    // The first entry of `ncfgs' is the one to connect to, the remaining ones
+    // are registered with it as replicas.
     MetaDataStorePtr
-    connect_(const MDSNodeConfig& ncfg) const;
+    connect_(const MDSNodeConfigs& ncfgs) const;
 
     MetaDataStorePtr
-    build_new_one_(const MDSNodeConfig& ncfg,
+    build_new_one_(const MDSNodeConfigs& ncfgs,
                    bool startup) const;
 
+    void
+    register_replicas_(MDSMetaDataBackend&,
+                       const MDSNodeConfigs&) const;
+
     void
     failover_(MetaDataStorePtr& md,
               const char* desc);
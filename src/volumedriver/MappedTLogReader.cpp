@@ -0,0 +1,226 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MappedTLogReader.h"
+#include "VolumeDriverError.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
+
+namespace volumedriver
+{
+
+namespace yt = youtils;
+
+namespace
+{
+
+// backward readers ask the kernel to read ahead (well, behind) this much
+const size_t backward_advice_size = 1ULL << 20;
+
+}
+
+MappedTLogReader::MappedTLogReader(const fs::path& tlog_path,
+                                   const std::string& tlog_name,
+                                   BackendInterfacePtr bi,
+                                   Direction dir,
+                                   VerifyTLogCRC verify)
+    : OneFileTLogReader(tlog_path,
+                        tlog_name,
+                        std::move(bi))
+    , dir_(dir)
+    , verify_(verify)
+    , addr_(nullptr)
+    , size_(0)
+    , entries_(nullptr)
+    , count_(0)
+    , pos_(0)
+{
+    map_();
+}
+
+MappedTLogReader::MappedTLogReader(const fs::path& path,
+                                   Direction dir,
+                                   VerifyTLogCRC verify)
+    : OneFileTLogReader(path)
+    , dir_(dir)
+    , verify_(verify)
+    , addr_(nullptr)
+    , size_(0)
+    , entries_(nullptr)
+    , count_(0)
+    , pos_(0)
+{
+    map_();
+}
+
+MappedTLogReader::~MappedTLogReader()
+{
+    if (addr_ != nullptr)
+    {
+        int ret = ::munmap(addr_,
+                           size_);
+        if (ret != 0)
+        {
+            ret = errno;
+            LOG_ERROR(file_->path() << ": failed to unmap: " << strerror(ret));
+        }
+    }
+}
+
+void
+MappedTLogReader::map_()
+{
+    VERIFY(file_);
+
+    const fs::path& path = file_->path();
+
+    try
+    {
+        // OneFileTLogReader already got rid of trailing garbage
+        size_ = fs::file_size(path);
+        VERIFY(size_ % Entry::getDataSize() == 0);
+        count_ = size_ / Entry::getDataSize();
+
+        if (size_ == 0)
+        {
+            return;
+        }
+
+        // FileDescriptor does not hand out its fd, so we open the file once more
+        // - the mapping outlives the fd anyway.
+        int fd = ::open(path.string().c_str(),
+                        O_RDONLY);
+        if (fd < 0)
+        {
+            throw fungi::IOException("Failed to open TLog",
+                                     path.string().c_str(),
+                                     errno);
+        }
+
+        auto on_exit(yt::make_scope_exit([&]
+                                         {
+                                             ::close(fd);
+                                         }));
+
+        addr_ = ::mmap(nullptr,
+                       size_,
+                       PROT_READ,
+                       MAP_SHARED,
+                       fd,
+                       0);
+        if (addr_ == MAP_FAILED)
+        {
+            addr_ = nullptr;
+            throw fungi::IOException("Failed to mmap TLog",
+                                     path.string().c_str(),
+                                     errno);
+        }
+
+        entries_ = static_cast<const Entry*>(addr_);
+
+        if (dir_ == Direction::Forward)
+        {
+            // errors are not fatal here, we'd merely miss out on the read ahead
+            ::madvise(addr_,
+                      size_,
+                      MADV_SEQUENTIAL);
+        }
+        else
+        {
+            advise_backward_();
+        }
+    }
+    CATCH_STD_ALL_EWHAT({
+            VolumeDriverError::report(events::VolumeDriverErrorCode::ReadTLog,
+                                      EWHAT);
+            throw;
+        });
+}
+
+// There's no madvise hint for reading backwards, so we explicitly ask for the
+// next chunk (in reading direction) to be read in whenever we enter a new one.
+void
+MappedTLogReader::advise_backward_()
+{
+    ASSERT(dir_ == Direction::Backward);
+
+    const uint64_t entries_per_chunk = backward_advice_size / Entry::getDataSize();
+    const uint64_t remaining = count_ - pos_;
+
+    if (remaining > 0 and pos_ % entries_per_chunk == 0)
+    {
+        const uint64_t first = remaining > entries_per_chunk ?
+            remaining - entries_per_chunk :
+            0;
+        // madvise wants a page aligned address
+        const uintptr_t page_mask = ~(static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE)) - 1);
+        const uintptr_t start = reinterpret_cast<uintptr_t>(entries_ + first) & page_mask;
+        const uintptr_t end = reinterpret_cast<uintptr_t>(entries_ + remaining);
+
+        ::madvise(reinterpret_cast<void*>(start),
+                  end - start,
+                  MADV_WILLNEED);
+    }
+}
+
+const Entry*
+MappedTLogReader::nextAny()
+{
+    if (pos_ == count_)
+    {
+        return nullptr;
+    }
+
+    const Entry* e = nullptr;
+
+    if (dir_ == Direction::Forward)
+    {
+        e = entries_ + pos_++;
+
+        if (T(verify_))
+        {
+            if (e->isTLogCRC() and
+                e->getCheckSum() != checksum_.getValue())
+            {
+                LOG_ERROR(file_->path() << ": TLog CRC mismatch at entry " <<
+                          (pos_ - 1) << ": expected " << e->getCheckSum() <<
+                          ", got " << checksum_.getValue());
+                throw TLogCRCMismatchException("TLog CRC mismatch",
+                                               file_->path().string().c_str());
+            }
+
+            checksum_.update(e,
+                             Entry::getDataSize());
+        }
+    }
+    else
+    {
+        advise_backward_();
+        e = entries_ + (count_ - ++pos_);
+    }
+
+    return e;
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
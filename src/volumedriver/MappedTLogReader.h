@@ -0,0 +1,142 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VD_MAPPED_TLOG_READER_H_
+#define VD_MAPPED_TLOG_READER_H_
+
+#include "Entry.h"
+#include "OneFileTLogReader.h"
+
+#include <youtils/BooleanEnum.h>
+#include <youtils/CheckSum.h>
+#include <youtils/IOException.h>
+#include <youtils/Logging.h>
+
+#include <backend/BackendInterface.h>
+
+namespace volumedriver
+{
+
+BOOLEAN_ENUM(VerifyTLogCRC);
+
+MAKE_EXCEPTION(TLogCRCMismatchException, fungi::IOException);
+
+// mmap()s the TLog and hands out the Entries in place instead of copying them
+// into a buffer with a read() first. The TLog must not change while it's being
+// read, i.e. this is not suitable for the current TLog of a running volume.
+// Forward readers can optionally verify the TLog CRC entries against the
+// checksum of the preceding entries.
+class MappedTLogReader
+    : public OneFileTLogReader
+{
+public:
+    enum class Direction
+    {
+        Forward,
+        Backward,
+    };
+
+    MappedTLogReader(const fs::path& tlog_path,
+                     const std::string& tlog_name,
+                     BackendInterfacePtr bi,
+                     Direction dir = Direction::Forward,
+                     VerifyTLogCRC verify = VerifyTLogCRC::F);
+
+    explicit MappedTLogReader(const fs::path& path,
+                              Direction dir = Direction::Forward,
+                              VerifyTLogCRC verify = VerifyTLogCRC::F);
+
+    virtual ~MappedTLogReader();
+
+    MappedTLogReader(const MappedTLogReader&) = delete;
+
+    MappedTLogReader&
+    operator=(const MappedTLogReader&) = delete;
+
+    const Entry*
+    nextAny() override final;
+
+private:
+    DECLARE_LOGGER("MappedTLogReader");
+
+    const Direction dir_;
+    const VerifyTLogCRC verify_;
+    void* addr_;
+    size_t size_;
+    const Entry* entries_;
+    uint64_t count_;
+    uint64_t pos_;
+    youtils::CheckSum checksum_;
+
+    void
+    map_();
+
+    void
+    advise_backward_();
+};
+
+// Drop-in for BackwardTLogReader.
+class BackwardMappedTLogReader
+    : public MappedTLogReader
+{
+public:
+    BackwardMappedTLogReader(const fs::path& tlog_path,
+                             const std::string& tlog_name,
+                             BackendInterfacePtr bi)
+        : MappedTLogReader(tlog_path,
+                           tlog_name,
+                           std::move(bi),
+                           Direction::Backward)
+    {}
+
+    explicit BackwardMappedTLogReader(const fs::path& path)
+        : MappedTLogReader(path,
+                           Direction::Backward)
+    {}
+
+    virtual ~BackwardMappedTLogReader() = default;
+};
+
+// Drop-in for MappedTLogReader (cf. CombinedTLogReader) that verifies the TLog
+// CRCs - for TLogs that were fetched from the backend.
+class VerifyingMappedTLogReader
+    : public MappedTLogReader
+{
+public:
+    VerifyingMappedTLogReader(const fs::path& tlog_path,
+                              const std::string& tlog_name,
+                              BackendInterfacePtr bi)
+        : MappedTLogReader(tlog_path,
+                           tlog_name,
+                           std::move(bi),
+                           Direction::Forward,
+                           VerifyTLogCRC::T)
+    {}
+
+    explicit VerifyingMappedTLogReader(const fs::path& path)
+        : MappedTLogReader(path,
+                           Direction::Forward,
+                           VerifyTLogCRC::T)
+    {}
+
+    virtual ~VerifyingMappedTLogReader() = default;
+};
+
+}
+
+#endif // !VD_MAPPED_TLOG_READER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
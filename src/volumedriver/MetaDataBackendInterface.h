@@ -19,6 +19,8 @@
 #include "ScrubId.h"
 #include "Types.h"
 
+#include <vector>
+
 #include <youtils/IOException.h>
 
 namespace volumedriver
@@ -27,6 +29,22 @@ namespace volumedriver
 MAKE_EXCEPTION(MetaDataStoreBackendException, fungi::IOException);
 class CachePage;
 
+// A page to be written back to (or discarded from) the backend, along with the
+// change of the number of used clusters it brings.
+struct PageUpdate
+{
+    PageUpdate(const CachePage& p,
+               int32_t delta)
+        : page(p)
+        , used_clusters_delta(delta)
+    {}
+
+    const CachePage& page;
+    const int32_t used_clusters_delta;
+};
+
+using PageUpdates = std::vector<PageUpdate>;
+
 class MetaDataBackendInterface
 {
 public:
@@ -51,9 +69,25 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) = 0;
 
+    // Batched versions of putPage / discardPage: all pages go to the backend in as
+    // few round trips as possible and the used clusters are updated once per batch.
+    virtual void
+    putPages(const PageUpdates& pages) = 0;
+
+    virtual void
+    discardPages(const PageUpdates& pages) = 0;
+
     virtual bool
     pageExistsInParent(const PageAddress) const = 0;
 
+    // Whether getPage may be invoked concurrently from several threads (while
+    // all writes are still serialized by the caller).
+    virtual bool
+    concurrent_reads() const
+    {
+        return false;
+    }
+
     virtual void
     sync() = 0;
 
@@ -0,0 +1,253 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MetaDataCacheBudget.h"
+
+#include <algorithm>
+
+#include <boost/thread/lock_guard.hpp>
+
+#include <youtils/Assert.h>
+
+namespace volumedriver
+{
+
+#define LOCK()                                  \
+    boost::lock_guard<decltype(lock_)> lg__(lock_)
+
+constexpr std::chrono::seconds MetaDataCacheBudget::period_;
+
+MetaDataCacheBudget::MetaDataCacheBudget(uint64_t max_pages,
+                                         uint32_t min_pages)
+    : max_pages_(max_pages)
+    , min_pages_(min_pages)
+    , used_pages_(0)
+    , period_start_(Clock::now())
+{
+    VERIFY(max_pages_ > 0);
+
+    LOG_INFO("max pages: " << max_pages_ << ", min pages per volume: " <<
+             min_pages_);
+}
+
+MetaDataCacheBudget::~MetaDataCacheBudget()
+{
+    LOCK();
+
+    if (not clients_.empty())
+    {
+        LOG_ERROR(clients_.size() << " clients still registered");
+    }
+}
+
+void
+MetaDataCacheBudget::register_client(Client& c)
+{
+    LOCK();
+
+    ClientInfo info;
+    info.accesses = c.cache_hits() + c.cache_misses();
+
+    const auto res(clients_.emplace(&c,
+                                    info));
+    VERIFY(res.second);
+
+    LOG_INFO(c.cache_id() << ": registered, " << clients_.size() << " clients");
+}
+
+void
+MetaDataCacheBudget::unregister_client(Client& c)
+{
+    LOCK();
+
+    auto it = clients_.find(&c);
+    VERIFY(it != clients_.end());
+
+    ASSERT(used_pages_ >= it->second.pages);
+    used_pages_ -= it->second.pages;
+
+    LOG_INFO(c.cache_id() << ": unregistered, returned " << it->second.pages <<
+             " pages");
+
+    clients_.erase(it);
+}
+
+void
+MetaDataCacheBudget::maybe_age_()
+{
+    const Clock::time_point now = Clock::now();
+    if (now - period_start_ < period_)
+    {
+        return;
+    }
+
+    for (auto& p : clients_)
+    {
+        ClientInfo& info = p.second;
+        info.heat = heat_(*p.first, info) / 2;
+        info.accesses = p.first->cache_hits() + p.first->cache_misses();
+    }
+
+    period_start_ = now;
+}
+
+uint64_t
+MetaDataCacheBudget::heat_(const Client& c,
+                           const ClientInfo& info) const
+{
+    const uint64_t accesses = c.cache_hits() + c.cache_misses();
+    return info.heat + (accesses > info.accesses ? accesses - info.accesses : 0);
+}
+
+bool
+MetaDataCacheBudget::hotter_(uint64_t heat1,
+                             uint64_t pages1,
+                             uint64_t heat2,
+                             uint64_t pages2) const
+{
+    // compare the accesses per page, avoiding the divisions
+    return heat1 * std::max<uint64_t>(pages2, 1) >
+        heat2 * std::max<uint64_t>(pages1, 1);
+}
+
+bool
+MetaDataCacheBudget::grow(Client& c)
+{
+    LOCK();
+
+    auto it = clients_.find(&c);
+    VERIFY(it != clients_.end());
+
+    ClientInfo& info = it->second;
+
+    if (used_pages_ < max_pages_)
+    {
+        ++used_pages_;
+        ++info.pages;
+        return true;
+    }
+
+    maybe_age_();
+
+    const bool reserved = info.pages < min_pages_;
+    const uint64_t heat = heat_(c, info);
+
+    struct Candidate
+    {
+        Client* client;
+        ClientInfo* info;
+        uint64_t heat;
+    };
+
+    std::vector<Candidate> candidates;
+
+    for (auto& p : clients_)
+    {
+        if (p.first != &c and
+            p.second.pages > min_pages_)
+        {
+            const uint64_t h = heat_(*p.first, p.second);
+            if (reserved or
+                hotter_(heat, info.pages + 1, h, p.second.pages))
+            {
+                candidates.push_back(Candidate{ p.first,
+                                                &p.second,
+                                                h });
+            }
+        }
+    }
+
+    // coldest first
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [&](const Candidate& a,
+                  const Candidate& b)
+              {
+                  return hotter_(b.heat, b.info->pages,
+                                 a.heat, a.info->pages);
+              });
+
+    for (auto& cand : candidates)
+    {
+        if (cand.client->release_page())
+        {
+            --cand.info->pages;
+            ++info.pages;
+
+            LOG_TRACE(c.cache_id() << ": took over a page from " <<
+                      cand.client->cache_id());
+            return true;
+        }
+    }
+
+    // a client without any pages cannot evict, hence the budget is rather
+    // overcommitted by a page than leaving it stuck
+    if (info.pages == 0)
+    {
+        ++used_pages_;
+        ++info.pages;
+        return true;
+    }
+
+    return false;
+}
+
+void
+MetaDataCacheBudget::shrink(Client& c,
+                            uint64_t pages)
+{
+    LOCK();
+
+    auto it = clients_.find(&c);
+    VERIFY(it != clients_.end());
+    VERIFY(it->second.pages >= pages);
+
+    it->second.pages -= pages;
+
+    ASSERT(used_pages_ >= pages);
+    used_pages_ -= pages;
+}
+
+uint64_t
+MetaDataCacheBudget::used_pages() const
+{
+    LOCK();
+    return used_pages_;
+}
+
+std::vector<MetaDataCacheBudget::ClientStats>
+MetaDataCacheBudget::client_stats() const
+{
+    std::vector<ClientStats> stats;
+
+    LOCK();
+
+    stats.reserve(clients_.size());
+
+    for (const auto& p : clients_)
+    {
+        stats.push_back(ClientStats{ p.first->cache_id(),
+                                     p.second.pages,
+                                     p.first->cache_hits(),
+                                     p.first->cache_misses() });
+    }
+
+    return stats;
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
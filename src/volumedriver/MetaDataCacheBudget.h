@@ -0,0 +1,160 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VD_METADATA_CACHE_BUDGET_H_
+#define VD_METADATA_CACHE_BUDGET_H_
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+
+// Host wide budget for metadata cache pages, shared by the CachedMetaDataStores
+// of all volumes:
+// * each client (mdstore) is guaranteed min_pages, as long as the budget allows
+// * spare pages are handed out on demand, and once the budget is exhausted a
+//   client that misses more often (per page held) than another one can take over
+//   a page from the latter.
+// Clients give up pages voluntarily via release_page(), which must not block nor
+// do I/O as it's invoked with the budget lock held - i.e. only free or clean
+// pages can be given up.
+class MetaDataCacheBudget
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        virtual const std::string&
+        cache_id() const = 0;
+
+        virtual uint64_t
+        cache_hits() const = 0;
+
+        virtual uint64_t
+        cache_misses() const = 0;
+
+        // Try to give up a free or clean page without blocking. Returns whether
+        // a page was released.
+        virtual bool
+        release_page() = 0;
+    };
+
+    MetaDataCacheBudget(uint64_t max_pages,
+                        uint32_t min_pages);
+
+    ~MetaDataCacheBudget();
+
+    MetaDataCacheBudget(const MetaDataCacheBudget&) = delete;
+
+    MetaDataCacheBudget&
+    operator=(const MetaDataCacheBudget&) = delete;
+
+    void
+    register_client(Client&);
+
+    // Returns the pages back to the budget.
+    void
+    unregister_client(Client&);
+
+    // Ask for one more page. If false is returned the client has to make do
+    // with (i.e. evict from) the pages it already has. A client that has no pages
+    // at all is always granted one.
+    bool
+    grow(Client&);
+
+    // The client freed up `pages' pages on its own accord.
+    void
+    shrink(Client&,
+           uint64_t pages);
+
+    uint64_t
+    max_pages() const
+    {
+        return max_pages_;
+    }
+
+    uint32_t
+    min_pages() const
+    {
+        return min_pages_;
+    }
+
+    uint64_t
+    used_pages() const;
+
+    struct ClientStats
+    {
+        std::string id;
+        uint64_t pages;
+        uint64_t cache_hits;
+        uint64_t cache_misses;
+    };
+
+    std::vector<ClientStats>
+    client_stats() const;
+
+private:
+    DECLARE_LOGGER("MetaDataCacheBudget");
+
+    using Clock = std::chrono::steady_clock;
+
+    struct ClientInfo
+    {
+        uint64_t pages = 0;
+        // accesses at the beginning of the current period
+        uint64_t accesses = 0;
+        // decayed number of accesses over the previous periods
+        uint64_t heat = 0;
+    };
+
+    const uint64_t max_pages_;
+    const uint32_t min_pages_;
+
+    mutable boost::mutex lock_;
+    std::map<Client*, ClientInfo> clients_;
+    uint64_t used_pages_;
+    Clock::time_point period_start_;
+
+    static constexpr std::chrono::seconds period_ = std::chrono::seconds(1);
+
+    void
+    maybe_age_();
+
+    uint64_t
+    heat_(const Client&,
+          const ClientInfo&) const;
+
+    bool
+    hotter_(uint64_t heat1,
+            uint64_t pages1,
+            uint64_t heat2,
+            uint64_t pages2) const;
+};
+
+}
+
+#endif // !VD_METADATA_CACHE_BUDGET_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -13,9 +13,6 @@
 // limitations under the License.
 
 #include "PartScrubber.h"
-#include "TLogReader.h"
-#include "TLogWriter.h"
-#include "BackwardTLogReader.h"
 
 #include <cassert>
 
@@ -26,17 +23,22 @@ namespace scrubbing
 using namespace volumedriver;
 
 // Not so good since it's coupled too tightly to TLogSplitter
-PartScrubber::PartScrubber(TLogSplitter::MapType::const_iterator& iterator,
-                           scrubbing::ScrubbingSCODataVector& scodata,
+PartScrubber::PartScrubber(TLogSplitter::MapType::iterator iterator,
+                           const scrubbing::ScrubbingSCODataVector& scodata,
+                           UsageCounts& usage_counts,
                            FilePool& filepool,
+                           ScrubMemoryBudget& budget,
                            RegionExponent regionsize,
                            ClusterExponent clustersize)
     : iterator_(iterator)
     , clustersize_(clustersize)
     , regionsize_(regionsize)
     , scodata_(scodata)
+    , usage_counts_(usage_counts)
     , filepool_(filepool)
+    , budget_(budget)
 {
+    VERIFY(usage_counts_.size() == scodata_.size());
     cluster_begin_ = (iterator_->first << regionsize_);
 }
 
@@ -55,15 +57,17 @@ PartScrubber::updateIterator(const SCO sconame)
     }
     else
     {
-        ++(scodata_iterator->usageCount);
-        VERIFY(scodata_iterator->size >= scodata_iterator->usageCount);
+        uint16_t& count = usage_counts_[scodata_iterator.base() - scodata_.begin() - 1];
+        ++count;
+        VERIFY(scodata_iterator->size >= count);
     }
 }
 
-void
-PartScrubber::operator()(std::vector<fs::path>& tlogs)
+std::unique_ptr<ScrubEntryBuffer>
+PartScrubber::operator()()
 {
-    BackwardTLogReader tlog_reader(iterator_->second);
+    VERIFY(iterator_->second);
+    std::unique_ptr<TLogReaderInterface> tlog_reader(iterator_->second->backward_reader());
 
     typedef boost::dynamic_bitset<> bitset_type;
 
@@ -78,16 +82,15 @@ PartScrubber::operator()(std::vector<fs::path>& tlogs)
 
     // Start Looking at the back of the sconames.
 
-    scodata_iterator = scodata_.rbegin();
+    scodata_iterator = scodata_.crbegin();
     std::stringstream ss;
     ss << "metadatascrubbed_tlog_for_region_" << iterator_->first;
-    fs::path tlog_path = filepool_.newFile(ss.str());
-
-    TLogWriter out_tlog(tlog_path);
-    ss.clear();
+    auto out(std::make_unique<ScrubEntryBuffer>(budget_,
+                                                filepool_,
+                                                ss.str()));
 
     const Entry* e;
-    while((e = tlog_reader.nextLocation()))
+    while((e = tlog_reader->nextLocation()))
     {
         // switch(e->getType())
         // {
@@ -97,8 +100,8 @@ PartScrubber::operator()(std::vector<fs::path>& tlogs)
         if(not bitset[e->clusterAddress() - cluster_begin_])
         {
             // We know it's a location entry here
-            out_tlog.add(e->clusterAddress(),
-                         e->clusterLocationAndHash());
+            out->add(e->clusterAddress(),
+                     e->clusterLocationAndHash());
             updateIterator(e->clusterLocation().sco());
             bitset[e->clusterAddress() - cluster_begin_] = true;
         }
@@ -109,7 +112,12 @@ PartScrubber::operator()(std::vector<fs::path>& tlogs)
         //     throw fungi::IOException("Unknown entry type");
         // }
     }
-    tlogs.push_back(tlog_path);
+
+    tlog_reader.reset();
+    iterator_->second.reset();
+
+    out->seal();
+    return out;
 }
 
 }
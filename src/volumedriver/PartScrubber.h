@@ -18,34 +18,46 @@
 #include "SCOPool.h"
 #include "TLogSplitter.h"
 #include <string>
+#include <vector>
 
 namespace scrubbing
 {
 class PartScrubber
 {
 public:
-    PartScrubber(TLogSplitter::MapType::const_iterator&,
-                 scrubbing::ScrubbingSCODataVector& scodata,
+    // Per SCO usage counts, indexed like the ScrubbingSCODataVector. PartScrubbers
+    // of different regions run concurrently, hence each of them accumulates into
+    // its own UsageCounts which are merged into the ScrubbingSCODataVector later on.
+    typedef std::vector<uint16_t> UsageCounts;
+
+    PartScrubber(TLogSplitter::MapType::iterator,
+                 const scrubbing::ScrubbingSCODataVector& scodata,
+                 UsageCounts& usage_counts,
                  volumedriver::FilePool& filepool,
+                 ScrubMemoryBudget& budget,
                  RegionExponent regionsize,
                  volumedriver::ClusterExponent clustersize);
 
-    void
-    operator()(std::vector<fs::path>& tlogs);
+    // Returns the metadata scrubbed entries of the region in backward order. The
+    // region's input entries are dropped.
+    std::unique_ptr<ScrubEntryBuffer>
+    operator()();
 
 private:
     DECLARE_LOGGER("PartScrubber");
 
-    ScrubbingSCODataVector::reverse_iterator scodata_iterator;
+    ScrubbingSCODataVector::const_reverse_iterator scodata_iterator;
 
-    TLogSplitter::MapType::const_iterator& iterator_;
+    TLogSplitter::MapType::iterator iterator_;
     // What the F?
     const uint16_t clustersize_;
     RegionExponent regionsize_;
     //    SCOPool& scopool_;
-    scrubbing::ScrubbingSCODataVector& scodata_;
+    const scrubbing::ScrubbingSCODataVector& scodata_;
+    UsageCounts& usage_counts_;
 
     volumedriver::FilePool& filepool_;
+    ScrubMemoryBudget& budget_;
     volumedriver::ClusterAddress cluster_begin_;
 
     void
@@ -31,10 +31,10 @@ public:
                                 be::BackendInterfacePtr bi,
                                 const CombinedTLogReader::FetchStrategy strategy)
         : path_(make_dir_(path / yt::UUID().str()))
-        , treader_(CombinedTLogReader::create(path_,
-                                              relocs,
-                                              std::move(bi),
-                                              strategy))
+        , treader_(CombinedTLogReader::create<VerifyingMappedTLogReader>(path_,
+                                                                         relocs,
+                                                                         std::move(bi),
+                                                                         strategy))
     {}
 
     ~RelocationReaderFromTempDir()
@@ -18,6 +18,7 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <backend/BackendConfig.h>
 #include <backend/BackendInterface.h>
 #include <backend/BackendConnectionManager.h>
 
@@ -42,6 +43,7 @@ Restore::Restore(const fs::path& configuration_file,
                  const youtils::GracePeriod& grace_period)
     : configuration_file_(configuration_file)
     , scratch_dir_(vd::FileUtils::temp_path())
+    , copy_streams_(be::ObjectCopier::default_streams)
     , barf_on_busted_backup_(barf_on_busted_backup)
     , grace_period_(grace_period)
 {}
@@ -95,7 +97,14 @@ Restore::operator()()
                                                            RegisterComponent::F));
 
         be::BackendInterfacePtr source_bi(source_cm->newBackendInterface(backend::Namespace(source_ns)));
-        copy_(source_bi->clone(), target_bi->clone());
+        // Same backend: let it copy the objects itself.
+        const be::ServerSideCopy server_side(source_cm->config() == target_cm->config() ?
+                                             be::ServerSideCopy::T :
+                                             be::ServerSideCopy::F);
+
+        copy_(source_bi->clone(),
+              target_bi->clone(),
+              server_side);
 
         LOG_INFO("Retrieving volume config from source namespace " <<
                  source_bi->getNS());
@@ -150,12 +159,22 @@ Restore::init_(const bpt::ptree& pt)
 
     LOG_INFO("Using " << scratch_dir_ << " as scratch directory");
 
+    const boost::optional<size_t>
+        maybe_copy_streams(pt.get_optional<size_t>("copy_streams"));
+
+    if (maybe_copy_streams)
+    {
+        copy_streams_ = *maybe_copy_streams;
+    }
+
+    LOG_INFO("Using " << copy_streams_ << " streams to copy objects");
 
 }
 
 void
 Restore::copy_(be::BackendInterfacePtr source_bi,
-               be::BackendInterfacePtr target_bi)
+               be::BackendInterfacePtr target_bi,
+               const be::ServerSideCopy server_side)
 {
     LOG_INFO("Copying volume from " << source_bi->getNS() << " -> " <<
              target_bi->getNS());
@@ -171,23 +190,24 @@ Restore::copy_(be::BackendInterfacePtr source_bi,
     std::list<std::string> objects;
     source_bi->listObjects(objects);
 
-    // Y42 straight copy would save some disk IO's
     // -- Almost straight namespace - namespace copy
+    std::vector<std::string> names;
+    names.reserve(objects.size());
+
     for (const auto& object : objects)
     {
         if(object != vd::VolumeConfig::config_backend_name and
            object != "lock_name")
         {
-            const fs::path p(vd::FileUtils::create_temp_file_in_temp_dir(object));
-            ALWAYS_CLEANUP_FILE(p);
-            boost::this_thread::interruption_point();
-            source_bi->read(p,
-                            object,
-                            InsistOnLatestVersion::T);
-            target_bi->write(p,
-                             object);
+            names.emplace_back(object);
         }
     }
+
+    be::ObjectCopier copier(std::move(source_bi),
+                            std::move(target_bi),
+                            server_side,
+                            copy_streams_);
+    copier(names);
 }
 
 void
@@ -22,6 +22,8 @@
 #include <youtils/IOException.h>
 #include <youtils/Logging.h>
 
+#include <backend/ObjectCopier.h>
+
 #include <volumedriver/VolumeConfig.h>
 // Y42 probably needs to go
 #include <youtils/WithGlobalLock.h>
@@ -77,6 +79,7 @@ private:
 
     const fs::path configuration_file_;
     fs::path scratch_dir_;
+    size_t copy_streams_;
     const bool barf_on_busted_backup_;
     void
     init_(const bpt::ptree& pt);
@@ -91,7 +94,8 @@ private:
 
     void
     copy_(be::BackendInterfacePtr source_bi,
-          be::BackendInterfacePtr target_bi);
+          be::BackendInterfacePtr target_bi,
+          const be::ServerSideCopy);
 
     void
     collect_garbage_(be::BackendInterfacePtr bi,
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "CachePageCodec.h"
 #include "MetaDataBackendInterface.h"
 #include "RocksDBMetaDataBackend.h"
 #include "VolManager.h"
@@ -21,6 +22,7 @@
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/status.h>
+#include <rocksdb/write_batch.h>
 
 #include <youtils/RocksLogger.h>
 
@@ -149,6 +151,7 @@ RocksDBMetaDataBackend::RocksDBMetaDataBackend(const VolumeConfig& cfg,
     , delete_global_artefacts(DeleteGlobalArtefacts::F)
     , nspace_(cfg.ns_)
     , filename_(VolManager::get()->getMetaDataPath(nspace_) / db_name)
+    , encode_pages_(VolManager::get()->metadata_page_encoding.value())
 {
     fs::create_directories(VolManager::get()->getMetaDataPath(nspace_));
 
@@ -227,8 +230,9 @@ RocksDBMetaDataBackend::getPage(CachePage& p)
     {
     case rdb::Status::kOk:
         {
-            VERIFY(res.size() == CachePage::size());
-            memcpy(p.data(), res.data(), res.size());
+            CachePageCodec::decode(res.data(),
+                                   res.size(),
+                                   p);
             return true;
         }
     case rdb::Status::kNotFound:
@@ -258,17 +262,21 @@ RocksDBMetaDataBackend::putPage(const CachePage& p,
     const int64_t used_clusters = used_clusters_ + used_clusters_diff;
     ASSERT(used_clusters >= 0);
 
+    std::string val;
+    CachePageCodec::serialize(p, val, encode_pages_);
+
     HANDLE(db_->Put(make_write_options(),
                     rdb::Slice(reinterpret_cast<const char*>(&pa),
                                sizeof(pa)),
-                    rdb::Slice(reinterpret_cast<const char*>(p.data()),
-                               p.size())));
+                    rdb::Slice(val)));
 
     HANDLE(db_->Put(make_write_options(),
                     rdb::Slice(reinterpret_cast<const char*>(&used_clusters_key_),
                                sizeof(used_clusters_key_)),
                     rdb::Slice(reinterpret_cast<const char*>(&used_clusters),
                                sizeof(used_clusters))));
+
+    used_clusters_ = used_clusters;
 }
 
 void
@@ -294,6 +302,71 @@ RocksDBMetaDataBackend::discardPage(const CachePage& p,
                                sizeof(used_clusters_key_)),
                     rdb::Slice(reinterpret_cast<const char*>(&used_clusters),
                                sizeof(used_clusters))));
+
+    used_clusters_ = used_clusters;
+}
+
+void
+RocksDBMetaDataBackend::write_batch_(const PageUpdates& pages,
+                                     bool discard)
+{
+    LOG_TRACE(pages.size() << " pages, discard: " << discard);
+
+    if (pages.empty())
+    {
+        return;
+    }
+
+    int64_t used_clusters = used_clusters_;
+    rdb::WriteBatch batch;
+    std::string val;
+
+    for (const auto& u : pages)
+    {
+        const PageAddress& pa = u.page.page_address();
+        check_page_address_(pa);
+
+        const rdb::Slice key(reinterpret_cast<const char*>(&pa),
+                             sizeof(pa));
+        if (discard)
+        {
+            batch.Delete(key);
+        }
+        else
+        {
+            CachePageCodec::serialize(u.page, val, encode_pages_);
+            batch.Put(key,
+                      rdb::Slice(val));
+        }
+
+        used_clusters += u.used_clusters_delta;
+    }
+
+    ASSERT(used_clusters >= 0);
+
+    batch.Put(rdb::Slice(reinterpret_cast<const char*>(&used_clusters_key_),
+                         sizeof(used_clusters_key_)),
+              rdb::Slice(reinterpret_cast<const char*>(&used_clusters),
+                         sizeof(used_clusters)));
+
+    HANDLE(db_->Write(make_write_options(),
+                      &batch));
+
+    used_clusters_ = used_clusters;
+}
+
+void
+RocksDBMetaDataBackend::putPages(const PageUpdates& pages)
+{
+    write_batch_(pages,
+                 false);
+}
+
+void
+RocksDBMetaDataBackend::discardPages(const PageUpdates& pages)
+{
+    write_batch_(pages,
+                 true);
 }
 
 void
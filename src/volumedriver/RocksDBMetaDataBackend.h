@@ -52,12 +52,24 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    virtual void
+    putPages(const PageUpdates& pages) override final;
+
+    virtual void
+    discardPages(const PageUpdates& pages) override final;
+
     bool
     pageExistsInParent(const PageAddress) const override final
     {
         return false;
     }
 
+    bool
+    concurrent_reads() const override final
+    {
+        return true;
+    }
+
     void
     sync() override final;
 
@@ -146,6 +158,7 @@ private:
 
     const backend::Namespace nspace_;
     const fs::path filename_;
+    const bool encode_pages_;
 
     static void
     fatalLog_(const char* message)
@@ -158,6 +171,10 @@ private:
 
     static void
     check_page_address_(const PageAddress pa);
+
+    void
+    write_batch_(const PageUpdates&,
+                 bool discard);
 };
 
 }
@@ -14,11 +14,11 @@
 
 #include "ClusterLocation.h"
 #include "SCOPool.h"
-#include "TLogReader.h"
 #include "TLogWriter.h"
 
 #include <youtils/Assert.h>
 #include <youtils/Catchers.h>
+#include <youtils/System.h>
 
 namespace scrubbing
 {
@@ -28,9 +28,14 @@ using namespace volumedriver;
 namespace fs = boost::filesystem;
 namespace yt = youtils;
 
+uint32_t SCOPool::backend_concurrency =
+    yt::System::get_env_with_default<uint32_t>("SCRUBBER_BACKEND_CONCURRENCY",
+                                               4);
+
 SCOPool::SCOPool(ScrubbingSCODataVector& scos,
-                 const fs::path& metadatascrubbed_tlog,
+                 TLogReaderInterface& metadatascrubbed_entries,
                  FilePool& filepool,
+                 ScrubMemoryBudget& budget,
                  BackendInterface& backendinterface,
                  const ClusterExponent& cluster_exponent,
                  // SCOSIZE in number of clusters
@@ -41,6 +46,7 @@ SCOPool::SCOPool(ScrubbingSCODataVector& scos,
                  std::vector<SCO>& new_scos)
     : scodata_(scos)
     , filepool_(filepool)
+    , budget_(budget)
     , backendinterface_(backendinterface)
     , cluster_size_(1UL << cluster_exponent)
     , sco_size_(scosize)
@@ -48,12 +54,15 @@ SCOPool::SCOPool(ScrubbingSCODataVector& scos,
     , current_offset_(0)
     , current_sco_name_(0)
     , access_data_(access_data)
-    , metadatascrubbed_tlog_(metadatascrubbed_tlog)
+    , metadatascrubbed_entries_(metadatascrubbed_entries)
     , minimum_used_entries_(minimum_used_entries)
     , backend_size_(0)
     , new_scos_(new_scos)
     , number_of_scos_read_from_backend(0)
     , number_of_scos_written_to_backend(0)
+    , run_in_(nullptr)
+    , run_in_offset_(0)
+    , run_clusters_(0)
 {
     // Make sure the last SCO is not scrubbed away. This is needed to ensure that the failover
     // cache can be replayed without gaps in case or restart.
@@ -114,6 +123,9 @@ SCOPool::doEntry(const Entry& e)
 
         if(it == sconame_map_.end())
         {
+            // the run references the input SCO that is about to go away
+            flush_run_();
+
             // Here we do some caching???
             if(not sconame_map_.empty())
             {
@@ -131,9 +143,7 @@ SCOPool::doEntry(const Entry& e)
                                          " from the filepool");
             }
 
-            std::string sco_string = sco_name.str();
-            fs::path sco_path = filepool_.newFile(sco_string);
-            backendinterface_.read(sco_path, sco_string, InsistOnLatestVersion::F);
+            const fs::path sco_path(fetch_(sco_name));
             ++number_of_scos_read_from_backend;
             auto fd(std::make_unique<yt::FileDescriptor>(sco_path,
                                                          yt::FDMode::Read));
@@ -153,13 +163,19 @@ SCOPool::doEntry(const Entry& e)
         }
         // read, write and put in tlogs
 
-        uint64_t sco_offset = cluster_location.offset() * cluster_size_;
-        in_io->pread(buffer_.data(), cluster_size_, sco_offset);
         MaybeUpdateCurrentSCO();
         new_sco_access_data[current_sco_name_] += access_data_[sco_name];
 
-        current_sco_->write(buffer_.data(), cluster_size_);
-        checksum_.update(buffer_.data(), cluster_size_);
+        // the data is copied once the run ends
+        const uint64_t in_offset = cluster_location.offset();
+        if(run_in_ != in_io or
+           run_in_offset_ + run_clusters_ != in_offset)
+        {
+            flush_run_();
+            run_in_ = in_io;
+            run_in_offset_ = in_offset;
+        }
+        ++run_clusters_;
         // Entry new_entry(e->clusterAddress(),
         //                 ClusterLocation(current_sco_name_,
         //                (c                 current_offset_++));
@@ -168,8 +184,8 @@ SCOPool::doEntry(const Entry& e)
         ClusterLocationAndHash loc_and_hash(loc,
                                             e.clusterLocationAndHash().weed());
 
-        rewritten_tlog_writer->add(e.clusterAddress(),
-                                   loc_and_hash);
+        rewritten_entries_->add(e.clusterAddress(),
+                                loc_and_hash);
         relocations_tlog_writer->add(e.clusterAddress(),
                                      e.clusterLocationAndHash());
         relocations_tlog_writer->add(e.clusterAddress(),
@@ -178,8 +194,8 @@ SCOPool::doEntry(const Entry& e)
     }
     else if(scodata_iterator_->state == ScrubbingSCOData::State::NotScrubbed)
     {
-        nonrewritten_tlog_writer->add(e.clusterAddress(),
-                                      e.clusterLocationAndHash());
+        nonrewritten_entries_->add(e.clusterAddress(),
+                                   e.clusterLocationAndHash());
     }
     else
     {
@@ -191,31 +207,34 @@ SCOPool::doEntry(const Entry& e)
 std::pair<yt::CheckSum, uint64_t>
 SCOPool::operator()()
 {
-    nonrewritten_tlog_path_ = filepool_.newFile("nonrewritten_tlog");
-    nonrewritten_tlog_writer.reset(new TLogWriter(nonrewritten_tlog_path_));
-    rewritten_tlog_path_ = filepool_.newFile("rewritten_tlog");
-    rewritten_tlog_writer.reset(new TLogWriter(rewritten_tlog_path_));
+    nonrewritten_entries_ = std::make_unique<ScrubEntryBuffer>(budget_,
+                                                               filepool_,
+                                                               "nonrewritten_tlog");
+    rewritten_entries_ = std::make_unique<ScrubEntryBuffer>(budget_,
+                                                            filepool_,
+                                                            "rewritten_tlog");
     relocations_tlog_path_ = filepool_.newFile("relocations_tlog");
     relocations_tlog_writer.reset(new TLogWriter(relocations_tlog_path_));
 
-    TLogReader input_reader(metadatascrubbed_tlog_);
-
     scodata_iterator_ = scodata_.begin();
     to_be_reused_iterator_ = scodata_.begin();
+    prefetch_iterator_ = scodata_.begin();
 
     current_usage_count_ = 0;
 
     const Entry* e = nullptr;
 
-    while((e = input_reader.nextLocation()))
+    while((e = metadatascrubbed_entries_.nextLocation()))
     {
         doEntry(*e);
     }
     VERIFY(scodata_iterator_ == scodata_.end() or
            ++scodata_iterator_ == scodata_.end());
 
-    nonrewritten_tlog_writer.reset(0);
-    rewritten_tlog_writer.reset(0);
+    flush_run_();
+
+    nonrewritten_entries_->seal();
+    rewritten_entries_->seal();
     const yt::CheckSum ss(relocations_tlog_writer->getCheckSum());
     uint64_t relocationEntries = relocations_tlog_writer->getEntriesWritten() / 2;
 
@@ -235,18 +254,15 @@ SCOPool::operator()()
         fs::path new_sco_path = current_sco_->path();
         ++number_of_scos_written_to_backend;
 
-        // work around ALBA uploads timing out but eventually succeeding in the
-        // background, leading to overwrite on retry.
-        TODO("AR: use OverwriteObject::F instead");
-        VERIFY(not backendinterface_.objectExists(current_sco_name_.str()));
-        backendinterface_.write(new_sco_path,
-                                 current_sco_name_.str(),
-                                 OverwriteObject::T,
-                                 &checksum_);
+        upload_(new_sco_path,
+                current_sco_name_,
+                checksum_);
         new_scos_.push_back(current_sco_name_);
 
     }
 
+    wait_for_uploads_(0);
+
     current_sco_ == nullptr;
 
     return std::make_pair(ss,
@@ -321,6 +337,8 @@ SCOPool::MaybeUpdateCurrentSCO()
     // Do an or here??
     if (not current_sco_ or current_offset_ >= sco_size_)
     {
+        flush_run_();
+
         if (current_sco_)
         {
             const fs::path old_sco_path = current_sco_->path();
@@ -334,16 +352,10 @@ SCOPool::MaybeUpdateCurrentSCO()
             new_sco_access_data[current_sco_name_] /= sco_size_;
             ++number_of_scos_written_to_backend;
 
-            // work around ALBA uploads timing out but eventually succeeding in the
-            // background, leading to overwrite on retry.
-            TODO("AR: use OverwriteObject::F instead");
-            VERIFY(not backendinterface_.objectExists(current_sco_name_.str()));
-            backendinterface_.write(old_sco_path,
-                                    current_sco_name_.str(),
-                                    OverwriteObject::T,
-                                    &checksum_);
+            upload_(old_sco_path,
+                    current_sco_name_,
+                    checksum_);
             new_scos_.push_back(current_sco_name_);
-            fs::remove(filepool_.directory() / current_sco_name_.str());
         }
 
         current_offset_ = 0;
@@ -366,6 +378,162 @@ SCOPool::MaybeUpdateCurrentSCO()
     }
 }
 
+void
+SCOPool::flush_run_()
+{
+    if(run_clusters_ == 0)
+    {
+        return;
+    }
+
+    VERIFY(run_in_ != nullptr);
+    VERIFY(current_sco_ != nullptr);
+
+    const size_t len = run_clusters_ * cluster_size_;
+    if(buffer_.size() < len)
+    {
+        buffer_.resize(len);
+    }
+
+    run_in_->pread(buffer_.data(),
+                   len,
+                   run_in_offset_ * cluster_size_);
+    current_sco_->write(buffer_.data(),
+                        len);
+    checksum_.update(buffer_.data(),
+                     len);
+
+    run_in_ = nullptr;
+    run_clusters_ = 0;
+}
+
+// Fetches the SCOs that doEntry will ask for next - these are the ones that
+// will be found to be underused, in the order of the SCO data. The last SCO was
+// marked NotScrubbed upfront and is hence never fetched.
+void
+SCOPool::prefetch_()
+{
+    const size_t window = std::max<uint32_t>(1, backend_concurrency);
+
+    while(prefetched_.size() < window and
+          prefetch_iterator_ != scodata_.end())
+    {
+        const ScrubbingSCOData& data = *prefetch_iterator_++;
+
+        if(data.usageCount > 0 and
+           data.usageCount < minimum_used_entries_ and
+           data.state != ScrubbingSCOData::State::NotScrubbed)
+        {
+            const SCO sco(data.sconame_);
+            const fs::path path(filepool_.newFile(sco.str()));
+            BackendInterfacePtr bi(backendinterface_.clone());
+
+            prefetched_.emplace_back(sco,
+                                     std::async(std::launch::async,
+                                                [path, sco, bi = std::move(bi)]() -> fs::path
+                                                {
+                                                    bi->read(path,
+                                                             sco.str(),
+                                                             InsistOnLatestVersion::F);
+                                                    return path;
+                                                }));
+        }
+    }
+}
+
+fs::path
+SCOPool::fetch_(const SCO sco)
+{
+    prefetch_();
+
+    if(not prefetched_.empty() and
+       prefetched_.front().first == sco)
+    {
+        const fs::path path(prefetched_.front().second.get());
+        prefetched_.pop_front();
+
+        prefetch_();
+
+        return path;
+    }
+
+    // The prefetches got out of step with doEntry - throw them away, fetch this
+    // one directly and restart prefetching after it.
+    LOG_WARN("SCO " << sco << " was not prefetched, discarding " <<
+             prefetched_.size() << " prefetched SCOs");
+
+    discard_prefetched_();
+
+    const fs::path path(filepool_.newFile(sco.str()));
+    backendinterface_.read(path,
+                           sco.str(),
+                           InsistOnLatestVersion::F);
+
+    prefetch_iterator_ = std::next(scodata_iterator_);
+    prefetch_();
+
+    return path;
+}
+
+void
+SCOPool::discard_prefetched_()
+{
+    for(auto& p : prefetched_)
+    {
+        const fs::path path(filepool_.directory() / p.first.str());
+
+        try
+        {
+            p.second.get();
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to prefetch " << p.first);
+
+        try
+        {
+            fs::remove(path);
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to remove " << path <<
+                                 " from the filepool");
+    }
+
+    prefetched_.clear();
+}
+
+void
+SCOPool::upload_(const fs::path& path,
+                 const SCO sco,
+                 const yt::CheckSum& checksum)
+{
+    wait_for_uploads_(std::max<uint32_t>(1, backend_concurrency) - 1);
+
+    BackendInterfacePtr bi(backendinterface_.clone());
+
+    uploads_.emplace_back(std::async(std::launch::async,
+                                     [path, sco, checksum, bi = std::move(bi)]()
+                                     {
+                                         // work around ALBA uploads timing out but eventually succeeding in the
+                                         // background, leading to overwrite on retry.
+                                         TODO("AR: use OverwriteObject::F instead");
+                                         VERIFY(not bi->objectExists(sco.str()));
+                                         bi->write(path,
+                                                   sco.str(),
+                                                   OverwriteObject::T,
+                                                   &checksum);
+                                         fs::remove(path);
+                                     }));
+}
+
+void
+SCOPool::wait_for_uploads_(size_t max_pending)
+{
+    while(uploads_.size() > max_pending)
+    {
+        // rethrows upload errors
+        uploads_.front().get();
+        uploads_.pop_front();
+    }
+}
+
 }
 
 // Local Variables: **
@@ -19,8 +19,12 @@
 #include "FilePool.h"
 #include "NormalizedSCOAccessData.h"
 #include "ScrubbingTypes.h"
+#include "ScrubEntryBuffer.h"
 #include "TLogSplitter.h"
 
+#include <deque>
+#include <future>
+
 #include <youtils/FileDescriptor.h>
 #include <youtils/CheckSum.h>
 
@@ -33,8 +37,9 @@ class SCOPool
 {
 public:
     SCOPool(scrubbing::ScrubbingSCODataVector& scos_,
-            const boost::filesystem::path& metadatascrubbed_tlog,
+            volumedriver::TLogReaderInterface& metadatascrubbed_entries,
             volumedriver::FilePool& filepool,
+            ScrubMemoryBudget& budget,
             volumedriver::BackendInterface& backendinterface,
             const volumedriver::ClusterExponent& cluster_exponent,
             const uint64_t scosize,
@@ -49,16 +54,18 @@ public:
     std::pair<youtils::CheckSum, uint64_t>
     operator()();
 
-    const boost::filesystem::path&
-    nonrewritten_tlog_path() const
+    const ScrubEntryBuffer&
+    nonrewritten_entries() const
     {
-        return nonrewritten_tlog_path_;
+        VERIFY(nonrewritten_entries_);
+        return *nonrewritten_entries_;
     }
 
-    const boost::filesystem::path&
-    rewritten_tlog_path() const
+    const ScrubEntryBuffer&
+    rewritten_entries() const
     {
-        return rewritten_tlog_path_;
+        VERIFY(rewritten_entries_);
+        return *rewritten_entries_;
     }
 
     const boost::filesystem::path&
@@ -113,13 +120,16 @@ public:
         return number_of_scos_written_to_backend;
     }
 
+    // Maximum number of SCOs that are fetched from the backend ahead of their
+    // use, and of finished SCOs that are uploaded to the backend concurrently.
+    // Not const as ScrubberTest messes with it.
+    static uint32_t backend_concurrency;
+
  private:
     DECLARE_LOGGER("SCOPool");
 
-    boost::filesystem::path nonrewritten_tlog_path_;
-    std::unique_ptr<volumedriver::TLogWriter> nonrewritten_tlog_writer;
-    boost::filesystem::path rewritten_tlog_path_;
-    std::unique_ptr<volumedriver::TLogWriter> rewritten_tlog_writer;
+    std::unique_ptr<ScrubEntryBuffer> nonrewritten_entries_;
+    std::unique_ptr<ScrubEntryBuffer> rewritten_entries_;
     boost::filesystem::path relocations_tlog_path_;
     std::unique_ptr<volumedriver::TLogWriter> relocations_tlog_writer;
 
@@ -129,6 +139,7 @@ public:
 
     ScrubbingSCODataVector& scodata_;
     volumedriver::FilePool& filepool_;
+    ScrubMemoryBudget& budget_;
     volumedriver::BackendInterface& backendinterface_;
 
     using SCONameMap =
@@ -148,7 +159,7 @@ public:
 
     volumedriver::CheckSum checksum_;
 
-    const boost::filesystem::path metadatascrubbed_tlog_;
+    volumedriver::TLogReaderInterface& metadatascrubbed_entries_;
 
     const uint16_t minimum_used_entries_;
 
@@ -160,6 +171,20 @@ public:
     uint64_t number_of_scos_read_from_backend;
     uint64_t number_of_scos_written_to_backend;
 
+    // Contiguous clusters of the current input SCO that go to the current
+    // output SCO - they're copied in one go.
+    youtils::FileDescriptor* run_in_;
+    uint64_t run_in_offset_;
+    uint64_t run_clusters_;
+
+    // SCOs fetched ahead, in the order of the SCO data
+    using Prefetched = std::pair<volumedriver::SCO,
+                                 std::future<boost::filesystem::path>>;
+    std::deque<Prefetched> prefetched_;
+    ScrubbingSCODataVector::const_iterator prefetch_iterator_;
+
+    std::deque<std::future<void>> uploads_;
+
     void
     doEntry(const volumedriver::Entry& e);
 
@@ -168,6 +193,26 @@ public:
 
     void
     MaybeUpdateCurrentSCO();
+
+    void
+    flush_run_();
+
+    void
+    prefetch_();
+
+    boost::filesystem::path
+    fetch_(const volumedriver::SCO);
+
+    void
+    discard_prefetched_();
+
+    void
+    upload_(const boost::filesystem::path&,
+            const volumedriver::SCO,
+            const youtils::CheckSum&);
+
+    void
+    wait_for_uploads_(size_t max_pending);
 };
 
 }
@@ -0,0 +1,236 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "FilePool.h"
+#include "MappedTLogReader.h"
+#include "ScrubEntryBuffer.h"
+#include "TLogWriter.h"
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+
+namespace scrubbing
+{
+
+using namespace volumedriver;
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+typedef std::deque<Entry> Entries;
+
+class InMemoryReader
+    : public TLogReaderInterface
+{
+public:
+    InMemoryReader(const Entries& entries,
+                   MappedTLogReader::Direction dir)
+        : entries_(entries)
+        , dir_(dir)
+        , pos_(0)
+    {}
+
+    virtual ~InMemoryReader() = default;
+
+    const Entry*
+    nextAny() override final
+    {
+        if (pos_ == entries_.size())
+        {
+            return nullptr;
+        }
+        else if (dir_ == MappedTLogReader::Direction::Forward)
+        {
+            return &entries_[pos_++];
+        }
+        else
+        {
+            return &entries_[entries_.size() - ++pos_];
+        }
+    }
+
+private:
+    const Entries& entries_;
+    const MappedTLogReader::Direction dir_;
+    size_t pos_;
+};
+
+}
+
+bool
+ScrubMemoryBudget::try_reserve(uint64_t bytes)
+{
+    uint64_t used = used_.load();
+
+    do
+    {
+        if (used + bytes > limit_)
+        {
+            return false;
+        }
+    }
+    while (not used_.compare_exchange_weak(used,
+                                           used + bytes));
+
+    return true;
+}
+
+void
+ScrubMemoryBudget::release(uint64_t bytes)
+{
+    const uint64_t prev = used_.fetch_sub(bytes);
+    VERIFY(prev >= bytes);
+}
+
+ScrubEntryBuffer::ScrubEntryBuffer(ScrubMemoryBudget& budget,
+                                   FilePool& filepool,
+                                   const std::string& name)
+    : budget_(budget)
+    , filepool_(filepool)
+    , name_(name)
+    , reserved_(0)
+    , size_(0)
+    , sealed_(false)
+{}
+
+ScrubEntryBuffer::~ScrubEntryBuffer()
+{
+    release_();
+
+    writer_.reset();
+
+    if (not path_.empty())
+    {
+        try
+        {
+            fs::remove(path_);
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to remove " << path_);
+    }
+}
+
+void
+ScrubEntryBuffer::release_()
+{
+    Entries().swap(entries_);
+
+    if (reserved_ > 0)
+    {
+        budget_.release(reserved_);
+        reserved_ = 0;
+    }
+}
+
+void
+ScrubEntryBuffer::spill_()
+{
+    VERIFY(not writer_);
+
+    LOG_INFO(name_ << ": memory budget of " << budget_.limit() <<
+             " bytes exhausted, moving " << entries_.size() <<
+             " entries to the FilePool");
+
+    path_ = filepool_.newFile(name_);
+    writer_ = std::make_unique<TLogWriter>(path_);
+
+    for (const auto& e : entries_)
+    {
+        writer_->add(e.clusterAddress(),
+                     e.clusterLocationAndHash());
+    }
+
+    release_();
+}
+
+void
+ScrubEntryBuffer::add(ClusterAddress ca,
+                      const ClusterLocationAndHash& loc)
+{
+    VERIFY(not sealed_);
+
+    if (not writer_ and
+        entries_.size() * sizeof(Entry) == reserved_)
+    {
+        const uint64_t chunk = chunk_entries * sizeof(Entry);
+        if (budget_.try_reserve(chunk))
+        {
+            reserved_ += chunk;
+        }
+        else
+        {
+            spill_();
+        }
+    }
+
+    if (writer_)
+    {
+        writer_->add(ca,
+                     loc);
+    }
+    else
+    {
+        entries_.emplace_back(ca,
+                              loc);
+    }
+
+    ++size_;
+}
+
+void
+ScrubEntryBuffer::seal()
+{
+    // closing the writer flushes it
+    writer_.reset();
+    sealed_ = true;
+}
+
+std::unique_ptr<TLogReaderInterface>
+ScrubEntryBuffer::reader() const
+{
+    VERIFY(sealed_);
+
+    if (spilled())
+    {
+        return std::make_unique<MappedTLogReader>(path_);
+    }
+    else
+    {
+        return std::make_unique<InMemoryReader>(entries_,
+                                                MappedTLogReader::Direction::Forward);
+    }
+}
+
+std::unique_ptr<TLogReaderInterface>
+ScrubEntryBuffer::backward_reader() const
+{
+    VERIFY(sealed_);
+
+    if (spilled())
+    {
+        return std::make_unique<BackwardMappedTLogReader>(path_);
+    }
+    else
+    {
+        return std::make_unique<InMemoryReader>(entries_,
+                                                MappedTLogReader::Direction::Backward);
+    }
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,160 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SCRUB_ENTRY_BUFFER_H_
+#define SCRUB_ENTRY_BUFFER_H_
+
+#include "ClusterLocationAndHash.h"
+#include "Entry.h"
+#include "TLogReaderInterface.h"
+#include "Types.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+class FilePool;
+class TLogWriter;
+}
+
+namespace scrubbing
+{
+
+// Memory the scrubber's intermediate ScrubEntryBuffers can use in total. Shared
+// by the buffers of concurrently running stages, hence the atomic.
+class ScrubMemoryBudget
+{
+public:
+    explicit ScrubMemoryBudget(uint64_t limit)
+        : limit_(limit)
+        , used_(0)
+    {}
+
+    ~ScrubMemoryBudget() = default;
+
+    ScrubMemoryBudget(const ScrubMemoryBudget&) = delete;
+
+    ScrubMemoryBudget&
+    operator=(const ScrubMemoryBudget&) = delete;
+
+    bool
+    try_reserve(uint64_t bytes);
+
+    void
+    release(uint64_t bytes);
+
+    uint64_t
+    limit() const
+    {
+        return limit_;
+    }
+
+    uint64_t
+    used() const
+    {
+        return used_;
+    }
+
+private:
+    DECLARE_LOGGER("ScrubMemoryBudget");
+
+    const uint64_t limit_;
+    std::atomic<uint64_t> used_;
+};
+
+// Location entries handed from one scrubbing stage to the next. They're kept
+// in memory as long as the ScrubMemoryBudget permits - once that is exhausted
+// the buffer moves its entries to a TLog in the FilePool and appends to that
+// from there on. Readers can only be obtained once the buffer is sealed and
+// must not outlive it.
+class ScrubEntryBuffer
+{
+public:
+    ScrubEntryBuffer(ScrubMemoryBudget&,
+                     volumedriver::FilePool&,
+                     const std::string& name);
+
+    ~ScrubEntryBuffer();
+
+    ScrubEntryBuffer(const ScrubEntryBuffer&) = delete;
+
+    ScrubEntryBuffer&
+    operator=(const ScrubEntryBuffer&) = delete;
+
+    void
+    add(volumedriver::ClusterAddress,
+        const volumedriver::ClusterLocationAndHash&);
+
+    // no more entries can be added afterwards
+    void
+    seal();
+
+    std::unique_ptr<volumedriver::TLogReaderInterface>
+    reader() const;
+
+    std::unique_ptr<volumedriver::TLogReaderInterface>
+    backward_reader() const;
+
+    uint64_t
+    size() const
+    {
+        return size_;
+    }
+
+    bool
+    spilled() const
+    {
+        return not path_.empty();
+    }
+
+    // memory is reserved from the budget in chunks of this many entries
+    static const size_t chunk_entries = 4096;
+
+private:
+    DECLARE_LOGGER("ScrubEntryBuffer");
+
+    ScrubMemoryBudget& budget_;
+    volumedriver::FilePool& filepool_;
+    const std::string name_;
+
+    std::deque<volumedriver::Entry> entries_;
+    uint64_t reserved_;
+
+    boost::filesystem::path path_;
+    std::unique_ptr<volumedriver::TLogWriter> writer_;
+
+    uint64_t size_;
+    bool sealed_;
+
+    void
+    spill_();
+
+    void
+    release_();
+};
+
+}
+
+#endif // !SCRUB_ENTRY_BUFFER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
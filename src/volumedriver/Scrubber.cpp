@@ -24,10 +24,17 @@
 #include "TLogMerger.h"
 #include "TLogSplitter.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <youtils/Assert.h>
+#include <youtils/ScopeExit.h>
+#include <youtils/System.h>
 #include <youtils/wall_timer.h>
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/thread.hpp>
 
 #include <backend/BackendInterface.h>
 #include <backend/BackendConnectionManager.h>
@@ -40,6 +47,15 @@ using namespace volumedriver;
 const char
 Scrubber::scrub_result_string[] = "scrubbing_result";
 
+uint64_t Scrubber::memory_budget =
+    youtils::System::get_env_with_default<uint64_t>("SCRUBBER_MEMORY_BUDGET",
+                                                    1ULL << 30);
+
+uint32_t Scrubber::region_threads =
+    youtils::System::get_env_with_default<uint32_t>("SCRUBBER_REGION_THREADS",
+                                                    std::max(1U,
+                                                             std::thread::hardware_concurrency()));
+
 ScrubberException::ScrubberException(const std::string& what,
                                      const ExitCode exit_code,
                                      const std::string& result)
@@ -141,17 +157,22 @@ Scrubber::operator()()
     VERIFY(not result_.tlog_names_in.empty());
 
     std::shared_ptr<TLogReaderInterface>
-        combined_tlog_reader(CombinedTLogReader::create(filepool.directory(),
-                                                        result_.tlog_names_in,
-                                                        backend_interface_->clone()));
+        combined_tlog_reader(CombinedTLogReader::create<VerifyingMappedTLogReader>(filepool.directory(),
+                                                                                   result_.tlog_names_in,
+                                                                                   backend_interface_->clone()));
     // Split the TLogs in parts and go through them
     LOG_INFO("Starting the TLog Splitter");
     scrubbing::ScrubbingSCODataVector scrubbing_data_vector;
 
+    // The intermediate entries are handed from one stage to the next in memory
+    // as far as the budget permits, the rest goes to the FilePool.
+    ScrubMemoryBudget budget(memory_budget);
+
     TLogSplitter tlog_splitter(combined_tlog_reader,
                                scrubbing_data_vector,
                                static_cast<RegionExponent>(args_.region_size_exponent),
-                               filepool);
+                               filepool,
+                               budget);
     boost::this_thread::interruption_point();
     tlog_splitter();
     boost::this_thread::interruption_point();
@@ -162,25 +183,109 @@ Scrubber::operator()()
         LOG_INFO("SCO information after the splitting\n" << scrubbing_data_vector);
     }
 
-    const TLogSplitter::MapType& split_tlog_map = tlog_splitter.getMap();
+    TLogSplitter::MapType& split_tlog_map = tlog_splitter.getMap();
 
     LOG_INFO("Metadata scrubbing the region tlogs");
 
-    std::vector<fs::path> tlogs;
+    // The regions are disjoint, so their PartScrubbers only share the SCO data
+    // whose usage counts are accumulated per worker and merged afterwards.
+    std::vector<TLogSplitter::MapType::iterator> regions;
+    regions.reserve(split_tlog_map.size());
 
-    for(TLogSplitter::MapType::const_iterator it = split_tlog_map.begin();
+    for(TLogSplitter::MapType::iterator it = split_tlog_map.begin();
         it != split_tlog_map.end();
         ++it)
     {
-        LOG_INFO("Handling tlog for region " << it->first);
-        PartScrubber part_scrubber(it,
-                                   scrubbing_data_vector,
-                                   filepool,
-                                   args_.region_size_exponent,
-                                   args_.cluster_size_exponent);
-        boost::this_thread::interruption_point();
-        part_scrubber(tlogs);
-        boost::this_thread::interruption_point();
+        regions.push_back(it);
+    }
+
+    // indexed like regions to keep the merge order independent of the scheduling
+    std::vector<std::unique_ptr<ScrubEntryBuffer>> tlogs(regions.size());
+
+    const size_t nworkers = std::max<size_t>(1,
+                                             std::min<size_t>(region_threads,
+                                                              regions.size()));
+
+    std::vector<PartScrubber::UsageCounts>
+        usage_counts(nworkers,
+                     PartScrubber::UsageCounts(scrubbing_data_vector.size(), 0));
+
+    std::atomic<size_t> next_region(0);
+    std::mutex error_lock;
+    std::exception_ptr error;
+
+    auto work([&](const size_t worker)
+              {
+                  try
+                  {
+                      while (true)
+                      {
+                          boost::this_thread::interruption_point();
+
+                          const size_t i = next_region++;
+                          if (i >= regions.size())
+                          {
+                              break;
+                          }
+
+                          LOG_INFO("Handling tlog for region " << regions[i]->first);
+                          PartScrubber part_scrubber(regions[i],
+                                                     scrubbing_data_vector,
+                                                     usage_counts[worker],
+                                                     filepool,
+                                                     budget,
+                                                     args_.region_size_exponent,
+                                                     args_.cluster_size_exponent);
+                          tlogs[i] = part_scrubber();
+                      }
+                  }
+                  catch (...)
+                  {
+                      std::lock_guard<std::mutex> g(error_lock);
+                      if (not error)
+                      {
+                          error = std::current_exception();
+                      }
+                      // make the other workers stop after their current region
+                      next_region = regions.size();
+                  }
+              });
+
+    {
+        boost::thread_group workers;
+
+        auto on_exit(youtils::make_scope_exit([&]
+                                              {
+                                                  boost::this_thread::disable_interruption di;
+                                                  workers.interrupt_all();
+                                                  workers.join_all();
+                                              }));
+
+        for (size_t w = 1; w < nworkers; ++w)
+        {
+            workers.create_thread([&work, w]
+                                  {
+                                      work(w);
+                                  });
+        }
+
+        work(0);
+        workers.join_all();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    for (const auto& counts : usage_counts)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            ScrubbingSCOData& scodata = scrubbing_data_vector[i];
+            scodata.usageCount += counts[i];
+            VERIFY(scodata.size >= scodata.usageCount);
+        }
     }
 
     LOG_INFO("Stopped the region metadatascrubs");
@@ -189,36 +294,30 @@ Scrubber::operator()()
         LOG_INFO("SCO information after the metadatascrub\n" << scrubbing_data_vector);
     }
 
-    // At this point tlogs contains backwards ordered tlogs with the metadatascrubbed scos.
-    // We merge them into one forward tlog...
+    // At this point tlogs contains backwards ordered entries with the metadatascrubbed scos.
+    // We merge them into one forward stream that is fed to the SCOPool...
 
     LOG_INFO("Merging the metadatascrubbed tlogs");
 
-    BackwardTLogMerger backward_merger;
-    for(std::vector<fs::path>::const_iterator i = tlogs.begin();
-        i != tlogs.end();
-        ++i)
+    uint64_t metadata_scrubbed_entries = 0;
+    ScrubEntryMerger backward_merger;
+
+    for (const auto& t : tlogs)
     {
-        backward_merger.addTLogReader(new BackwardTLogReader(*i));
+        metadata_scrubbed_entries += t->size();
+        backward_merger.addTLogReader(t->backward_reader().release());
     }
 
-    const fs::path metadata_scrubbed = filepool.newFile("metadatascrubbed_tlog");
+    // The merged stream ends with the last entry of the last SCO - that one
+    // cannot have been overwritten, hence it's also the last in the SCO data.
     ClusterLocation last;
-    boost::this_thread::interruption_point();
-    backward_merger(metadata_scrubbed,
-                    &last);
-    boost::this_thread::interruption_point();
-#ifndef NDEBUG
-    uint64_t size = 0;
-
-    for(std::vector<fs::path>::const_iterator i = tlogs.begin();
-        i != tlogs.end();
-        ++i)
+    if (not scrubbing_data_vector.empty())
     {
-        size += fs::file_size(*i);
+        VERIFY(scrubbing_data_vector.back().usageCount > 0);
+        last = ClusterLocation(scrubbing_data_vector.back().sconame_,
+                               0);
     }
-    VERIFY(size == fs::file_size(metadata_scrubbed));
-#endif
+
     double metadata_scrubbed_time = metadatascrubtime.elapsed();
 
     youtils::wall_timer datascrubtime;
@@ -227,8 +326,9 @@ Scrubber::operator()()
     LOG_INFO("Starting the DataScrub");
 
     SCOPool scopool(scrubbing_data_vector,
-                    metadata_scrubbed,
+                    backward_merger,
                     filepool,
+                    budget,
                     *backend_interface_,
                     args_.cluster_size_exponent,
                     args_.sco_size,
@@ -237,7 +337,14 @@ Scrubber::operator()()
                     last.sco(),
                     result_.new_sconames);
 
+    boost::this_thread::interruption_point();
     std::pair<volumedriver::CheckSum, uint64_t> sp_result = scopool();
+    boost::this_thread::interruption_point();
+
+    VERIFY(scopool.get_backend_size() ==
+           metadata_scrubbed_entries * (1ULL << args_.cluster_size_exponent));
+
+    tlogs.clear();
 
     // variable 'ss0' set but not used [-Werror=unused-but-set-variable]
     // CheckSum ss0 = sp_result.first;
@@ -253,27 +360,14 @@ Scrubber::operator()()
 
     double data_scrub_time = datascrubtime.elapsed();
 
-    LOG_INFO("Starting the forward merging of tlogs");
-
-    ForwardTLogMerger forward_merger;
-    forward_merger.addTLogReader(new TLogReader(scopool.rewritten_tlog_path()));
-    forward_merger.addTLogReader(new TLogReader(scopool.nonrewritten_tlog_path()));
-    const fs::path result_tlog(filepool.newFile("completely_scrubbed_tlog"));
-
-    // variable 'cs1' set but not used [-Werror=unused-but-set-variable]
-    // CheckSum cs1 = forward_merger(result_tlog);
-    boost::this_thread::interruption_point();
-    forward_merger(result_tlog);
-    boost::this_thread::interruption_point();
-
-    LOG_INFO("Finished the forward merging of tlogs");
-
-    LOG_INFO("Starting cutting up the tlog in digestible chuncks");
+    LOG_INFO("Starting the forward merging of tlogs and cutting them up in digestible chunks");
 
-    // Now we cut up the tlog into pieces again
+    ScrubEntryMerger forward_merger;
+    forward_merger.addTLogReader(scopool.rewritten_entries().reader().release());
+    forward_merger.addTLogReader(scopool.nonrewritten_entries().reader().release());
 
     TLogCutter t(*backend_interface_,
-                 result_tlog,
+                 forward_merger,
                  filepool,
                  ClusterSize(1U << args_.cluster_size_exponent));
 
@@ -283,7 +377,7 @@ Scrubber::operator()()
 
     VERIFY(not result_.tlogs_out.empty());
 
-    LOG_INFO("Finished cutting up the tlog in digestible chunks");
+    LOG_INFO("Finished merging and cutting up the tlogs in digestible chunks");
 
     if(fs::file_size(scopool.relocations_tlog_path()) > 0)
     {
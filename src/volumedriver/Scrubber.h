@@ -160,6 +160,14 @@ public:
         return scrubbing_result_name;
     }
 
+    // Number of threads used to metadata scrub the regions - not const as
+    // ScrubberTest messes with it.
+    static uint32_t region_threads;
+
+    // Bytes the intermediate scrubbing stages can keep in memory before they
+    // resort to temporary TLogs.
+    static uint64_t memory_budget;
+
 private:
     DECLARE_LOGGER("Scrubber");
 
@@ -275,6 +275,21 @@ SetupHelper::setup_volmanager_parameters(const boost::property_tree::ptree& ptre
         the_dtl_write_trigger.persist(config_ptree_,
                                       ReportDefault::T);
     }
+    {
+        PARAMETER_TYPE(dtl_batches_in_flight) the_dtl_batches_in_flight(ptree);
+        the_dtl_batches_in_flight.persist(config_ptree_,
+                                          ReportDefault::T);
+    }
+    {
+        PARAMETER_TYPE(dtl_shmem_size) the_dtl_shmem_size(ptree);
+        the_dtl_shmem_size.persist(config_ptree_,
+                                   ReportDefault::T);
+    }
+    {
+        PARAMETER_TYPE(dtl_compression) the_dtl_compression(ptree);
+        the_dtl_compression.persist(config_ptree_,
+                                    ReportDefault::T);
+    }
 
     {
         PARAMETER_TYPE(freespace_check_interval) the_freespace_check_interval(ptree);
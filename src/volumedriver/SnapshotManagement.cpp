@@ -114,7 +114,9 @@ SnapshotManagement::SnapshotManagement(const VolumeConfig& cfg,
         fs::create_directories(tlogPath_);
 
         LOCKSNAP;
-        sp->saveToFile(snapshots_file_path_(), SyncAndRename::T);
+        sp->saveToFile(snapshots_file_path_(),
+                       SyncAndRename::T,
+                       binary_journal_());
         currentTLogId_ = sp->getCurrentTLog();
     }
 }
@@ -211,6 +213,14 @@ SnapshotManagement::snapshots_file_path_() const
     return snapshots_file_path(snapshotPath_);
 }
 
+BinaryJournal
+SnapshotManagement::binary_journal_() const
+{
+    return VolManager::get()->snapshots_binary_journal.value() ?
+        BinaryJournal::T :
+        BinaryJournal::F;
+}
+
 bool
 SnapshotManagement::lastSnapshotOnBackend() const
 {
@@ -239,7 +249,9 @@ SnapshotManagement::setAsTemplate(const MaybeCheckSum& maybe_sco_crc)
     {
         LOCKSNAP;
         sp->deleteAllButLastSnapshot();
-        sp->saveToFile(snapshots_file_path_(), SyncAndRename::T);
+        sp->saveToFile(snapshots_file_path_(),
+                       SyncAndRename::T,
+                       binary_journal_());
     }
     scheduleWriteSnapshotToBackend();
 }
@@ -285,7 +297,8 @@ SnapshotManagement::createSnapshot(const SnapshotName& name,
                 openTLog_();
             }
             sp->saveToFile(snapshots_file_path_(),
-                           SyncAndRename::T);
+                           SyncAndRename::T,
+                           binary_journal_());
             // num = sp->getSnapshotNum(name);
             sp->getSnapshotNum(name);
         }
@@ -370,7 +383,8 @@ SnapshotManagement::scheduleBackendSync(const MaybeCheckSum& maybe_sco_crc)
                                   boost::lexical_cast<std::string>(currentTLogId_).c_str());
 
                        sp->saveToFile(snapshots_file_path_(),
-                                      SyncAndRename::T);
+                                      SyncAndRename::T,
+                                      binary_journal_());
 
                        scheduleWriteTLogToBackend(tlog_id,
                                                   tlogpath,
@@ -434,7 +448,9 @@ SnapshotManagement::eraseSnapshotsAndTLogsAfterSnapshot(SnapshotNum num)
             openTLog_();
         }
 
-        sp->saveToFile(snapshots_file_path_(), SyncAndRename::T);
+        sp->saveToFile(snapshots_file_path_(),
+                       SyncAndRename::T,
+                       binary_journal_());
     }
 
     const std::vector<fs::path> paths(tlogPathPrepender(tlog_ids));
@@ -456,7 +472,9 @@ SnapshotManagement::deleteSnapshot(const SnapshotName& name)
     {
         LOCKSNAP;
         sp->deleteSnapshot(sp->getSnapshotNum(name));
-        sp->saveToFile(snapshots_file_path_(), SyncAndRename::T);
+        sp->saveToFile(snapshots_file_path_(),
+                       SyncAndRename::T,
+                       binary_journal_());
     }
     scheduleWriteSnapshotToBackend();
 }
@@ -714,7 +732,8 @@ SnapshotManagement::maybe_switch_tlog_()
                                    tlog_crc);
 
         sp->saveToFile(snapshots_file_path_(),
-                       SyncAndRename::T);
+                       SyncAndRename::T,
+                       binary_journal_());
     }
 }
 
@@ -797,7 +816,8 @@ SnapshotManagement::tlogWrittenToBackendCallback(const TLogId& tlog_id,
         }
 
         tmp->saveToFile(snapshots_file_path_(),
-                        SyncAndRename::T);
+                        SyncAndRename::T,
+                        binary_journal_());
     }
     CATCH_STD_ALL_VLOG_HALT_RETHROW("problem setting TLog " << tlog_id <<
                                     " written to backend");
@@ -864,6 +884,35 @@ SnapshotManagement::getTLogsAfterSnapshot(SnapshotNum num) const
     return tlog_ids;
 }
 
+OrderedTLogIds
+SnapshotManagement::getTLogsBetweenSnapshots(const boost::optional<SnapshotName>& start_snap,
+                                             const SnapshotName& end_snap) const
+{
+    OrderedTLogIds tlog_ids;
+
+    LOCKSNAP;
+    const SnapshotNum end_num = sp->getSnapshotNum(end_snap);
+
+    if (start_snap and *start_snap == end_snap)
+    {
+        // nothing changed (cf. Backup)
+        return tlog_ids;
+    }
+    else if (start_snap)
+    {
+        sp->getTLogsBetweenSnapshots(sp->getSnapshotNum(*start_snap),
+                                     end_num,
+                                     tlog_ids);
+    }
+    else
+    {
+        sp->getTLogsTillSnapshot(end_num,
+                                 tlog_ids);
+    }
+
+    return tlog_ids;
+}
+
 bool
 SnapshotManagement::snapshotExists(SnapshotNum num) const
 {
@@ -908,7 +957,8 @@ SnapshotManagement::new_scrub_id()
         LOCKSNAP;
         scrub_id = std::move(sp->new_scrub_id());
         sp->saveToFile(snapshots_file_path_(),
-                       SyncAndRename::T);
+                       SyncAndRename::T,
+                       binary_journal_());
     }
 
     scheduleWriteSnapshotToBackend();
@@ -930,7 +980,8 @@ SnapshotManagement::replaceTLogsWithScrubbedOnes(const OrderedTLogIds &in,
         sp->setSnapshotScrubbed(num,
                                 true);
         sp->saveToFile(snapshots_file_path_(),
-                       SyncAndRename::T);
+                       SyncAndRename::T,
+                       binary_journal_());
     }
 
     scheduleWriteSnapshotToBackend();
@@ -241,6 +241,12 @@ public:
     OrderedTLogIds
     getTLogsAfterSnapshot(SnapshotNum) const;
 
+    // TLogs making up the changes from start_snap (or the volume's creation if
+    // none is given) up to and including end_snap - none if they're the same.
+    OrderedTLogIds
+    getTLogsBetweenSnapshots(const boost::optional<SnapshotName>& start_snap,
+                             const SnapshotName& end_snap) const;
+
     // Don't use this. You probably want to enrich the snapshotmanagement api
     const SnapshotPersistor&
     getSnapshotPersistor() const
@@ -320,6 +326,11 @@ private:
     boost::filesystem::path
     snapshots_file_path_() const;
 
+    // Format of the local snapshots file (cf. snapshots_binary_journal); what's
+    // written to the backend is always XML.
+    BinaryJournal
+    binary_journal_() const;
+
     // To be called by Volume on local restart
     void
     scheduleTLogsToBeWrittenToBackend();
@@ -16,6 +16,7 @@
 #include "TracePoints_tp.h"
 #include "VolumeDriverError.h"
 
+#include <array>
 #include <cerrno>
 #include <iomanip>
 #include <iostream>
@@ -25,21 +26,95 @@
 
 #include <boost/filesystem/fstream.hpp>
 #include <boost/archive/archive_exception.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/serialization/optional.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/CheckSum.h>
+#include <youtils/FileDescriptor.h>
 #include <youtils/ScopeExit.h>
+#include <youtils/System.h>
 
 namespace volumedriver
 {
 
+namespace ba = boost::archive;
+namespace bio = boost::iostreams;
 namespace yt = youtils;
 namespace be = backend;
 
 const char* SnapshotPersistor::nvp_name = "snapshots";
 
+uint32_t SnapshotPersistor::max_journal_records =
+    yt::System::get_env_with_default<uint32_t>("SNAPSHOTS_MAX_JOURNAL_RECORDS",
+                                               64);
+
+namespace
+{
+
+// Binary snapshots file layout:
+// * BinaryHeader
+// * base: parent, snapshots and use_hash as a binary archive
+// * journal: a sequence of records (RecordHeader + binary archive payload), each
+//   one replacing the TLogs of current from a given index on and carrying the
+//   scrub id. The first one is written along with the base.
+// saveToFile only appends a record if the file's base matches the in-memory
+// state (cf. SnapshotPersistor::generation_), and only with the TLogs that
+// differ from the ones in the file. A torn record at the end is ignored.
+const char binary_magic[8] = { 'V', 'D', 'S', 'N', 'A', 'P', 'S', '\n' };
+const uint32_t binary_version = 1;
+
+struct BinaryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t base_crc;
+    uint64_t base_size;
+    char generation[36];
+    uint32_t pad;
+};
+
+static_assert(sizeof(BinaryHeader) == 64,
+              "unexpected BinaryHeader size");
+
+struct RecordHeader
+{
+    uint32_t size;
+    uint32_t crc;
+};
+
+static_assert(sizeof(RecordHeader) == 8,
+              "unexpected RecordHeader size");
+
+uint32_t
+crc32c(const char* buf,
+       size_t size)
+{
+    yt::CheckSum cs;
+    cs.update(buf,
+              size);
+    return cs.getValue();
+}
+
+// Saving to a file is not necessarily serialized by the owner (cf.
+// SnapshotManagement::tlogWrittenToBackendCallback) but appending requires it.
+boost::mutex&
+path_lock(const fs::path& p)
+{
+    static std::array<boost::mutex, 61> locks;
+    return locks[std::hash<std::string>()(p.string()) % locks.size()];
+}
+
+}
+
 SnapshotPersistor::SnapshotPersistor(const MaybeParentConfig& p)
     : parent_(p)
 {
@@ -54,10 +129,9 @@ SnapshotPersistor::SnapshotPersistor(const fs::path& path)
     {
         try
         {
-            fs::ifstream ifs(path);
-            boost::archive::xml_iarchive ia(ifs);
-            ia >> boost::serialization::make_nvp(nvp_name,
-                                                 *this);
+            fs::ifstream ifs(path,
+                             std::ios::in | std::ios::binary);
+            load_(ifs);
         }
         CATCH_STD_ALL_EWHAT({
                 VolumeDriverError::report(events::VolumeDriverErrorCode::ReadSnapshots,
@@ -89,8 +163,7 @@ SnapshotPersistor::SnapshotPersistor(std::istream& istr)
 
     try
     {
-        boost::archive::xml_iarchive ia(istr);
-        ia >> boost::serialization::make_nvp(nvp_name, *this);
+        load_(istr);
     }
     catch(std::exception& e)
     {
@@ -107,10 +180,184 @@ SnapshotPersistor::SnapshotPersistor(std::istream& istr)
 SnapshotPersistor::SnapshotPersistor(BackendInterfacePtr& bi)
 {
     LOG_TRACE("filling from backend namespace " << bi->getNS());
-    bi->fillObject(*this,
-                   snapshotFilename(),
-                   nvp_name,
-                   InsistOnLatestVersion::T);
+
+    try
+    {
+        const fs::path
+            p(FileUtils::create_temp_file_in_temp_dir(bi->getNS().str() +
+                                                      "-" +
+                                                      snapshotFilename()));
+        ALWAYS_CLEANUP_FILE(p);
+
+        bi->read(p,
+                 snapshotFilename(),
+                 InsistOnLatestVersion::T);
+
+        fs::ifstream ifs(p,
+                         std::ios::in | std::ios::binary);
+        load_(ifs);
+    }
+    CATCH_STD_ALL_LOG_RETHROW("Problem getting " << snapshotFilename() <<
+                              " from " << bi->getNS());
+}
+
+void
+SnapshotPersistor::load_(std::istream& is)
+{
+    if (is.peek() == binary_magic[0])
+    {
+        const std::string buf((std::istreambuf_iterator<char>(is)),
+                              std::istreambuf_iterator<char>());
+        load_binary_(buf);
+    }
+    else
+    {
+        ba::xml_iarchive ia(is);
+        ia >> boost::serialization::make_nvp(nvp_name,
+                                             *this);
+    }
+}
+
+void
+SnapshotPersistor::load_binary_(const std::string& buf)
+{
+    BinaryHeader h;
+
+    if (buf.size() < sizeof(h))
+    {
+        LOG_ERROR("Binary snapshots file too short: " << buf.size() << " bytes");
+        throw SnapshotPersistorException("Binary snapshots file too short");
+    }
+
+    memcpy(&h,
+           buf.data(),
+           sizeof(h));
+
+    if (memcmp(h.magic,
+               binary_magic,
+               sizeof(binary_magic)) != 0)
+    {
+        LOG_ERROR("Not a binary snapshots file");
+        throw SnapshotPersistorException("Not a binary snapshots file");
+    }
+
+    if (h.version != binary_version)
+    {
+        LOG_ERROR("Unsupported binary snapshots file version " << h.version <<
+                  ", expected " << binary_version);
+        throw SnapshotPersistorException("Unsupported binary snapshots file version");
+    }
+
+    if (buf.size() - sizeof(h) < h.base_size)
+    {
+        LOG_ERROR("Binary snapshots file truncated: " << buf.size() <<
+                  " bytes, base size " << h.base_size);
+        throw SnapshotPersistorException("Binary snapshots file truncated");
+    }
+
+    const char* base = buf.data() + sizeof(h);
+
+    if (crc32c(base, h.base_size) != h.base_crc)
+    {
+        LOG_ERROR("Checksum mismatch in binary snapshots file");
+        throw SnapshotPersistorException("Checksum mismatch in binary snapshots file");
+    }
+
+    {
+        bio::stream<bio::array_source> is(base,
+                                          h.base_size);
+        ba::binary_iarchive ia(is);
+
+        bool use_hash = true;
+        ia >> parent_;
+        ia >> snapshots;
+        ia >> use_hash;
+
+        VERIFY(ClusterLocationAndHash::use_hash() == use_hash);
+    }
+
+    generation_ = yt::UUID(std::string(h.generation,
+                                       sizeof(h.generation)));
+
+    const size_t off = sizeof(h) + h.base_size;
+    size_t nrecords = 0;
+
+    current.clear();
+
+    const size_t valid = replay_journal_(buf.data() + off,
+                                         buf.size() - off,
+                                         current,
+                                         scrub_id_,
+                                         nrecords);
+    if (nrecords == 0)
+    {
+        LOG_ERROR("No valid journal record in binary snapshots file");
+        throw SnapshotPersistorException("No valid journal record in binary snapshots file");
+    }
+
+    if (off + valid != buf.size())
+    {
+        LOG_WARN("Ignoring " << (buf.size() - off - valid) <<
+                 " bytes of torn journal records");
+    }
+
+    verifySanity_();
+}
+
+size_t
+SnapshotPersistor::replay_journal_(const char* buf,
+                                   size_t size,
+                                   TLogs& tlogs,
+                                   ScrubId& scrub_id,
+                                   size_t& nrecords)
+{
+    size_t off = 0;
+
+    while (size - off >= sizeof(RecordHeader))
+    {
+        RecordHeader rh;
+        memcpy(&rh,
+               buf + off,
+               sizeof(rh));
+
+        const char* payload = buf + off + sizeof(rh);
+
+        if (size - off - sizeof(rh) < rh.size or
+            crc32c(payload, rh.size) != rh.crc)
+        {
+            break;
+        }
+
+        bio::stream<bio::array_source> is(payload,
+                                          rh.size);
+        ba::binary_iarchive ia(is,
+                               ba::no_header);
+
+        uint64_t keep = 0;
+        TLogs tail;
+
+        ia >> keep;
+        ia >> tail;
+        ia >> scrub_id;
+
+        if (keep > tlogs.size())
+        {
+            LOG_ERROR("Journal record keeps " << keep << " TLogs but only " <<
+                      tlogs.size() << " are known");
+            throw SnapshotPersistorException("Invalid journal record in snapshots file");
+        }
+
+        tlogs.erase(std::next(tlogs.begin(),
+                              keep),
+                    tlogs.end());
+        tlogs.splice(tlogs.end(),
+                     tail);
+
+        off += sizeof(rh) + rh.size;
+        ++nrecords;
+    }
+
+    return off;
 }
 
 std::unique_ptr<SnapshotPersistor>
@@ -162,7 +409,8 @@ SnapshotPersistor::isSnapshotInBackend(const SnapshotNum num) const
 
 void
 SnapshotPersistor::saveToFile(const fs::path& filename,
-                                  const SyncAndRename sync_and_rename) const
+                              const SyncAndRename sync_and_rename,
+                              const BinaryJournal binary_journal) const
 {
     tracepoint(openvstorage_volumedriver,
                snapshots_persist_start,
@@ -181,10 +429,18 @@ SnapshotPersistor::saveToFile(const fs::path& filename,
     {
         if (T(sync_and_rename))
         {
+            boost::lock_guard<boost::mutex> g(path_lock(filename));
+
+            if (T(binary_journal) and append_(filename))
+            {
+                return;
+            }
+
             fs::path tmp;
             tmp = FileUtils::create_temp_file(filename);
             ALWAYS_CLEANUP_FILE(tmp);
-            saveToFileSimple_(tmp);
+            saveToFileSimple_(tmp,
+                              binary_journal);
             {
                 yt::FileDescriptor justToSync(tmp,
                                               yt::FDMode::Write);
@@ -194,7 +450,8 @@ SnapshotPersistor::saveToFile(const fs::path& filename,
         }
         else
         {
-            saveToFileSimple_(filename);
+            saveToFileSimple_(filename,
+                              binary_journal);
         }
     }
     CATCH_STD_ALL_LOGLEVEL_ADDERROR_RETHROW("Failed to persist snapshots",
@@ -202,12 +459,205 @@ SnapshotPersistor::saveToFile(const fs::path& filename,
                                             events::VolumeDriverErrorCode::WriteSnapshots);
 }
 
+std::string
+SnapshotPersistor::encode_base_() const
+{
+    std::ostringstream os;
+
+    {
+        ba::binary_oarchive oa(os);
+
+        const bool use_hash = ClusterLocationAndHash::use_hash();
+        oa << parent_;
+        oa << snapshots;
+        oa << use_hash;
+    }
+
+    return os.str();
+}
+
+std::string
+SnapshotPersistor::encode_record_(uint64_t keep) const
+{
+    VERIFY(keep <= current.size());
+
+    std::ostringstream os;
+    os.write(std::string(sizeof(RecordHeader), 0).data(),
+             sizeof(RecordHeader));
+
+    {
+        ba::binary_oarchive oa(os,
+                               ba::no_header);
+
+        TLogs tail;
+        std::copy(std::next(current.begin(),
+                            keep),
+                  current.end(),
+                  std::back_inserter(tail));
+
+        oa << keep;
+        oa << tail;
+        oa << scrub_id_;
+    }
+
+    std::string rec(os.str());
+
+    RecordHeader rh;
+    rh.size = rec.size() - sizeof(rh);
+    rh.crc = crc32c(rec.data() + sizeof(rh),
+                    rh.size);
+
+    memcpy(&rec[0],
+           &rh,
+           sizeof(rh));
+
+    return rec;
+}
+
+bool
+SnapshotPersistor::append_(const fs::path& path) const
+{
+    if (not fs::exists(path))
+    {
+        return false;
+    }
+
+    try
+    {
+        yt::FileDescriptor fd(path,
+                              yt::FDMode::ReadWrite,
+                              CreateIfNecessary::F,
+                              SyncOnCloseAndDestructor::F);
+
+        const uint64_t size = fd.size();
+        BinaryHeader h;
+
+        if (size < sizeof(h) or
+            fd.pread(&h, sizeof(h), 0) != sizeof(h) or
+            memcmp(h.magic, binary_magic, sizeof(binary_magic)) != 0 or
+            h.version != binary_version or
+            std::string(h.generation, sizeof(h.generation)) != generation_.str() or
+            size - sizeof(h) < h.base_size)
+        {
+            return false;
+        }
+
+        const uint64_t off = sizeof(h) + h.base_size;
+        std::string journal(size - off, 0);
+
+        if (fd.pread(&journal[0], journal.size(), off) != journal.size())
+        {
+            return false;
+        }
+
+        TLogs tlogs;
+        ScrubId scrub_id;
+        size_t nrecords = 0;
+
+        const size_t valid = replay_journal_(journal.data(),
+                                             journal.size(),
+                                             tlogs,
+                                             scrub_id,
+                                             nrecords);
+
+        if (nrecords == 0 or nrecords >= max_journal_records)
+        {
+            return false;
+        }
+
+        uint64_t keep = 0;
+        auto it = current.begin();
+        auto jt = tlogs.begin();
+
+        while (it != current.end() and
+               jt != tlogs.end() and
+               *it == *jt)
+        {
+            ++keep;
+            ++it;
+            ++jt;
+        }
+
+        if (it == current.end() and
+            jt == tlogs.end() and
+            scrub_id == scrub_id_)
+        {
+            return true;
+        }
+
+        if (valid != journal.size())
+        {
+            LOG_WARN(path << ": dropping " << (journal.size() - valid) <<
+                     " bytes of torn journal records");
+            fd.truncate(off + valid);
+        }
+
+        const std::string rec(encode_record_(keep));
+        fd.pwrite(rec.data(),
+                  rec.size(),
+                  off + valid);
+        fd.sync();
+
+        return true;
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_WARN(path << ": failed to append to snapshots file, rewriting it: " <<
+                     EWHAT);
+            return false;
+        });
+}
+
+void
+SnapshotPersistor::saveToFileSimple_(const fs::path& filename,
+                                     const BinaryJournal binary_journal) const
+{
+    if (T(binary_journal))
+    {
+        saveToFileBinary_(filename);
+    }
+    else
+    {
+        yt::Serialization::serializeNVPAndFlush<ba::xml_oarchive>(filename,
+                                                                  nvp_name,
+                                                                  *this);
+    }
+}
+
 void
-SnapshotPersistor::saveToFileSimple_(const fs::path& filename) const
+SnapshotPersistor::saveToFileBinary_(const fs::path& filename) const
 {
-    yt::Serialization::serializeNVPAndFlush<boost::archive::xml_oarchive>(filename,
-                                                                          "snapshots",
-                                                                          *this);
+    const std::string base(encode_base_());
+    const std::string rec(encode_record_(0));
+
+    BinaryHeader h;
+    memset(&h,
+           0x0,
+           sizeof(h));
+    memcpy(h.magic,
+           binary_magic,
+           sizeof(binary_magic));
+    h.version = binary_version;
+    h.base_crc = crc32c(base.data(),
+                        base.size());
+    h.base_size = base.size();
+
+    const std::string gen(generation_.str());
+    VERIFY(gen.size() == sizeof(h.generation));
+    memcpy(h.generation,
+           gen.data(),
+           sizeof(h.generation));
+
+    fs::ofstream ofs(filename,
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.exceptions(std::ios::failbit | std::ios::badbit);
+
+    ofs.write(reinterpret_cast<const char*>(&h),
+              sizeof(h));
+    ofs.write(base.data(),
+              base.size());
+    ofs.write(rec.data(),
+              rec.size());
+    ofs.flush();
 }
 
 void
@@ -222,7 +672,11 @@ SnapshotPersistor::setTLogWrittenToBackend(const TLogId& tlogid)
 {
     // The "snapshots before current" order needs to be maintained as the
     // consistency check in TLogs::setTLogWrittenToBackend() relies on it.
-    if(not snapshots.setTLogWrittenToBackend(tlogid))
+    if (snapshots.setTLogWrittenToBackend(tlogid))
+    {
+        snapshots_changed_();
+    }
+    else
     {
         if (not current.setTLogWrittenToBackend(tlogid))
         {
@@ -330,6 +784,7 @@ SnapshotPersistor::snapshot(const SnapshotName& name,
                      create_scrubbed);
 
     snapshots.push_back(s);
+    snapshots_changed_();
     current.clear();
     newTLog();
 }
@@ -428,12 +883,14 @@ SnapshotPersistor::deleteSnapshot(SnapshotNum num)
 {
     snapshots.deleteSnapshot(num,
                              current);
+    snapshots_changed_();
 }
 
 void
 SnapshotPersistor::deleteAllButLastSnapshot()
 {
     snapshots.deleteAllButLastSnapshot();
+    snapshots_changed_();
 }
 
 void
@@ -477,6 +934,7 @@ void
 SnapshotPersistor::deleteTLogsAndSnapshotsAfterSnapshot(SnapshotNum num)
 {
     snapshots.deleteTLogsAndSnapshotsAfterSnapshot(num);
+    snapshots_changed_();
     current.clear();
     newTLog();
 }
@@ -492,6 +950,7 @@ SnapshotPersistor::snip(const TLogId& tlog_id,
         current.clear();
         current = snapshots.back();
         snapshots.pop_back();
+        snapshots_changed_();
         return true;
     }
     else
@@ -540,6 +999,7 @@ SnapshotPersistor::replace(const OrderedTLogIds& in,
     snapshots.replace(in,
                       out,
                       num);
+    snapshots_changed_();
     return new_scrub_id();
 }
 
@@ -568,6 +1028,7 @@ SnapshotPersistor::setSnapshotScrubbed(SnapshotNum num,
                                        bool scrubbed)
 {
     snapshots.find_or_throw_(num)->scrubbed = scrubbed;
+    snapshots_changed_();
 }
 
 void
@@ -658,6 +1119,7 @@ SnapshotPersistor::trimToBackend()
         {
             current = i->tlogsOnDss();
             snapshots.erase(i, snapshots.end());
+            snapshots_changed_();
             ready = true;
             break;
         }
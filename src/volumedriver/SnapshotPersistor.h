@@ -45,6 +45,7 @@ class SnapshotPersistorToolCut;
 BOOLEAN_ENUM(WithCurrent)
 
 BOOLEAN_ENUM(SyncAndRename);
+BOOLEAN_ENUM(BinaryJournal);
 
 BOOLEAN_ENUM(FromOldest);
 
@@ -129,9 +130,17 @@ public:
         return snapshots.empty();
     }
 
+    // Writes the XML format unless BinaryJournal::T is passed, which is only
+    // meant for the local snapshots file - older versions cannot read the
+    // binary format, hence it must not end up on the backend.
+    // With BinaryJournal::T and SyncAndRename::T a binary file previously written
+    // from the same state of the snapshots is only appended to with the TLogs
+    // that changed, otherwise it's rewritten in full.
+    // The constructors read both formats.
     void
     saveToFile(const fs::path& path,
-               const SyncAndRename sync_and_rename) const;
+               const SyncAndRename sync_and_rename,
+               const BinaryJournal binary_journal = BinaryJournal::F) const;
 
     void
     snapshot(const SnapshotName& name,
@@ -355,6 +364,11 @@ public:
     // push this and the associated test down to Snapshot?
     static constexpr uint32_t max_snapshot_metadata_size = 4096;
 
+    // Number of journal records saveToFile appends to a binary snapshots file
+    // before rewriting it in full.
+    // Not const as SnapshotPersistorTest messes with it.
+    static uint32_t max_journal_records;
+
 private:
     DECLARE_LOGGER("SnapshotPersistor");
 
@@ -363,8 +377,45 @@ private:
     MaybeParentConfig parent_;
     ScrubId scrub_id_;
 
+    // Identifies the state of everything but current and scrub_id_, which are
+    // the only parts that can be updated by appending to a binary snapshots
+    // file. Needs to be renewed whenever anything else changes.
+    youtils::UUID generation_;
+
+    void
+    snapshots_changed_()
+    {
+        generation_ = youtils::UUID();
+    }
+
+    void
+    load_(std::istream& is);
+
+    void
+    load_binary_(const std::string& buf);
+
+    static size_t
+    replay_journal_(const char* buf,
+                    size_t size,
+                    TLogs& tlogs,
+                    ScrubId& scrub_id,
+                    size_t& nrecords);
+
+    std::string
+    encode_base_() const;
+
+    std::string
+    encode_record_(uint64_t keep) const;
+
+    bool
+    append_(const fs::path& path) const;
+
+    void
+    saveToFileSimple_(const fs::path& path,
+                      const BinaryJournal binary_journal) const;
+
     void
-    saveToFileSimple_(const fs::path& path) const;
+    saveToFileBinary_(const fs::path& path) const;
 
     friend class boost::serialization::access;
     BOOST_SERIALIZATION_SPLIT_MEMBER();
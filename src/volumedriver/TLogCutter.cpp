@@ -22,12 +22,12 @@ namespace volumedriver
 {
 
 TLogCutter::TLogCutter(BackendInterface& bi,
-                       const fs::path& file,
+                       TLogReaderInterface& entries,
                        FilePool& filepool,
                        const ClusterSize cluster_size,
                        uint64_t max_entries)
     : bi_(bi)
-    , file_(file)
+    , entries_(entries)
     , filepool_(filepool)
     , max_entries_(max_entries)
     , cluster_size_(cluster_size)
@@ -74,11 +74,10 @@ TLogCutter::operator()()
 {
     uint64_t entries_written = 0;
     makeNewTLog();
-    TLogReader tlog_reader(file_);
     const Entry* e  = 0;
     SCONumber prev_sco_num = 0;
 
-    while((e = tlog_reader.nextLocation()))
+    while((e = entries_.nextLocation()))
     {
         const SCONumber current_sco_num = e->clusterLocation().number();
 
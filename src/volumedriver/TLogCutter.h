@@ -16,7 +16,7 @@
 #define TLOG_CUTTER_H_
 
 #include "FilePool.h"
-#include "TLogReader.h"
+#include "TLogReaderInterface.h"
 #include "TLogWriter.h"
 
 #include <vector>
@@ -38,7 +38,7 @@ class TLogCutter
 {
 public:
     TLogCutter(BackendInterface&,
-               const boost::filesystem::path& file,
+               TLogReaderInterface& entries,
                FilePool&,
                const ClusterSize,
                uint64_t max_entries = 4194304);
@@ -63,7 +63,7 @@ private:
     writeTLogToBackend();
 
     BackendInterface& bi_;
-    const boost::filesystem::path file_;
+    TLogReaderInterface& entries_;
     FilePool& filepool_;
     const uint64_t max_entries_;
     const ClusterSize cluster_size_;
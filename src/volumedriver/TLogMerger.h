@@ -20,6 +20,7 @@
 #include "TLogWriter.h"
 #include "BackwardTLogReader.h"
 #include "TLogReader.h"
+#include "TLogReaderInterface.h"
 #include "ClusterLocation.h"
 #include <youtils/CheckSum.h>
 namespace scrubbing
@@ -27,8 +28,11 @@ namespace scrubbing
 using namespace volumedriver;
 namespace fs = boost::filesystem;
 
+// Also usable as a TLogReaderInterface that hands out the merged entries
+// one by one, i.e. without writing them to a TLog first.
 template<typename T>
 class TLogMerger
+    : public TLogReaderInterface
 {
 private:
     typedef std::list<std::pair<T*, const Entry*> > TLogReaderList;
@@ -39,6 +43,16 @@ public:
 
     ~TLogMerger()
     {
+        for (auto& r : tlog_readers)
+        {
+            delete r.first;
+        }
+    }
+
+    const Entry*
+    nextAny() override final
+    {
+        return next();
     }
 
 
@@ -146,6 +160,7 @@ private:
 
 typedef TLogMerger<BackwardTLogReader> BackwardTLogMerger;
 typedef TLogMerger<TLogReader> ForwardTLogMerger;
+typedef TLogMerger<TLogReaderInterface> ScrubEntryMerger;
 
 }
 
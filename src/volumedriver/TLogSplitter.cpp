@@ -15,7 +15,6 @@
 #include "TLogSplitter.h"
 #include "CombinedTLogReader.h"
 #include <boost/shared_ptr.hpp>
-#include "TLogWriter.h"
 #include "FilePool.h"
 
 namespace scrubbing
@@ -25,46 +24,36 @@ using namespace volumedriver;
 TLogSplitter::TLogSplitter(std::shared_ptr<TLogReaderInterface> reader,
                            ScrubbingSCODataVector& sco_data,
                            const RegionExponent& region_exponent,
-                           FilePool& filepool)
+                           FilePool& filepool,
+                           ScrubMemoryBudget& budget)
     : region_exponent_(region_exponent),
       reader_(reader),
       filepool_(filepool),
-      sco_data_(sco_data)
+      sco_data_(sco_data),
+      budget_(budget)
 {}
 
 TLogSplitter::~TLogSplitter()
-{
-
-    for(TLogWriterMap::iterator it = tlog_writers_.begin() ; it != tlog_writers_.end(); ++it)
-    {
-        delete it->second;
-    }
-    tlog_writers_.clear();
-}
+{}
 
 void
 TLogSplitter::doEntry(const Entry* e)
 {
     ClusterAddress cluster_address = e->clusterAddress();
     uint64_t index = cluster_address >> region_exponent_;
-    TLogWriterMap::const_iterator it = tlog_writers_.find(index);
-    TLogWriter* tlog_writer = 0;
-    if(it == tlog_writers_.end())
+    MapType::iterator it = tlog_names_.find(index);
+    if(it == tlog_names_.end())
     {
         std::stringstream ss;
         ss << "tlog_for_region_" << index;
-        fs::path tlog_path = filepool_.newFile(ss.str());
-        tlog_writer = new TLogWriter(tlog_path);
-        tlog_names_.insert(std::make_pair(index, tlog_path));
-        tlog_writers_.insert(std::make_pair(index, tlog_writer));
-    }
-    else
-    {
-        tlog_writer = it->second;
+        it = tlog_names_.emplace(index,
+                                 std::make_unique<ScrubEntryBuffer>(budget_,
+                                                                    filepool_,
+                                                                    ss.str())).first;
     }
 
-    tlog_writer->add(e->clusterAddress(),
-                     e->clusterLocationAndHash());
+    it->second->add(e->clusterAddress(),
+                    e->clusterLocationAndHash());
 
     SCO sco_name = e->clusterLocation().sco();
     if(sco_data_.empty() or
@@ -89,11 +78,11 @@ TLogSplitter::operator()()
     {
         doEntry(e);
     }
-    for(TLogWriterMap::iterator it = tlog_writers_.begin() ; it != tlog_writers_.end(); ++it)
+
+    for(auto& r : tlog_names_)
     {
-        delete it->second;
+        r.second->seal();
     }
-    tlog_writers_.clear();
 }
 }
 
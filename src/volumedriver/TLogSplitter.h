@@ -19,13 +19,13 @@
 #include <youtils/Logging.h>
 #include "youtils/FileUtils.h"
 #include "ScrubbingSCOData.h"
+#include "ScrubEntryBuffer.h"
 #include "TLogReaderInterface.h"
 #include <boost/smart_ptr/shared_ptr.hpp>
 
 namespace volumedriver
 {
 class FilePool;
-class TLogWriter;
 class Entry;
 }
 
@@ -37,14 +37,15 @@ using namespace volumedriver;
 class TLogSplitter
 {
 public:
-    typedef std::map<uint64_t, fs::path> MapType;
+    typedef std::map<uint64_t, std::unique_ptr<ScrubEntryBuffer>> MapType;
 
 
 
     TLogSplitter(std::shared_ptr<TLogReaderInterface> reader_,
                  ScrubbingSCODataVector& sco_data,
                  const RegionExponent&,
-                 volumedriver::FilePool& filepool);
+                 volumedriver::FilePool& filepool,
+                 ScrubMemoryBudget& budget);
 
     ~TLogSplitter();
 
@@ -60,6 +61,13 @@ public:
         return tlog_names_;
     }
 
+    // Non-const as the consumers drop the regions' entries once they're done with them.
+    MapType&
+    getMap()
+    {
+        return tlog_names_;
+    }
+
 private:
     void
     doEntry(const volumedriver::Entry*);
@@ -68,14 +76,9 @@ private:
     std::shared_ptr<volumedriver::TLogReaderInterface>  reader_;
     volumedriver::FilePool& filepool_;
     ScrubbingSCODataVector& sco_data_;
-
-    typedef std::map<uint64_t, volumedriver::TLogWriter*> TLogWriterMap;
+    ScrubMemoryBudget& budget_;
 
     MapType tlog_names_;
-
-
-    TLogWriterMap tlog_writers_;
-
 };
 }
 
@@ -234,6 +234,88 @@ TokyoCabinetMetaDataBackend::discardPage(const CachePage& p,
     }
 }
 
+void
+TokyoCabinetMetaDataBackend::putPages(const PageUpdates& pages)
+{
+    LOG_TRACE(pages.size() << " pages");
+
+    if (pages.empty())
+    {
+        return;
+    }
+
+    int64_t used_clusters = used_clusters_;
+
+    for (const auto& u : pages)
+    {
+        check_page_address_(u.page);
+
+        HANDLE(tcbdbput(database_,
+                        &u.page.page_address(),
+                        sizeof(u.page.page_address()),
+                        u.page.data(),
+                        CachePage::size()));
+
+        used_clusters += u.used_clusters_delta;
+    }
+
+    ASSERT(used_clusters >= 0);
+    used_clusters_ = used_clusters;
+
+    HANDLE(tcbdbput(database_,
+                    &used_clusters_key_,
+                    sizeof(used_clusters_key_),
+                    &used_clusters_,
+                    sizeof(used_clusters_)));
+}
+
+void
+TokyoCabinetMetaDataBackend::discardPages(const PageUpdates& pages)
+{
+    LOG_TRACE(pages.size() << " pages");
+
+    int64_t used_clusters = used_clusters_;
+    bool removed = false;
+
+    for (const auto& u : pages)
+    {
+        check_page_address_(u.page);
+
+        const bool res = tcbdbout(database_,
+                                  &u.page.page_address(),
+                                  sizeof(u.page.page_address()));
+        if (not res)
+        {
+            const int ecode = tcbdbecode(database_);
+            if (ecode != TCENOREC)
+            {
+                std::stringstream ss;
+                ss << "problem with tc: failed to remove page " << u.page.page_address()
+                   << ": " << tcbdberrmsg(ecode);
+                throw MetaDataStoreBackendException(ss.str().c_str(), __FUNCTION__);
+            }
+        }
+        else
+        {
+            // cf. discardPage: only pages that were present count
+            used_clusters += u.used_clusters_delta;
+            removed = true;
+        }
+    }
+
+    if (removed)
+    {
+        ASSERT(used_clusters >= 0);
+        used_clusters_ = used_clusters;
+
+        HANDLE(tcbdbput(database_,
+                        &used_clusters_key_,
+                        sizeof(used_clusters_key_),
+                        &used_clusters_,
+                        sizeof(used_clusters_)));
+    }
+}
+
 void
 TokyoCabinetMetaDataBackend::sync()
 {
@@ -54,6 +54,12 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    virtual void
+    putPages(const PageUpdates& pages) override final;
+
+    virtual void
+    discardPages(const PageUpdates& pages) override final;
+
     bool
     pageExistsInParent(const PageAddress) const override final
     {
@@ -15,6 +15,7 @@
 #include "BackendTasks.h"
 #include "Entry.h"
 #include "LockStoreFactory.h"
+#include "MetaDataCacheBudget.h"
 #include "SCOCache.h"
 #include "SCOCacheAccessDataPersistor.h"
 #include "SnapshotManagement.h"
@@ -145,10 +146,17 @@ try
           , dtl_throttle_usecs(pt)
           , dtl_queue_depth(pt)
           , dtl_write_trigger(pt)
+          , dtl_batches_in_flight(pt)
+          , dtl_shmem_size(pt)
+          , dtl_compression(pt)
           , number_of_scos_in_tlog(pt)
           , non_disposable_scos_factor(pt)
           , default_cluster_size(pt)
           , metadata_cache_capacity(pt)
+          , metadata_cache_budget(pt)
+          , metadata_cache_min_pages(pt)
+          , metadata_page_encoding(pt)
+          , snapshots_binary_journal(pt)
           , debug_metadata_path(pt)
           , arakoon_metadata_sequence_size(pt)
           , allow_inconsistent_partial_reads(pt)
@@ -156,6 +164,13 @@ try
 {
     THROW_UNLESS((default_cluster_size.value() % VolumeConfig::default_lba_size()) == 0);
 
+    if (metadata_cache_budget.value() > 0)
+    {
+        metadata_cache_budget_ =
+            std::make_shared<MetaDataCacheBudget>(metadata_cache_budget.value(),
+                                                  metadata_cache_min_pages.value());
+    }
+
     periodicActions_.push_back(new yt::PeriodicAction("SCOCacheCleaner",
                                                       [this]
                                                       {
@@ -1772,6 +1787,9 @@ VolManager::update(const boost::property_tree::ptree& pt,
     dtl_throttle_usecs.update(pt, report);
     dtl_queue_depth.update(pt, report);
     dtl_write_trigger.update(pt, report);
+    dtl_batches_in_flight.update(pt, report);
+    dtl_shmem_size.update(pt, report);
+    dtl_compression.update(pt, report);
 
     freespace_check_interval.update(pt, report);
     read_cache_default_behaviour.update(pt, report);
@@ -1785,6 +1803,10 @@ VolManager::update(const boost::property_tree::ptree& pt,
     non_disposable_scos_factor.update(pt, report);
     default_cluster_size.update(pt, report);
     metadata_cache_capacity.update(pt, report);
+    metadata_cache_budget.update(pt, report);
+    metadata_cache_min_pages.update(pt, report);
+    metadata_page_encoding.update(pt, report);
+    snapshots_binary_journal.update(pt, report);
     debug_metadata_path.update(pt, report);
     arakoon_metadata_sequence_size.update(pt, report);
     allow_inconsistent_partial_reads.update(pt, report);
@@ -1809,11 +1831,18 @@ VolManager::persist(boost::property_tree::ptree& pt,
     dtl_throttle_usecs.persist(pt, reportDefault);
     dtl_queue_depth.persist(pt, reportDefault);
     dtl_write_trigger.persist(pt, reportDefault);
+    dtl_batches_in_flight.persist(pt, reportDefault);
+    dtl_shmem_size.persist(pt, reportDefault);
+    dtl_compression.persist(pt, reportDefault);
 
     number_of_scos_in_tlog.persist(pt, reportDefault);
     non_disposable_scos_factor.persist(pt, reportDefault);
     default_cluster_size.persist(pt, reportDefault);
     metadata_cache_capacity.persist(pt, reportDefault);
+    metadata_cache_budget.persist(pt, reportDefault);
+    metadata_cache_min_pages.persist(pt, reportDefault);
+    metadata_page_encoding.persist(pt, reportDefault);
+    snapshots_binary_journal.persist(pt, reportDefault);
     debug_metadata_path.persist(pt, reportDefault);
     arakoon_metadata_sequence_size.persist(pt, reportDefault);
     allow_inconsistent_partial_reads.persist(pt, reportDefault);
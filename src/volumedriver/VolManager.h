@@ -15,6 +15,7 @@
 #ifndef VOLMANAGER_H_
 #define VOLMANAGER_H_
 
+#include "ChangedClusters.h"
 #include "ClusterCache.h"
 #include "DataStoreCallBack.h"
 #include "Events.h"
@@ -65,6 +66,7 @@ namespace volumedriver
 
 class ClusterClusterCache;
 class LockStoreFactory;
+class MetaDataCacheBudget;
 class PeriodicAction;
 class Volume;
 
@@ -251,6 +253,12 @@ public:
         return ClusterCache_;
     }
 
+    ChangedClustersCache&
+    getChangedClustersCache()
+    {
+        return changed_clusters_cache_;
+    }
+
     void
     getVolumeList(std::list<VolumeId> &) const;
 
@@ -462,6 +470,13 @@ public:
     std::shared_ptr<metadata_server::Manager>
     metadata_server_manager();
 
+    // nullptr if there is no shared budget for metadata cache pages
+    std::shared_ptr<MetaDataCacheBudget>
+    get_metadata_cache_budget() const
+    {
+        return metadata_cache_budget_;
+    }
+
     ClusterCacheBehaviour
     get_cluster_cache_default_behaviour() const;
 
@@ -500,8 +515,12 @@ private:
 
     ClusterCache ClusterCache_;
 
+    ChangedClustersCache changed_clusters_cache_;
+
     std::shared_ptr<metadata_server::Manager> mds_manager_;
 
+    std::shared_ptr<MetaDataCacheBudget> metadata_cache_budget_;
+
     mutable boost::optional<uint64_t> max_file_descriptors_;
 
     DECLARE_PARAMETER(metadata_path);
@@ -525,11 +544,18 @@ public:
     DECLARE_PARAMETER(dtl_throttle_usecs);
     DECLARE_PARAMETER(dtl_queue_depth);
     DECLARE_PARAMETER(dtl_write_trigger);
+    DECLARE_PARAMETER(dtl_batches_in_flight);
+    DECLARE_PARAMETER(dtl_shmem_size);
+    DECLARE_PARAMETER(dtl_compression);
 
     DECLARE_PARAMETER(number_of_scos_in_tlog);
     DECLARE_PARAMETER(non_disposable_scos_factor);
     DECLARE_PARAMETER(default_cluster_size);
     DECLARE_PARAMETER(metadata_cache_capacity);
+    DECLARE_PARAMETER(metadata_cache_budget);
+    DECLARE_PARAMETER(metadata_cache_min_pages);
+    DECLARE_PARAMETER(metadata_page_encoding);
+    DECLARE_PARAMETER(snapshots_binary_journal);
     DECLARE_PARAMETER(debug_metadata_path);
     DECLARE_PARAMETER(arakoon_metadata_sequence_size);
     DECLARE_PARAMETER(allow_inconsistent_partial_reads);
@@ -21,6 +21,7 @@
 #include "CombinedTLogReader.h"
 #include "DataStoreNG.h"
 #include "FailOverCacheClientInterface.h"
+#include "FailOverCacheReplayReader.h"
 #include "MDSMetaDataStore.h"
 #include "MetaDataStoreInterface.h"
 #include "RelocationReaderFactory.h"
@@ -35,10 +36,12 @@
 #include "ScrubReply.h"
 #include "ScrubWork.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <numeric>
 
 #include <math.h>
 #include <float.h>
@@ -124,7 +127,8 @@ Volume::Volume(const VolumeConfig& vCfg,
                                                      LBASize(vCfg.lba_size_),
                                                      vCfg.cluster_mult_,
                                                      VolManager::get()->dtl_queue_depth.value(),
-                                                     VolManager::get()->dtl_write_trigger.value()))
+                                                     VolManager::get()->dtl_write_trigger.value(),
+                                                     VolManager::get()->dtl_batches_in_flight.value()))
     , metaDataStore_(metadatastore.release())
     , clusterSize_(vCfg.getClusterSize())
     , config_(vCfg)
@@ -471,7 +475,9 @@ Volume::localRestart()
                                                      TODO("AR: fix getLBASize instead")
                                                      LBASize(getLBASize()),
                                                      getClusterMultiplier(),
-                                                     failover_->getDefaultRequestTimeout());
+                                                     failover_->getDefaultRequestTimeout(),
+                                                     VolManager::get()->dtl_shmem_size.value(),
+                                                     VolManager::get()->dtl_compression.value());
         }
         CATCH_STD_ALL_EWHAT({
                 LOG_VINFO("Could not start with previous failover settings: " << EWHAT);
@@ -592,7 +598,9 @@ Volume::backend_restart(const CloneTLogs& restartTLogs,
                                                      cfg.getNS(),
                                                      LBASize(getLBASize()),
                                                      getClusterMultiplier(),
-                                                     failover_->getDefaultRequestTimeout());
+                                                     failover_->getDefaultRequestTimeout(),
+                                                     VolManager::get()->dtl_shmem_size.value(),
+                                                     VolManager::get()->dtl_compression.value());
         }
         CATCH_STD_ALL_EWHAT({
                 if (ignoreFOCIfUnreachable == IgnoreFOCIfUnreachable::T)
@@ -2055,20 +2063,31 @@ Volume::removeUpToFromFailOverCache(const SCO sconame)
 }
 
 void
-Volume::replayClusterFromFailOverCache_(ClusterAddress ca,
-                                        const ClusterLocation& loc,
-                                        const uint8_t* buf)
+Volume::replayClustersFromFailOverCache_(const ClusterLocation& start,
+                                         const std::vector<uint64_t>& lbas,
+                                         const uint8_t* buf)
 {
     ASSERT_WRITES_SERIALIZED();
     ASSERT_WLOCKED();
 
-    LOG_VTRACE("ca " << ca << ", loc " << loc << ", buf " << &buf);
+    LOG_VTRACE("start " << start << ", clusters " << lbas.size() << ", buf " <<
+               &buf);
     checkNotHalted_();
 
+    const size_t csize = getClusterSize();
+    std::vector<ClusterAddress> cas;
+    cas.reserve(lbas.size());
+
+    for (const auto lba : lbas)
+    {
+        validateIOAlignment(lba, csize);
+        cas.push_back(addr2CA(LBA2Addr(lba)));
+    }
+
     uint32_t throttle = 0;
     MaybeCheckSum forced_rollover;
 
-    if (loc.offset() == 0)
+    if (start.offset() == 0)
     {
         LOG_VTRACE("forced SCO rollover");
         forced_rollover = dataStore_->finalizeCurrentSCO();
@@ -2078,9 +2097,10 @@ Volume::replayClusterFromFailOverCache_(ClusterAddress ca,
     // than what is currently configured, i.e.
     // dataStore_->getRemainingSCOCapacity() could return values < 0.
     // So no sanity check here!
-    dataStore_->writeClusterToLocation(buf,
-                                       loc,
-                                       throttle);
+    dataStore_->writeClustersToLocation(buf,
+                                        start,
+                                        lbas.size(),
+                                        throttle);
 
     // if the SCO is filled up at this stage it will be either rolled over on
     // the next cluster replay or - if there is no next cluster - as part of
@@ -2090,11 +2110,50 @@ Volume::replayClusterFromFailOverCache_(ClusterAddress ca,
         snapshotManagement_->addSCOCRC(*forced_rollover);
     }
 
-    ClusterLocationAndHash loc_and_hash(loc,
-                                        buf,
-                                        getClusterSize());
-    writeClusterMetaData_(ca,
-                          loc_and_hash);
+    std::vector<ClusterLocationAndHash> locs_and_hashes;
+    locs_and_hashes.reserve(lbas.size());
+
+    // The TLog has to see the entries in the order they were written ...
+    for (size_t i = 0; i < lbas.size(); ++i)
+    {
+        const ClusterLocation loc(start.number(),
+                                  start.offset() + i);
+        locs_and_hashes.emplace_back(loc,
+                                     buf + i * csize,
+                                     csize);
+        snapshotManagement_->addClusterEntry(cas[i],
+                                             locs_and_hashes.back());
+    }
+
+    // ... whereas the metadata store only cares about the last one per
+    // cluster address, so the updates are applied in address order to
+    // work through one metadata page after the other.
+    std::vector<size_t> order(lbas.size());
+    std::iota(order.begin(),
+              order.end(),
+              0);
+    std::stable_sort(order.begin(),
+                     order.end(),
+                     [&](size_t a, size_t b)
+                     {
+                         return cas[a] < cas[b];
+                     });
+
+    try
+    {
+        for (const auto i : order)
+        {
+            metaDataStore_->writeCluster(cas[i],
+                                         locs_and_hashes[i]);
+        }
+    }
+    CATCH_STD_ALL_EWHAT({
+            VolumeDriverError::report(events::VolumeDriverErrorCode::MetaDataStore,
+                                      EWHAT,
+                                      getName());
+            halt();
+            throw;
+        });
 
     if(throttle > 0)
     {
@@ -2251,7 +2310,8 @@ Volume::setFailOverCacheMode_(const FailOverCacheMode mode)
                                                          LBASize(getLBASize()),
                                                          getClusterMultiplier(),
                                                          VolManager::get()->dtl_queue_depth.value(),
-                                                         VolManager::get()->dtl_write_trigger.value());
+                                                         VolManager::get()->dtl_write_trigger.value(),
+                                                         VolManager::get()->dtl_batches_in_flight.value());
         init_failover_cache_();
     }
 }
@@ -2275,7 +2335,9 @@ Volume::setFailOverCacheConfig_(const FailOverCacheConfig& config)
                                                              getNamespace(),
                                                              LBASize(getLBASize()),
                                                              getClusterMultiplier(),
-                                                             failover_->getDefaultRequestTimeout()));
+                                                             failover_->getDefaultRequestTimeout(),
+                                                             VolManager::get()->dtl_shmem_size.value(),
+                                                             VolManager::get()->dtl_compression.value()));
     failover_->Clear();
 
     MaybeCheckSum cs = dataStore_->finalizeCurrentSCO();
@@ -2390,6 +2452,23 @@ Volume::getSnapshotSCOCount(const SnapshotName& snapshotName)
     return lst.size();
 }
 
+ChangedClusters
+Volume::getChangedClusters(const boost::optional<SnapshotName>& start_snap,
+                           const SnapshotName& end_snap)
+{
+    const OrderedTLogIds
+        tlog_ids(snapshotManagement_->getTLogsBetweenSnapshots(start_snap,
+                                                               end_snap));
+
+    LOG_VINFO("start snapshot " << start_snap << ", end snapshot " << end_snap <<
+              ": " << tlog_ids.size() << " TLogs");
+
+    ChangedClustersCache& cache = VolManager::get()->getChangedClustersCache();
+    return cache.get(snapshotManagement_->getTLogsPath(),
+                     tlog_ids,
+                     *getBackendInterface());
+}
+
 uint64_t
 Volume::getCacheHits() const
 {
@@ -2653,42 +2732,38 @@ Volume::replayFOC_(FailOverCacheProxy& foc)
     ASSERT_WRITES_SERIALIZED();
     ASSERT_WLOCKED();
 
-    auto fun([&](ClusterLocation loc,
-                 uint64_t lba,
-                 const byte* buf,
-                 size_t size)
-             {
-                 uint32_t counter = 0;
-                 LOG_VTRACE("Replaying " << loc << "lba " << lba);
-
-                 VERIFY(size == static_cast<size_t>(clusterSize_));
+    try
+    {
+        FailOverCacheReplayReader reader(foc,
+                                         getClusterSize());
 
-                 validateIOAlignment(lba, size);
+        reader.read([&](const FailOverCacheReplayReader::Run& run)
+                    {
+                        LOG_VTRACE("Replaying " << run.lbas.size() <<
+                                   " clusters from " << run.start);
 
-                 while (true)
-                 {
-                     try
-                     {
-                         replayClusterFromFailOverCache_(addr2CA(LBA2Addr(lba)),
-                                                         loc,
-                                                         buf);
-                         return;
-                     }
-                     catch (TransientException& e)
-                     {
-                         LOG_VINFO("TransientException");
-                         if (++counter == 256)
-                         {
-                             throw;
-                         }
-                         boost::this_thread::sleep_for(bc::seconds(1));
-                     }
-                 }
-             });
+                        uint32_t counter = 0;
 
-    try
-    {
-        foc.getEntries(std::move(fun));
+                        while (true)
+                        {
+                            try
+                            {
+                                replayClustersFromFailOverCache_(run.start,
+                                                                 run.lbas,
+                                                                 run.data.data());
+                                return;
+                            }
+                            catch (TransientException& e)
+                            {
+                                LOG_VINFO("TransientException");
+                                if (++counter == 256)
+                                {
+                                    throw;
+                                }
+                                boost::this_thread::sleep_for(bc::seconds(1));
+                            }
+                        }
+                    });
 
         MaybeCheckSum cs = dataStore_->finalizeCurrentSCO();
 
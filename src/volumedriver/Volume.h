@@ -16,6 +16,7 @@
 #define VOLUME_H_
 
 #include "BackendTasks.h"
+#include "ChangedClusters.h"
 #include "ClusterCacheHandle.h"
 #include "FailOverCacheConfigWrapper.h"
 #include "FailOverCacheProxy.h"
@@ -393,6 +394,13 @@ public:
     uint64_t
     getSnapshotSCOCount(const SnapshotName& = SnapshotName());
 
+    // Clusters written to after start_snap (or the creation of the volume if
+    // none is given) up to and including end_snap. Clusters inherited from a
+    // clone's parent are not included.
+    ChangedClusters
+    getChangedClusters(const boost::optional<SnapshotName>& start_snap,
+                       const SnapshotName& end_snap);
+
     // Y42 should be made const
     bool
     isSyncedToBackend() const;
@@ -651,9 +659,9 @@ private:
                           const ClusterLocationAndHash& loc);
 
     void
-    replayClusterFromFailOverCache_(ClusterAddress ca,
-                                    const ClusterLocation& loc,
-                                    const uint8_t* buf);
+    replayClustersFromFailOverCache_(const ClusterLocation& start,
+                                     const std::vector<uint64_t>& lbas,
+                                     const uint8_t* buf);
 
     void
     writeClustersToFailOverCache_(const std::vector<ClusterLocation>& locs,
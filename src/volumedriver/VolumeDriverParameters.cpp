@@ -75,6 +75,27 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_write_trigger,
                                       ShowDocumentation::T,
                                       8);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_batches_in_flight,
+                                      volmanager_component_name,
+                                      "dtl_batches_in_flight",
+                                      "Maximum number of batches of entries sent to the DTL (in asynchronous mode) that are not acknowledged yet",
+                                      ShowDocumentation::T,
+                                      4);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_shmem_size,
+                                      volmanager_component_name,
+                                      "dtl_shmem_size",
+                                      "Size of the shared memory region used to pass data to a DTL running on the same host, 0 disables it; requires DTL servers that support it",
+                                      ShowDocumentation::T,
+                                      0);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_compression,
+                                      volmanager_component_name,
+                                      "dtl_compression",
+                                      "Whether to compress data sent to the DTL over the network (snappy); requires DTL servers that support it",
+                                      ShowDocumentation::T,
+                                      false);
+
 DEFINE_INITIALIZED_PARAM(clean_interval,
                          volmanager_component_name,
                          "scocache_cleanup_interval",
@@ -174,6 +195,34 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_capacity,
                                       ShowDocumentation::T,
                                       8192);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_budget,
+                                      volmanager_component_name,
+                                      "metadata_cache_budget",
+                                      "number of metadata pages shared by all volumes of this instance, 0 disables the shared budget. If enabled, metadata_cache_capacity is an upper bound per volume",
+                                      ShowDocumentation::T,
+                                      0ULL);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_min_pages,
+                                      volmanager_component_name,
+                                      "metadata_cache_min_pages",
+                                      "number of metadata pages reserved per volume out of the metadata_cache_budget",
+                                      ShowDocumentation::T,
+                                      32U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_page_encoding,
+                                      volmanager_component_name,
+                                      "metadata_page_encoding",
+                                      "Whether to store metadata pages in a compact encoding (RocksDB, Arakoon and MDS backends), applies to volumes started afterwards; requires all volumedrivers and MDS servers accessing the metadata to support it",
+                                      ShowDocumentation::T,
+                                      false);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(snapshots_binary_journal,
+                                      volmanager_component_name,
+                                      "snapshots_binary_journal",
+                                      "Whether to keep the local snapshots file in a binary format that is appended to on TLog updates instead of rewriting the XML; the backend copy stays XML. Requires a volumedriver version that supports it for local restarts",
+                                      ShowDocumentation::T,
+                                      false);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(debug_metadata_path,
                                       volmanager_component_name,
                                       "no_python_name",
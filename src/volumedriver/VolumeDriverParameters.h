@@ -38,6 +38,12 @@ DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_queue_depth,
                                                   std::atomic<unsigned>);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_write_trigger,
                                                   std::atomic<unsigned>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_batches_in_flight,
+                                                  std::atomic<unsigned>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_shmem_size,
+                                                  std::atomic<uint64_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(dtl_compression,
+                                                  std::atomic<bool>);
 
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(freespace_check_interval,
                                                   std::atomic<uint64_t>);
@@ -69,6 +75,14 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(default_cluster_size,
                                        uint32_t);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_capacity,
                                        uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_budget,
+                                       uint64_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_min_pages,
+                                       uint32_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_page_encoding,
+                                                  std::atomic<bool>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(snapshots_binary_journal,
+                                                  std::atomic<bool>);
 
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(debug_metadata_path, std::string);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(arakoon_metadata_sequence_size, uint32_t);
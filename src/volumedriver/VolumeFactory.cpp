@@ -41,6 +41,7 @@
 #include <dirent.h>
 
 #include <youtils/Catchers.h>
+#include <youtils/wall_timer.h>
 
 #include <backend/Namespace.h>
 
@@ -56,6 +57,67 @@ namespace
 
 DECLARE_LOGGER("VolumeFactory");
 
+// Keeps track of the wall clock time spent in the phases of a volume restart
+// and logs them in one go once the restart is done (or has failed).
+class RestartPhaseTimer
+{
+public:
+    RestartPhaseTimer(const be::Namespace& ns,
+                      const char* what)
+        : ns_(ns)
+        , what_(what)
+        , current_(nullptr)
+    {}
+
+    ~RestartPhaseTimer()
+    {
+        try
+        {
+            phase(nullptr);
+
+            std::stringstream ss;
+            for (const auto& p : phases_)
+            {
+                ss << p.first << ": " << p.second << "s, ";
+            }
+
+            LOG_INFO(ns_ << ": " << what_ << " phase timings: " << ss.str() <<
+                     "total: " << total_.elapsed() << "s");
+        }
+        CATCH_STD_ALL_LOG_IGNORE(ns_ << ": failed to log " << what_ <<
+                                 " phase timings");
+    }
+
+    RestartPhaseTimer(const RestartPhaseTimer&) = delete;
+
+    RestartPhaseTimer&
+    operator=(const RestartPhaseTimer&) = delete;
+
+    // ends the current phase (if any) and starts the next one
+    void
+    phase(const char* name)
+    {
+        if (current_ != nullptr)
+        {
+            phases_.emplace_back(current_,
+                                 timer_.elapsed());
+        }
+
+        current_ = name;
+        timer_.restart();
+    }
+
+private:
+    DECLARE_LOGGER("RestartPhaseTimer");
+
+    const be::Namespace ns_;
+    const char* what_;
+    const char* current_;
+    yt::wall_timer timer_;
+    yt::wall_timer total_;
+    std::vector<std::pair<const char*, double>> phases_;
+};
+
 template<DeleteLocalData delete_local_meta_data,
          RemoveVolumeCompletely remove_volume_completely>
 struct FreshVolumeDestroyer
@@ -134,13 +196,15 @@ make_metadata_store(const VolumeConfig& config)
             return std::unique_ptr<MetaDataStoreInterface>(new MDSMetaDataStore(mcfg,
                                                                                 std::move(bi),
                                                                                 home,
-                                                                                num_pages_cached));
+                                                                                num_pages_cached,
+                                                                                vm.get_metadata_cache_budget()));
         }
     }
 
     return std::unique_ptr<MetaDataStoreInterface>(new CachedMetaDataStore(mdb,
                                                                            config.ns_,
-                                                                           num_pages_cached));
+                                                                           num_pages_cached,
+                                                                           vm.get_metadata_cache_budget()));
 }
 
 std::unique_ptr<MetaDataStoreInterface>
@@ -549,8 +613,14 @@ local_restart_volume(const VolumeConfig& config,
                      const IgnoreFOCIfUnreachable)
 try
 {
+    RestartPhaseTimer timer(config.getNS(),
+                            "local restart");
+
+    timer.phase("metadata store");
     std::unique_ptr<MetaDataStoreInterface>
         mdstore(local_restart_metadata_store(config));
+
+    timer.phase("clone namespaces");
     NSIDMap nsid;
     SnapshotPersistor sp(config.parent());
     NSIDMapBuilder builder(nsid);
@@ -558,12 +628,15 @@ try
     sp.vold(builder,
             VolManager::get()->createBackendInterface(config.getNS()));
 
+    timer.phase("volume setup");
     auto vol(create_volume_stage_1<DeleteLocalData::F,
                                    RemoveVolumeCompletely::F>(config,
                                                               owner_tag,
                                                               RestartContext::LocalRestart,
                                                               std::move(nsid),
                                                               std::move(mdstore)));
+
+    timer.phase("data store and DTL");
     vol->localRestart();
     return std::unique_ptr<Volume>(vol.release());
 }
@@ -650,6 +723,10 @@ VolumeFactory::backend_restart(const VolumeConfig& config,
 
     try
     {
+        RestartPhaseTimer timer(nspace,
+                                "backend restart");
+
+        timer.phase("snapshots");
         BackendInterfacePtr bi(vm->createBackendInterface(nspace));
         LOG_TRACE("reading the snapshots file " <<
                   snapshotFilename() <<
@@ -676,6 +753,7 @@ VolumeFactory::backend_restart(const VolumeConfig& config,
         sp.saveToFile(VolManager::get()->getSnapshotsPath(config),
                       SyncAndRename::T);
 
+        timer.phase("metadata store");
         std::unique_ptr<MetaDataStoreInterface>
             mdstore(make_metadata_store(config,
                                         sp.scrub_id()));
@@ -693,6 +771,7 @@ VolumeFactory::backend_restart(const VolumeConfig& config,
 
         VERIFY(restartTLogs.size() <= nsid.size());
 
+        timer.phase("restart SCO");
         LOG_INFO("Trying to find out restart sconumber");
 
         VERIFY(restartTLogs.back().first == SCOCloneID(0));
@@ -718,18 +797,22 @@ VolumeFactory::backend_restart(const VolumeConfig& config,
             LOG_WARN("Could not find a SCO, restarting datastore from 0");
         }
 
+        timer.phase("volume setup");
         auto vol(create_volume_stage_1<DeleteLocalData::T,
                                        RemoveVolumeCompletely::F>(config,
                                                                   owner_tag,
                                                                   RestartContext::BackendRestart,
                                                                   std::move(nsid),
                                                                   std::move(mdstore)));
+
+        timer.phase("TLog replay and DTL");
         vol->backend_restart(restartTLogs,
                              restart_sco_num,
                              ignoreFOCIfUnreachable,
                              sp.lastCork());
         if (T(prefetch))
         {
+            timer.phase("prefetch");
             try
             {
                 vol->startPrefetch(restart_sco_num);
@@ -40,6 +40,9 @@ public:
     Backend&
     operator=(const Backend&) = delete;
 
+    // The buffer owns the data of the entries. If it's null the data is only
+    // valid for the duration of the call (it lives in a client's shared
+    // memory region) and implementations that hold on to it need to copy it.
     void
     addEntries(std::vector<volumedriver::FailOverCacheEntry>,
                std::unique_ptr<uint8_t[]>);
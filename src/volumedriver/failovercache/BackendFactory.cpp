@@ -14,7 +14,9 @@
 
 #include "BackendFactory.h"
 #include "FileBackend.h"
+#include "GroupCommitter.h"
 #include "MemoryBackend.h"
+#include "SegmentLogBackend.h"
 
 namespace failovercache
 {
@@ -41,8 +43,11 @@ maybe_make_dir(const boost::optional<fs::path>& p)
 
 }
 
-BackendFactory::BackendFactory(const boost::optional<fs::path>& path)
+BackendFactory::BackendFactory(const boost::optional<fs::path>& path,
+                               UseSegmentLog use_segment_log)
     : root_(maybe_make_dir(path))
+    , use_segment_log_(use_segment_log)
+    , committer_(std::make_unique<GroupCommitter>())
 {
     if (root_)
     {
@@ -105,7 +110,14 @@ std::unique_ptr<Backend>
 BackendFactory::make_backend(const std::string& nspace,
                              const vd::ClusterSize csize)
 {
-    if (root_)
+    if (root_ and use_segment_log_ == UseSegmentLog::T)
+    {
+        return std::make_unique<SegmentLogBackend>(*root_,
+                                                   nspace,
+                                                   csize,
+                                                   *committer_);
+    }
+    else if (root_)
     {
         return std::make_unique<FileBackend>(*root_,
                                              nspace,
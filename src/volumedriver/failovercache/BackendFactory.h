@@ -16,16 +16,22 @@
 
 #include <boost/filesystem.hpp>
 
+#include <youtils/BooleanEnum.h>
 #include <youtils/FileDescriptor.h>
 #include <youtils/Logging.h>
 
 namespace failovercache
 {
 
+BOOLEAN_ENUM(UseSegmentLog);
+
+class GroupCommitter;
+
 class BackendFactory
 {
 public:
-    explicit BackendFactory(const boost::optional<boost::filesystem::path>&);
+    explicit BackendFactory(const boost::optional<boost::filesystem::path>&,
+                            UseSegmentLog = UseSegmentLog::F);
 
     ~BackendFactory();
 
@@ -45,6 +51,9 @@ private:
     boost::unique_lock<youtils::FileDescriptor> file_lock_;
 
     const boost::optional<boost::filesystem::path> root_;
+    const UseSegmentLog use_segment_log_;
+    // shared by all SegmentLogBackends
+    std::unique_ptr<GroupCommitter> committer_;
 };
 
 }
@@ -30,8 +30,10 @@ using namespace fungi;
 #define LOCK()                                  \
     boost::lock_guard<decltype(mutex_)> lg_(mutex_)
 
-FailOverCacheAcceptor::FailOverCacheAcceptor(const boost::optional<fs::path>& path)
-    : factory_(path)
+FailOverCacheAcceptor::FailOverCacheAcceptor(const boost::optional<fs::path>& path,
+                                             UseSegmentLog use_segment_log)
+    : factory_(path,
+               use_segment_log)
 {}
 
 FailOverCacheAcceptor::~FailOverCacheAcceptor()
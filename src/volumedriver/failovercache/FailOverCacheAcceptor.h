@@ -42,7 +42,8 @@ class FailOverCacheAcceptor
     friend class volumedrivertest::FailOverCacheTestContext;
 
 public:
-    explicit FailOverCacheAcceptor(const boost::optional<boost::filesystem::path>& root);
+    explicit FailOverCacheAcceptor(const boost::optional<boost::filesystem::path>& root,
+                                   UseSegmentLog = UseSegmentLog::F);
 
     virtual ~FailOverCacheAcceptor();
 
@@ -0,0 +1,1141 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Backend.h"
+#include "FailOverCacheAcceptor.h"
+#include "FailOverCacheEventServer.h"
+
+#include "../FailOverCacheStreamers.h"
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <boost/optional/optional_io.hpp>
+
+#include <snappy.h>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/IOException.h>
+#include <youtils/SharedMemoryRegion.h>
+
+namespace failovercache
+{
+
+namespace vd = volumedriver;
+namespace yt = youtils;
+
+#define LOCK_CONNECTIONS()                                      \
+    boost::lock_guard<decltype(connections_lock_)> lgc__(connections_lock_)
+
+namespace
+{
+
+// Upper bound for a single request - a sanity check against garbage on the
+// wire rather than a protocol limit. AddEntries requests are bounded by the
+// client's batch size which is nowhere near this.
+const uint32_t max_request_size = 256U << 20;
+
+// Replies are written synchronously by the worker; give up on clients that do
+// not drain their socket within this period.
+const int send_timeout_ms = 30000;
+
+// Decodes the fields of a request chunk in place. The encoding matches what
+// fungi::IOBaseStream produces: native byte order, strings and byte arrays
+// prefixed with an int64 length.
+class ChunkReader
+{
+public:
+    ChunkReader(const uint8_t* buf,
+                size_t size)
+        : pos_(buf)
+        , end_(buf + size)
+    {}
+
+    template<typename T>
+    T
+    get()
+    {
+        T t;
+        memcpy(&t, bytes(sizeof(T)), sizeof(T));
+        return t;
+    }
+
+    const uint8_t*
+    bytes(size_t n)
+    {
+        if (static_cast<size_t>(end_ - pos_) < n)
+        {
+            throw fungi::IOException("DTL request truncated");
+        }
+
+        const uint8_t* p = pos_;
+        pos_ += n;
+        return p;
+    }
+
+    size_t
+    remaining() const
+    {
+        return end_ - pos_;
+    }
+
+    std::string
+    string()
+    {
+        const int64_t len = get<int64_t>();
+        if (len < 0)
+        {
+            throw fungi::IOException("DTL request contains invalid string");
+        }
+
+        const char* p = reinterpret_cast<const char*>(bytes(len));
+        return std::string(p, len);
+    }
+
+    vd::SCO
+    sco()
+    {
+        const auto version = get<uint8_t>();
+        const auto number = get<uint32_t>();
+        const auto clone_id = get<uint8_t>();
+
+        return vd::SCO(number,
+                       vd::SCOCloneID(clone_id),
+                       vd::SCOVersion(version));
+    }
+
+    vd::ClusterLocation
+    cluster_location()
+    {
+        const auto offset = get<uint16_t>();
+        return vd::ClusterLocation(sco(),
+                                   offset);
+    }
+
+private:
+    const uint8_t* pos_;
+    const uint8_t* const end_;
+};
+
+// Encoded size of an entry header: cluster location + lba + size.
+const size_t entry_header_size = 8 + sizeof(uint64_t) + sizeof(int64_t);
+
+// The checks below guard against garbage sent by a peer, which must only cost
+// that peer its connection (cf. FailOverCacheEventServer::serve_) instead of
+// taking down the DTL of all volumes served by this process.
+uint64_t
+entry_count(ChunkReader& r)
+{
+    const auto count = r.get<uint64_t>();
+    if (count > r.remaining() / entry_header_size)
+    {
+        throw fungi::IOException("DTL request has invalid entry count");
+    }
+
+    return count;
+}
+
+void
+check_entry_size(int64_t size,
+                 uint64_t cluster_size)
+{
+    if (size <= 0 or static_cast<uint64_t>(size) != cluster_size)
+    {
+        throw fungi::IOException("DTL entry has invalid size");
+    }
+}
+
+void
+check_single_sco(const std::vector<vd::FailOverCacheEntry>& entries)
+{
+    if (not entries.empty() and
+        entries.front().cli_.sco() != entries.back().cli_.sco())
+    {
+        throw fungi::IOException("DTL entries span multiple SCOs");
+    }
+}
+
+// Counterpart of ChunkReader for replies: builds a complete length-prefixed
+// chunk in memory which is then sent in one go.
+class ChunkWriter
+{
+public:
+    explicit ChunkWriter(std::vector<uint8_t>& buf)
+        : buf_(buf)
+    {
+        buf_.clear();
+        buf_.resize(sizeof(uint32_t));
+    }
+
+    template<typename T>
+    void
+    put(const T& t)
+    {
+        append(&t, sizeof(T));
+    }
+
+    void
+    append(const void* p,
+           size_t size)
+    {
+        const size_t off = buf_.size();
+        buf_.resize(off + size);
+        memcpy(buf_.data() + off, p, size);
+    }
+
+    void
+    sco(const vd::SCO& sco)
+    {
+        put<uint8_t>(sco.version());
+        put<uint32_t>(sco.number());
+        put<uint8_t>(sco.cloneID());
+    }
+
+    void
+    cluster_location(const vd::ClusterLocation& loc)
+    {
+        put<uint16_t>(loc.offset());
+        sco(loc.sco());
+    }
+
+    const std::vector<uint8_t>&
+    finish()
+    {
+        const uint32_t len = buf_.size() - sizeof(uint32_t);
+        memcpy(buf_.data(), &len, sizeof(len));
+        return buf_;
+    }
+
+private:
+    std::vector<uint8_t>& buf_;
+};
+
+}
+
+struct FailOverCacheEventServer::Connection
+{
+    explicit Connection(int f)
+        : fd(f)
+    {}
+
+    ~Connection()
+    {
+        ::close(fd);
+    }
+
+    Connection(const Connection&) = delete;
+
+    Connection&
+    operator=(const Connection&) = delete;
+
+    const int fd;
+    std::shared_ptr<Backend> cache;
+    std::unique_ptr<yt::SharedMemoryRegion> shmem;
+    bool compression = false;
+
+    uint8_t header[sizeof(uint32_t)];
+    size_t header_off = 0;
+
+    std::unique_ptr<uint8_t[]> body;
+    size_t body_size = 0;
+    size_t body_off = 0;
+
+    std::vector<uint8_t> out;
+
+    void
+    reset_request()
+    {
+        header_off = 0;
+        body = nullptr;
+        body_size = 0;
+        body_off = 0;
+    }
+
+    void
+    send(const std::vector<uint8_t>& buf)
+    {
+        size_t off = 0;
+        while (off < buf.size())
+        {
+            const ssize_t ret = ::send(fd,
+                                       buf.data() + off,
+                                       buf.size() - off,
+                                       MSG_NOSIGNAL);
+            if (ret >= 0)
+            {
+                off += ret;
+            }
+            else if (errno == EAGAIN or errno == EWOULDBLOCK)
+            {
+                struct pollfd pfd;
+                pfd.fd = fd;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+
+                const int res = ::poll(&pfd, 1, send_timeout_ms);
+                if (res == 0)
+                {
+                    throw fungi::IOException("timeout sending DTL reply");
+                }
+                else if (res < 0 and errno != EINTR)
+                {
+                    throw fungi::IOException("failed to poll DTL connection",
+                                             "",
+                                             errno);
+                }
+            }
+            else if (errno != EINTR)
+            {
+                throw fungi::IOException("failed to send DTL reply",
+                                         "",
+                                         errno);
+            }
+        }
+    }
+
+    void
+    reply(vd::FailOverCacheCommand com)
+    {
+        ChunkWriter w(out);
+        w.put<uint32_t>(com);
+        send(w.finish());
+    }
+};
+
+constexpr size_t FailOverCacheEventServer::default_workers;
+
+FailOverCacheEventServer::FailOverCacheEventServer(FailOverCacheAcceptor& acceptor,
+                                                   const boost::optional<std::string>& addr,
+                                                   uint16_t port,
+                                                   size_t nworkers)
+    : acceptor_(acceptor)
+    , server_socket_(fungi::Socket::createSocket(false))
+    , epoll_fd_(-1)
+    , event_fd_(-1)
+    , stop_(false)
+{
+    VERIFY(nworkers > 0);
+
+    server_socket_->setName("DtlEventServer");
+    server_socket_->bind(addr,
+                         port);
+    server_socket_->listen();
+    server_socket_->setNonBlocking();
+
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0)
+    {
+        throw fungi::IOException("failed to create epoll instance",
+                                 "",
+                                 errno);
+    }
+
+    event_fd_ = ::eventfd(0, EFD_CLOEXEC bitor EFD_NONBLOCK);
+    if (event_fd_ < 0)
+    {
+        ::close(epoll_fd_);
+        throw fungi::IOException("failed to create eventfd",
+                                 "",
+                                 errno);
+    }
+
+    try
+    {
+        // Level triggered and not one-shot: once signalled every worker
+        // gets to see it.
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &event_fd_;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev) < 0)
+        {
+            throw fungi::IOException("failed to register eventfd",
+                                     "",
+                                     errno);
+        }
+
+        arm_(server_socket_->fileno(),
+             nullptr,
+             EPOLL_CTL_ADD);
+
+        workers_.reserve(nworkers);
+        for (size_t i = 0; i < nworkers; ++i)
+        {
+            workers_.emplace_back([this]
+                                  {
+                                      work_();
+                                  });
+        }
+    }
+    catch (...)
+    {
+        stop();
+        join();
+        ::close(event_fd_);
+        ::close(epoll_fd_);
+        throw;
+    }
+
+    LOG_INFO("listening on " << addr << ":" << port << " with " <<
+             nworkers << " worker threads");
+}
+
+FailOverCacheEventServer::~FailOverCacheEventServer()
+{
+    try
+    {
+        stop();
+        join();
+    }
+    CATCH_STD_ALL_LOG_IGNORE("failed to stop DTL event server");
+
+    {
+        LOCK_CONNECTIONS();
+        connections_.clear();
+    }
+
+    ::close(event_fd_);
+    ::close(epoll_fd_);
+}
+
+void
+FailOverCacheEventServer::stop()
+{
+    stop_ = true;
+
+    const uint64_t one = 1;
+    const ssize_t ret = ::write(event_fd_, &one, sizeof(one));
+    if (ret < 0)
+    {
+        LOG_ERROR("Failed to send stop request to workers: " << strerror(errno));
+    }
+}
+
+void
+FailOverCacheEventServer::join()
+{
+    for (auto& t : workers_)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+}
+
+size_t
+FailOverCacheEventServer::connections() const
+{
+    LOCK_CONNECTIONS();
+    return connections_.size();
+}
+
+void
+FailOverCacheEventServer::arm_(int fd,
+                               void* data,
+                               int op)
+{
+    struct epoll_event ev;
+    ev.events = EPOLLIN bitor EPOLLRDHUP bitor EPOLLONESHOT;
+    ev.data.ptr = data;
+
+    if (::epoll_ctl(epoll_fd_, op, fd, &ev) < 0)
+    {
+        throw fungi::IOException("failed to (re)arm epoll for fd",
+                                 "",
+                                 errno);
+    }
+}
+
+void
+FailOverCacheEventServer::work_()
+{
+    while (not stop_)
+    {
+        struct epoll_event ev;
+        const int ret = ::epoll_wait(epoll_fd_, &ev, 1, -1);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            else
+            {
+                LOG_ERROR("epoll_wait failed: " << strerror(errno) <<
+                          " - exiting worker");
+                break;
+            }
+        }
+        else if (ret == 0)
+        {
+            continue;
+        }
+        else if (ev.data.ptr == &event_fd_)
+        {
+            break;
+        }
+        else if (ev.data.ptr == nullptr)
+        {
+            accept_();
+        }
+        else
+        {
+            serve_(*static_cast<Connection*>(ev.data.ptr));
+        }
+    }
+}
+
+void
+FailOverCacheEventServer::accept_()
+{
+    while (true)
+    {
+        const int fd = ::accept4(server_socket_->fileno(),
+                                 nullptr,
+                                 nullptr,
+                                 SOCK_NONBLOCK bitor SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR or errno == ECONNABORTED or errno == EPROTO)
+            {
+                continue;
+            }
+            else if (errno != EAGAIN and errno != EWOULDBLOCK)
+            {
+                LOG_ERROR("Failed to accept new connection: " << strerror(errno));
+            }
+            break;
+        }
+
+        try
+        {
+            auto conn(std::make_shared<Connection>(fd));
+
+            {
+                LOCK_CONNECTIONS();
+                const auto res(connections_.emplace(fd,
+                                                    conn));
+                VERIFY(res.second);
+            }
+
+            try
+            {
+                arm_(fd,
+                     conn.get(),
+                     EPOLL_CTL_ADD);
+            }
+            catch (...)
+            {
+                LOCK_CONNECTIONS();
+                connections_.erase(fd);
+                throw;
+            }
+
+            LOG_INFO("Connected, fd " << fd);
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to set up new connection");
+    }
+
+    try
+    {
+        arm_(server_socket_->fileno(),
+             nullptr,
+             EPOLL_CTL_MOD);
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_FATAL("Failed to re-arm listening socket: " << EWHAT <<
+                      " - no new connections will be accepted");
+        });
+}
+
+void
+FailOverCacheEventServer::drop_(Connection& conn)
+{
+    if (conn.cache)
+    {
+        LOG_INFO("Exiting cache server for namespace: " << conn.cache->getNamespace());
+    }
+    else
+    {
+        LOG_INFO("Exiting cache server before even registering, probably framework ping");
+    }
+
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+
+    LOCK_CONNECTIONS();
+    connections_.erase(conn.fd);
+}
+
+void
+FailOverCacheEventServer::serve_(Connection& conn)
+{
+    try
+    {
+        while (read_(conn))
+        {
+            dispatch_(conn);
+            conn.reset_request();
+
+            if (stop_)
+            {
+                return;
+            }
+        }
+
+        arm_(conn.fd,
+             &conn,
+             EPOLL_CTL_MOD);
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_INFO("Dropping connection, fd " << conn.fd << ": " << EWHAT);
+            drop_(conn);
+        });
+}
+
+// Returns true if a complete request is available, false if the socket was
+// drained before that. Throws if the connection was closed or broke.
+bool
+FailOverCacheEventServer::read_(Connection& conn)
+{
+    while (true)
+    {
+        uint8_t* dst;
+        size_t len;
+
+        if (conn.header_off < sizeof(conn.header))
+        {
+            dst = conn.header + conn.header_off;
+            len = sizeof(conn.header) - conn.header_off;
+        }
+        else
+        {
+            if (conn.body == nullptr)
+            {
+                uint32_t size;
+                memcpy(&size, conn.header, sizeof(size));
+
+                if (size < sizeof(uint32_t) or size > max_request_size)
+                {
+                    throw fungi::IOException("DTL request has invalid size");
+                }
+
+                conn.body_size = size;
+                conn.body_off = 0;
+                conn.body = std::make_unique<uint8_t[]>(size);
+            }
+
+            if (conn.body_off == conn.body_size)
+            {
+                return true;
+            }
+
+            dst = conn.body.get() + conn.body_off;
+            len = conn.body_size - conn.body_off;
+        }
+
+        const ssize_t ret = ::read(conn.fd, dst, len);
+        if (ret > 0)
+        {
+            if (conn.header_off < sizeof(conn.header))
+            {
+                conn.header_off += ret;
+            }
+            else
+            {
+                conn.body_off += ret;
+            }
+        }
+        else if (ret == 0)
+        {
+            throw fungi::IOException("connection closed by peer");
+        }
+        else if (errno == EAGAIN or errno == EWOULDBLOCK)
+        {
+            return false;
+        }
+        else if (errno != EINTR)
+        {
+            throw fungi::IOException("failed to read from DTL connection",
+                                     "",
+                                     errno);
+        }
+    }
+}
+
+void
+FailOverCacheEventServer::dispatch_(Connection& conn)
+{
+    ChunkReader r(conn.body.get(),
+                  conn.body_size);
+    const auto com = r.get<uint32_t>();
+
+    if (com != vd::Register and not conn.cache)
+    {
+        throw fungi::IOException("DTL request before Register");
+    }
+
+    try
+    {
+        switch (com)
+        {
+        case vd::Register:
+            LOG_TRACE("Executing Register");
+            register_(conn);
+            break;
+        case vd::Unregister:
+            LOG_TRACE("Executing Unregister");
+            unregister_(conn);
+            break;
+        case vd::AddEntries:
+            LOG_TRACE("Executing AddEntries");
+            add_entries_(conn);
+            break;
+        case vd::AttachSharedMemory:
+            LOG_TRACE("Executing AttachSharedMemory");
+            attach_shared_memory_(conn);
+            break;
+        case vd::AddEntriesShared:
+            LOG_TRACE("Executing AddEntriesShared");
+            add_entries_shared_(conn);
+            break;
+        case vd::EnableCompression:
+            LOG_TRACE("Executing EnableCompression");
+            enable_compression_(conn);
+            break;
+        case vd::AddEntriesCompressed:
+            LOG_TRACE("Executing AddEntriesCompressed");
+            add_entries_compressed_(conn);
+            break;
+        case vd::GetEntries:
+            LOG_TRACE("Executing GetEntries");
+            get_entries_(conn,
+                         boost::none);
+            break;
+        case vd::GetSCO:
+            LOG_TRACE("Executing GetSCO");
+            get_entries_(conn,
+                         r.sco());
+            break;
+        case vd::Flush:
+            LOG_TRACE("Flushing for namespace " << conn.cache->getNamespace());
+            conn.cache->flush();
+            conn.reply(vd::Ok);
+            break;
+        case vd::Clear:
+            LOG_INFO("Clearing for namespace " << conn.cache->getNamespace());
+            conn.cache->clear();
+            conn.reply(vd::Ok);
+            break;
+        case vd::GetSCORange:
+            LOG_TRACE("Executing GetSCORange");
+            get_sco_range_(conn);
+            break;
+        case vd::RemoveUpTo:
+            LOG_TRACE("Executing RemoveUpTo");
+            remove_up_to_(conn);
+            break;
+        default:
+            LOG_ERROR("Invalid command " << com);
+            throw fungi::IOException("no valid command");
+        }
+    }
+    catch (...)
+    {
+        try
+        {
+            conn.reply(vd::NotOk);
+        }
+        CATCH_STD_ALL_LOG_IGNORE("Failed to send NotOk");
+        throw;
+    }
+}
+
+void
+FailOverCacheEventServer::register_(Connection& conn)
+{
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    vd::CommandData<vd::Register> data;
+    data.ns_ = r.string();
+    data.clustersize_ = vd::ClusterSize(r.get<uint32_t>());
+
+    LOG_INFO("Registering namespace " << data.ns_);
+    conn.cache = acceptor_.lookup(data);
+    if (not conn.cache)
+    {
+        conn.reply(vd::NotOk);
+    }
+    else
+    {
+        VERIFY(conn.cache->registered());
+        conn.reply(vd::Ok);
+    }
+}
+
+void
+FailOverCacheEventServer::unregister_(Connection& conn)
+{
+    LOG_INFO("Unregistering namespace " << conn.cache->getNamespace());
+    try
+    {
+        acceptor_.remove(*conn.cache);
+        conn.cache = nullptr;
+    }
+    catch (...)
+    {
+        conn.reply(vd::NotOk);
+        return;
+    }
+
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::add_entries_(Connection& conn)
+{
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const auto count = entry_count(r);
+
+    std::vector<vd::FailOverCacheEntry> entries;
+    entries.reserve(count);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const vd::ClusterLocation loc(r.cluster_location());
+        const auto lba = r.get<uint64_t>();
+        const auto size = r.get<int64_t>();
+
+        check_entry_size(size,
+                         conn.cache->cluster_size());
+
+        entries.emplace_back(loc,
+                             lba,
+                             r.bytes(size),
+                             size);
+    }
+
+    check_single_sco(entries);
+
+    if (not entries.empty())
+    {
+        // The entries point into the request buffer, which is handed over
+        // to the backend as is.
+        conn.cache->addEntries(std::move(entries),
+                               std::move(conn.body));
+    }
+
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::attach_shared_memory_(Connection& conn)
+{
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const yt::SharedMemoryRegionId id(r.get<uint64_t>());
+    const auto cookie = r.get<uint64_t>();
+    const auto size = r.get<uint64_t>();
+
+    std::unique_ptr<yt::SharedMemoryRegion> region;
+
+    try
+    {
+        region = std::make_unique<yt::SharedMemoryRegion>(id);
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_INFO(conn.cache->getNamespace() <<
+                     ": cannot open shared memory region " << id << ": " << EWHAT);
+            conn.reply(vd::NotOk);
+            return;
+        });
+
+    uint64_t c = 0;
+    if (region->size() >= sizeof(c))
+    {
+        memcpy(&c,
+               region->address(),
+               sizeof(c));
+    }
+
+    if (c != cookie or
+        region->size() != size or
+        size <= vd::dtl_shmem_header_size)
+    {
+        LOG_INFO(conn.cache->getNamespace() <<
+                 ": shared memory region " << id <<
+                 " does not match the client's - not on the same host?");
+        conn.reply(vd::NotOk);
+        return;
+    }
+
+    LOG_INFO(conn.cache->getNamespace() << ": attached to shared memory region " <<
+             id << ", size " << size);
+
+    conn.shmem = std::move(region);
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::add_entries_shared_(Connection& conn)
+{
+    if (conn.shmem == nullptr)
+    {
+        throw fungi::IOException("AddEntriesShared without shared memory region");
+    }
+
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const auto count = entry_count(r);
+    const auto off = r.get<uint64_t>();
+    const uint64_t csize = conn.cache->cluster_size();
+    const uint64_t area = conn.shmem->size() - vd::dtl_shmem_header_size;
+
+    if (count > area / csize or
+        off > area - count * csize)
+    {
+        throw fungi::IOException("AddEntriesShared exceeds shared memory region");
+    }
+
+    // The entries point straight into the region: the client only reuses
+    // that memory once the request is acknowledged, i.e. after addEntries
+    // returned. Backends that keep the data around copy it themselves.
+    const uint8_t* data = static_cast<const uint8_t*>(conn.shmem->address()) +
+        vd::dtl_shmem_header_size + off;
+
+    std::vector<vd::FailOverCacheEntry> entries;
+    entries.reserve(count);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const vd::ClusterLocation loc(r.cluster_location());
+        const auto lba = r.get<uint64_t>();
+        const auto size = r.get<int64_t>();
+
+        check_entry_size(size,
+                         csize);
+
+        entries.emplace_back(loc,
+                             lba,
+                             data + i * csize,
+                             size);
+    }
+
+    check_single_sco(entries);
+
+    if (not entries.empty())
+    {
+        conn.cache->addEntries(std::move(entries),
+                               nullptr);
+    }
+
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::enable_compression_(Connection& conn)
+{
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const auto codec = r.get<uint32_t>();
+    if (codec != vd::dtl_compression_snappy)
+    {
+        LOG_WARN(conn.cache->getNamespace() <<
+                 ": unsupported compression codec " << codec);
+        conn.reply(vd::NotOk);
+        return;
+    }
+
+    LOG_INFO(conn.cache->getNamespace() << ": enabling compression");
+    conn.compression = true;
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::add_entries_compressed_(Connection& conn)
+{
+    if (not conn.compression)
+    {
+        throw fungi::IOException("AddEntriesCompressed without EnableCompression");
+    }
+
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const auto count = entry_count(r);
+    const uint64_t csize = conn.cache->cluster_size();
+
+    std::vector<vd::FailOverCacheEntry> entries;
+    entries.reserve(count);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const vd::ClusterLocation loc(r.cluster_location());
+        const auto lba = r.get<uint64_t>();
+        const auto size = r.get<int64_t>();
+
+        check_entry_size(size,
+                         csize);
+
+        // filled in once decompressed
+        entries.emplace_back(loc,
+                             lba,
+                             nullptr,
+                             size);
+    }
+
+    const auto raw_size = r.get<uint64_t>();
+    const auto size = r.get<int64_t>();
+
+    // snappy cannot do better than ~1:22
+    if (raw_size != count * csize or
+        size <= 0 or
+        raw_size / 32 > static_cast<uint64_t>(size))
+    {
+        throw fungi::IOException("AddEntriesCompressed with invalid sizes");
+    }
+
+    const char* data = reinterpret_cast<const char*>(r.bytes(size));
+
+    size_t n = 0;
+    if (not snappy::GetUncompressedLength(data,
+                                          size,
+                                          &n) or
+        n != raw_size)
+    {
+        throw fungi::IOException("AddEntriesCompressed with invalid compressed data");
+    }
+
+    std::unique_ptr<uint8_t[]> buf(std::make_unique<uint8_t[]>(raw_size));
+    if (not snappy::RawUncompress(data,
+                                  size,
+                                  reinterpret_cast<char*>(buf.get())))
+    {
+        throw fungi::IOException("AddEntriesCompressed: failed to decompress");
+    }
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        entries[i].buffer_ = buf.get() + i * csize;
+    }
+
+    check_single_sco(entries);
+
+    if (not entries.empty())
+    {
+        conn.cache->addEntries(std::move(entries),
+                               std::move(buf));
+    }
+
+    conn.reply(vd::Ok);
+}
+
+void
+FailOverCacheEventServer::get_entries_(Connection& conn,
+                                       const boost::optional<vd::SCO>& sco)
+{
+    LOG_INFO("Namespace " << conn.cache->getNamespace() << ", SCO " << sco);
+
+    ChunkWriter w(conn.out);
+
+    auto fun([&](vd::ClusterLocation loc,
+                 int64_t lba,
+                 const uint8_t* buf,
+                 int64_t size)
+             {
+                 LOG_TRACE("Sending Entry for lba " << lba);
+                 w.cluster_location(loc);
+                 w.put<int64_t>(lba);
+                 w.put<int64_t>(size);
+                 w.append(buf, size);
+             });
+
+    try
+    {
+        if (sco)
+        {
+            conn.cache->getSCO(*sco,
+                               std::move(fun));
+        }
+        else
+        {
+            conn.cache->getEntries(std::move(fun));
+        }
+    }
+    CATCH_STD_ALL_LOG_IGNORE(conn.cache->getNamespace() <<
+                             ": failed to retrieve entries");
+
+    // the end marker is always sent, even if retrieving entries failed
+    w.cluster_location(vd::ClusterLocation());
+    conn.send(w.finish());
+}
+
+void
+FailOverCacheEventServer::get_sco_range_(Connection& conn)
+{
+    LOG_INFO("Namespace " << conn.cache->getNamespace());
+
+    vd::SCO oldest;
+    vd::SCO youngest;
+    conn.cache->getSCORange(oldest,
+                            youngest);
+
+    ChunkWriter w(conn.out);
+    w.sco(oldest);
+    w.sco(youngest);
+    conn.send(w.finish());
+}
+
+void
+FailOverCacheEventServer::remove_up_to_(Connection& conn)
+{
+    ChunkReader r(conn.body.get() + sizeof(uint32_t),
+                  conn.body_size - sizeof(uint32_t));
+
+    const vd::SCO sco(r.sco());
+
+    LOG_INFO("Namespace " << conn.cache->getNamespace());
+
+    try
+    {
+        conn.cache->removeUpTo(sco);
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_ERROR(conn.cache->getNamespace() <<
+                      ": caught exception removing SCOs up to " <<
+                      sco << ": " << EWHAT);
+            conn.reply(vd::NotOk);
+            return;
+        });
+
+    conn.reply(vd::Ok);
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
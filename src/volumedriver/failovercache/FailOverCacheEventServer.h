@@ -0,0 +1,162 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DTL_EVENT_SERVER_H_
+#define DTL_EVENT_SERVER_H_
+
+#include "fungilib/Socket.h"
+
+#include "../ClusterLocation.h"
+#include "../SCO.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace failovercache
+{
+
+class Backend;
+class FailOverCacheAcceptor;
+
+// Event driven replacement for fungi::SocketServer + FailOverCacheProtocol
+// (one thread per connection) for the TCP transport:
+// * all connections are multiplexed over a single epoll instance that is
+//   shared by a small pool of worker threads
+// * connections are registered with EPOLLONESHOT, hence a connection is only
+//   ever served by one worker at a time and requests on a connection are
+//   processed in order
+// * a request (one corked chunk on the wire) is read into a single buffer and
+//   decoded in place - AddEntries hands that buffer over to the Backend without
+//   copying the cluster data again.
+// The wire format is unchanged, so existing clients talk to it as before.
+// Clients on the same host can additionally pass the cluster data through
+// shared memory (AttachSharedMemory / AddEntriesShared - the requests and
+// replies still go through the socket), and remote ones can
+// ask for the cluster data to be sent compressed (EnableCompression /
+// AddEntriesCompressed) - decompression happens on the worker.
+// RSocket does not support epoll and hence still uses the thread-per-connection
+// server.
+class FailOverCacheEventServer
+{
+public:
+    FailOverCacheEventServer(FailOverCacheAcceptor&,
+                             const boost::optional<std::string>& addr,
+                             uint16_t port,
+                             size_t nworkers = default_workers);
+
+    ~FailOverCacheEventServer();
+
+    FailOverCacheEventServer(const FailOverCacheEventServer&) = delete;
+
+    FailOverCacheEventServer&
+    operator=(const FailOverCacheEventServer&) = delete;
+
+    void
+    stop();
+
+    void
+    join();
+
+    size_t
+    connections() const;
+
+    static constexpr size_t default_workers = 4;
+
+private:
+    DECLARE_LOGGER("DtlEventServer");
+
+    struct Connection;
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    FailOverCacheAcceptor& acceptor_;
+    std::unique_ptr<fungi::Socket> server_socket_;
+    int epoll_fd_;
+    int event_fd_;
+    std::atomic<bool> stop_;
+
+    mutable boost::mutex connections_lock_;
+    std::unordered_map<int, ConnectionPtr> connections_;
+
+    std::vector<std::thread> workers_;
+
+    void
+    work_();
+
+    void
+    accept_();
+
+    void
+    serve_(Connection&);
+
+    bool
+    read_(Connection&);
+
+    void
+    dispatch_(Connection&);
+
+    void
+    arm_(int fd,
+         void* data,
+         int op);
+
+    void
+    drop_(Connection&);
+
+    void
+    register_(Connection&);
+
+    void
+    unregister_(Connection&);
+
+    void
+    add_entries_(Connection&);
+
+    void
+    attach_shared_memory_(Connection&);
+
+    void
+    add_entries_shared_(Connection&);
+
+    void
+    enable_compression_(Connection&);
+
+    void
+    add_entries_compressed_(Connection&);
+
+    void
+    get_entries_(Connection&,
+                 const boost::optional<volumedriver::SCO>&);
+
+    void
+    get_sco_range_(Connection&);
+
+    void
+    remove_up_to_(Connection&);
+};
+
+}
+
+#endif // !DTL_EVENT_SERVER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
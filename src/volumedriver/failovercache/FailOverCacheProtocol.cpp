@@ -24,10 +24,13 @@
 
 #include <cerrno>
 #include <cstring>
+#include <limits>
 
 #include <rdma/rdma_cma.h>
 #include <rdma/rsocket.h>
 
+#include <snappy.h>
+
 #include <youtils/Assert.h>
 #include <youtils/ScopeExit.h>
 
@@ -44,6 +47,7 @@ FailOverCacheProtocol::FailOverCacheProtocol(std::unique_ptr<fungi::Socket> sock
     , stream_(*sock_)
     , fact_(fact)
     , use_rs_(sock_->isRdma())
+    , compression_(false)
 {
     if(pipe(pipes_) != 0)
     {
@@ -192,6 +196,21 @@ FailOverCacheProtocol::run()
                 removeUpTo_();
                 LOG_TRACE("Finished RemoveUpTo");
 
+                break;
+            case volumedriver::AttachSharedMemory:
+                LOG_TRACE("Executing AttachSharedMemory");
+                attachSharedMemory_();
+                LOG_TRACE("Finished AttachSharedMemory");
+                break;
+            case volumedriver::EnableCompression:
+                LOG_TRACE("Executing EnableCompression");
+                enableCompression_();
+                LOG_TRACE("Finished EnableCompression");
+                break;
+            case volumedriver::AddEntriesCompressed:
+                LOG_TRACE("Executing AddEntriesCompressed");
+                addEntriesCompressed_();
+                LOG_TRACE("Finished AddEntriesCompressed");
                 break;
             default:
                 LOG_ERROR("DEFAULT BRANCH IN SWITCH...");
@@ -279,6 +298,138 @@ FailOverCacheProtocol::addEntries_()
     returnOk();
 }
 
+void
+FailOverCacheProtocol::attachSharedMemory_()
+{
+    uint64_t id;
+    uint64_t cookie;
+    uint64_t size;
+
+    stream_ >> id;
+    stream_ >> cookie;
+    stream_ >> size;
+
+    // Only the TCP server (FailOverCacheEventServer) supports shared memory.
+    LOG_INFO("Declining shared memory region " << id);
+    returnNotOk();
+}
+
+void
+FailOverCacheProtocol::enableCompression_()
+{
+    VERIFY(cache_);
+
+    uint32_t codec;
+    stream_ >> codec;
+
+    if (codec == volumedriver::dtl_compression_snappy)
+    {
+        LOG_INFO(cache_->getNamespace() << ": enabling compression");
+        compression_ = true;
+        returnOk();
+    }
+    else
+    {
+        LOG_WARN(cache_->getNamespace() << ": unsupported compression codec " <<
+                 codec);
+        returnNotOk();
+    }
+}
+
+void
+FailOverCacheProtocol::addEntriesCompressed_()
+{
+    VERIFY(cache_);
+
+    if (not compression_)
+    {
+        throw fungi::IOException("AddEntriesCompressed without EnableCompression");
+    }
+
+    const uint64_t csize = cache_->cluster_size();
+
+    uint64_t count;
+    stream_ >> count;
+
+    std::vector<volumedriver::ClusterLocation> locs;
+    std::vector<uint64_t> lbas;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        volumedriver::ClusterLocation cli;
+        stream_ >> cli;
+
+        uint64_t lba;
+        stream_ >> lba;
+
+        int64_t size;
+        stream_ >> size;
+
+        VERIFY(static_cast<uint64_t>(size) == csize);
+
+        locs.push_back(cli);
+        lbas.push_back(lba);
+    }
+
+    uint64_t raw_size;
+    stream_ >> raw_size;
+
+    int64_t size;
+    stream_ >> size;
+
+    // snappy cannot do better than ~1:22
+    if (raw_size != count * csize or
+        size <= 0 or
+        raw_size / 32 > static_cast<uint64_t>(size) or
+        size > std::numeric_limits<int32_t>::max())
+    {
+        throw fungi::IOException("AddEntriesCompressed with invalid sizes");
+    }
+
+    std::vector<uint8_t> compressed(size);
+    stream_.read(compressed.data(),
+                 size);
+
+    const char* data = reinterpret_cast<const char*>(compressed.data());
+
+    size_t n = 0;
+    if (not snappy::GetUncompressedLength(data,
+                                          compressed.size(),
+                                          &n) or
+        n != raw_size)
+    {
+        throw fungi::IOException("AddEntriesCompressed with invalid compressed data");
+    }
+
+    std::unique_ptr<uint8_t[]> buf(std::make_unique<uint8_t[]>(raw_size));
+    if (not snappy::RawUncompress(data,
+                                  compressed.size(),
+                                  reinterpret_cast<char*>(buf.get())))
+    {
+        throw fungi::IOException("AddEntriesCompressed: failed to decompress");
+    }
+
+    if (count > 0)
+    {
+        std::vector<volumedriver::FailOverCacheEntry> entries;
+        entries.reserve(count);
+
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            entries.emplace_back(locs[i],
+                                 lbas[i],
+                                 buf.get() + i * csize,
+                                 csize);
+        }
+
+        VERIFY(entries.front().cli_.sco() == entries.back().cli_.sco());
+        cache_->addEntries(std::move(entries),
+                           std::move(buf));
+    }
+
+    returnOk();
+}
+
 void
 FailOverCacheProtocol::returnOk()
 {
@@ -64,6 +64,7 @@ private:
 
     FailOverCacheAcceptor& fact_;
     bool use_rs_;
+    bool compression_;
 
     int pipes_[2];
     int nfds_;
@@ -101,6 +102,15 @@ private:
     void
     removeUpTo_();
 
+    void
+    attachSharedMemory_();
+
+    void
+    enableCompression_();
+
+    void
+    addEntriesCompressed_();
+
     void
     processFailOverCacheEntry_(volumedriver::ClusterLocation cli,
                                int64_t lba,
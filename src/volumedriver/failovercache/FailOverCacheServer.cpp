@@ -43,9 +43,14 @@ FailOverCacheServer::FailOverCacheServer(const constructor_type& c)
         ("port",
          po::value<uint16_t>(&port_)->default_value(23096),
          "port of the failovercache server")
+        ("workers",
+         po::value<size_t>(&workers_)->default_value(failovercache::FailOverCacheEventServer::default_workers),
+         "number of worker threads serving TCP connections")
         ("transport",
          po::value<vd::FailOverCacheTransport>(&transport_)->default_value(transport_),
          "transport type of the failovercache server (TCP|RSocket)")
+        ("segment-log",
+         "use a log of preallocated segments with group committed syncs instead of one file per SCO (requires --path)")
         ("daemonize,D",
          "run as a daemon");
 }
@@ -120,21 +125,47 @@ FailOverCacheServer::run()
               ", port: " << port_ <<
               ", transport type: " << transport_);
 
-    acceptor = std::make_unique<failovercache::FailOverCacheAcceptor>(path);
+    const failovercache::UseSegmentLog use_segment_log =
+        vm_.count("segment-log") ?
+        failovercache::UseSegmentLog::T :
+        failovercache::UseSegmentLog::F;
 
-    LOG_INFO("Running the SocketServer");
+    acceptor = std::make_unique<failovercache::FailOverCacheAcceptor>(path,
+                                                                      use_segment_log);
 
-    s = fungi::SocketServer::createSocketServer(*acceptor,
-                                                addr,
-                                                port_,
-                                                transport_ == vd::FailOverCacheTransport::RSocket);
-    running_ = true;
+    if (transport_ == vd::FailOverCacheTransport::RSocket)
+    {
+        LOG_INFO("Running the SocketServer");
+
+        s = fungi::SocketServer::createSocketServer(*acceptor,
+                                                    addr,
+                                                    port_,
+                                                    true);
+        running_ = true;
+
+        LOG_INFO("Waiting for the SocketServer");
+        s->join();
 
-    LOG_INFO("Waiting for the SocketServer");
-    s->join();
+        LOG_INFO("Exiting SocketServer");
+        s.reset();
+    }
+    else
+    {
+        LOG_INFO("Running the event server with " << workers_ << " workers");
 
-    LOG_INFO("Exiting SocketServer");
-    s.reset();
+        event_server_ =
+            std::make_unique<failovercache::FailOverCacheEventServer>(*acceptor,
+                                                                      addr,
+                                                                      port_,
+                                                                      workers_);
+        running_ = true;
+
+        LOG_INFO("Waiting for the event server");
+        event_server_->join();
+
+        LOG_INFO("Exiting event server");
+        event_server_.reset();
+    }
 
     return 0;
 }
@@ -155,6 +186,10 @@ FailOverCacheServer::stop_()
         // fungi::SocketServer::stop() is protected against multiple invocations
         // s = 0;
     }
+    else if (event_server_)
+    {
+        event_server_->stop();
+    }
     else
     {
         LOG_INFO("No socket server");
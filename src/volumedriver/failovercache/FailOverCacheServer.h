@@ -16,6 +16,7 @@
 #define FAILOVERCACHE_SERVER_H_
 
 #include "FailOverCacheAcceptor.h"
+#include "FailOverCacheEventServer.h"
 
 #include "../FailOverCacheTransport.h"
 
@@ -68,6 +69,7 @@ private:
     static youtils::Logger::logger_type* logger_;
 
     std::unique_ptr<fungi::SocketServer> s;
+    std::unique_ptr<failovercache::FailOverCacheEventServer> event_server_;
     std::unique_ptr<failovercache::FailOverCacheAcceptor> acceptor;
 
     boost::program_options::options_description desc_;
@@ -75,6 +77,7 @@ private:
     boost::filesystem::path path_;
     std::string addr_;
     uint16_t port_;
+    size_t workers_;
     volumedriver::FailOverCacheTransport transport_;
     bool running_;
 
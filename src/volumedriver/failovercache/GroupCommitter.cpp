@@ -0,0 +1,99 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "GroupCommitter.h"
+
+#include <youtils/Catchers.h>
+#include <youtils/IOException.h>
+
+namespace failovercache
+{
+
+namespace yt = youtils;
+
+void
+GroupCommitter::sync(yt::FileDescriptor& fd)
+{
+    boost::unique_lock<decltype(lock_)> u(lock_);
+
+    // references to unordered_map elements survive rehashing
+    File& file = files_[&fd];
+    ++file.waiters;
+
+    if (not file.collecting)
+    {
+        file.collecting = std::make_shared<Round>();
+    }
+
+    const RoundPtr round(file.collecting);
+
+    while (not round->done)
+    {
+        if (file.syncing)
+        {
+            cond_.wait(u);
+            continue;
+        }
+
+        // Become the leader for the round: everyone who queued up so far is
+        // covered by it, later callers start a new one.
+        file.collecting.reset();
+        file.syncing = true;
+        ++rounds_;
+
+        u.unlock();
+
+        boost::optional<std::string> error;
+
+        try
+        {
+            fd.sync();
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR("Failed to sync " << fd.path() << ": " << EWHAT);
+                error = EWHAT;
+            });
+
+        u.lock();
+
+        round->error = std::move(error);
+        round->done = true;
+        file.syncing = false;
+        cond_.notify_all();
+    }
+
+    if (--file.waiters == 0)
+    {
+        files_.erase(&fd);
+    }
+
+    if (round->error)
+    {
+        throw fungi::IOException("failed to sync DTL segment",
+                                 round->error->c_str());
+    }
+}
+
+uint64_t
+GroupCommitter::rounds() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return rounds_;
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,94 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DTL_GROUP_COMMITTER_H_
+#define DTL_GROUP_COMMITTER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/FileDescriptor.h>
+#include <youtils/Logging.h>
+
+namespace failovercache
+{
+
+// Batches fdatasync requests of concurrent callers: callers that want the same
+// file synced while a sync of it is already in progress queue up, and the first
+// of them to run once it finished syncs the file on behalf of all of them
+// (one fdatasync per round instead of one per caller).
+// Different files (i.e. namespaces, as each has its own segment log) are
+// synced concurrently, each by one of its own callers - there is no dedicated
+// sync thread, and a slow or failing file does not hold up the others.
+// Errors are only reported to the callers whose round failed.
+class GroupCommitter
+{
+public:
+    GroupCommitter() = default;
+
+    ~GroupCommitter() = default;
+
+    GroupCommitter(const GroupCommitter&) = delete;
+
+    GroupCommitter&
+    operator=(const GroupCommitter&) = delete;
+
+    // Returns once the data written to the file so far is on stable storage.
+    // The caller must keep the FileDescriptor alive until this returns.
+    void
+    sync(youtils::FileDescriptor&);
+
+    // Number of fdatasyncs issued so far.
+    uint64_t
+    rounds() const;
+
+private:
+    DECLARE_LOGGER("DtlGroupCommitter");
+
+    struct Round
+    {
+        bool done = false;
+        boost::optional<std::string> error;
+    };
+
+    using RoundPtr = std::shared_ptr<Round>;
+
+    struct File
+    {
+        // round that new requests are queued in
+        RoundPtr collecting;
+        bool syncing = false;
+        size_t waiters = 0;
+    };
+
+    mutable boost::mutex lock_;
+    boost::condition_variable cond_;
+
+    std::unordered_map<youtils::FileDescriptor*, File> files_;
+    uint64_t rounds_ = 0;
+};
+
+}
+
+#endif // !DTL_GROUP_COMMITTER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -14,6 +14,8 @@
 
 #include "MemoryBackend.h"
 
+#include <cstring>
+
 namespace failovercache
 {
 
@@ -49,6 +51,25 @@ MemoryBackend::add_entries(std::vector<vd::FailOverCacheEntry> entries,
 {
     VERIFY(current_);
 
+    if (not buf)
+    {
+        size_t size = 0;
+        for (const auto& e : entries)
+        {
+            size += e.size_;
+        }
+
+        buf = std::make_unique<uint8_t[]>(size);
+        uint8_t* dst = buf.get();
+
+        for (auto& e : entries)
+        {
+            memcpy(dst, e.buffer_, e.size_);
+            e.buffer_ = dst;
+            dst += e.size_;
+        }
+    }
+
     const size_t cap = current_->capacity();
     const size_t size = current_->size();
 
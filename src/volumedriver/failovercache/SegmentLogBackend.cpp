@@ -0,0 +1,407 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "GroupCommitter.h"
+#include "SegmentLogBackend.h"
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+
+namespace failovercache
+{
+
+namespace fs = boost::filesystem;
+namespace vd = volumedriver;
+namespace yt = youtils;
+
+namespace
+{
+
+const uint32_t record_magic = 0x44544c52; // "DTLR"
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t count;
+    uint32_t cluster_size;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) == 16,
+              "unexpected RecordHeader size");
+
+struct EntryHeader
+{
+    vd::ClusterLocation loc;
+    uint64_t lba;
+};
+
+static_assert(sizeof(EntryHeader) == 16,
+              "unexpected EntryHeader size");
+
+// upper bound for a single read when replaying a SCO
+const size_t max_read_size = 1ULL << 20;
+
+}
+
+constexpr uint64_t SegmentLogBackend::default_segment_size;
+constexpr size_t SegmentLogBackend::max_spare_segments;
+
+SegmentLogBackend::Segment::Segment(const fs::path& p,
+                                    uint64_t sz)
+    : path(p)
+    , size(sz)
+    , fd(p,
+         yt::FDMode::ReadWrite,
+         CreateIfNecessary::T,
+         SyncOnCloseAndDestructor::F)
+    , live_entries(0)
+{
+    fd.fallocate(size);
+}
+
+SegmentLogBackend::Segment::~Segment()
+{
+    try
+    {
+        fs::remove(path);
+    }
+    CATCH_STD_ALL_LOG_IGNORE("failed to remove " << path);
+}
+
+SegmentLogBackend::SegmentLogBackend(const fs::path& root,
+                                     const std::string& nspace,
+                                     const vd::ClusterSize cluster_size,
+                                     GroupCommitter& committer,
+                                     uint64_t segment_size)
+    : Backend(nspace,
+              cluster_size)
+    , root_(root / nspace)
+    , committer_(committer)
+    , segment_size_(segment_size)
+    , next_segment_(0)
+    , next_file_(0)
+    , write_offset_(0)
+{
+    VERIFY(segment_size_ > 0);
+
+    LOG_INFO("creating " << root_ << ", segment size " << segment_size_);
+    fs::create_directories(root_);
+}
+
+SegmentLogBackend::~SegmentLogBackend()
+{
+    LOG_INFO("removing " << root_);
+
+    index_.clear();
+    segments_.clear();
+    spare_.clear();
+
+    try
+    {
+        fs::remove_all(root_);
+    }
+    CATCH_STD_ALL_LOG_IGNORE(getNamespace() << ": failed to remove " << root_);
+}
+
+void
+SegmentLogBackend::open(const vd::SCO sco)
+{
+    LOG_INFO(getNamespace() << ": opening " << sco);
+
+    const auto res(index_.emplace(sco,
+                                  std::vector<Location>()));
+    VERIFY(res.second);
+}
+
+void
+SegmentLogBackend::close()
+{
+    // Nothing to do - the next SCO is simply appended to the current segment.
+}
+
+SegmentLogBackend::Segment&
+SegmentLogBackend::segment_for_(uint64_t size)
+{
+    if (not segments_.empty())
+    {
+        Segment& current = *segments_.rbegin()->second;
+        if (write_offset_ + size <= current.size)
+        {
+            return current;
+        }
+    }
+
+    SegmentPtr seg;
+
+    if (not spare_.empty() and spare_.back()->size >= size)
+    {
+        seg = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    else
+    {
+        const fs::path p(root_ / ("segment_" +
+                                  boost::lexical_cast<std::string>(next_file_++)));
+        seg = std::make_unique<Segment>(p,
+                                        std::max(segment_size_,
+                                                 size));
+    }
+
+    boost::optional<uint64_t> prev;
+    if (not segments_.empty())
+    {
+        prev = segments_.rbegin()->first;
+    }
+
+    const uint64_t id = next_segment_++;
+    LOG_INFO(getNamespace() << ": starting segment " << id << " in " << seg->path);
+
+    Segment& s = *seg;
+    segments_.emplace(id,
+                      std::move(seg));
+    write_offset_ = 0;
+
+    if (prev and segments_[*prev]->live_entries == 0)
+    {
+        release_(*prev);
+    }
+
+    return s;
+}
+
+void
+SegmentLogBackend::release_(uint64_t id)
+{
+    VERIFY(not segments_.empty());
+    VERIFY(id != segments_.rbegin()->first);
+
+    auto it = segments_.find(id);
+    VERIFY(it != segments_.end());
+    VERIFY(it->second->live_entries == 0);
+
+    LOG_INFO(getNamespace() << ": releasing segment " << id);
+
+    SegmentPtr seg(std::move(it->second));
+    segments_.erase(it);
+    dirty_.erase(id);
+
+    if (spare_.size() < max_spare_segments and
+        seg->size == segment_size_)
+    {
+        spare_.emplace_back(std::move(seg));
+    }
+}
+
+void
+SegmentLogBackend::add_entries(std::vector<vd::FailOverCacheEntry> entries,
+                               std::unique_ptr<uint8_t[]> /* buf */)
+{
+    VERIFY(not entries.empty());
+
+    const vd::SCO sco(entries.front().cli_.sco());
+    auto idx = index_.find(sco);
+    VERIFY(idx != index_.end());
+
+    const uint64_t csize = cluster_size();
+    const size_t count = entries.size();
+
+    std::vector<uint8_t> hdr(sizeof(RecordHeader) + count * sizeof(EntryHeader));
+
+    RecordHeader* rh = reinterpret_cast<RecordHeader*>(hdr.data());
+    rh->magic = record_magic;
+    rh->count = count;
+    rh->cluster_size = csize;
+    rh->reserved = 0;
+
+    EntryHeader* eh = reinterpret_cast<EntryHeader*>(hdr.data() + sizeof(RecordHeader));
+
+    std::vector<struct iovec> iov;
+    iov.reserve(count + 1);
+    iov.push_back({ hdr.data(), hdr.size() });
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const vd::FailOverCacheEntry& e = entries[i];
+        VERIFY(e.size_ == csize);
+
+        eh[i].loc = e.cli_;
+        eh[i].lba = e.lba_;
+
+        uint8_t* p = const_cast<uint8_t*>(e.buffer_);
+        struct iovec& prev = iov.back();
+
+        if (iov.size() > 1 and
+            static_cast<uint8_t*>(prev.iov_base) + prev.iov_len == p)
+        {
+            prev.iov_len += e.size_;
+        }
+        else
+        {
+            iov.push_back({ p, e.size_ });
+        }
+    }
+
+    const uint64_t size = hdr.size() + count * csize;
+    Segment& seg = segment_for_(size);
+    const uint64_t id = segments_.rbegin()->first;
+    const uint64_t off = write_offset_;
+
+    uint64_t pos = off;
+    for (size_t i = 0; i < iov.size(); i += IOV_MAX)
+    {
+        const size_t n = std::min<size_t>(IOV_MAX,
+                                          iov.size() - i);
+        pos += seg.fd.pwritev(&iov[i],
+                              n,
+                              pos);
+    }
+
+    VERIFY(pos == off + size);
+
+    std::vector<Location>& locs = idx->second;
+    locs.reserve(locs.size() + count);
+
+    const uint64_t data_off = off + hdr.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        locs.push_back(Location{ id,
+                                 data_off + i * csize,
+                                 entries[i].cli_,
+                                 entries[i].lba_ });
+    }
+
+    seg.live_entries += count;
+    write_offset_ += size;
+    dirty_.insert(id);
+}
+
+void
+SegmentLogBackend::flush()
+{
+    while (not dirty_.empty())
+    {
+        const uint64_t id = *dirty_.begin();
+        auto it = segments_.find(id);
+        VERIFY(it != segments_.end());
+
+        committer_.sync(it->second->fd);
+        dirty_.erase(id);
+    }
+}
+
+void
+SegmentLogBackend::remove(const vd::SCO sco)
+{
+    LOG_INFO(getNamespace() << ": removing " << sco);
+
+    auto idx = index_.find(sco);
+    if (idx == index_.end())
+    {
+        return;
+    }
+
+    std::set<uint64_t> touched;
+
+    for (const auto& l : idx->second)
+    {
+        auto it = segments_.find(l.segment);
+        VERIFY(it != segments_.end());
+        VERIFY(it->second->live_entries > 0);
+
+        --it->second->live_entries;
+        touched.insert(l.segment);
+    }
+
+    index_.erase(idx);
+
+    for (const auto id : touched)
+    {
+        if (id != segments_.rbegin()->first and
+            segments_[id]->live_entries == 0)
+        {
+            release_(id);
+        }
+    }
+}
+
+void
+SegmentLogBackend::get_entries(const vd::SCO sco,
+                               Backend::EntryProcessorFun& fun)
+{
+    LOG_INFO(getNamespace() << ": processing SCO " << sco);
+
+    auto idx = index_.find(sco);
+    if (idx == index_.end())
+    {
+        return;
+    }
+
+    const std::vector<Location>& locs = idx->second;
+    const size_t csize = cluster_size();
+    const size_t max_clusters = std::max<size_t>(1,
+                                                 max_read_size / csize);
+
+    std::vector<uint8_t> buf(max_clusters * csize);
+
+    size_t i = 0;
+    while (i < locs.size())
+    {
+        // coalesce entries that are adjacent in the log into a single read
+        size_t n = 1;
+        while (i + n < locs.size() and
+               n < max_clusters and
+               locs[i + n].segment == locs[i].segment and
+               locs[i + n].offset == locs[i].offset + n * csize)
+        {
+            ++n;
+        }
+
+        auto it = segments_.find(locs[i].segment);
+        VERIFY(it != segments_.end());
+
+        const size_t res = it->second->fd.pread(buf.data(),
+                                                n * csize,
+                                                locs[i].offset);
+        VERIFY(res == n * csize);
+
+        for (size_t j = 0; j < n; ++j)
+        {
+            const Location& l = locs[i + j];
+
+            LOG_DEBUG(getNamespace() << ": sending entry " << l.loc <<
+                      ", lba " << l.lba);
+
+            fun(l.loc,
+                l.lba,
+                buf.data() + j * csize,
+                csize);
+        }
+
+        i += n;
+    }
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,156 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DTL_SEGMENT_LOG_BACKEND_H_
+#define DTL_SEGMENT_LOG_BACKEND_H_
+
+#include "Backend.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <youtils/FileDescriptor.h>
+
+namespace failovercache
+{
+
+class GroupCommitter;
+
+// Log structured alternative to FileBackend: instead of one append file per SCO
+// all entries of a namespace go to a log of preallocated segment files.
+// * each AddEntries batch is written with a single pwritev
+// * flush() does an fdatasync through the GroupCommitter shared by all
+//   namespaces: concurrent flushes of a segment share one, those of different
+//   namespaces run in parallel
+// * an in-memory index maps SCOs to their entries in the log; segments without
+//   live entries (after removeUpTo / clear) are recycled as a whole.
+// The log is not meant to survive a restart of the DTL server (which wipes its
+// directory anyway), but the records are self describing for forensics:
+//   RecordHeader | count * EntryHeader | count * cluster data
+class SegmentLogBackend
+    : public Backend
+{
+public:
+    SegmentLogBackend(const boost::filesystem::path&,
+                      const std::string&,
+                      const volumedriver::ClusterSize,
+                      GroupCommitter&,
+                      uint64_t segment_size = default_segment_size);
+
+    ~SegmentLogBackend();
+
+    SegmentLogBackend(const SegmentLogBackend&) = delete;
+
+    SegmentLogBackend&
+    operator=(const SegmentLogBackend&) = delete;
+
+    virtual void
+    open(const volumedriver::SCO) override final;
+
+    virtual void
+    close() override final;
+
+    virtual void
+    add_entries(std::vector<volumedriver::FailOverCacheEntry>,
+                std::unique_ptr<uint8_t[]>) override final;
+
+    virtual void
+    flush() override final;
+
+    virtual void
+    remove(const volumedriver::SCO) override final;
+
+    virtual void
+    get_entries(const volumedriver::SCO,
+                Backend::EntryProcessorFun&) override final;
+
+    const boost::filesystem::path&
+    root() const
+    {
+        return root_;
+    }
+
+    size_t
+    segments() const
+    {
+        return segments_.size();
+    }
+
+    static constexpr uint64_t default_segment_size = 64ULL << 20;
+    static constexpr size_t max_spare_segments = 2;
+
+private:
+    DECLARE_LOGGER("DtlSegmentLogBackend");
+
+    struct Segment
+    {
+        Segment(const boost::filesystem::path&,
+                uint64_t size);
+
+        ~Segment();
+
+        Segment(const Segment&) = delete;
+
+        Segment&
+        operator=(const Segment&) = delete;
+
+        const boost::filesystem::path path;
+        const uint64_t size;
+        youtils::FileDescriptor fd;
+        size_t live_entries;
+    };
+
+    using SegmentPtr = std::unique_ptr<Segment>;
+
+    struct Location
+    {
+        uint64_t segment;
+        uint64_t offset;
+        volumedriver::ClusterLocation loc;
+        uint64_t lba;
+    };
+
+    const boost::filesystem::path root_;
+    GroupCommitter& committer_;
+    const uint64_t segment_size_;
+
+    // keyed by a monotonically increasing segment number, the last one is
+    // the one being written to
+    std::map<uint64_t, SegmentPtr> segments_;
+    std::vector<SegmentPtr> spare_;
+    uint64_t next_segment_;
+    uint64_t next_file_;
+    uint64_t write_offset_;
+    std::set<uint64_t> dirty_;
+
+    std::map<volumedriver::SCO, std::vector<Location>> index_;
+
+    Segment&
+    segment_for_(uint64_t size);
+
+    void
+    release_(uint64_t segment);
+};
+
+}
+
+#endif // !DTL_SEGMENT_LOG_BACKEND_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -58,6 +58,11 @@ public:
         return mySink_.write(buf, n);
     }
 
+    /** @exception IOException */
+    void writev(const struct iovec *iov, int iovcnt) {
+        mySink_.writev(iov, iovcnt);
+    }
+
     void close() {
         mySink_.close();
     }
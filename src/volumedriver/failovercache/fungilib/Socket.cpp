@@ -31,12 +31,14 @@
 // #endif
 
 #include <sys/time.h>
+#include <climits>
 #include <cstring>
 #include <cassert>
 #include <limits>
 #include <sstream>
 #include <iostream>
 #include <poll.h>
+#include <vector>
 
 #include <sys/sendfile.h>
 
@@ -247,6 +249,57 @@ int Socket::fileno() const {
 	return sock_;
 }
 
+void Socket::writev(const struct iovec *iov, int iovcnt) {
+    VERIFY(not corked_);
+
+    if (use_rs_)
+    {
+        Streamable::writev(iov, iovcnt);
+        return;
+    }
+
+    // sendmsg updates neither the iovecs nor the count, so work on a copy
+    // that is advanced past what was sent already.
+    std::vector<struct iovec> vec(iov, iov + iovcnt);
+    size_t idx = 0;
+
+    while (idx < vec.size())
+    {
+        if (nonblocking_ || requestTimeout_ > 0) {
+            wait_for_write();
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec.data() + idx;
+        msg.msg_iovlen = std::min<size_t>(vec.size() - idx, IOV_MAX);
+
+        const ssize_t s = ::sendmsg(sock_, &msg, 0);
+        if (s < 0)
+        {
+            const int err = getErrorNumber();
+            if (err == EAGAIN || err == EINTR) {
+                continue;
+            }
+            LOG_DEBUG("sendmsg error < 0, other error");
+            throw IOException("Socket::writev", "", err);
+        }
+
+        size_t left = s;
+        while (idx < vec.size() && left >= vec[idx].iov_len)
+        {
+            left -= vec[idx].iov_len;
+            ++idx;
+        }
+
+        if (left > 0)
+        {
+            vec[idx].iov_base = static_cast<byte*>(vec[idx].iov_base) + left;
+            vec[idx].iov_len -= left;
+        }
+    }
+}
+
 void Socket::setCork() {
     corked_ = true;
     if (!use_rs_) { // only read-ahead in TCP
@@ -109,6 +109,13 @@ public:
     /** @exception IOException */
     int32_t write(const byte *buf, int32_t n);
 
+    /** @exception IOException
+     * Sends the buffers with sendmsg(2) instead of copying them into the
+     * cork buffer first. Must not be called while corked; the caller has to
+     * do the framing (see clearCork) itself.
+     */
+    void writev(const struct iovec *iov, int iovcnt) override;
+
     /** @exception IOException */
     void setCork();
 
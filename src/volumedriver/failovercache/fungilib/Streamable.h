@@ -16,6 +16,9 @@
 #define STREAMABLE_H_
 
 #include "defines.h"
+
+#include <sys/uio.h>
+
 #include <youtils/Logging.h>
 
 namespace fungi {
@@ -26,6 +29,18 @@ public:
     virtual	int32_t read(byte *buf, int32_t n) = 0;
     /** @exception IOException */
     virtual int32_t write(const byte *buf, int32_t n) = 0;
+    /** @exception IOException
+     * Scatter-gather write of iovcnt buffers; implementations that can hand
+     * them to the kernel in one go are expected to override this.
+     */
+    virtual void writev(const struct iovec *iov, int iovcnt)
+    {
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            write(static_cast<const byte*>(iov[i].iov_base),
+                  static_cast<int32_t>(iov[i].iov_len));
+        }
+    }
     /** @exception IOException */
     virtual void setCork() = 0;
     /** @exception IOException */
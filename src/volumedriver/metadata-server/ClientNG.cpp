@@ -17,12 +17,16 @@
 
 #include "../MDSNodeConfig.h"
 
+#include <algorithm>
+
 #include <boost/array.hpp>
 
 #include <capnp/message.h>
 #include <capnp/serialize.h>
 
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
 #include <youtils/SourceOfUncertainty.h>
 
 namespace metadata_server
@@ -246,6 +250,81 @@ struct TableHandle
         return num_tlogs;
     }
 
+    virtual void
+    set_replicas(const vd::MDSNodeConfigs& replicas) override final
+    {
+        auto b([&](mdsproto::Methods::SetReplicasParams::Builder& builder)
+               {
+                   // LOG_TRACE(nspace_ << ": building SetReplicas of size " << replicas.size());
+
+                   builder.setNspace(nspace_);
+
+                   size_t idx = 0;
+                   auto l = builder.initReplicas(replicas.size());
+
+                   for (const auto& r : replicas)
+                   {
+                       auto e = l[idx];
+                       e.setAddress(r.address());
+                       e.setPort(r.port());
+                       ++idx;
+                   }
+               });
+
+        auto r([&](mdsproto::Methods::SetReplicasResults::Reader&)
+               {
+                   // LOG_TRACE(nspace_ << ": reading SetReplicas results");
+               });
+
+        client_->interact_<mdsproto::RequestHeader::Type::SetReplicas>(std::move(b),
+                                                                       std::move(r));
+    }
+
+    virtual bool
+    replicate(const ReplicationHeader& hdr,
+              const Records& records,
+              Barrier barrier) override final
+    {
+        auto b([&](mdsproto::Methods::ReplicateParams::Builder& builder)
+               {
+                   // LOG_TRACE(nspace_ << ": building Replicate of size " << records.size() <<
+                   //           ", session " << hdr.session << ", seq " << hdr.seq);
+
+                   builder.setNspace(nspace_);
+                   builder.setSession(hdr.session.str());
+                   builder.setSeq(hdr.seq);
+                   builder.setBaseCork(hdr.base_cork ? *hdr.base_cork : std::string());
+                   builder.setCycleStart(hdr.cycle_start);
+                   builder.setBarrier(barrier == Barrier::T);
+
+                   size_t idx = 0;
+                   auto l = builder.initRecords(records.size());
+
+                   for (const auto& r : records)
+                   {
+                       auto e = l[idx];
+                       e.setKey(capnp::Data::Reader(static_cast<const kj::byte*>(r.key.data),
+                                                    r.key.size));
+                       e.setVal(capnp::Data::Reader(static_cast<const kj::byte*>(r.val.data),
+                                                    r.val.size));
+                       ++idx;
+                   }
+               });
+
+        bool applied = false;
+
+        auto r([&](mdsproto::Methods::ReplicateResults::Reader& reader)
+               {
+                   // LOG_TRACE(nspace_ << ": reading Replicate results");
+                   applied = reader.getApplied();
+               });
+
+        client_->interact_<mdsproto::RequestHeader::Type::Replicate>(std::move(b),
+                                                                     std::move(r));
+
+        return applied;
+    }
+
     virtual const std::string&
     nspace() const override final
     {
@@ -256,38 +335,75 @@ struct TableHandle
     ClientNG::Ptr client_;
 };
 
+struct ClientNG::Request
+{
+    explicit Request(mdsproto::Tag t)
+        : tag(t)
+    {}
+
+    const mdsproto::Tag tag;
+    std::unique_ptr<yt::SharedMemoryRegion> mr;
+    size_t txoff = 0;
+    mdsproto::ResponseHeader rxhdr;
+    std::vector<capnp::word> rxbuf;
+    bool done = false;
+};
+
 ClientNG::Ptr
 ClientNG::create(const vd::MDSNodeConfig& cfg,
                  size_t shmem_size,
                  const boost::optional<std::chrono::seconds>& timeout,
-                 ForceRemote force_remote)
+                 ForceRemote force_remote,
+                 size_t max_requests_in_flight)
 {
     return Ptr(new ClientNG(cfg,
                             shmem_size,
                             timeout,
-                            force_remote));
+                            force_remote,
+                            max_requests_in_flight));
 }
 
 ClientNG::ClientNG(const vd::MDSNodeConfig& cfg,
                    size_t shmem_size,
                    const boost::optional<std::chrono::seconds>& timeout,
-                   ForceRemote force_remote)
-    : client_(cfg.address(),
+                   ForceRemote force_remote,
+                   size_t max_requests_in_flight)
+    : send_done_(false)
+    , client_(cfg.address(),
               cfg.port(),
               timeout,
               force_remote)
-    , mr_(shmem_size ? new yt::SharedMemoryRegion(shmem_size) : nullptr)
+    , shmem_size_(shmem_size)
     , timeout_(timeout)
+    , max_requests_in_flight_(std::max<size_t>(max_requests_in_flight, 1))
+    , next_tag_(reinterpret_cast<uint64_t>(this))
+    , in_flight_(0)
 {
     LOG_INFO(this << ": " << cfg << ", shmem size " << shmem_size <<
              ", is local: " << client_.is_local() << ", timeout: " <<
              (timeout_ ? boost::lexical_cast<std::string>(timeout->count()) : "--") <<
-             " secs");
+             " secs, max requests in flight: " << max_requests_in_flight_);
+
+    // the io_service was already run to establish the connection
+    client_.io_service().reset();
+    recv_header_();
+
+    io_thread_ = boost::thread([this]
+                               {
+                                   run_();
+                               });
 }
 
 ClientNG::~ClientNG()
 {
     LOG_INFO(this << ": terminating");
+
+    try
+    {
+        client_.io_service().stop();
+        io_thread_.join();
+    }
+    CATCH_STD_ALL_LOG_IGNORE(this << ": failed to stop the io thread");
 }
 
 TableInterfacePtr
@@ -384,7 +500,263 @@ ClientNG::ping(const std::vector<uint8_t>& out,
 }
 
 void
-ClientNG::prepare_shmem_()
+ClientNG::run_()
+{
+    try
+    {
+        client_.io_service().run();
+        fail_(std::make_exception_ptr(fungi::IOException("MDS client was shut down")));
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_ERROR(this << ": connection failed: " << EWHAT);
+            fail_(std::current_exception());
+        });
+}
+
+// Marks the connection as unusable and wakes up everyone waiting for it.
+void
+ClientNG::fail_(std::exception_ptr e)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (error_ == nullptr)
+    {
+        error_ = e;
+    }
+
+    for (auto& p : pending_)
+    {
+        p.second->done = true;
+    }
+
+    client_.io_service().stop();
+    cond_.notify_all();
+}
+
+template<typename Pred>
+void
+ClientNG::wait_until_(boost::unique_lock<boost::mutex>& u,
+                      Pred&& pred,
+                      const char* what)
+{
+    if (timeout_)
+    {
+        const auto deadline(boost::chrono::steady_clock::now() +
+                            boost::chrono::seconds(timeout_->count()));
+
+        while (not pred())
+        {
+            if (cond_.wait_until(u, deadline) == boost::cv_status::timeout and
+                not pred())
+            {
+                LOG_ERROR(this << ": timeout waiting for " << what);
+                u.unlock();
+                // as before the connection is unusable after a timeout
+                fail_(std::make_exception_ptr(fungi::IOException("timeout waiting for MDS")));
+                u.lock();
+                return;
+            }
+        }
+    }
+    else
+    {
+        cond_.wait(u,
+                   std::move(pred));
+    }
+}
+
+ClientNG::RequestPtr
+ClientNG::start_request_()
+{
+    boost::unique_lock<decltype(lock_)> u(lock_);
+
+    wait_until_(u,
+                [&]() -> bool
+                {
+                    return error_ != nullptr or
+                        in_flight_ < max_requests_in_flight_;
+                },
+                "a request slot");
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+
+    auto req(std::make_shared<Request>(mdsproto::Tag(++next_tag_)));
+
+    if (use_shmem_())
+    {
+        if (regions_.empty())
+        {
+            req->mr = std::make_unique<yt::SharedMemoryRegion>(shmem_size_);
+        }
+        else
+        {
+            req->mr = std::move(regions_.back());
+            regions_.pop_back();
+        }
+    }
+
+    pending_.emplace(static_cast<uint64_t>(req->tag),
+                     req);
+    ++in_flight_;
+
+    return req;
+}
+
+void
+ClientNG::finish_request_(const RequestPtr& req)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    pending_.erase(static_cast<uint64_t>(req->tag));
+    --in_flight_;
+
+    // The server might still write to the region of a request that did not
+    // complete, so it's not reused.
+    if (req->mr and error_ == nullptr)
+    {
+        regions_.emplace_back(std::move(req->mr));
+    }
+
+    cond_.notify_all();
+}
+
+void
+ClientNG::wait_(Request& req)
+{
+    boost::unique_lock<decltype(lock_)> u(lock_);
+
+    wait_until_(u,
+                [&]() -> bool
+                {
+                    return req.done;
+                },
+                "a response");
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void
+ClientNG::complete_(const RequestPtr& req)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    req->done = true;
+    cond_.notify_all();
+}
+
+void
+ClientNG::recv_header_()
+{
+    client_.async_recv(ba::buffer(&rxhdr_,
+                                  sizeof(rxhdr_)),
+                       [this]
+                       {
+                           header_received_();
+                       });
+}
+
+void
+ClientNG::header_received_()
+{
+    if (rxhdr_.magic != mdsproto::magic)
+    {
+        LOG_ERROR("Response lacks our protocol magic, giving up");
+        throw mdsproto::NoMagicException("no magic key in received header");
+    }
+
+    // LOG_TRACE("received hdr " << rxhdr_.response_type <<
+    //           ", tag " << rxhdr_.tag <<
+    //           ", size " << rxhdr_.size <<
+    //           ", flags " << rxhdr_.flags);
+
+    const bool inband =
+        (rxhdr_.flags bitand mdsproto::ResponseHeader::Flags::UseShmem) == 0;
+
+    RequestPtr req;
+
+    {
+        boost::lock_guard<decltype(lock_)> g(lock_);
+
+        auto it = pending_.find(static_cast<uint64_t>(rxhdr_.tag));
+        if (it == pending_.end())
+        {
+            LOG_ERROR(this << ": response with unknown tag " << rxhdr_.tag);
+            throw fungi::IOException("MDS response with unknown tag");
+        }
+
+        req = it->second;
+
+        ++in_counters_.messages;
+        in_counters_.data_bytes += rxhdr_.size;
+        in_counters_.data_bytes_sqsum += rxhdr_.size * rxhdr_.size;
+
+        if (rxhdr_.size and inband and req->mr)
+        {
+            ++in_counters_.shmem_overruns;
+        }
+    }
+
+    req->rxhdr = rxhdr_;
+
+    if (rxhdr_.size and inband)
+    {
+        req->rxbuf.resize(rxhdr_.size / sizeof(capnp::word));
+        client_.async_recv(ba::buffer(req->rxbuf),
+                           [req, this]
+                           {
+                               complete_(req);
+                               recv_header_();
+                           });
+    }
+    else
+    {
+        complete_(req);
+        recv_header_();
+    }
+}
+
+template<typename BufferSequence>
+void
+ClientNG::send_(const BufferSequence& bufs)
+{
+    boost::lock_guard<decltype(send_lock_)> s(send_lock_);
+    boost::unique_lock<decltype(lock_)> u(lock_);
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+
+    send_done_ = false;
+
+    client_.async_send(bufs,
+                       [this]
+                       {
+                           boost::lock_guard<decltype(lock_)> g(lock_);
+                           send_done_ = true;
+                           cond_.notify_all();
+                       });
+
+    wait_until_(u,
+                [&]() -> bool
+                {
+                    return error_ != nullptr or send_done_;
+                },
+                "a request to be sent");
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void
+ClientNG::prepare_shmem_(yt::SharedMemoryRegion& mr)
 {
     // This is a serious performance hog, but Cap'n Proto shows all sorts of weird errors
     // (exceptions about missing \0-terminators of strings) when not doing it. Sigh.
@@ -392,27 +764,26 @@ ClientNG::prepare_shmem_()
     // the buffer to prevent information leaks in hostile environments this also punishes
     // those in a controlled environment, FFS!
 #if 1
-    if (mr_ != nullptr)
-    {
-        memset(mr_->address(),
-               0x0,
-               mr_->size());
-    }
+    memset(mr.address(),
+           0x0,
+           mr.size());
 #endif
 }
 
 template<enum metadata_server_protocol::RequestHeader::Type T,
          typename Build>
 size_t
-ClientNG::send_shmem_(mdsproto::Tag tag,
+ClientNG::send_shmem_(Request& req,
                       Build&& build)
 {
     using Traits = mdsproto::RequestTraits<T>;
 
-    prepare_shmem_();
+    yt::SharedMemoryRegion& mr = *req.mr;
+
+    prepare_shmem_(mr);
 
-    capnp::FlatMessageBuilder builder(kj::arrayPtr(static_cast<capnp::word*>(mr_->address()),
-                                                   mr_->size() / sizeof(capnp::word)));
+    capnp::FlatMessageBuilder builder(kj::arrayPtr(static_cast<capnp::word*>(mr.address()),
+                                                   mr.size() / sizeof(capnp::word)));
 
     auto root(builder.initRoot<typename Traits::Params>());
 
@@ -423,10 +794,10 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
 
     const mdsproto::RequestHeader hdr(Traits::request_type,
                                       size,
-                                      tag,
-                                      mr_->id(),
+                                      req.tag,
+                                      mr.id(),
                                       0,
-                                      mr_->id(),
+                                      mr.id(),
                                       size);
 
     // LOG_TRACE("sending " << hdr.request_type <<
@@ -435,9 +806,10 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
     //           ", out region " << hdr.out_region << ", off " << hdr.out_offset <<
     //           ", in region " << hdr.in_region << ", off " << hdr.in_offset);
 
-    client_.send(ba::buffer(&hdr,
-                            sizeof(hdr)),
-                 timeout_);
+    send_(ba::buffer(&hdr,
+                     sizeof(hdr)));
+
+    boost::lock_guard<decltype(lock_)> g(lock_);
 
     ++out_counters_.messages;
     out_counters_.data_bytes += size;
@@ -449,7 +821,7 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
 template<enum metadata_server_protocol::RequestHeader::Type T,
          typename Build>
 size_t
-ClientNG::send_inband_(mdsproto::Tag tag,
+ClientNG::send_inband_(Request& req,
                        Build&& build)
 {
     using Traits = mdsproto::RequestTraits<T>;
@@ -461,15 +833,18 @@ ClientNG::send_inband_(mdsproto::Tag tag,
 
     kj::Array<capnp::word> data(capnp::messageToFlatArray(builder));
 
-    prepare_shmem_();
+    if (req.mr)
+    {
+        prepare_shmem_(*req.mr);
+    }
 
     const mdsproto::RequestHeader hdr(Traits::request_type,
                                       data.size() * sizeof(capnp::word),
-                                      tag,
+                                      req.tag,
                                       yt::SharedMemoryRegionId(0),
                                       0,
-                                      use_shmem_() ?
-                                      mr_->id() :
+                                      req.mr ?
+                                      req.mr->id() :
                                       yt::SharedMemoryRegionId(0),
                                       0);
 
@@ -486,8 +861,9 @@ ClientNG::send_inband_(mdsproto::Tag tag,
     //           ", out region " << hdr.out_region << ", off " << hdr.out_offset <<
     //           ", in region " << hdr.in_region << ", off " << hdr.in_offset);
 
-    client_.send(bufs,
-                 timeout_);
+    send_(bufs);
+
+    boost::lock_guard<decltype(lock_)> g(lock_);
 
     ++out_counters_.messages;
     out_counters_.data_bytes += hdr.size;
@@ -503,99 +879,72 @@ void
 ClientNG::interact_(Build&& build,
                     Read&& read)
 {
-    boost::lock_guard<decltype(lock_)> g(lock_);
+    RequestPtr req(start_request_());
 
-    const mdsproto::Tag txtag(reinterpret_cast<uint64_t>(this));
+    auto on_exit(yt::make_scope_exit([&]
+                                     {
+                                         finish_request_(req);
+                                     }));
 
-    size_t txoff = 0;
-
-    bool use_shmem = use_shmem_();
+    bool use_shmem = req->mr != nullptr;
     if (use_shmem)
     {
         try
         {
-            txoff = send_shmem_<T>(txtag,
-                                    std::move(build));
+            req->txoff = send_shmem_<T>(*req,
+                                        std::move(build));
         }
         catch (kj::Exception& e)
         {
             LOG_ERROR("Failed to build shmem message " << e.getDescription().cStr() <<
                       " - falling back to socket");
-            ++out_counters_.shmem_overruns;
+            {
+                boost::lock_guard<decltype(lock_)> g(lock_);
+                ++out_counters_.shmem_overruns;
+            }
             use_shmem = false;
         }
     }
 
     if (not use_shmem)
     {
-        send_inband_<T>(txtag,
+        send_inband_<T>(*req,
                         std::move(build));
     }
 
-    recv_<T>(txtag,
-             txoff,
+    recv_<T>(*req,
              std::move(read));
 }
 
 template<enum mdsproto::RequestHeader::Type T,
          typename Read>
 void
-ClientNG::recv_(mdsproto::Tag txtag,
-                size_t txoff,
+ClientNG::recv_(Request& req,
                 Read&& read)
 {
-    mdsproto::ResponseHeader rxhdr;
+    wait_(req);
 
-    client_.recv(ba::buffer(&rxhdr,
-                            sizeof(rxhdr)),
-                 timeout_);
-
-    if (rxhdr.magic != mdsproto::magic)
-    {
-        LOG_ERROR("Response lacks our protocol magic, giving up");
-        throw mdsproto::NoMagicException("no magic key in received header");
-    }
-
-    // LOG_TRACE("received hdr " << rxhdr.response_type <<
-    //           ", tag " << rxhdr.tag <<
-    //           ", size " << rxhdr.size <<
-    //           ", flags " << rxhdr.flags);
-
-    TODO("AR: better exceptions");
-    THROW_WHEN(rxhdr.tag != txtag);
-
-    ++in_counters_.messages;
-    in_counters_.data_bytes += rxhdr.size;
-    in_counters_.data_bytes_sqsum += rxhdr.size * rxhdr.size;
+    const mdsproto::ResponseHeader& rxhdr = req.rxhdr;
 
     if (rxhdr.size)
     {
         if ((rxhdr.flags bitand mdsproto::ResponseHeader::Flags::UseShmem) == 0)
         {
-            if (use_shmem_())
-            {
-                ++in_counters_.shmem_overruns;
-            }
-
-            std::vector<capnp::word> rxbuf(rxhdr.size / sizeof(capnp::word));
-
-            client_.recv(ba::buffer(rxbuf),
-                         timeout_);
-
-            capnp::FlatArrayMessageReader reader(kj::arrayPtr(rxbuf.data(),
-                                                              rxbuf.size()));
+            capnp::FlatArrayMessageReader reader(kj::arrayPtr(req.rxbuf.data(),
+                                                              req.rxbuf.size()));
             handle_response_<T>(rxhdr,
                                 reader,
                                 std::move(read));
         }
         else
         {
-            THROW_UNLESS(use_shmem_());
+            THROW_UNLESS(req.mr != nullptr);
 
-            const uint8_t* addr = static_cast<const uint8_t*>(mr_->address()) + txoff;
+            const yt::SharedMemoryRegion& mr = *req.mr;
+            const uint8_t* addr = static_cast<const uint8_t*>(mr.address()) + req.txoff;
 
             THROW_UNLESS(addr + rxhdr.size <=
-                         static_cast<const uint8_t*>(mr_->address()) + mr_->size());
+                         static_cast<const uint8_t*>(mr.address()) + mr.size());
 
             auto seg(kj::arrayPtr(reinterpret_cast<const capnp::word*>(addr),
                                   rxhdr.size / sizeof(capnp::word)));
@@ -19,7 +19,10 @@
 #include "Protocol.h"
 
 #include <chrono>
+#include <exception>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -40,6 +43,11 @@ namespace metadata_server
 
 class TableHandle;
 
+// Requests are multiplexed over a single connection: callers build and send
+// their request (writes are serialized), and then wait for the response which
+// is matched by its tag by a dedicated thread that keeps reading from the
+// connection. Up to max_requests_in_flight requests can be outstanding; each
+// of them gets a shared memory region of its own if the server is local.
 class ClientNG
     : public DataBaseInterface
     , public std::enable_shared_from_this<ClientNG>
@@ -51,7 +59,8 @@ public:
     create(const volumedriver::MDSNodeConfig& cfg,
            size_t shmem_size = 8ULL << 10,
            const boost::optional<std::chrono::seconds>& timeout = boost::none,
-           ForceRemote force_remote = ForceRemote::F);
+           ForceRemote force_remote = ForceRemote::F,
+           size_t max_requests_in_flight = default_max_requests_in_flight);
 
     ~ClientNG();
 
@@ -101,38 +110,65 @@ public:
     counters(OutCounters& out,
              InCounters& in) const
     {
+        boost::lock_guard<decltype(lock_)> g(lock_);
         out = out_counters_;
         in = in_counters_;
     }
 
+    static constexpr size_t default_max_requests_in_flight = 8;
+
 private:
     DECLARE_LOGGER("MetaDataServerClientNG");
 
     friend class TableHandle;
 
-    boost::mutex lock_;
+    struct Request;
+    using RequestPtr = std::shared_ptr<Request>;
+
+    // protects everything below except for the client_ and the io thread,
+    // and is the mutex for cond_
+    mutable boost::mutex lock_;
+    boost::condition_variable cond_;
+    // serializes writes to the connection
+    boost::mutex send_lock_;
+    bool send_done_;
+
     youtils::LocORemClient client_;
-    std::unique_ptr<youtils::SharedMemoryRegion> mr_;
+    const size_t shmem_size_;
     const boost::optional<std::chrono::seconds> timeout_;
+    const size_t max_requests_in_flight_;
+
+    uint64_t next_tag_;
+    std::unordered_map<uint64_t, RequestPtr> pending_;
+    size_t in_flight_;
+    std::vector<std::unique_ptr<youtils::SharedMemoryRegion>> regions_;
+    // set once the connection is unusable
+    std::exception_ptr error_;
+
+    // only used by the io thread
+    metadata_server_protocol::ResponseHeader rxhdr_;
 
     OutCounters out_counters_;
     InCounters in_counters_;
 
+    boost::thread io_thread_;
+
     ClientNG(const volumedriver::MDSNodeConfig& cfg,
              size_t shmem_size,
              const boost::optional<std::chrono::seconds>& timeout,
-             ForceRemote force_remote);
+             ForceRemote force_remote,
+             size_t max_requests_in_flight);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Build>
     size_t
-    send_shmem_(metadata_server_protocol::Tag tag,
+    send_shmem_(Request&,
                 Build&& build);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Build>
     size_t
-    send_inband_(metadata_server_protocol::Tag tag,
+    send_inband_(Request&,
                  Build&& build);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
@@ -145,10 +181,43 @@ private:
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Read>
     void
-    recv_(metadata_server_protocol::Tag tag,
-          size_t txsize,
+    recv_(Request&,
           Read&&);
 
+    template<typename BufferSequence>
+    void
+    send_(const BufferSequence&);
+
+    RequestPtr
+    start_request_();
+
+    void
+    finish_request_(const RequestPtr&);
+
+    void
+    wait_(Request&);
+
+    void
+    run_();
+
+    void
+    recv_header_();
+
+    void
+    header_received_();
+
+    void
+    complete_(const RequestPtr&);
+
+    void
+    fail_(std::exception_ptr);
+
+    template<typename Pred>
+    void
+    wait_until_(boost::unique_lock<boost::mutex>&,
+                Pred&&,
+                const char* what);
+
     template<enum metadata_server_protocol::RequestHeader::Type T,
              typename Read>
     void
@@ -157,12 +226,12 @@ private:
                      Read&&);
 
     void
-    prepare_shmem_();
+    prepare_shmem_(youtils::SharedMemoryRegion&);
 
     bool
     use_shmem_() const
     {
-        return mr_ != nullptr and is_local();
+        return shmem_size_ != 0 and is_local();
     }
 };
 
@@ -24,7 +24,9 @@
 #include <boost/optional.hpp>
 
 #include <youtils/BooleanEnum.h>
+#include <youtils/UUID.h>
 
+#include <volumedriver/MDSNodeConfig.h>
 #include <volumedriver/ScrubId.h>
 #include <volumedriver/Types.h>
 
@@ -156,6 +158,24 @@ enum class Role
     Slave
 };
 
+// Streaming replication: a master forwards each batch it applied to its replicas,
+// tagged with
+// * session: identifies the master's incarnation - a new one is started whenever
+//   the table takes over the master role or is cleared
+// * seq: number of the batch within the session
+// * base_cork: the cork (if any) of the master before the batch was applied
+// * cycle_start: whether the batch is the first one after the cork was set.
+// A replica applies a batch if it directly follows the previously applied one of the
+// same session or, if it lost track, if it starts a cycle on top of the replica's own
+// cork. Otherwise it's up to the replica to catch up via the backend.
+struct ReplicationHeader
+{
+    youtils::UUID session;
+    uint64_t seq = 0;
+    boost::optional<std::string> base_cork;
+    bool cycle_start = false;
+};
+
 // A table represents a namespace within a database.
 //
 // This is modelled after RocksDB's API, which returns values as `std::string's.
@@ -215,6 +235,22 @@ public:
     virtual size_t
     catch_up(volumedriver::DryRun dry_run) = 0;
 
+    // Tables in master role stream their updates to the given replicas.
+    // default: no support for streaming replication.
+    virtual void
+    set_replicas(const volumedriver::MDSNodeConfigs&)
+    {}
+
+    // Apply a batch streamed by the master; returns whether it was applied.
+    // default: no support for streaming replication.
+    virtual bool
+    replicate(const ReplicationHeader&,
+              const Records&,
+              Barrier)
+    {
+        return false;
+    }
+
 private:
     Role role_ = Role::Slave;
 };
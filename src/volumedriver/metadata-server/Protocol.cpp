@@ -50,6 +50,8 @@ req_hdr_reminder(RequestHeader::Type t)
         C(Ping);
         C(ApplyRelocationLogs);
         C(CatchUp);
+        C(SetReplicas);
+        C(Replicate);
         // If the compiler yells at you that you've forgotten dealing with an enum
         // value chances are that it's also missing from the translations map below.
         // If so add it RIGHT NOW.
@@ -104,6 +106,8 @@ operator<<(std::ostream& os,
         P(Ping),
         P(ApplyRelocationLogs),
         P(CatchUp),
+        P(SetReplicas),
+        P(Replicate),
     };
 
 #undef P
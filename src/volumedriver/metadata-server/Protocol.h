@@ -68,6 +68,8 @@ struct RequestHeader
         Ping = 8,
         ApplyRelocationLogs = 9,
         CatchUp = 10,
+        SetReplicas = 11,
+        Replicate = 12,
     };
 
     RequestHeader() = default;
@@ -187,6 +189,8 @@ MAKE_REQUEST(Open);
 MAKE_REQUEST(Ping);
 MAKE_REQUEST(ApplyRelocationLogs);
 MAKE_REQUEST(CatchUp);
+MAKE_REQUEST(SetReplicas);
+MAKE_REQUEST(Replicate);
 
 #undef MAKE_REQUEST
 
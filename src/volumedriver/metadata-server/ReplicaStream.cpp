@@ -0,0 +1,255 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ClientNG.h"
+#include "ReplicaStream.h"
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/System.h>
+
+namespace metadata_server
+{
+
+namespace sc = std::chrono;
+namespace vd = volumedriver;
+namespace yt = youtils;
+
+#define LOCK()                                          \
+    boost::unique_lock<decltype(lock_)> lg__(lock_)
+
+namespace
+{
+
+const sc::seconds replication_timeout(10);
+const sc::seconds reconnect_delay(10);
+const size_t replication_shmem_size = 64ULL << 10;
+
+const size_t max_queued_bytes =
+    yt::System::get_env_with_default<size_t>("MDS_REPLICATION_QUEUE_BYTES",
+                                             32ULL << 20);
+
+}
+
+ReplicaStream::Ptr
+ReplicaStream::get(const vd::MDSNodeConfig& cfg)
+{
+    static boost::mutex lock;
+    static std::map<vd::MDSNodeConfig, std::weak_ptr<ReplicaStream>> streams;
+
+    boost::lock_guard<decltype(lock)> g(lock);
+
+    for (auto it = streams.begin(); it != streams.end();)
+    {
+        if (it->second.expired())
+        {
+            it = streams.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    Ptr stream(streams[cfg].lock());
+    if (stream == nullptr)
+    {
+        stream = Ptr(new ReplicaStream(cfg));
+        streams[cfg] = stream;
+    }
+
+    return stream;
+}
+
+ReplicaStream::ReplicaStream(const vd::MDSNodeConfig& cfg)
+    : config_(cfg)
+{
+    LOG_INFO(config_ << ": starting replication stream");
+    thread_ = boost::thread([this]
+                            {
+                                work_();
+                            });
+}
+
+ReplicaStream::~ReplicaStream()
+{
+    LOG_INFO(config_ << ": stopping replication stream");
+
+    try
+    {
+        {
+            LOCK();
+            stop_ = true;
+        }
+
+        cond_.notify_one();
+        thread_.join();
+    }
+    CATCH_STD_ALL_LOG_IGNORE(config_ << ": failed to stop replication stream");
+}
+
+bool
+ReplicaStream::enqueue(const std::string& nspace,
+                       const ReplicationHeader& hdr,
+                       const TableInterface::Records& records,
+                       Barrier barrier)
+{
+    Batch batch;
+    batch.nspace = nspace;
+    batch.header = hdr;
+    batch.barrier = barrier;
+    batch.size = 0;
+    batch.records.reserve(records.size());
+
+    for (const auto& r : records)
+    {
+        boost::optional<std::string> val;
+        if (r.val.data != nullptr)
+        {
+            val = std::string(static_cast<const char*>(r.val.data),
+                              r.val.size);
+        }
+
+        batch.records.emplace_back(std::string(static_cast<const char*>(r.key.data),
+                                               r.key.size),
+                                   std::move(val));
+        batch.size += r.key.size + r.val.size;
+    }
+
+    {
+        LOCK();
+
+        if (resyncing_.count(nspace) != 0)
+        {
+            if (not hdr.cycle_start)
+            {
+                return false;
+            }
+
+            resyncing_.erase(nspace);
+        }
+
+        if (queued_bytes_ + batch.size > max_queued_bytes and not queue_.empty())
+        {
+            LOG_WARN(nspace << ": replication queue to " << config_ <<
+                     " is full, dropping batch " << hdr.seq << " of session " <<
+                     hdr.session);
+            resyncing_.insert(nspace);
+            return false;
+        }
+
+        queued_bytes_ += batch.size;
+        queue_.emplace_back(std::move(batch));
+    }
+
+    cond_.notify_one();
+    return true;
+}
+
+void
+ReplicaStream::work_()
+{
+    while (true)
+    {
+        Batch batch;
+
+        {
+            LOCK();
+
+            cond_.wait(lg__,
+                       [&]
+                       {
+                           return stop_ or not queue_.empty();
+                       });
+
+            if (stop_)
+            {
+                return;
+            }
+
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+            queued_bytes_ -= batch.size;
+        }
+
+        try
+        {
+            send_(batch);
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_WARN(batch.nspace << ": failed to forward batch " <<
+                         batch.header.seq << " to " << config_ << ": " << EWHAT);
+                tables_.clear();
+                client_ = nullptr;
+                retry_after_ = sc::steady_clock::now() + reconnect_delay;
+                drop_(batch);
+            });
+    }
+}
+
+void
+ReplicaStream::send_(const Batch& batch)
+{
+    if (client_ == nullptr)
+    {
+        if (sc::steady_clock::now() < retry_after_)
+        {
+            drop_(batch);
+            return;
+        }
+
+        client_ = ClientNG::create(config_,
+                                   replication_shmem_size,
+                                   replication_timeout);
+    }
+
+    TableInterfacePtr& table = tables_[batch.nspace];
+    if (table == nullptr)
+    {
+        table = client_->open(batch.nspace);
+    }
+
+    TableInterface::Records records;
+    records.reserve(batch.records.size());
+
+    for (const auto& r : batch.records)
+    {
+        records.emplace_back(Key(r.first.data(),
+                                 r.first.size()),
+                             r.second ?
+                             Value(r.second->data(),
+                                   r.second->size()) :
+                             Value(nullptr,
+                                   0));
+    }
+
+    if (not table->replicate(batch.header,
+                             records,
+                             batch.barrier))
+    {
+        LOG_DEBUG(batch.nspace << ": " << config_ <<
+                  " did not apply batch " << batch.header.seq <<
+                  " of session " << batch.header.session <<
+                  " - it needs to catch up via the backend");
+    }
+}
+
+void
+ReplicaStream::drop_(const Batch& batch)
+{
+    LOCK();
+    resyncing_.insert(batch.nspace);
+}
+
+}
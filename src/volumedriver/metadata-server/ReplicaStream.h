@@ -0,0 +1,121 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef META_DATA_SERVER_REPLICA_STREAM_H_
+#define META_DATA_SERVER_REPLICA_STREAM_H_
+
+#include "Interface.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <youtils/Logging.h>
+
+#include <volumedriver/MDSNodeConfig.h>
+
+namespace metadata_server
+{
+
+// Master side of streaming replication (cf. Table): ships the batches of all
+// tables replicating to a given node over a single connection.
+// Batches are queued and sent by a dedicated thread, so writers are never held
+// up by a slow or unreachable replica. If the queue is full or the replica
+// cannot be reached batches are dropped instead, and all further batches of
+// that namespace up to the next cycle start as the replica cannot apply them
+// anyway - it detects the gap and catches up via the backend.
+class ReplicaStream
+{
+public:
+    using Ptr = std::shared_ptr<ReplicaStream>;
+
+    // Returns the stream to the given node, which is shared by all tables.
+    static Ptr
+    get(const volumedriver::MDSNodeConfig&);
+
+    ~ReplicaStream();
+
+    ReplicaStream(const ReplicaStream&) = delete;
+
+    ReplicaStream&
+    operator=(const ReplicaStream&) = delete;
+
+    // The records are copied. Returns false if the batch was dropped.
+    bool
+    enqueue(const std::string& nspace,
+            const ReplicationHeader&,
+            const TableInterface::Records&,
+            Barrier);
+
+    const volumedriver::MDSNodeConfig&
+    config() const
+    {
+        return config_;
+    }
+
+private:
+    DECLARE_LOGGER("MetaDataServerReplicaStream");
+
+    using OwnedRecord = std::pair<std::string, boost::optional<std::string>>;
+
+    struct Batch
+    {
+        std::string nspace;
+        ReplicationHeader header;
+        std::vector<OwnedRecord> records;
+        Barrier barrier;
+        size_t size;
+    };
+
+    const volumedriver::MDSNodeConfig config_;
+
+    boost::mutex lock_;
+    boost::condition_variable cond_;
+    std::deque<Batch> queue_;
+    size_t queued_bytes_ = 0;
+    std::set<std::string> resyncing_;
+    bool stop_ = false;
+
+    // only used by the worker thread
+    DataBaseInterfacePtr client_;
+    std::map<std::string, TableInterfacePtr> tables_;
+    std::chrono::steady_clock::time_point retry_after_;
+
+    boost::thread thread_;
+
+    explicit ReplicaStream(const volumedriver::MDSNodeConfig&);
+
+    void
+    work_();
+
+    void
+    send_(const Batch&);
+
+    void
+    drop_(const Batch&);
+};
+
+}
+
+#endif // !META_DATA_SERVER_REPLICA_STREAM_H_
@@ -214,6 +214,8 @@ ServerNG::dispatch_(C& conn,
         CASE(Ping, ping_);
         CASE(ApplyRelocationLogs, apply_relocation_logs_);
         CASE(CatchUp, catch_up_);
+        CASE(SetReplicas, set_replicas_);
+        CASE(Replicate, replicate_);
     }
 
 #undef CASE
@@ -716,4 +718,76 @@ ServerNG::catch_up_(mdsproto::Methods::CatchUpParams::Reader& reader,
     builder.setNumTLogs(num_tlogs);
 }
 
+void
+ServerNG::set_replicas_(mdsproto::Methods::SetReplicasParams::Reader& reader,
+                        mdsproto::Methods::SetReplicasResults::Builder&)
+{
+    const std::string nspace(reader.getNspace().begin(),
+                             reader.getNspace().size());
+
+    auto replicas_reader(reader.getReplicas());
+    vd::MDSNodeConfigs replicas;
+    replicas.reserve(replicas_reader.size());
+
+    for (const auto& r : replicas_reader)
+    {
+        replicas.emplace_back(std::string(r.getAddress().begin(),
+                                          r.getAddress().size()),
+                              r.getPort());
+    }
+
+    // LOG_TRACE("set_replicas request to " << nspace << ", size " << replicas.size());
+
+    db_->open(nspace)->set_replicas(replicas);
+}
+
+void
+ServerNG::replicate_(mdsproto::Methods::ReplicateParams::Reader& reader,
+                     mdsproto::Methods::ReplicateResults::Builder& builder)
+{
+    const std::string nspace(reader.getNspace().begin(),
+                             reader.getNspace().size());
+
+    ReplicationHeader hdr;
+    hdr.session = yt::UUID(std::string(reader.getSession().begin(),
+                                       reader.getSession().size()));
+    hdr.seq = reader.getSeq();
+    hdr.cycle_start = reader.getCycleStart();
+
+    if (reader.getBaseCork().size() != 0)
+    {
+        hdr.base_cork = std::string(reader.getBaseCork().begin(),
+                                    reader.getBaseCork().size());
+    }
+
+    const Barrier barrier(reader.getBarrier() ?
+                          Barrier::T :
+                          Barrier::F);
+
+    auto recs_reader(reader.getRecords());
+
+    TableInterface::Records recs;
+    recs.reserve(recs_reader.size());
+
+    for (const auto& r : recs_reader)
+    {
+        capnp::Data::Reader kreader(r.getKey());
+        Key k(kreader.begin(),
+              kreader.size());
+
+        capnp::Data::Reader vreader(r.getVal());
+        Value v(vreader.begin(),
+                vreader.size());
+
+        recs.emplace_back(Record(k, v));
+    }
+
+    // LOG_TRACE("replicate request to " << nspace << ", session " << hdr.session <<
+    //           ", seq " << hdr.seq << ", size " << recs.size());
+
+    builder.setApplied(db_->open(nspace)->replicate(hdr,
+                                                    recs,
+                                                    barrier));
+}
+
 }
@@ -196,6 +196,14 @@ private:
     catch_up_(metadata_server_protocol::Methods::CatchUpParams::Reader& reader,
               metadata_server_protocol::Methods::CatchUpResults::Builder& builder);
 
+    void
+    set_replicas_(metadata_server_protocol::Methods::SetReplicasParams::Reader& reader,
+                  metadata_server_protocol::Methods::SetReplicasResults::Builder& builder);
+
+    void
+    replicate_(metadata_server_protocol::Methods::ReplicateParams::Reader& reader,
+               metadata_server_protocol::Methods::ReplicateResults::Builder& builder);
+
 };
 
 }
@@ -16,7 +16,12 @@
 #include "Table.h"
 #include "Utils.h"
 
+#include <cstring>
+
+#include <boost/optional/optional_io.hpp>
+
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
 
 #include <volumedriver/MetaDataStoreBuilder.h>
 #include <volumedriver/RelocationReaderFactory.h>
@@ -38,6 +43,9 @@ namespace yt = youtils;
 #define LOCKW()                                                 \
     boost::unique_lock<decltype(rwlock_)> wlg__(rwlock_)
 
+#define LOCK_REPLICAS()                                         \
+    boost::unique_lock<decltype(replicas_lock_)> rplg__(replicas_lock_)
+
 Table::Table(DataBaseInterfacePtr db,
              be::BackendInterfacePtr bi,
              yt::PeriodicActionPool::Ptr act_pool,
@@ -106,6 +114,8 @@ void
 Table::set_role(Role role)
 {
     decltype(act_) stop_act;
+    // cf. set_replicas
+    decltype(replicas_) old_replicas;
 
     LOCKW();
 
@@ -131,6 +141,14 @@ Table::set_role(Role role)
         }
 
         TableInterface::set_role(role);
+
+        in_sync_ = false;
+
+        LOCK_REPLICAS();
+
+        old_replicas = std::move(replicas_);
+        replicas_.clear();
+        reset_replication_();
     }
 }
 
@@ -230,6 +248,10 @@ Table::apply_relocations(const vd::ScrubId& scrub_id,
                     }
                     throw;
                 });
+
+            // the relocations were not applied in the order the master applied its
+            // batches, so don't rely on the stream anymore until the next cork
+            in_sync_ = false;
         }
     }
 }
@@ -256,8 +278,174 @@ Table::multiset(const TableInterface::Records& records,
 
     prevent_updates_on_slaves_("multiset");
 
+    LOCK_REPLICAS();
+
+    if (replicas_.empty())
+    {
+        rplg__.unlock();
+        table_->multiset(records,
+                         barrier);
+    }
+    else
+    {
+        if (not repl_cork_known_)
+        {
+            repl_header_.base_cork = cork_();
+            repl_header_.cycle_start = false;
+            repl_cork_known_ = true;
+        }
+
+        table_->multiset(records,
+                         barrier);
+        forward_(records,
+                 barrier);
+    }
+}
+
+void
+Table::reset_replication_()
+{
+    repl_header_ = ReplicationHeader();
+    repl_cork_known_ = false;
+}
+
+boost::optional<std::string>
+Table::cork_()
+{
+    const TableInterface::Keys keys{ Key(vd::MDSMetaDataBackend::cork_key()) };
+    const TableInterface::MaybeStrings ms(table_->multiget(keys));
+
+    VERIFY(ms.size() == 1);
+    return ms[0];
+}
+
+void
+Table::forward_(const TableInterface::Records& records,
+                Barrier barrier)
+{
+    const ReplicationHeader hdr(repl_header_);
+
+    ++repl_header_.seq;
+    repl_header_.cycle_start = false;
+
+    const std::string& cork_key = vd::MDSMetaDataBackend::cork_key();
+
+    for (const auto& r : records)
+    {
+        if (r.key.size == cork_key.size() and
+            memcmp(r.key.data, cork_key.data(), cork_key.size()) == 0)
+        {
+            if (r.val.data == nullptr)
+            {
+                repl_header_.base_cork = boost::none;
+            }
+            else
+            {
+                repl_header_.base_cork = std::string(static_cast<const char*>(r.val.data),
+                                                     r.val.size);
+            }
+
+            repl_header_.cycle_start = true;
+        }
+    }
+
+    for (auto& r : replicas_)
+    {
+        r->enqueue(table_->nspace(),
+                   hdr,
+                   records,
+                   barrier);
+    }
+}
+
+void
+Table::set_replicas(const vd::MDSNodeConfigs& replicas)
+{
+    // destroy streams that are not needed anymore only after dropping the locks
+    // as that waits for a send that might be in flight
+    decltype(replicas_) old_replicas;
+
+    LOCKR();
+
+    LOG_INFO(table_->nspace() << ": " << replicas.size() << " replicas requested");
+
+    if (TableInterface::get_role() != Role::Master)
+    {
+        LOG_WARN(table_->nspace() <<
+                 ": ignoring replicas as we're not in master role");
+        return;
+    }
+
+    LOCK_REPLICAS();
+
+    old_replicas = std::move(replicas_);
+    replicas_.clear();
+    replicas_.reserve(replicas.size());
+
+    for (const auto& cfg : replicas)
+    {
+        LOG_INFO(table_->nspace() << ": replica " << cfg);
+        replicas_.emplace_back(ReplicaStream::get(cfg));
+    }
+}
+
+bool
+Table::replicate(const ReplicationHeader& hdr,
+                 const TableInterface::Records& records,
+                 Barrier barrier)
+{
+    // Don't hold up the master while the backend is being checked - the batch is
+    // dropped instead and the gap is detected with the next one.
+    boost::upgrade_lock<decltype(rwlock_)> ulg(rwlock_,
+                                               boost::try_to_lock);
+    if (not ulg.owns_lock())
+    {
+        LOG_INFO(table_->nspace() << ": busy, dropping batch " << hdr.seq <<
+                 " of session " << hdr.session);
+        return false;
+    }
+
+    if (TableInterface::get_role() != Role::Slave)
+    {
+        LOG_WARN(table_->nspace() << ": refusing batch " << hdr.seq <<
+                 " of session " << hdr.session << " as we're not in slave role");
+        return false;
+    }
+
+    const bool follows = in_sync_ and
+        hdr.session == synced_session_ and
+        hdr.seq == synced_seq_ + 1;
+
+    if (not follows)
+    {
+        if (in_sync_)
+        {
+            LOG_WARN(table_->nspace() << ": lost track of the master: got batch " <<
+                     hdr.seq << " of session " << hdr.session << ", expected " <<
+                     (synced_seq_ + 1) << " of session " << synced_session_);
+            in_sync_ = false;
+        }
+
+        if (not hdr.cycle_start or hdr.base_cork != cork_())
+        {
+            return false;
+        }
+
+        LOG_INFO(table_->nspace() << ": in sync with session " << hdr.session <<
+                 " as of batch " << hdr.seq << ", cork " << hdr.base_cork);
+    }
+
+    in_sync_ = false;
+
     table_->multiset(records,
                      barrier);
+
+    in_sync_ = true;
+    synced_session_ = hdr.session;
+    synced_seq_ = hdr.seq;
+    last_replicated_ = sc::steady_clock::now();
+
+    return true;
 }
 
 TableInterface::MaybeStrings
@@ -277,7 +465,14 @@ Table::work_()
 
     LOG_INFO(table_->nspace() << ": running periodic action");
 
-    if (TableInterface::get_role() == Role::Slave)
+    if (TableInterface::get_role() == Role::Slave and
+        in_sync_ and
+        sc::steady_clock::now() - last_replicated_ < sc::seconds(poll_secs_.load()))
+    {
+        LOG_INFO(table_->nspace() <<
+                 ": in sync with the master, no need to check the backend");
+    }
+    else if (TableInterface::get_role() == Role::Slave)
     {
         try
         {
@@ -320,7 +515,13 @@ Table::clear()
     LOCKR();
 
     prevent_updates_on_slaves_("clear");
+
+    LOCK_REPLICAS();
+
     table_->clear();
+
+    // replicas can't follow that, so start over
+    reset_replication_();
 }
 
 size_t
@@ -16,10 +16,13 @@
 #define META_DATA_SERVER_TABLE_H_
 
 #include "Interface.h"
+#include "ReplicaStream.h"
 
+#include <chrono>
 #include <memory>
 
 #include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
 #include <youtils/IOException.h>
@@ -51,6 +54,16 @@ namespace metadata_server
 //
 // Roles are switched explicitly via ->set_role().
 //
+// Streaming replication:
+// * a master queues each multiset batch for the replicas registered via
+//   ->set_replicas() after applying it (cf. ReplicationHeader, ReplicaStream).
+//   Batches that cannot be queued or sent are dropped - replicas detect the gap
+//   and catch up via the backend.
+// * a slave applies batches via ->replicate() as long as it's in sync with the
+//   master and skips the periodic backend check while batches keep coming in.
+//   Batches arriving while the backend is checked are dropped, as are batches the
+//   slave cannot relate to its own state - the backend check is the fallback.
+//
 // Locking:
 //   A shared mutex is held exclusively
 //   * while switching roles (*)
@@ -111,6 +124,14 @@ public:
     virtual size_t
     catch_up(volumedriver::DryRun dry_run) override final;
 
+    virtual void
+    set_replicas(const volumedriver::MDSNodeConfigs&) override final;
+
+    virtual bool
+    replicate(const ReplicationHeader&,
+              const TableInterface::Records&,
+              Barrier) override final;
+
     void
     stop();
 
@@ -132,6 +153,20 @@ private:
 
     volumedriver::NSIDMap nsid_map_;
 
+    // Master side of streaming replication. The lock also serializes multisets
+    // while there are replicas to retain the order of the batches.
+    boost::mutex replicas_lock_;
+    std::vector<ReplicaStream::Ptr> replicas_;
+    ReplicationHeader repl_header_;
+    bool repl_cork_known_ = false;
+
+    // Slave side of streaming replication, protected by rwlock_ held in upgrade or
+    // exclusive mode.
+    bool in_sync_ = false;
+    youtils::UUID synced_session_;
+    uint64_t synced_seq_ = 0;
+    std::chrono::steady_clock::time_point last_replicated_;
+
     void
     start_(const std::chrono::milliseconds& ramp_up);
 
@@ -149,6 +184,16 @@ private:
 
     void
     prevent_updates_on_slaves_(const char* desc);
+
+    void
+    forward_(const TableInterface::Records&,
+             Barrier);
+
+    void
+    reset_replication_();
+
+    boost::optional<std::string>
+    cork_();
 };
 
 typedef std::shared_ptr<Table> TablePtr;
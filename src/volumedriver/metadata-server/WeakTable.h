@@ -89,6 +89,22 @@ public:
         return lock_()->catch_up(dry_run);
     }
 
+    virtual void
+    set_replicas(const volumedriver::MDSNodeConfigs& replicas) override final
+    {
+        lock_()->set_replicas(replicas);
+    }
+
+    virtual bool
+    replicate(const ReplicationHeader& hdr,
+              const Records& recs,
+              Barrier barrier) override final
+    {
+        return lock_()->replicate(hdr,
+                                  recs,
+                                  barrier);
+    }
+
     MAKE_EXCEPTION(Exception,
                    fungi::IOException);
 
@@ -0,0 +1,268 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../CachedMetaDataPage.h"
+#include "../CachePageCodec.h"
+#include "../ClusterLocationAndHash.h"
+
+#include "ExGTest.h"
+
+#include <vector>
+
+#include <youtils/SourceOfUncertainty.h>
+#include <youtils/Weed.h>
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+namespace yt = youtils;
+
+class CachePageCodecTest
+    : public ExGTest
+{
+protected:
+    CachePageCodecTest()
+        : data_(CachePage::capacity())
+        , page_(PageAddress(42),
+                data_.data())
+    {
+        page_.reset();
+    }
+
+    ClusterLocationAndHash
+    make_clh(const ClusterLocation& loc)
+    {
+        const uint64_t x = rand_(std::numeric_limits<uint64_t>::max());
+        return ClusterLocationAndHash(loc,
+                                      yt::Weed(reinterpret_cast<const uint8_t*>(&x),
+                                               sizeof(x)));
+    }
+
+    // returns the size of the encoded page
+    size_t
+    check_roundtrip()
+    {
+        std::string buf;
+        CachePageCodec::encode(page_, buf);
+
+        EXPECT_GT(CachePage::size(), 0U);
+        EXPECT_LE(buf.size(), CachePage::size());
+
+        std::vector<ClusterLocationAndHash> data(CachePage::capacity());
+        CachePage page(page_.page_address(),
+                       data.data());
+
+        CachePageCodec::decode(buf.data(),
+                               buf.size(),
+                               page);
+
+        EXPECT_EQ(0,
+                  memcmp(page_.data(),
+                         page.data(),
+                         CachePage::size()));
+
+        return buf.size();
+    }
+
+    yt::SourceOfUncertainty rand_;
+    std::vector<ClusterLocationAndHash> data_;
+    CachePage page_;
+};
+
+TEST_F(CachePageCodecTest, empty)
+{
+    EXPECT_GT(CachePage::size() / 16,
+              check_roundtrip());
+}
+
+TEST_F(CachePageCodecTest, discarded)
+{
+    for (size_t i = 0; i < CachePage::capacity(); i += 2)
+    {
+        page_[i] = ClusterLocationAndHash::discarded_location_and_hash();
+    }
+
+    EXPECT_GT(CachePage::size() / 16,
+              check_roundtrip());
+}
+
+TEST_F(CachePageCodecTest, sequential)
+{
+    ClusterLocation loc(SCONumber(13),
+                        SCOOffset(0),
+                        SCOCloneID(1));
+
+    for (size_t i = 0; i < CachePage::capacity(); ++i)
+    {
+        page_[i] = make_clh(loc);
+        if (i % 16 == 15)
+        {
+            loc = ClusterLocation(SCONumber(loc.number() + 1),
+                                  SCOOffset(0),
+                                  loc.cloneID());
+        }
+        else
+        {
+            loc.offset(loc.offset() + 1);
+        }
+    }
+
+    const size_t size = check_roundtrip();
+    EXPECT_GT(CachePage::size(), size);
+
+    if (not ClusterLocationAndHash::use_hash())
+    {
+        EXPECT_GT(CachePage::size() / 16,
+                  size);
+    }
+}
+
+TEST_F(CachePageCodecTest, random)
+{
+    for (size_t i = 0; i < CachePage::capacity(); ++i)
+    {
+        const ClusterLocation
+            loc(SCONumber(rand_(std::numeric_limits<uint32_t>::max())),
+                SCOOffset(rand_(std::numeric_limits<uint16_t>::max())),
+                SCOCloneID(rand_(std::numeric_limits<uint8_t>::max())),
+                SCOVersion(rand_(std::numeric_limits<uint8_t>::max())));
+        page_[i] = make_clh(loc);
+    }
+
+    // falls back to the raw page
+    EXPECT_EQ(CachePage::size(),
+              check_roundtrip());
+}
+
+TEST_F(CachePageCodecTest, mixed)
+{
+    ClusterLocation loc(SCONumber(1));
+
+    for (size_t i = 0; i < CachePage::capacity(); ++i)
+    {
+        switch (rand_(3U))
+        {
+        case 0:
+            break;
+        case 1:
+            page_[i] = ClusterLocationAndHash::discarded_location_and_hash();
+            break;
+        default:
+            loc = ClusterLocation(SCONumber(rand_(std::numeric_limits<uint32_t>::max())),
+                                  SCOOffset(rand_(std::numeric_limits<uint16_t>::max())));
+            page_[i] = make_clh(loc);
+            break;
+        }
+    }
+
+    check_roundtrip();
+}
+
+TEST_F(CachePageCodecTest, raw)
+{
+    page_[7] = make_clh(ClusterLocation(SCONumber(7)));
+
+    std::vector<ClusterLocationAndHash> data(CachePage::capacity());
+    CachePage page(page_.page_address(),
+                   data.data());
+
+    // pages written by older versions
+    CachePageCodec::decode(page_.data(),
+                           CachePage::size(),
+                           page);
+
+    EXPECT_EQ(0,
+              memcmp(page_.data(),
+                     page.data(),
+                     CachePage::size()));
+}
+
+TEST_F(CachePageCodecTest, serialize)
+{
+    page_[7] = make_clh(ClusterLocation(SCONumber(7)));
+
+    std::string raw;
+    CachePageCodec::serialize(page_, raw, false);
+
+    ASSERT_EQ(CachePage::size(), raw.size());
+    EXPECT_EQ(0,
+              memcmp(page_.data(),
+                     raw.data(),
+                     CachePage::size()));
+
+    std::string encoded;
+    CachePageCodec::serialize(page_, encoded, true);
+
+    EXPECT_GT(raw.size(), encoded.size());
+
+    for (const auto& buf : { raw, encoded })
+    {
+        std::vector<ClusterLocationAndHash> data(CachePage::capacity());
+        CachePage page(page_.page_address(),
+                       data.data());
+
+        CachePageCodec::decode(buf.data(),
+                               buf.size(),
+                               page);
+
+        EXPECT_EQ(0,
+                  memcmp(page_.data(),
+                         page.data(),
+                         CachePage::size()));
+    }
+}
+
+TEST_F(CachePageCodecTest, garbage)
+{
+    std::vector<ClusterLocationAndHash> data(CachePage::capacity());
+    CachePage page(page_.page_address(),
+                   data.data());
+
+    std::string buf;
+    CachePageCodec::encode(page_, buf);
+    ASSERT_LT(buf.size(), CachePage::size());
+
+    EXPECT_THROW(CachePageCodec::decode(buf.data(),
+                                        0,
+                                        page),
+                 CachePageCodecException);
+
+    EXPECT_THROW(CachePageCodec::decode(buf.data(),
+                                        CachePage::size() + 1,
+                                        page),
+                 CachePageCodecException);
+
+    std::string b(buf);
+    b[0] = 0x7f;
+
+    EXPECT_THROW(CachePageCodec::decode(b.data(),
+                                        b.size(),
+                                        page),
+                 CachePageCodecException);
+
+    b = buf;
+    b.resize(b.size() - 1);
+
+    EXPECT_THROW(CachePageCodec::decode(b.data(),
+                                        b.size(),
+                                        page),
+                 fungi::IOException);
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -0,0 +1,114 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ExGTest.h"
+
+#include "../ChangedClusters.h"
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+
+class ChangedClustersTest
+    : public ExGTest
+{
+protected:
+    using Extent = ChangedClusters::Extent;
+    using Extents = ChangedClusters::Extents;
+};
+
+TEST_F(ChangedClustersTest, empty)
+{
+    const ChangedClusters c;
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(0U, c.size());
+    EXPECT_FALSE(c.contains(0));
+
+    ChangedClusters d(std::vector<ClusterAddress>{});
+    EXPECT_EQ(c, d);
+
+    d.merge(c);
+    EXPECT_TRUE(d.empty());
+}
+
+TEST_F(ChangedClustersTest, construction)
+{
+    const ChangedClusters c(std::vector<ClusterAddress>{ 7, 3, 4, 3, 5, 11, 7, 0 });
+
+    const Extents exp{ Extent(0, 1),
+                       Extent(3, 3),
+                       Extent(7, 1),
+                       Extent(11, 1) };
+
+    EXPECT_EQ(exp, c.extents());
+    EXPECT_EQ(6U, c.size());
+
+    for (ClusterAddress ca = 0; ca < 16; ++ca)
+    {
+        const bool exp_changed = ca == 0 or
+            (ca >= 3 and ca <= 5) or
+            ca == 7 or
+            ca == 11;
+        EXPECT_EQ(exp_changed, c.contains(ca)) << "ca " << ca;
+    }
+}
+
+TEST_F(ChangedClustersTest, merge)
+{
+    ChangedClusters c(std::vector<ClusterAddress>{ 0, 1, 2, 10, 11, 20 });
+    const ChangedClusters d(std::vector<ClusterAddress>{ 2, 3, 9, 15, 21, 22, 30 });
+
+    c.merge(d);
+
+    const Extents exp{ Extent(0, 4),
+                       Extent(9, 3),
+                       Extent(15, 1),
+                       Extent(20, 3),
+                       Extent(30, 1) };
+
+    EXPECT_EQ(exp, c.extents());
+    EXPECT_EQ(12U, c.size());
+
+    // idempotent
+    c.merge(d);
+    EXPECT_EQ(exp, c.extents());
+
+    ChangedClusters e;
+    e.merge(c);
+    EXPECT_EQ(c, e);
+}
+
+TEST_F(ChangedClustersTest, merge_covering)
+{
+    ChangedClusters c(std::vector<ClusterAddress>{ 4, 6, 8 });
+
+    std::vector<ClusterAddress> cas;
+    for (ClusterAddress ca = 2; ca < 10; ++ca)
+    {
+        cas.push_back(ca);
+    }
+
+    const ChangedClusters d(std::move(cas));
+    c.merge(d);
+
+    EXPECT_EQ(d, c);
+    EXPECT_EQ(Extents{ Extent(2, 8) }, c.extents());
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -57,17 +57,39 @@ FailOverCacheTestContext::FailOverCacheTestContext(FailOverCacheTestSetup& setup
     , port_(port)
     , acceptor_(make_directory(setup_.path,
                                port_))
-    , server_(fungi::SocketServer::createSocketServer(acceptor_,
-                                                      addr_,
-                                                      port_,
-                                                      setup.transport() == vd::FailOverCacheTransport::RSocket))
-{}
+{
+    if (setup.transport() == vd::FailOverCacheTransport::RSocket)
+    {
+        server_ = fungi::SocketServer::createSocketServer(acceptor_,
+                                                          addr_,
+                                                          port_,
+                                                          true);
+    }
+    else
+    {
+        event_server_ =
+            std::make_unique<failovercache::FailOverCacheEventServer>(acceptor_,
+                                                                      addr_,
+                                                                      port_);
+    }
+}
 
 FailOverCacheTestContext::~FailOverCacheTestContext()
 {
-    EXPECT_NO_THROW(server_->stop());
-    EXPECT_NO_THROW(server_->join());
-    server_.reset();
+    if (server_)
+    {
+        EXPECT_NO_THROW(server_->stop());
+        EXPECT_NO_THROW(server_->join());
+        server_.reset();
+    }
+
+    if (event_server_)
+    {
+        EXPECT_NO_THROW(event_server_->stop());
+        EXPECT_NO_THROW(event_server_->join());
+        event_server_.reset();
+    }
+
     setup_.release_port_(port_);
 }
 
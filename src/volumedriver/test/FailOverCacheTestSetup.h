@@ -27,6 +27,7 @@
 #include "../FailOverCacheTransport.h"
 #include "../failovercache/Backend.h"
 #include "../failovercache/FailOverCacheAcceptor.h"
+#include "../failovercache/FailOverCacheEventServer.h"
 #include "../failovercache/FailOverCacheProtocol.h"
 
 class VolumeDriverTest;
@@ -55,6 +56,7 @@ private:
     const uint16_t port_;
     failovercache::FailOverCacheAcceptor acceptor_;
     std::unique_ptr<fungi::SocketServer> server_;
+    std::unique_ptr<failovercache::FailOverCacheEventServer> event_server_;
 
 public:
     ~FailOverCacheTestContext();
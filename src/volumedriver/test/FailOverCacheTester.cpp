@@ -17,12 +17,23 @@
 #include "../VolumeConfig.h"
 #include "../Api.h"
 #include "../FailOverCacheAsyncBridge.h"
+#include "../FailOverCacheReplayReader.h"
+#include "../FailOverCacheStreamers.h"
 #include "../FailOverCacheSyncBridge.h"
+#include "../FailOverCacheTransport.h"
 #include "../failovercache/FileBackend.h"
 
+#include <netdb.h>
 #include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <future>
+#include <random>
+#include <set>
+
+#include <boost/scope_exit.hpp>
 
 namespace volumedriver
 {
@@ -769,6 +780,327 @@ TEST_P(FailOverCacheTester, clear)
                  std::exception);
 }
 
+TEST_P(FailOverCacheTester, pipelined_entries)
+{
+    auto wrns(make_random_namespace());
+    auto foc_ctx(start_one_foc());
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60));
+
+    const size_t csize = default_cluster_size();
+    const size_t nbatches = 8;
+    const size_t batch_size = 16;
+
+    std::vector<uint8_t> buf(csize * nbatches * batch_size);
+
+    for (size_t i = 0; i < nbatches; ++i)
+    {
+        std::vector<FailOverCacheEntry> entries;
+        for (size_t j = 0; j < batch_size; ++j)
+        {
+            const size_t n = i * batch_size + j;
+            uint8_t* ptr = buf.data() + n * csize;
+            *reinterpret_cast<size_t*>(ptr) = n;
+            entries.emplace_back(ClusterLocation(1, n),
+                                 n,
+                                 ptr,
+                                 csize);
+        }
+
+        EXPECT_EQ(i + 1, proxy.sendEntries(entries));
+    }
+
+    EXPECT_EQ(nbatches, proxy.entriesInFlight());
+
+    EXPECT_EQ(1U, proxy.ackEntries());
+    EXPECT_EQ(nbatches - 1, proxy.entriesInFlight());
+
+    // other requests collect the outstanding acknowledgements first
+    proxy.flush();
+    EXPECT_EQ(0U, proxy.entriesInFlight());
+
+    size_t count = 0;
+    proxy.getEntries([&](ClusterLocation loc,
+                         uint64_t lba,
+                         const uint8_t* buf,
+                         size_t bufsize)
+                     {
+                         ASSERT_EQ(count, loc.offset());
+                         ASSERT_EQ(count, lba);
+                         ASSERT_EQ(count, *reinterpret_cast<const size_t*>(buf));
+                         ASSERT_EQ(csize, bufsize);
+                         ++count;
+                     });
+
+    EXPECT_EQ(nbatches * batch_size, count);
+}
+
+// more entries than fit into a single sendmsg call
+TEST_P(FailOverCacheTester, large_batch)
+{
+    auto wrns(make_random_namespace());
+    auto foc_ctx(start_one_foc());
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60));
+
+    const size_t csize = default_cluster_size();
+    const size_t count = 4096;
+
+    std::vector<uint8_t> buf(csize * count);
+    std::vector<FailOverCacheEntry> entries;
+    entries.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t* ptr = buf.data() + i * csize;
+        *reinterpret_cast<size_t*>(ptr) = i;
+        entries.emplace_back(ClusterLocation(1, i),
+                             i,
+                             ptr,
+                             csize);
+    }
+
+    proxy.addEntries(std::move(entries));
+
+    size_t n = 0;
+    proxy.getEntries([&](ClusterLocation loc,
+                         uint64_t lba,
+                         const uint8_t* buf,
+                         size_t bufsize)
+                     {
+                         ASSERT_EQ(n, loc.offset());
+                         ASSERT_EQ(n, lba);
+                         ASSERT_EQ(n, *reinterpret_cast<const size_t*>(buf));
+                         ASSERT_EQ(csize, bufsize);
+                         ++n;
+                     });
+
+    EXPECT_EQ(count, n);
+}
+
+TEST_P(FailOverCacheTester, replay_reader)
+{
+    auto wrns(make_random_namespace());
+    auto foc_ctx(start_one_foc());
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60));
+
+    const size_t csize = default_cluster_size();
+    const size_t scos = 3;
+    const size_t entries_per_sco = 10;
+    const size_t max_run = 4;
+
+    std::vector<uint8_t> buf(csize * entries_per_sco);
+
+    for (size_t s = 0; s < scos; ++s)
+    {
+        std::vector<FailOverCacheEntry> entries;
+        for (size_t i = 0; i < entries_per_sco; ++i)
+        {
+            uint8_t* ptr = buf.data() + i * csize;
+            *reinterpret_cast<size_t*>(ptr) = s * entries_per_sco + i;
+            entries.emplace_back(ClusterLocation(s + 1, i),
+                                 s * entries_per_sco + i,
+                                 ptr,
+                                 csize);
+        }
+
+        proxy.addEntries(std::move(entries));
+    }
+
+    FailOverCacheReplayReader reader(proxy,
+                                     ClusterSize(csize),
+                                     max_run);
+
+    size_t count = 0;
+    size_t runs = 0;
+
+    reader.read([&](const FailOverCacheReplayReader::Run& run)
+                {
+                    ++runs;
+
+                    // runs never cross SCO boundaries
+                    EXPECT_EQ(count / entries_per_sco + 1, run.start.number());
+                    EXPECT_EQ(count % entries_per_sco, run.start.offset());
+                    ASSERT_GE(max_run, run.lbas.size());
+                    ASSERT_EQ(run.lbas.size() * csize, run.data.size());
+
+                    for (size_t i = 0; i < run.lbas.size(); ++i)
+                    {
+                        EXPECT_EQ(count, run.lbas[i]);
+                        EXPECT_EQ(count,
+                                  *reinterpret_cast<const size_t*>(run.data.data() + i * csize));
+                        ++count;
+                    }
+                });
+
+    EXPECT_EQ(scos * entries_per_sco, count);
+    EXPECT_EQ(scos * 3, runs);
+}
+
+TEST_P(FailOverCacheTester, shared_memory)
+{
+    auto wrns(make_random_namespace());
+    auto foc_ctx(start_one_foc());
+
+    const size_t csize = default_cluster_size();
+    const size_t batch_size = 8;
+    // room for a bit more than 2 batches to exercise the wrap around
+    const uint64_t shmem_size = (2 * batch_size + 3) * csize;
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60),
+                             shmem_size);
+
+    if (FailOverCacheTestSetup::transport() == FailOverCacheTransport::TCP)
+    {
+        EXPECT_TRUE(proxy.uses_shared_memory());
+    }
+    else
+    {
+        EXPECT_FALSE(proxy.uses_shared_memory());
+    }
+
+    const size_t nbatches = 16;
+    std::vector<uint8_t> buf(csize * nbatches * batch_size);
+
+    for (size_t i = 0; i < nbatches; ++i)
+    {
+        std::vector<FailOverCacheEntry> entries;
+        for (size_t j = 0; j < batch_size; ++j)
+        {
+            const size_t n = i * batch_size + j;
+            uint8_t* ptr = buf.data() + n * csize;
+            *reinterpret_cast<size_t*>(ptr) = n;
+            entries.emplace_back(ClusterLocation(1, n),
+                                 n,
+                                 ptr,
+                                 csize);
+        }
+
+        if (i % 2)
+        {
+            proxy.addEntries(std::move(entries));
+        }
+        else
+        {
+            proxy.sendEntries(entries);
+        }
+    }
+
+    proxy.flush();
+
+    size_t count = 0;
+    proxy.getEntries([&](ClusterLocation loc,
+                         uint64_t lba,
+                         const uint8_t* buf,
+                         size_t bufsize)
+                     {
+                         ASSERT_EQ(count, loc.offset());
+                         ASSERT_EQ(count, lba);
+                         ASSERT_EQ(count, *reinterpret_cast<const size_t*>(buf));
+                         ASSERT_EQ(csize, bufsize);
+                         ++count;
+                     });
+
+    EXPECT_EQ(nbatches * batch_size, count);
+}
+
+TEST_P(FailOverCacheTester, compression)
+{
+    auto wrns(make_random_namespace());
+    auto foc_ctx(start_one_foc());
+
+    const size_t csize = default_cluster_size();
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60),
+                             0,
+                             true);
+
+    EXPECT_TRUE(proxy.uses_compression());
+
+    const size_t batch_size = 8;
+    const size_t nbatches = 32;
+    std::vector<uint8_t> buf(csize * nbatches * batch_size);
+
+    // runs of compressible and incompressible batches, to get the backoff to
+    // kick in and out again
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < nbatches; ++i)
+    {
+        uint8_t* ptr = buf.data() + i * batch_size * csize;
+        if ((i / 4) % 2)
+        {
+            std::generate(ptr,
+                          ptr + batch_size * csize,
+                          std::ref(rng));
+        }
+    }
+
+    for (size_t i = 0; i < nbatches; ++i)
+    {
+        std::vector<FailOverCacheEntry> entries;
+        for (size_t j = 0; j < batch_size; ++j)
+        {
+            // odd batches are not contiguous in memory
+            const size_t k = (i % 2) ? batch_size - j - 1 : j;
+            const size_t n = i * batch_size + k;
+            uint8_t* ptr = buf.data() + n * csize;
+            *reinterpret_cast<size_t*>(ptr) = n;
+            entries.emplace_back(ClusterLocation(1, n),
+                                 n,
+                                 ptr,
+                                 csize);
+        }
+
+        if (i % 3)
+        {
+            proxy.addEntries(std::move(entries));
+        }
+        else
+        {
+            proxy.sendEntries(entries);
+        }
+    }
+
+    proxy.flush();
+
+    std::set<uint64_t> seen;
+    proxy.getEntries([&](ClusterLocation loc,
+                         uint64_t lba,
+                         const uint8_t* data,
+                         size_t bufsize)
+                     {
+                         ASSERT_EQ(lba, loc.offset());
+                         ASSERT_EQ(csize, bufsize);
+                         ASSERT_EQ(0, memcmp(buf.data() + lba * csize,
+                                             data,
+                                             csize));
+                         EXPECT_TRUE(seen.insert(lba).second);
+                     });
+
+    EXPECT_EQ(nbatches * batch_size, seen.size());
+}
+
 TEST_P(FailOverCacheTester, non_standard_cluster_size)
 {
     auto foc_ctx(start_one_foc());
@@ -871,6 +1203,198 @@ TEST_P(FailOverCacheTester, wrong_cluster_size)
                  std::exception);
 }
 
+// The (TCP) DTL server multiplexes all connections over a small pool of
+// workers - make sure clients outnumbering them are served concurrently.
+TEST_P(FailOverCacheTester, more_clients_than_workers)
+{
+    auto foc_ctx(start_one_foc());
+
+    const size_t nclients = 4 * failovercache::FailOverCacheEventServer::default_workers;
+    const size_t nentries = 64;
+    const size_t csize = default_cluster_size();
+
+    std::vector<std::unique_ptr<be::BackendTestSetup::WithRandomNamespace>> wrns;
+    std::vector<std::unique_ptr<FailOverCacheProxy>> proxies;
+
+    for (size_t i = 0; i < nclients; ++i)
+    {
+        wrns.emplace_back(make_random_namespace());
+        proxies.emplace_back(std::make_unique<FailOverCacheProxy>(foc_ctx->config(GetParam().foc_mode()),
+                                                                  wrns.back()->ns(),
+                                                                  default_lba_size(),
+                                                                  default_cluster_multiplier(),
+                                                                  boost::chrono::seconds(60)));
+    }
+
+    std::vector<std::future<size_t>> futures;
+
+    for (auto& p : proxies)
+    {
+        FailOverCacheProxy& proxy = *p;
+        futures.emplace_back(std::async(std::launch::async,
+                                        [&proxy, nentries, csize]() -> size_t
+                                        {
+                                            std::vector<uint8_t> buf(csize);
+                                            for (size_t i = 0; i < nentries; ++i)
+                                            {
+                                                *reinterpret_cast<size_t*>(buf.data()) = i;
+                                                std::vector<FailOverCacheEntry> entries {
+                                                    FailOverCacheEntry(ClusterLocation(1, i),
+                                                                       i,
+                                                                       buf.data(),
+                                                                       buf.size()) };
+                                                proxy.addEntries(std::move(entries));
+                                            }
+
+                                            proxy.flush();
+
+                                            size_t count = 0;
+                                            proxy.getEntries([&](ClusterLocation loc,
+                                                                 uint64_t lba,
+                                                                 const uint8_t* data,
+                                                                 size_t size)
+                                                             {
+                                                                 EXPECT_EQ(count, loc.offset());
+                                                                 EXPECT_EQ(count, lba);
+                                                                 EXPECT_EQ(count,
+                                                                           *reinterpret_cast<const size_t*>(data));
+                                                                 EXPECT_EQ(csize, size);
+                                                                 ++count;
+                                                             });
+                                            return count;
+                                        }));
+    }
+
+    for (auto& f : futures)
+    {
+        EXPECT_EQ(nentries,
+                  f.get());
+    }
+}
+
+// Garbage sent by one client must only cost that client its connection, not
+// bring down the (event driven) server and with it all other clients.
+TEST_P(FailOverCacheTester, invalid_request_drops_connection)
+{
+    if (FailOverCacheTestSetup::transport() != FailOverCacheTransport::TCP)
+    {
+        return;
+    }
+
+    auto foc_ctx(start_one_foc());
+    auto wrns1(make_random_namespace());
+    auto wrns2(make_random_namespace());
+
+    FailOverCacheProxy proxy(foc_ctx->config(GetParam().foc_mode()),
+                             wrns1->ns(),
+                             default_lba_size(),
+                             default_cluster_multiplier(),
+                             boost::chrono::seconds(60));
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* ai = nullptr;
+    ASSERT_EQ(0, ::getaddrinfo(FailOverCacheTestSetup::host().c_str(),
+                               boost::lexical_cast<std::string>(foc_ctx->port()).c_str(),
+                               &hints,
+                               &ai));
+    BOOST_SCOPE_EXIT((ai))
+    {
+        ::freeaddrinfo(ai);
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    const int fd = ::socket(ai->ai_family,
+                            ai->ai_socktype,
+                            ai->ai_protocol);
+    ASSERT_LE(0, fd);
+    BOOST_SCOPE_EXIT((fd))
+    {
+        ::close(fd);
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    ASSERT_EQ(0, ::connect(fd, ai->ai_addr, ai->ai_addrlen));
+
+    const timeval tv = { 30, 0 };
+    ASSERT_EQ(0, ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)));
+
+    std::vector<uint8_t> req;
+
+    auto put([&](const auto& t)
+             {
+                 const uint8_t* p = reinterpret_cast<const uint8_t*>(&t);
+                 req.insert(req.end(), p, p + sizeof(t));
+             });
+
+    auto send_request([&]
+                     {
+                         const uint32_t size = req.size();
+                         ASSERT_EQ(static_cast<ssize_t>(sizeof(size)),
+                                   ::send(fd, &size, sizeof(size), MSG_NOSIGNAL));
+                         ASSERT_EQ(static_cast<ssize_t>(req.size()),
+                                   ::send(fd, req.data(), req.size(), MSG_NOSIGNAL));
+                         req.clear();
+                     });
+
+    const std::string nspace(wrns2->ns().str());
+
+    put(static_cast<uint32_t>(Register));
+    put(static_cast<int64_t>(nspace.size()));
+    req.insert(req.end(), nspace.begin(), nspace.end());
+    put(static_cast<uint32_t>(default_cluster_size()));
+    send_request();
+
+    // a single entry that claims to be 1 byte large
+    put(static_cast<uint32_t>(AddEntries));
+    put(static_cast<uint64_t>(1));
+    put(static_cast<uint16_t>(0)); // cluster offset
+    put(static_cast<uint8_t>(0)); // sco version
+    put(static_cast<uint32_t>(1)); // sco number
+    put(static_cast<uint8_t>(0)); // sco clone id
+    put(static_cast<uint64_t>(0)); // lba
+    put(static_cast<int64_t>(1)); // size
+    put(static_cast<uint8_t>(0xff));
+    send_request();
+
+    // the replies, followed by EOF
+    ssize_t ret = 0;
+    do
+    {
+        uint8_t buf[64];
+        ret = ::recv(fd, buf, sizeof(buf), 0);
+    }
+    while (ret > 0);
+
+    EXPECT_EQ(0, ret);
+
+    // ... while the other client is still served
+    const size_t csize = default_cluster_size();
+    std::vector<uint8_t> buf(csize, 'x');
+    std::vector<FailOverCacheEntry> entries {
+        FailOverCacheEntry(ClusterLocation(1, 0),
+                           0,
+                           buf.data(),
+                           buf.size()) };
+
+    proxy.addEntries(std::move(entries));
+    proxy.flush();
+
+    size_t count = 0;
+    proxy.getEntries([&](ClusterLocation,
+                         uint64_t,
+                         const uint8_t*,
+                         size_t)
+                     {
+                         ++count;
+                     });
+
+    EXPECT_EQ(1U, count);
+}
+
 TEST_P(FailOverCacheTester, DISABLED_a_whole_lotta_clients)
 {
     auto foc_ctx(start_one_foc());
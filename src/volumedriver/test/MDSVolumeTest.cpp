@@ -769,6 +769,77 @@ TEST_P(MDSVolumeTest, slave_catchup)
                      ncfgs[1]);
 }
 
+TEST_P(MDSVolumeTest, streaming_replication)
+{
+    // the backend is effectively never polled, so the slave can only keep up
+    // via the updates streamed by the master
+    const auto
+        poll_secs(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::hours(1)));
+    mds_manager_ =
+        mds_test_setup_->make_manager(cm_,
+                                      2,
+                                      poll_secs);
+
+    const MDSNodeConfigs ncfgs(node_configs());
+    ASSERT_EQ(2U,
+              ncfgs.size());
+
+    const auto wrns(make_random_namespace());
+    SharedVolumePtr v = make_volume(*wrns);
+
+    MDSMetaDataBackend mdb(ncfgs[1],
+                           wrns->ns(),
+                           boost::none);
+
+    auto wait_for_slave([&]
+                        {
+                            for (size_t i = 0; i < 100; ++i)
+                            {
+                                if (mdb.lastCorkUUID() == v->getMetaDataStore()->lastCork())
+                                {
+                                    break;
+                                }
+                                boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+                            }
+
+                            check_slave_sync(*v,
+                                             *wrns,
+                                             ncfgs[1],
+                                             false);
+                        });
+
+    const std::string pattern1("first");
+    writeToVolume(*v,
+                  0,
+                  v->getClusterSize(),
+                  pattern1);
+
+    v->createSnapshot(SnapshotName("first-snap"));
+    waitForThisBackendWrite(*v);
+
+    // the slave can only pick up the stream at a cork it already knows about
+    catch_up(ncfgs[1],
+             wrns->ns().str(),
+             DryRun::F);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const std::string pattern("pattern-"s +
+                                  boost::lexical_cast<std::string>(i));
+
+        writeToVolume(*v,
+                      (i + 1) * v->getClusterMultiplier(),
+                      v->getClusterSize(),
+                      pattern);
+
+        v->createSnapshot(SnapshotName("snap-"s +
+                                       boost::lexical_cast<std::string>(i)));
+        waitForThisBackendWrite(*v);
+
+        wait_for_slave();
+    }
+}
+
 TEST_P(MDSVolumeTest, failover_before_tlog)
 {
     test_before_tlog(true);
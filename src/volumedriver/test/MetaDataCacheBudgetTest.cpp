@@ -0,0 +1,275 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "../MetaDataCacheBudget.h"
+
+#include <youtils/TestBase.h>
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+namespace ytt = youtilstest;
+
+namespace
+{
+
+struct Client
+    : public MetaDataCacheBudget::Client
+{
+    explicit Client(const std::string& id)
+        : id(id)
+    {}
+
+    const std::string&
+    cache_id() const override final
+    {
+        return id;
+    }
+
+    uint64_t
+    cache_hits() const override final
+    {
+        return hits;
+    }
+
+    uint64_t
+    cache_misses() const override final
+    {
+        return misses;
+    }
+
+    bool
+    release_page() override final
+    {
+        if (releasable > 0)
+        {
+            --releasable;
+            ++released;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const std::string id;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t releasable = 0;
+    uint64_t released = 0;
+};
+
+}
+
+class MetaDataCacheBudgetTest
+    : public ytt::TestBase
+{
+protected:
+    uint64_t
+    grow(MetaDataCacheBudget& b,
+         Client& c,
+         uint64_t n)
+    {
+        uint64_t granted = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            if (b.grow(c))
+            {
+                ++granted;
+            }
+        }
+
+        return granted;
+    }
+
+    uint64_t
+    pages(const MetaDataCacheBudget& b,
+          const Client& c)
+    {
+        for (const auto& s : b.client_stats())
+        {
+            if (s.id == c.id)
+            {
+                return s.pages;
+            }
+        }
+
+        ADD_FAILURE() << c.id << " not found";
+        return 0;
+    }
+};
+
+TEST_F(MetaDataCacheBudgetTest, spare_pages)
+{
+    const uint64_t max_pages = 8;
+    MetaDataCacheBudget b(max_pages, 2);
+
+    Client c("c");
+    b.register_client(c);
+
+    EXPECT_EQ(max_pages, grow(b, c, max_pages));
+    EXPECT_EQ(max_pages, b.used_pages());
+
+    EXPECT_FALSE(b.grow(c));
+    EXPECT_EQ(0U, c.released);
+
+    b.shrink(c, 3);
+    EXPECT_EQ(max_pages - 3, b.used_pages());
+    EXPECT_EQ(max_pages - 3, pages(b, c));
+
+    EXPECT_EQ(3U, grow(b, c, 4));
+
+    b.unregister_client(c);
+    EXPECT_EQ(0U, b.used_pages());
+}
+
+TEST_F(MetaDataCacheBudgetTest, reservation)
+{
+    const uint64_t max_pages = 8;
+    const uint32_t min_pages = 2;
+    MetaDataCacheBudget b(max_pages, min_pages);
+
+    Client c1("c1");
+    Client c2("c2");
+
+    b.register_client(c1);
+    b.register_client(c2);
+
+    EXPECT_EQ(max_pages, grow(b, c1, max_pages));
+    c1.hits = 1000;
+    c1.releasable = max_pages;
+
+    // c2 is entitled to its reservation even though c1 is a lot busier
+    EXPECT_EQ(min_pages, grow(b, c2, min_pages));
+    EXPECT_EQ(min_pages, c1.released);
+    EXPECT_EQ(max_pages - min_pages, pages(b, c1));
+    EXPECT_EQ(min_pages, pages(b, c2));
+
+    // .. but no more than that
+    EXPECT_FALSE(b.grow(c2));
+    EXPECT_EQ(max_pages, b.used_pages());
+
+    b.unregister_client(c2);
+    b.unregister_client(c1);
+}
+
+TEST_F(MetaDataCacheBudgetTest, frequency)
+{
+    const uint64_t max_pages = 16;
+    const uint32_t min_pages = 2;
+    MetaDataCacheBudget b(max_pages, min_pages);
+
+    Client c1("c1");
+    Client c2("c2");
+    Client c3("c3");
+
+    b.register_client(c1);
+    b.register_client(c2);
+    b.register_client(c3);
+
+    EXPECT_EQ(6U, grow(b, c1, 6));
+    EXPECT_EQ(6U, grow(b, c2, 6));
+    EXPECT_EQ(4U, grow(b, c3, 4));
+
+    c1.releasable = max_pages;
+    c2.releasable = max_pages;
+    c1.hits = 60;
+    c2.hits = 6;
+    c3.misses = 1000;
+
+    // the idle c2 has to give up its pages first, and c1 only has to chip in
+    // once c2 is down to its reservation.
+    EXPECT_EQ(4U, grow(b, c3, 4));
+    EXPECT_EQ(0U, c1.released);
+    EXPECT_EQ(4U, c2.released);
+    EXPECT_EQ(min_pages, pages(b, c2));
+
+    EXPECT_EQ(2U, grow(b, c3, 2));
+    EXPECT_EQ(2U, c1.released);
+
+    // c2 has nothing left to give and c3 is hotter per page than c1 -> no
+    // change
+    c3.releasable = max_pages;
+    EXPECT_FALSE(b.grow(c1));
+    EXPECT_EQ(0U, c3.released);
+
+    EXPECT_EQ(max_pages, b.used_pages());
+
+    b.unregister_client(c3);
+    b.unregister_client(c2);
+    b.unregister_client(c1);
+}
+
+TEST_F(MetaDataCacheBudgetTest, busy_donor)
+{
+    const uint64_t max_pages = 8;
+    MetaDataCacheBudget b(max_pages, 1);
+
+    Client c1("c1");
+    Client c2("c2");
+
+    b.register_client(c1);
+    b.register_client(c2);
+
+    EXPECT_EQ(max_pages - 1, grow(b, c1, max_pages - 1));
+    EXPECT_TRUE(b.grow(c2));
+
+    c2.misses = 1000;
+
+    // c1 doesn't have any clean pages to give up
+    EXPECT_FALSE(b.grow(c2));
+
+    c1.releasable = 1;
+    EXPECT_TRUE(b.grow(c2));
+    EXPECT_FALSE(b.grow(c2));
+
+    EXPECT_EQ(2U, pages(b, c2));
+    EXPECT_EQ(max_pages - 2, pages(b, c1));
+
+    b.unregister_client(c1);
+    EXPECT_EQ(2U, b.used_pages());
+
+    b.unregister_client(c2);
+    EXPECT_EQ(0U, b.used_pages());
+}
+
+TEST_F(MetaDataCacheBudgetTest, client_without_pages)
+{
+    MetaDataCacheBudget b(1, 0);
+
+    Client c1("c1");
+    Client c2("c2");
+
+    b.register_client(c1);
+    b.register_client(c2);
+
+    EXPECT_TRUE(b.grow(c1));
+
+    // c2 would be stuck otherwise
+    EXPECT_TRUE(b.grow(c2));
+    EXPECT_EQ(2U, b.used_pages());
+
+    EXPECT_FALSE(b.grow(c2));
+
+    b.unregister_client(c2);
+    b.unregister_client(c1);
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -14,6 +14,8 @@
 
 #include "MDSTestSetup.h"
 
+#include <future>
+
 #include <boost/algorithm/string.hpp>
 
 #include <youtils/FileUtils.h>
@@ -657,6 +659,91 @@ TEST_P(MetaDataServerTest, ping)
                      size));
 }
 
+TEST_P(MetaDataServerTest, concurrent_requests)
+{
+    const size_t nthreads = 2 * mds::ClientNG::default_max_requests_in_flight;
+    const size_t nkeys = 64;
+    const size_t iterations = 100;
+
+    be::BackendTestSetup::WithRandomNamespace wrns("",
+                                                   cm_);
+
+    auto client(make_client());
+    auto table(client->open(wrns.ns().str()));
+    table->set_role(mds::Role::Master);
+
+    std::vector<std::string> strs;
+    strs.reserve(nthreads * nkeys);
+
+    for (size_t i = 0; i < nthreads * nkeys; ++i)
+    {
+        strs.emplace_back(boost::lexical_cast<std::string>(i));
+    }
+
+    mds::TableInterface::Records recs;
+    recs.reserve(strs.size());
+
+    for (const auto& s : strs)
+    {
+        recs.emplace_back(mds::Record(mds::Key(s),
+                                      mds::Value(s)));
+    }
+
+    table->multiset(recs,
+                    Barrier::F);
+
+    // every thread uses its own table handle but they all share the client and
+    // hence the connection
+    auto fun([&](size_t t)
+             {
+                 auto tbl(client->open(wrns.ns().str()));
+
+                 mds::TableInterface::Keys keys;
+                 keys.reserve(nkeys);
+
+                 for (size_t i = 0; i < nkeys; ++i)
+                 {
+                     keys.emplace_back(mds::Key(strs[t * nkeys + i]));
+                 }
+
+                 for (size_t i = 0; i < iterations; ++i)
+                 {
+                     const mds::TableInterface::MaybeStrings mvals(tbl->multiget(keys));
+                     ASSERT_EQ(nkeys, mvals.size());
+
+                     for (size_t j = 0; j < nkeys; ++j)
+                     {
+                         ASSERT_TRUE(mvals[j] != boost::none);
+                         ASSERT_EQ(strs[t * nkeys + j], *mvals[j]);
+                     }
+                 }
+             });
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(nthreads);
+
+    for (size_t t = 0; t < nthreads; ++t)
+    {
+        futures.emplace_back(std::async(std::launch::async,
+                                        [&fun, t]
+                                        {
+                                            fun(t);
+                                        }));
+    }
+
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+
+    mds::ClientNG::OutCounters out;
+    mds::ClientNG::InCounters in;
+    client->counters(out,
+                     in);
+
+    EXPECT_EQ(out.messages, in.messages);
+}
+
 TEST_P(MetaDataServerTest, exceeding_the_shmem_size)
 {
     const size_t limit = GetParam().shmem_size + 1;
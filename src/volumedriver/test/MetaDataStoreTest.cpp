@@ -1107,6 +1107,84 @@ TEST_P(MetaDataStoreTest, LRU)
     }
 }
 
+TEST_P(MetaDataStoreTest, batched_write_back)
+{
+    const uint32_t page_size = CachePage::capacity();
+    const uint32_t max_pages = 4;
+    const uint32_t npages = 4 * max_pages;
+    const ClusterMultiplier cmult = default_cluster_multiplier();
+    const LBASize sectorsize = default_lba_size();
+
+    const uint64_t volsize = npages * page_size * cmult * sectorsize;
+
+    const auto ns(make_random_namespace());
+
+    SharedVolumePtr v = newVolume("volume",
+                                  ns->ns(),
+                                  VolumeSize(volsize),
+                                  default_sco_multiplier(),
+                                  sectorsize,
+                                  cmult,
+                                  max_pages);
+
+    std::unique_ptr<MetaDataStoreInterface>& md = getMDStore(v);
+
+    // a few clusters on every page, the dirty ones have to be written back while
+    // being evicted
+    const uint32_t stride = page_size / 4;
+    uint64_t written = 0;
+
+    for (uint64_t i = 0; i < npages * page_size; i += stride)
+    {
+        const ClusterLocation loc(i + 1);
+        const ClusterLocationAndHash clh(loc, w);
+        md->writeCluster(i, clh);
+        ++written;
+    }
+
+    yt::UUID cork;
+    md->cork(cork);
+    md->unCork();
+
+    MetaDataStoreStats mds;
+    md->getStats(mds);
+    EXPECT_EQ(written, mds.used_clusters);
+    EXPECT_EQ(max_pages, mds.cached_pages);
+
+    // discard every other page completely
+    for (uint64_t i = 0; i < npages * page_size; i += stride)
+    {
+        if ((i / page_size) % 2)
+        {
+            md->writeCluster(i,
+                             ClusterLocationAndHash::discarded_location_and_hash());
+            --written;
+        }
+    }
+
+    cork = yt::UUID();
+    md->cork(cork);
+    md->unCork();
+
+    md->getStats(mds);
+    EXPECT_EQ(written, mds.used_clusters);
+
+    for (uint64_t i = 0; i < npages * page_size; i += stride)
+    {
+        ClusterLocationAndHash clh;
+        md->readCluster(i, clh);
+
+        if ((i / page_size) % 2)
+        {
+            EXPECT_TRUE(clh.clusterLocation.isNull());
+        }
+        else
+        {
+            EXPECT_EQ(ClusterLocation(i + 1), clh.clusterLocation);
+        }
+    }
+}
+
 TEST_P(MetaDataStoreTest, DISABLED_page_compression)
 {
     const uint32_t num_pages(youtils::System::get_env_with_default("NUM_PAGES",
@@ -0,0 +1,203 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ExGTest.h"
+
+#include "../FilePool.h"
+#include "../ScrubEntryBuffer.h"
+#include "../TLogMerger.h"
+
+#include <youtils/Weed.h>
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+using namespace scrubbing;
+
+namespace fs = boost::filesystem;
+
+class ScrubEntryBufferTest
+    : public ExGTest
+{
+protected:
+    ScrubEntryBufferTest()
+        : directory_(getTempPath("ScrubEntryBufferTest"))
+    {}
+
+    virtual void
+    SetUp()
+    {
+        fs::remove_all(directory_);
+        fs::create_directories(directory_);
+        filepool_ = std::make_unique<FilePool>(directory_);
+    }
+
+    virtual void
+    TearDown()
+    {
+        filepool_.reset();
+        fs::remove_all(directory_);
+    }
+
+    static ClusterLocationAndHash
+    make_loc(uint64_t i)
+    {
+        return ClusterLocationAndHash(ClusterLocation(i / 1000 + 1,
+                                                      i % 1000),
+                                      youtils::Weed::null());
+    }
+
+    void
+    fill(ScrubEntryBuffer& buf,
+         uint64_t count,
+         uint64_t step = 1)
+    {
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            buf.add(ClusterAddress(i * step),
+                    make_loc(i * step));
+        }
+        buf.seal();
+    }
+
+    void
+    check(ScrubEntryBuffer& buf,
+          uint64_t count)
+    {
+        EXPECT_EQ(count, buf.size());
+
+        std::unique_ptr<TLogReaderInterface> r(buf.reader());
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const Entry* e = r->nextLocation();
+            ASSERT_TRUE(e != nullptr);
+            EXPECT_EQ(ClusterAddress(i), e->clusterAddress());
+            EXPECT_EQ(make_loc(i).clusterLocation, e->clusterLocation());
+        }
+        EXPECT_TRUE(r->nextLocation() == nullptr);
+
+        std::unique_ptr<TLogReaderInterface> b(buf.backward_reader());
+        for (uint64_t i = count; i > 0; --i)
+        {
+            const Entry* e = b->nextLocation();
+            ASSERT_TRUE(e != nullptr);
+            EXPECT_EQ(ClusterAddress(i - 1), e->clusterAddress());
+        }
+        EXPECT_TRUE(b->nextLocation() == nullptr);
+    }
+
+    const fs::path directory_;
+    std::unique_ptr<FilePool> filepool_;
+};
+
+TEST_F(ScrubEntryBufferTest, in_memory)
+{
+    ScrubMemoryBudget budget(1ULL << 20);
+    const uint64_t count = 3 * ScrubEntryBuffer::chunk_entries + 1;
+
+    {
+        ScrubEntryBuffer buf(budget,
+                             *filepool_,
+                             "buf");
+        fill(buf, count);
+
+        EXPECT_FALSE(buf.spilled());
+        EXPECT_EQ(4 * ScrubEntryBuffer::chunk_entries * sizeof(Entry),
+                  budget.used());
+
+        check(buf, count);
+    }
+
+    EXPECT_EQ(0U, budget.used());
+}
+
+TEST_F(ScrubEntryBufferTest, spill)
+{
+    const uint64_t chunk = ScrubEntryBuffer::chunk_entries * sizeof(Entry);
+    ScrubMemoryBudget budget(2 * chunk);
+
+    const uint64_t count = 5 * ScrubEntryBuffer::chunk_entries;
+
+    ScrubEntryBuffer small(budget,
+                           *filepool_,
+                           "small");
+    fill(small, 10);
+
+    EXPECT_FALSE(small.spilled());
+    EXPECT_EQ(chunk, budget.used());
+
+    {
+        ScrubEntryBuffer big(budget,
+                             *filepool_,
+                             "big");
+        fill(big, count);
+
+        EXPECT_TRUE(big.spilled());
+        EXPECT_TRUE(fs::exists(filepool_->directory() / "big"));
+        EXPECT_EQ(chunk, budget.used());
+
+        check(big, count);
+    }
+
+    EXPECT_FALSE(fs::exists(filepool_->directory() / "big"));
+    check(small, 10);
+}
+
+TEST_F(ScrubEntryBufferTest, merge)
+{
+    const uint64_t chunk = ScrubEntryBuffer::chunk_entries * sizeof(Entry);
+    ScrubMemoryBudget budget(chunk);
+
+    ScrubEntryBuffer even(budget,
+                          *filepool_,
+                          "even");
+    ScrubEntryBuffer odd(budget,
+                         *filepool_,
+                         "odd");
+
+    const uint64_t count = 2 * ScrubEntryBuffer::chunk_entries;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        ScrubEntryBuffer& buf = (i % 2) ? odd : even;
+        buf.add(ClusterAddress(i),
+                make_loc(i));
+    }
+
+    even.seal();
+    odd.seal();
+
+    EXPECT_NE(even.spilled(),
+              odd.spilled());
+
+    ScrubEntryMerger merger;
+    merger.addTLogReader(odd.reader().release());
+    merger.addTLogReader(even.reader().release());
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const Entry* e = merger.nextLocation();
+        ASSERT_TRUE(e != nullptr);
+        EXPECT_EQ(ClusterAddress(i), e->clusterAddress());
+    }
+
+    EXPECT_TRUE(merger.nextLocation() == nullptr);
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
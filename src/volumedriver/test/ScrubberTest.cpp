@@ -15,6 +15,8 @@
 #include "VolManagerTestSetup.h"
 
 #include "../Api.h"
+#include "../CachedMetaDataStore.h"
+#include "../SCOPool.h"
 #include "../Scrubber.h"
 #include "../ScrubberAdapter.h"
 #include "../ScrubWork.h"
@@ -22,6 +24,7 @@
 #include "../VolManager.h"
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/scope_exit.hpp>
 
 #include <backend/GarbageCollector.h>
 
@@ -684,6 +687,200 @@ TEST_P(ScrubberTest, SmallRegionScrub1)
                   RemoveVolumeCompletely::T);
 }
 
+TEST_P(ScrubberTest, parallel_region_scrub)
+{
+    const uint32_t region_threads_orig = Scrubber::region_threads;
+
+    BOOST_SCOPE_EXIT((&region_threads_orig))
+    {
+        Scrubber::region_threads = region_threads_orig;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    Scrubber::region_threads = 4;
+
+    auto ns_ptr = make_random_namespace();
+    SharedVolumePtr v = newVolume(VolumeId("volume1"),
+                                  ns_ptr->ns());
+
+    const size_t nclusters = 512;
+
+    // the overwrites leave the SCOs of the first pass half empty, with the
+    // survivors spread over all regions
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = pass; i < nclusters; i += pass + 1)
+        {
+            writeToVolume(*v,
+                          i * v->getClusterMultiplier(),
+                          default_cluster_size(),
+                          boost::lexical_cast<std::string>(pass) + "-" +
+                          boost::lexical_cast<std::string>(i));
+        }
+    }
+
+    v->createSnapshot(SnapshotName("snap"));
+    waitForThisBackendWrite(*v);
+
+    auto work(getScrubbingWork(v->getName()));
+    ASSERT_EQ(1U, work.size());
+
+    scrubbing::ScrubReply reply;
+    // 4 clusters per region
+    ASSERT_NO_THROW(reply = do_scrub(work.front(),
+                                     2));
+
+    ASSERT_NO_THROW(apply_scrubbing(v->getName(),
+                                    reply,
+                                    ScrubbingCleanup::OnError));
+
+    for (size_t i = 0; i < nclusters; ++i)
+    {
+        const size_t pass = i % 2;
+        checkVolume(*v,
+                    i * v->getClusterMultiplier(),
+                    default_cluster_size(),
+                    boost::lexical_cast<std::string>(pass) + "-" +
+                    boost::lexical_cast<std::string>(i));
+    }
+
+    ASSERT_TRUE(v->checkConsistency());
+}
+
+TEST_P(ScrubberTest, concurrent_sco_fetch_and_upload)
+{
+    const uint32_t backend_concurrency_orig = SCOPool::backend_concurrency;
+
+    BOOST_SCOPE_EXIT((&backend_concurrency_orig))
+    {
+        SCOPool::backend_concurrency = backend_concurrency_orig;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    SCOPool::backend_concurrency = 3;
+
+    auto ns_ptr = make_random_namespace();
+    SharedVolumePtr v = newVolume(VolumeId("volume1"),
+                                  ns_ptr->ns());
+
+    const size_t nclusters = 8 * v->getSCOMultiplier();
+
+    auto pattern([](size_t pass, size_t i)
+                 {
+                     return boost::lexical_cast<std::string>(pass) + "-" +
+                         boost::lexical_cast<std::string>(i);
+                 });
+
+    for (size_t i = 0; i < nclusters; ++i)
+    {
+        writeToVolume(*v,
+                      i * v->getClusterMultiplier(),
+                      default_cluster_size(),
+                      pattern(0, i));
+    }
+
+    // leaves runs of 8 contiguous live clusters in every SCO of the first pass
+    for (size_t i = 0; i < nclusters; ++i)
+    {
+        if ((i / 8) % 2)
+        {
+            writeToVolume(*v,
+                          i * v->getClusterMultiplier(),
+                          default_cluster_size(),
+                          pattern(1, i));
+        }
+    }
+
+    v->createSnapshot(SnapshotName("snap"));
+    waitForThisBackendWrite(*v);
+
+    auto work(getScrubbingWork(v->getName()));
+    ASSERT_EQ(1U, work.size());
+
+    scrubbing::ScrubReply reply;
+    ASSERT_NO_THROW(reply = do_scrub(work.front()));
+
+    ASSERT_NO_THROW(apply_scrubbing(v->getName(),
+                                    reply,
+                                    ScrubbingCleanup::OnError));
+
+    for (size_t i = 0; i < nclusters; ++i)
+    {
+        checkVolume(*v,
+                    i * v->getClusterMultiplier(),
+                    default_cluster_size(),
+                    pattern((i / 8) % 2, i));
+    }
+
+    ASSERT_TRUE(v->checkConsistency());
+}
+
+TEST_P(ScrubberTest, batched_relocation_application)
+{
+    const uint64_t batch_size_orig = CachedMetaDataStore::relocationBatchSize;
+
+    BOOST_SCOPE_EXIT((&batch_size_orig))
+    {
+        CachedMetaDataStore::relocationBatchSize = batch_size_orig;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    // an odd batch size to have batches end in the middle of a page
+    CachedMetaDataStore::relocationBatchSize = 7;
+
+    auto ns_ptr = make_random_namespace();
+    SharedVolumePtr v = newVolume(VolumeId("volume1"),
+                                  ns_ptr->ns());
+
+    const size_t nclusters = 4 * v->getSCOMultiplier();
+
+    auto pattern([](size_t pass, size_t i)
+                 {
+                     return boost::lexical_cast<std::string>(pass) + "-" +
+                         boost::lexical_cast<std::string>(i);
+                 });
+
+    // write in reverse order so the relocations arrive out of address order
+    for (size_t i = nclusters; i > 0; --i)
+    {
+        writeToVolume(*v,
+                      (i - 1) * v->getClusterMultiplier(),
+                      default_cluster_size(),
+                      pattern(0, i - 1));
+    }
+
+    for (size_t i = 0; i < nclusters; i += 3)
+    {
+        writeToVolume(*v,
+                      i * v->getClusterMultiplier(),
+                      default_cluster_size(),
+                      pattern(1, i));
+    }
+
+    v->createSnapshot(SnapshotName("snap"));
+    waitForThisBackendWrite(*v);
+
+    auto work(getScrubbingWork(v->getName()));
+    ASSERT_EQ(1U, work.size());
+
+    scrubbing::ScrubReply reply;
+    ASSERT_NO_THROW(reply = do_scrub(work.front()));
+
+    ASSERT_NO_THROW(apply_scrubbing(v->getName(),
+                                    reply,
+                                    ScrubbingCleanup::OnError));
+
+    for (size_t i = 0; i < nclusters; ++i)
+    {
+        checkVolume(*v,
+                    i * v->getClusterMultiplier(),
+                    default_cluster_size(),
+                    pattern(i % 3 ? 0 : 1, i));
+    }
+
+    ASSERT_TRUE(v->checkConsistency());
+}
+
 TEST_P(ScrubberTest, CloneScrubbin)
 {
     auto ns_ptr = make_random_namespace();
@@ -0,0 +1,259 @@
+// Copyright 2015 iNuron NV
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ExGTest.h"
+
+#include "../VolumeConfig.h"
+#include "../failovercache/GroupCommitter.h"
+#include "../failovercache/SegmentLogBackend.h"
+
+#include <future>
+
+#include <boost/filesystem.hpp>
+
+#include <youtils/FileDescriptor.h>
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+
+namespace fc = failovercache;
+namespace fs = boost::filesystem;
+namespace yt = youtils;
+
+class SegmentLogBackendTest
+    : public ExGTest
+{
+protected:
+    SegmentLogBackendTest()
+        : directory_(getTempPath("SegmentLogBackendTest"))
+    {}
+
+    void
+    SetUp() override final
+    {
+        fs::remove_all(directory_);
+        fs::create_directories(directory_);
+    }
+
+    void
+    TearDown() override final
+    {
+        fs::remove_all(directory_);
+    }
+
+    // Runs `nthreads' threads per file, each syncing it `nsyncs' times, and
+    // returns the number of failed syncs per file.
+    std::vector<size_t>
+    concurrent_syncs(fc::GroupCommitter& committer,
+                     std::vector<std::unique_ptr<yt::FileDescriptor>>& fds,
+                     size_t nthreads,
+                     size_t nsyncs)
+    {
+        std::vector<std::future<size_t>> futures;
+
+        for (auto& fd : fds)
+        {
+            for (size_t i = 0; i < nthreads; ++i)
+            {
+                yt::FileDescriptor& f = *fd;
+                futures.emplace_back(std::async(std::launch::async,
+                                                [&committer, &f, nsyncs]() -> size_t
+                                                {
+                                                    size_t errors = 0;
+                                                    for (size_t j = 0; j < nsyncs; ++j)
+                                                    {
+                                                        try
+                                                        {
+                                                            committer.sync(f);
+                                                        }
+                                                        catch (std::exception&)
+                                                        {
+                                                            ++errors;
+                                                        }
+                                                    }
+                                                    return errors;
+                                                }));
+            }
+        }
+
+        std::vector<size_t> errors(fds.size(), 0);
+
+        for (size_t i = 0; i < futures.size(); ++i)
+        {
+            // a waiter that is never woken up would hang here
+            EXPECT_EQ(std::future_status::ready,
+                      futures[i].wait_for(std::chrono::seconds(60)));
+            errors[i / nthreads] += futures[i].get();
+        }
+
+        return errors;
+    }
+
+    const fs::path directory_;
+};
+
+TEST_F(SegmentLogBackendTest, segments)
+{
+    const size_t csize = VolumeConfig::default_cluster_size();
+    const size_t entries_per_sco = 32;
+    const size_t nscos = 8;
+    // room for two SCOs per segment
+    const uint64_t segment_size = 2 * entries_per_sco * (csize + 64);
+
+    fc::GroupCommitter committer;
+    fc::SegmentLogBackend
+        backend(directory_ / "segment-log",
+                "some-namespace",
+                ClusterSize(csize),
+                committer,
+                segment_size);
+
+    for (size_t s = 1; s <= nscos; ++s)
+    {
+        for (size_t i = 0; i < entries_per_sco; i += 4)
+        {
+            auto buf(std::make_unique<uint8_t[]>(4 * csize));
+            std::vector<FailOverCacheEntry> entries;
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                uint8_t* p = buf.get() + j * csize;
+                memset(p, s * entries_per_sco + i + j, csize);
+                entries.emplace_back(ClusterLocation(s, i + j),
+                                     s * entries_per_sco + i + j,
+                                     p,
+                                     csize);
+            }
+
+            backend.addEntries(std::move(entries),
+                               std::move(buf));
+        }
+    }
+
+    backend.flush();
+    EXPECT_LT(0U, committer.rounds());
+    EXPECT_LE(nscos / 2, backend.segments());
+
+    auto check([&](size_t s) -> size_t
+               {
+                   size_t count = 0;
+                   backend.getSCO(SCO(s),
+                                  [&](ClusterLocation loc,
+                                      int64_t lba,
+                                      const uint8_t* buf,
+                                      int64_t size)
+                                  {
+                                      EXPECT_EQ(SCO(s), loc.sco());
+                                      EXPECT_EQ(count, loc.offset());
+                                      EXPECT_EQ(s * entries_per_sco + count,
+                                                static_cast<size_t>(lba));
+                                      EXPECT_EQ(csize,
+                                                static_cast<size_t>(size));
+                                      EXPECT_EQ(static_cast<uint8_t>(lba), buf[0]);
+                                      EXPECT_EQ(static_cast<uint8_t>(lba), buf[size - 1]);
+                                      ++count;
+                                  });
+                   return count;
+               });
+
+    for (size_t s = 1; s <= nscos; ++s)
+    {
+        EXPECT_EQ(entries_per_sco, check(s));
+    }
+
+    const size_t segments = backend.segments();
+
+    backend.removeUpTo(SCO(nscos - 2));
+
+    EXPECT_GT(segments, backend.segments());
+
+    for (size_t s = 1; s <= nscos; ++s)
+    {
+        EXPECT_EQ(s > nscos - 2 ? entries_per_sco : 0, check(s));
+    }
+}
+
+TEST_F(SegmentLogBackendTest, concurrent_group_commits)
+{
+    const size_t nfiles = 4;
+    const size_t nthreads = 4;
+    const size_t nsyncs = 32;
+
+    std::vector<std::unique_ptr<yt::FileDescriptor>> fds;
+
+    for (size_t i = 0; i < nfiles; ++i)
+    {
+        fds.emplace_back(std::make_unique<yt::FileDescriptor>(directory_ / ("file-" + boost::lexical_cast<std::string>(i)),
+                                                              yt::FDMode::Write,
+                                                              CreateIfNecessary::T));
+        fds.back()->write("some data", 9);
+    }
+
+    fc::GroupCommitter committer;
+
+    const std::vector<size_t> errors(concurrent_syncs(committer,
+                                                      fds,
+                                                      nthreads,
+                                                      nsyncs));
+
+    for (const auto& e : errors)
+    {
+        EXPECT_EQ(0U, e);
+    }
+
+    EXPECT_LT(0U, committer.rounds());
+    EXPECT_GE(nfiles * nthreads * nsyncs, committer.rounds());
+}
+
+TEST_F(SegmentLogBackendTest, group_commit_errors)
+{
+    const size_t nthreads = 4;
+    const size_t nsyncs = 16;
+
+    std::vector<std::unique_ptr<yt::FileDescriptor>> fds;
+
+    fds.emplace_back(std::make_unique<yt::FileDescriptor>(directory_ / "good",
+                                                          yt::FDMode::Write,
+                                                          CreateIfNecessary::T));
+
+    // fdatasync on /dev/null fails with EINVAL
+    fds.emplace_back(std::make_unique<yt::FileDescriptor>("/dev/null",
+                                                          yt::FDMode::ReadWrite,
+                                                          CreateIfNecessary::F,
+                                                          SyncOnCloseAndDestructor::F));
+
+    fds.emplace_back(std::make_unique<yt::FileDescriptor>(directory_ / "also-good",
+                                                          yt::FDMode::Write,
+                                                          CreateIfNecessary::T));
+
+    fc::GroupCommitter committer;
+
+    const std::vector<size_t> errors(concurrent_syncs(committer,
+                                                      fds,
+                                                      nthreads,
+                                                      nsyncs));
+
+    ASSERT_EQ(3U, errors.size());
+    EXPECT_EQ(0U, errors[0]);
+    EXPECT_EQ(nthreads * nsyncs, errors[1]);
+    EXPECT_EQ(0U, errors[2]);
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
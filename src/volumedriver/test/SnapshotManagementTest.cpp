@@ -656,6 +656,104 @@ TEST_P(SnapshotManagementTest, dontLeakTLogCheckSumsOnRestore)
     checkVolume(*vol_, 0, vol_->getClusterSize(), snap1);
 }
 
+TEST_P(SnapshotManagementTest, changed_clusters)
+{
+    using Extent = ChangedClusters::Extent;
+    using Extents = ChangedClusters::Extents;
+
+    const uint64_t csize = vol_->getClusterSize();
+    const uint64_t cmult = vol_->getClusterMultiplier();
+
+    auto write([&](ClusterAddress ca,
+                   uint64_t count,
+                   const std::string& pattern)
+               {
+                   writeToVolume(*vol_,
+                                 ca * cmult,
+                                 count * csize,
+                                 pattern);
+               });
+
+    write(0, 4, "first");
+    write(16, 1, "first");
+
+    const SnapshotName first("first");
+    vol_->createSnapshot(first);
+    waitForThisBackendWrite(*vol_);
+
+    write(2, 4, "second");
+    write(32, 2, "second");
+
+    const SnapshotName second("second");
+    vol_->createSnapshot(second);
+    waitForThisBackendWrite(*vol_);
+
+    write(100, 1, "not in a snapshot");
+
+    EXPECT_EQ((Extents{ Extent(0, 4),
+                        Extent(16, 1) }),
+              vol_->getChangedClusters(boost::none,
+                                       first).extents());
+
+    EXPECT_EQ((Extents{ Extent(2, 4),
+                        Extent(32, 2) }),
+              vol_->getChangedClusters(first,
+                                       second).extents());
+
+    const ChangedClusters all(vol_->getChangedClusters(boost::none,
+                                                       second));
+    EXPECT_EQ((Extents{ Extent(0, 6),
+                        Extent(16, 1),
+                        Extent(32, 2) }),
+              all.extents());
+
+    // 2nd time around it's served from the cache, which is shared by all
+    // volumes
+    const ChangedClustersCache& shared =
+        VolManager::get()->getChangedClustersCache();
+    const size_t cached = shared.size();
+    EXPECT_LT(0U,
+              cached);
+
+    EXPECT_EQ(all,
+              vol_->getChangedClusters(boost::none,
+                                       second));
+    EXPECT_EQ(cached,
+              shared.size());
+
+    EXPECT_THROW(vol_->getChangedClusters(boost::none,
+                                          SnapshotName("no-such-snapshot")),
+                 SnapshotNotFoundException);
+
+    EXPECT_THROW(vol_->getChangedClusters(second,
+                                          first),
+                 fungi::IOException);
+
+    EXPECT_TRUE(vol_->getChangedClusters(second,
+                                         second).empty());
+
+    EXPECT_THROW(vol_->getChangedClusters(SnapshotName("no-such-snapshot"),
+                                          SnapshotName("no-such-snapshot")),
+                 SnapshotNotFoundException);
+
+    // the cache is bounded by its footprint but keeps at least one entry
+    const SnapshotManagement& sm = vol_->getSnapshotManagement();
+    const OrderedTLogIds tlog_ids(sm.getTLogsBetweenSnapshots(boost::none,
+                                                              second));
+    ASSERT_LT(1U,
+              tlog_ids.size());
+
+    ChangedClustersCache cache(1);
+    EXPECT_EQ(all,
+              cache.get(sm.getTLogsPath(),
+                        tlog_ids,
+                        *vol_->getBackendInterface()));
+    EXPECT_EQ(1U,
+              cache.size());
+    EXPECT_LT(0U,
+              cache.bytes());
+}
+
 INSTANTIATE_TEST(SnapshotManagementTest);
 }
 
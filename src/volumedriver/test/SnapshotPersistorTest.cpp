@@ -18,14 +18,18 @@
 #include <algorithm>
 #include <iostream>
 
+#include <boost/archive/xml_oarchive.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/scope_exit.hpp>
 
+#include <youtils/Serialization.h>
 #include <youtils/TestBase.h>
 
 namespace volumedriver
 {
 
 namespace fs = boost::filesystem;
+namespace yt = youtils;
 
 class SnapshotPersistorTest
     : public youtilstest::TestBase
@@ -179,6 +183,42 @@ protected:
         }
     }
 
+    void
+    check_equal(const SnapshotPersistor& sp1,
+                const SnapshotPersistor& sp2)
+    {
+        ASSERT_EQ(static_cast<bool>(sp1.parent()),
+                  static_cast<bool>(sp2.parent()));
+        if (sp1.parent())
+        {
+            EXPECT_EQ(sp1.parent()->nspace,
+                      sp2.parent()->nspace);
+            EXPECT_EQ(sp1.parent()->snapshot,
+                      sp2.parent()->snapshot);
+        }
+
+        EXPECT_EQ(sp1.scrub_id(),
+                  sp2.scrub_id());
+        EXPECT_TRUE(sp1.current == sp2.current);
+
+        ASSERT_EQ(sp1.snapshots.size(),
+                  sp2.snapshots.size());
+
+        auto it = sp2.snapshots.begin();
+        for (const auto& snap : sp1.snapshots)
+        {
+            EXPECT_EQ(snap.getName(),
+                      it->getName());
+            EXPECT_EQ(snap.snapshotNumber(),
+                      it->snapshotNumber());
+            EXPECT_EQ(snap.scrubbed,
+                      it->scrubbed);
+            EXPECT_TRUE(static_cast<const TLogs&>(snap) ==
+                        static_cast<const TLogs&>(*it));
+            ++it;
+        }
+    }
+
     const fs::path basedir_;
     std::unique_ptr<SnapshotPersistor> sp_;
     const Namespace parentnamespace;
@@ -834,6 +874,228 @@ TEST_F(SnapshotPersistorTest, synced_to_backend)
     EXPECT_TRUE(sp_->isTLogWrittenToBackend(tlog));
 }
 
+TEST_F(SnapshotPersistorTest, xml_compat)
+{
+    sp_->newTLog();
+    sp_->snapshot(SnapshotName("snap"));
+    sp_->newTLog();
+    sp_->addCurrentBackendSize(4096);
+
+    const fs::path p(basedir_ / "snapshots.xml");
+    yt::Serialization::serializeNVPAndFlush<boost::archive::xml_oarchive>(p,
+                                                                          SnapshotPersistor::nvp_name,
+                                                                          *sp_);
+
+    const SnapshotPersistor sp(p);
+    check_equal(*sp_,
+                sp);
+
+    fs::ifstream ifs(p);
+    const SnapshotPersistor sp2(ifs);
+    check_equal(*sp_,
+                sp2);
+}
+
+TEST_F(SnapshotPersistorTest, xml_by_default)
+{
+    sp_->newTLog();
+    sp_->snapshot(SnapshotName("snap"));
+
+    const fs::path p(basedir_ / "snapshots");
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    // an existing binary file is replaced, not appended to
+    sp_->newTLog();
+    sp_->saveToFile(p,
+                    SyncAndRename::T);
+
+    {
+        fs::ifstream ifs(p);
+        ASSERT_EQ('<', ifs.peek());
+    }
+
+    check_equal(*sp_,
+                SnapshotPersistor(p));
+}
+
+TEST_F(SnapshotPersistorTest, binary_roundtrip)
+{
+    for (size_t i = 0; i < 4; ++i)
+    {
+        sp_->newTLog();
+        sp_->snapshot(SnapshotName("snap-" + boost::lexical_cast<std::string>(i)));
+        sp_->addCurrentBackendSize(4096 * i);
+    }
+
+    sp_->setSnapshotScrubbed(1, true);
+
+    const fs::path p(basedir_ / "snapshots");
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    {
+        fs::ifstream ifs(p);
+        ASSERT_NE('<', ifs.peek());
+    }
+
+    const SnapshotPersistor sp(p);
+    check_equal(*sp_,
+                sp);
+}
+
+TEST_F(SnapshotPersistorTest, incremental_updates)
+{
+    const TLogId first(sp_->getCurrentTLog());
+    sp_->snapshot(SnapshotName("snap"));
+    sp_->setTLogWrittenToBackend(first);
+
+    const fs::path p(basedir_ / "snapshots");
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    const uint64_t size = fs::file_size(p);
+    uint64_t prev_size = size;
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        const TLogId tlog_id(sp_->getCurrentTLog());
+        sp_->addCurrentBackendSize(4096);
+        sp_->newTLog();
+        sp_->setTLogWrittenToBackend(tlog_id);
+
+        sp_->saveToFile(p,
+                        SyncAndRename::T,
+                        BinaryJournal::T);
+
+        // the old TLogs are not written out again
+        const uint64_t new_size = fs::file_size(p);
+        EXPECT_LT(prev_size,
+                  new_size);
+        EXPECT_GT(size,
+                  new_size - prev_size);
+        prev_size = new_size;
+
+        const SnapshotPersistor sp(p);
+        check_equal(*sp_,
+                    sp);
+    }
+
+    // nothing changed, nothing appended
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+    EXPECT_EQ(prev_size,
+              fs::file_size(p));
+
+    // appending works from a copy as well
+    {
+        SnapshotPersistor sp(*sp_);
+        sp.addCurrentBackendSize(4096);
+        sp.saveToFile(p,
+                      SyncAndRename::T,
+                      BinaryJournal::T);
+        check_equal(sp,
+                    SnapshotPersistor(p));
+    }
+
+    sp_->addCurrentBackendSize(8192);
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+    check_equal(*sp_,
+                SnapshotPersistor(p));
+
+    // snapshot changes lead to a rewrite
+    sp_->snapshot(SnapshotName("snap2"));
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+    check_equal(*sp_,
+                SnapshotPersistor(p));
+}
+
+TEST_F(SnapshotPersistorTest, torn_journal_record)
+{
+    const fs::path p(basedir_ / "snapshots");
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    const SnapshotPersistor old(*sp_);
+    const uint64_t size = fs::file_size(p);
+
+    sp_->newTLog();
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    const uint64_t new_size = fs::file_size(p);
+    ASSERT_LT(size,
+              new_size);
+
+    fs::resize_file(p,
+                    new_size - 1);
+
+    check_equal(old,
+                SnapshotPersistor(p));
+
+    // the torn record is replaced on the next save
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+    EXPECT_EQ(new_size,
+              fs::file_size(p));
+    check_equal(*sp_,
+                SnapshotPersistor(p));
+}
+
+TEST_F(SnapshotPersistorTest, journal_compaction)
+{
+    const uint32_t max_journal_records_orig = SnapshotPersistor::max_journal_records;
+
+    BOOST_SCOPE_EXIT((&max_journal_records_orig))
+    {
+        SnapshotPersistor::max_journal_records = max_journal_records_orig;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    SnapshotPersistor::max_journal_records = 3;
+
+    const fs::path p(basedir_ / "snapshots");
+    sp_->saveToFile(p,
+                    SyncAndRename::T,
+                    BinaryJournal::T);
+
+    uint64_t prev_size = fs::file_size(p);
+    size_t rewrites = 0;
+
+    for (size_t i = 0; i < 9; ++i)
+    {
+        sp_->addCurrentBackendSize(4096);
+        sp_->saveToFile(p,
+                        SyncAndRename::T,
+                        BinaryJournal::T);
+
+        const uint64_t size = fs::file_size(p);
+        if (size <= prev_size)
+        {
+            ++rewrites;
+        }
+
+        prev_size = size;
+
+        check_equal(*sp_,
+                    SnapshotPersistor(p));
+    }
+
+    EXPECT_EQ(3U,
+              rewrites);
+}
+
 }
 
 // Local Variables: **
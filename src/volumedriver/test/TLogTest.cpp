@@ -28,9 +28,12 @@
 #include <youtils/FileUtils.h>
 #include <youtils/System.h>
 
+#include <backend/BackendTestSetup.h>
+
 #include "../CombinedTLogReader.h"
 #include "../TLogWriter.h"
 #include "../ClusterLocation.h"
+#include "../MappedTLogReader.h"
 #include "../TLogReader.h"
 #include "../BackwardTLogReader.h"
 #include "../TLog.h"
@@ -189,6 +192,236 @@ TEST_F(TLogTest, combined)
     }
 }
 
+TEST_F(TLogTest, parallel_fetch)
+{
+    const size_t ntlogs = 3 * CombinedTLogReader::parallel_fetch_window() + 1;
+    std::vector<std::string> names;
+    names.reserve(ntlogs);
+
+    for (size_t i = 0; i < ntlogs; ++i)
+    {
+        names.push_back("tlog_" + boost::lexical_cast<std::string>(i));
+
+        TLogWriter w(directory_ / names.back());
+        // leave some of them empty
+        for (size_t j = 0; j < (i % 5) * 7; ++j)
+        {
+            const ClusterLocationAndHash
+                loc_and_hash(ClusterLocation(i + 1, j, SCOCloneID(1)),
+                             VolManagerTestSetup::growWeed());
+            w.add(ClusterAddress(i * 1000 + j),
+                  loc_and_hash);
+        }
+    }
+
+    std::unique_ptr<TLogReaderInterface>
+        par(CombinedTLogReader::create(directory_,
+                                       names,
+                                       nullptr,
+                                       CombinedTLogReader::FetchStrategy::Parallel));
+
+    std::unique_ptr<TLogReaderInterface>
+        seq(CombinedTLogReader::create(directory_,
+                                       names,
+                                       nullptr,
+                                       CombinedTLogReader::FetchStrategy::OnDemand));
+
+    assertTLogReadersEqual(par.get(),
+                           seq.get());
+}
+
+class TLogBackendTest
+    : public TLogTest
+    , public be::BackendTestSetup
+{
+protected:
+    virtual void
+    SetUp()
+    {
+        TLogTest::SetUp();
+        initialize_connection_manager();
+    }
+
+    virtual void
+    TearDown()
+    {
+        uninitialize_connection_manager();
+        TLogTest::TearDown();
+    }
+};
+
+TEST_F(TLogBackendTest, parallel_fetch)
+{
+    auto wrns(make_random_namespace());
+    BackendInterfacePtr bi(createBackendInterface(wrns->ns()));
+
+    const fs::path src(directory_ / "src");
+    fs::create_directories(src);
+
+    const size_t ntlogs = 2 * CombinedTLogReader::parallel_fetch_window() + 3;
+    OrderedTLogIds tlog_ids;
+    tlog_ids.reserve(ntlogs);
+
+    for (size_t i = 0; i < ntlogs; ++i)
+    {
+        tlog_ids.emplace_back(TLogId());
+        const std::string name(boost::lexical_cast<std::string>(tlog_ids.back()));
+        const fs::path p(src / name);
+
+        {
+            TLogWriter w(p);
+            for (size_t j = 0; j < (i % 3) * 11; ++j)
+            {
+                const ClusterLocationAndHash
+                    loc_and_hash(ClusterLocation(i + 1, j, SCOCloneID(1)),
+                                 VolManagerTestSetup::growWeed());
+                w.add(ClusterAddress(i * 1000 + j),
+                      loc_and_hash);
+            }
+        }
+
+        bi->write(p,
+                  name);
+    }
+
+    // neither of them has any of the TLogs locally
+    const fs::path par_dir(directory_ / "parallel");
+    const fs::path seq_dir(directory_ / "on-demand");
+    fs::create_directories(par_dir);
+    fs::create_directories(seq_dir);
+
+    {
+        std::unique_ptr<TLogReaderInterface>
+            par(CombinedTLogReader::create<MappedTLogReader>(par_dir,
+                                                             tlog_ids,
+                                                             bi->clone(),
+                                                             CombinedTLogReader::FetchStrategy::Parallel));
+
+        std::unique_ptr<TLogReaderInterface>
+            seq(CombinedTLogReader::create(seq_dir,
+                                           tlog_ids,
+                                           bi->clone(),
+                                           CombinedTLogReader::FetchStrategy::OnDemand));
+
+        assertTLogReadersEqual(par.get(),
+                               seq.get());
+    }
+
+    // the fetched TLogs are cleaned up with their readers
+    EXPECT_TRUE(fs::is_empty(par_dir));
+}
+
+TEST_F(TLogTest, mapped_reader)
+{
+    const fs::path p(directory_ / "tlog");
+    const CheckSum cs(42);
+
+    {
+        TLogWriter w(p);
+        // more than the backward reader's read ahead chunk
+        for (size_t i = 0; i < 100000; ++i)
+        {
+            const ClusterLocationAndHash
+                loc_and_hash(ClusterLocation(i / 100 + 1, i % 100),
+                             VolManagerTestSetup::growWeed());
+            w.add(ClusterAddress(i),
+                  loc_and_hash);
+            if (i % 1000 == 0)
+            {
+                w.add(cs);
+            }
+            if (i % 3333 == 0)
+            {
+                w.sync();
+            }
+        }
+    }
+
+    auto check([&](TLogReaderInterface& x,
+                   TLogReaderInterface& y)
+               {
+                   const Entry* ex;
+                   while ((ex = x.nextAny()))
+                   {
+                       const Entry* ey = y.nextAny();
+                       ASSERT_TRUE(ey != nullptr);
+                       ASSERT_EQ(0, memcmp(ex,
+                                           ey,
+                                           Entry::getDataSize()));
+                   }
+                   ASSERT_TRUE(y.nextAny() == nullptr);
+               });
+
+    {
+        TLogReader r(p);
+        MappedTLogReader m(p,
+                           MappedTLogReader::Direction::Forward,
+                           VerifyTLogCRC::T);
+        check(r, m);
+    }
+
+    {
+        BackwardTLogReader r(p);
+        BackwardMappedTLogReader m(p);
+        check(r, m);
+    }
+}
+
+TEST_F(TLogTest, mapped_reader_crc_verification)
+{
+    const fs::path p(directory_ / "tlog");
+
+    {
+        TLogWriter w(p);
+        for (size_t i = 0; i < 10; ++i)
+        {
+            w.add(ClusterAddress(i),
+                  ClusterLocationAndHash(ClusterLocation(1, i),
+                                         VolManagerTestSetup::growWeed()));
+        }
+        w.addWrongTLogCRC();
+    }
+
+    {
+        MappedTLogReader m(p);
+        size_t count = 0;
+        while (m.nextAny())
+        {
+            ++count;
+        }
+        EXPECT_LT(10U, count);
+    }
+
+    MappedTLogReader m(p,
+                       MappedTLogReader::Direction::Forward,
+                       VerifyTLogCRC::T);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(m.nextAny() != nullptr);
+    }
+
+    EXPECT_THROW(m.nextAny(),
+                 TLogCRCMismatchException);
+
+    // as used on the restart and scrub paths
+    const std::vector<std::string> names{ p.filename().string() };
+    std::unique_ptr<TLogReaderInterface>
+        c(CombinedTLogReader::create<VerifyingMappedTLogReader>(directory_,
+                                                                names,
+                                                                nullptr));
+
+    auto drain([&]
+               {
+                   while (c->nextAny())
+                   {
+                   }
+               });
+
+    EXPECT_THROW(drain(),
+                 TLogCRCMismatchException);
+}
+
 namespace
 {
 
@@ -1737,6 +1737,86 @@ TEST_P(VolManagerRestartTest, testAllTlogEntriesAreReplayed)
                   RemoveVolumeCompletely::T);
 }
 
+TEST_P(VolManagerRestartTest, parallel_tlog_replay)
+{
+    const uint64_t replayClustersCached_orig = CachedMetaDataStore::replayClustersCached;
+    const uint32_t replayThreads_orig = CachedMetaDataStore::replayThreads;
+
+    BOOST_SCOPE_EXIT((&replayClustersCached_orig)(&replayThreads_orig))
+    {
+        CachedMetaDataStore::replayClustersCached = replayClustersCached_orig;
+        CachedMetaDataStore::replayThreads = replayThreads_orig;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    // small enough to have the entries of a page spread over several batches
+    CachedMetaDataStore::replayClustersCached = 64;
+    CachedMetaDataStore::replayThreads = 4;
+
+    // every 3rd page, to spread the clusters over the regions of all workers
+    const uint64_t stride = 3 * CachePage::capacity();
+    const uint64_t nclusters = 256;
+
+    auto ns_ptr = make_random_namespace();
+    const Namespace& ns = ns_ptr->ns();
+
+    SharedVolumePtr v = newVolume("volume1",
+                                  ns,
+                                  VolumeSize((nclusters + 1) * stride * 4096));
+
+    const uint64_t csize = v->getClusterSize();
+    const uint64_t lbas_per_cluster = csize / v->getLBASize();
+
+    auto lba([&](uint64_t i) -> uint64_t
+             {
+                 return (i * stride + i % CachePage::capacity()) * lbas_per_cluster;
+             });
+
+    for (uint64_t i = 0; i < nclusters; ++i)
+    {
+        writeToVolume(*v,
+                      lba(i),
+                      csize,
+                      "first");
+    }
+
+    v->createSnapshot(SnapshotName("snap"));
+    waitForThisBackendWrite(*v);
+
+    // overwrite every other cluster in the next TLog
+    for (uint64_t i = 0; i < nclusters; i += 2)
+    {
+        writeToVolume(*v,
+                      lba(i),
+                      csize,
+                      "second");
+    }
+
+    v->createSnapshot(SnapshotName("snap2"));
+
+    const VolumeConfig cfg(v->get_config());
+
+    waitForThisBackendWrite(*v);
+    destroyVolume(v,
+                  DeleteLocalData::T,
+                  RemoveVolumeCompletely::F);
+
+    restartVolume(cfg);
+
+    v = getVolume(VolumeId("volume1"));
+    ASSERT_TRUE(v != nullptr);
+
+    for (uint64_t i = 0; i < nclusters; ++i)
+    {
+        checkVolume(*v,
+                    lba(i),
+                    csize,
+                    (i % 2) ? "first" : "second");
+    }
+
+    checkCurrentBackendSize(*v);
+}
+
 // reproduces a RemoteTest.volume_migration failure -- only when running with arakoon
 TEST_P(VolManagerRestartTest, plain_backend_restart)
 {
@@ -232,6 +232,26 @@ FileDescriptor::pwrite(const void* const buf,
     return s;
 }
 
+size_t
+FileDescriptor::pwritev(const struct iovec* iov,
+                        int iovcnt,
+                        off_t pos)
+{
+    size_t size = 0;
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        size += iov[i].iov_len;
+    }
+
+    ssize_t s = ::pwritev(fd_, iov, iovcnt, pos);
+    if (s != (ssize_t)size)
+    {
+        throw FileDescriptorException(errno,
+                                    FileDescriptorException::Exception::WriteException);
+    }
+    return s;
+}
+
 off_t
 FileDescriptor::seek(off_t offset,
                      Whence w)
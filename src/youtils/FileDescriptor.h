@@ -35,6 +35,8 @@
 #ifndef FILEDESCRIPTOR_H_
 #define FILEDESCRIPTOR_H_
 
+#include <sys/uio.h>
+
 #include <boost/filesystem.hpp>
 #include "BooleanEnum.h"
 #include "Logging.h"
@@ -138,6 +140,13 @@ public:
            size_t size,
            off_t pos);
 
+    // Gathering version of pwrite: all iovecs are written or an exception is
+    // thrown.
+    size_t
+    pwritev(const struct iovec* iov,
+            int iovcnt,
+            off_t pos);
+
     off_t
     seek(off_t offset,
          Whence w);
@@ -88,6 +88,44 @@ public:
                              conn_);
     }
 
+    // Asynchronous variants of send / recv for users that run the io_service
+    // themselves (e.g. in a dedicated thread) to have a read and a write in
+    // progress at the same time. `fun' (a copyable callable without arguments)
+    // is invoked on the connection's strand once the data was transferred;
+    // errors escape from io_service::run() as exceptions.
+    // async_send can be called from any thread but the caller needs to wait
+    // for the completion before issuing the next one; async_recv must only be
+    // called from a completion or before the io_service is run.
+    template<typename BufferSequence,
+             typename Fun>
+    void
+    async_send(const BufferSequence& bufs,
+               Fun fun)
+    {
+        AsyncSendVisitor<BufferSequence, Fun> v(bufs,
+                                                std::move(fun));
+        boost::apply_visitor(v,
+                             conn_);
+    }
+
+    template<typename BufferSequence,
+             typename Fun>
+    void
+    async_recv(const BufferSequence& bufs,
+               Fun fun)
+    {
+        AsyncRecvVisitor<BufferSequence, Fun> v(bufs,
+                                                std::move(fun));
+        boost::apply_visitor(v,
+                             conn_);
+    }
+
+    boost::asio::io_service&
+    io_service()
+    {
+        return io_service_;
+    }
+
     bool
     is_local() const;
 
@@ -174,6 +212,70 @@ private:
             // LOG_TRACE("io service is done");
         }
     };
+
+    template<typename BufferSequence,
+             typename Fun>
+    struct AsyncSendVisitor
+        : public boost::static_visitor<>
+    {
+        const BufferSequence bufs_;
+        Fun fun_;
+
+        AsyncSendVisitor(const BufferSequence& bufs,
+                         Fun fun)
+            : bufs_(bufs)
+            , fun_(std::move(fun))
+        {}
+
+        template<typename C>
+        void
+        operator()(C conn)
+        {
+            // the write is started from the strand as the io_service thread
+            // might be busy with the socket
+            auto w([bufs = bufs_,
+                    fun = fun_](typename C::element_type& c)
+                   {
+                       auto f([fun](typename C::element_type&)
+                              {
+                                  fun();
+                              });
+
+                       c.async_write(bufs,
+                                     std::move(f));
+                   });
+
+            conn->async_work(std::move(w));
+        }
+    };
+
+    template<typename BufferSequence,
+             typename Fun>
+    struct AsyncRecvVisitor
+        : public boost::static_visitor<>
+    {
+        const BufferSequence bufs_;
+        Fun fun_;
+
+        AsyncRecvVisitor(const BufferSequence& bufs,
+                         Fun fun)
+            : bufs_(bufs)
+            , fun_(std::move(fun))
+        {}
+
+        template<typename C>
+        void
+        operator()(C conn)
+        {
+            auto f([fun = fun_](typename C::element_type&)
+                   {
+                       fun();
+                   });
+
+            conn->async_read(bufs_,
+                             std::move(f));
+        }
+    };
 };
 
 }